@@ -27,6 +27,7 @@
 
 #include <sstream>
 #include <cmath>
+#include <mutex>
 
 namespace sigrok
 {
@@ -270,7 +271,7 @@ shared_ptr<Packet> Context::create_header_packet(Glib::TimeVal start_time)
 	header->feed_version = 1;
 	header->starttime.tv_sec = start_time.tv_sec;
 	header->starttime.tv_usec = start_time.tv_usec;
-	auto packet = g_new(struct sr_datafeed_packet, 1);
+	auto packet = g_new0(struct sr_datafeed_packet, 1);
 	packet->type = SR_DF_HEADER;
 	packet->payload = header;
 	return shared_ptr<Packet>{new Packet{nullptr, packet},
@@ -290,7 +291,7 @@ shared_ptr<Packet> Context::create_meta_packet(
 		output->data = value.gobj_copy();
 		meta->config = g_slist_append(meta->config, output);
 	}
-	auto packet = g_new(struct sr_datafeed_packet, 1);
+	auto packet = g_new0(struct sr_datafeed_packet, 1);
 	packet->type = SR_DF_META;
 	packet->payload = meta;
 	return shared_ptr<Packet>{new Packet{nullptr, packet},
@@ -304,7 +305,7 @@ shared_ptr<Packet> Context::create_logic_packet(
 	logic->length = data_length;
 	logic->unitsize = unit_size;
 	logic->data = data_pointer;
-	auto packet = g_new(struct sr_datafeed_packet, 1);
+	auto packet = g_new0(struct sr_datafeed_packet, 1);
 	packet->type = SR_DF_LOGIC;
 	packet->payload = logic;
 	return shared_ptr<Packet>{new Packet{nullptr, packet}, default_delete<Packet>{}};
@@ -327,7 +328,7 @@ shared_ptr<Packet> Context::create_analog_packet(
 	meaning->unit = static_cast<sr_unit>(unit->id());
 	meaning->mqflags = static_cast<sr_mqflag>(QuantityFlag::mask_from_flags(move(mqflags)));
 	analog->data = data_pointer;
-	auto packet = g_new(struct sr_datafeed_packet, 1);
+	auto packet = g_new0(struct sr_datafeed_packet, 1);
 	packet->type = SR_DF_ANALOG;
 	packet->payload = analog;
 	return shared_ptr<Packet>{new Packet{nullptr, packet}, default_delete<Packet>{}};
@@ -636,6 +637,11 @@ void Device::close()
 	check(sr_dev_close(_structure));
 }
 
+void Device::clear_config_cache()
+{
+	check(sr_config_cache_clear(_structure));
+}
+
 HardwareDevice::HardwareDevice(shared_ptr<Driver> driver,
 		struct sr_dev_inst *structure) :
 	Device(structure),
@@ -870,6 +876,303 @@ void DatafeedCallbackData::run(const struct sr_dev_inst *sdi,
 	_callback(move(device), move(packet));
 }
 
+DatafeedViewCallbackData::DatafeedViewCallbackData(Session *session,
+		DatafeedViewCallbackFunction callback) :
+	_callback(move(callback)),
+	_session(session)
+{
+}
+
+void DatafeedViewCallbackData::run(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *pkt)
+{
+	auto *const device = _session->get_device_pointer(sdi);
+	_callback(device, PacketView{device, pkt});
+}
+
+/* Owned copy of a datafeed packet, reused through the pool. */
+struct BatchDatafeedCallbackData::Entry
+{
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_time time;
+	struct sr_datafeed_header header;
+	struct sr_datafeed_meta meta;
+	struct sr_datafeed_logic logic;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	vector<uint8_t> data;
+	unique_ptr<Packet> object;
+
+	Entry()
+	{
+		meta.config = nullptr;
+		meaning.channels = nullptr;
+	}
+
+	~Entry()
+	{
+		clear();
+	}
+
+	/* Free the copied lists, but keep the data buffer's capacity. */
+	void clear()
+	{
+		for (GSList *l = meta.config; l; l = l->next) {
+			auto *const config = static_cast<struct sr_config *>(l->data);
+			g_variant_unref(config->data);
+			g_free(config);
+		}
+		g_slist_free(meta.config);
+		meta.config = nullptr;
+		g_slist_free(meaning.channels);
+		meaning.channels = nullptr;
+		data.clear();
+	}
+};
+
+/* Pool of entries, shared with the deleters of packets handed out. */
+class BatchDatafeedCallbackData::Pool
+{
+public:
+	unique_ptr<Entry> get()
+	{
+		lock_guard<mutex> lock(_mutex);
+		if (_free.empty())
+			return unique_ptr<Entry>{new Entry};
+		auto entry = move(_free.back());
+		_free.pop_back();
+		return entry;
+	}
+
+	void put(unique_ptr<Entry> entry)
+	{
+		entry->clear();
+		lock_guard<mutex> lock(_mutex);
+		if (_free.size() < max_free)
+			_free.push_back(move(entry));
+	}
+private:
+	static const size_t max_free = 64;
+	mutex _mutex;
+	vector<unique_ptr<Entry> > _free;
+};
+
+BatchDatafeedCallbackData::BatchDatafeedCallbackData(Session *session,
+		BatchDatafeedCallbackFunction callback,
+		size_t max_bytes, unsigned int max_interval_ms) :
+	_callback(move(callback)),
+	_session(session),
+	_max_bytes(max_bytes),
+	_max_interval(int64_t{max_interval_ms} * 1000),
+	_sdi(nullptr),
+	_first_time(0),
+	_pending_bytes(0),
+	_pool(make_shared<Pool>())
+{
+}
+
+BatchDatafeedCallbackData::~BatchDatafeedCallbackData()
+{
+	/*
+	 * Hand over whatever is still pending. Once the session itself is
+	 * being destroyed its devices can't be shared any more, and the
+	 * packets are dropped; exceptions must not leave a destructor.
+	 */
+	try {
+		flush();
+	} catch (...) {
+	}
+}
+
+static size_t analog_data_size(const struct sr_datafeed_analog *analog)
+{
+	return size_t{analog->num_samples}
+		* g_slist_length(analog->meaning->channels)
+		* analog->encoding->unitsize;
+}
+
+static bool same_analog_format(const struct sr_datafeed_analog *a,
+	const struct sr_datafeed_analog *b)
+{
+	const auto *const ea = a->encoding;
+	const auto *const eb = b->encoding;
+	if (ea->unitsize != eb->unitsize || ea->is_signed != eb->is_signed
+			|| ea->is_float != eb->is_float
+			|| ea->is_bigendian != eb->is_bigendian
+			|| ea->scale.p != eb->scale.p || ea->scale.q != eb->scale.q
+			|| ea->offset.p != eb->offset.p
+			|| ea->offset.q != eb->offset.q)
+		return false;
+	const auto *const ma = a->meaning;
+	const auto *const mb = b->meaning;
+	if (ma->mq != mb->mq || ma->unit != mb->unit
+			|| ma->mqflags != mb->mqflags)
+		return false;
+	const GSList *la = ma->channels, *lb = mb->channels;
+	for (; la && lb; la = la->next, lb = lb->next)
+		if (la->data != lb->data)
+			return false;
+	return !la && !lb;
+}
+
+/* Append the packet's data to the last pending packet, if compatible. */
+bool BatchDatafeedCallbackData::merge(const struct sr_datafeed_packet *pkt)
+{
+	if (_pending.empty())
+		return false;
+	auto &last = *_pending.back();
+	if (last.packet.type != pkt->type)
+		return false;
+
+	const uint8_t *data;
+	size_t size;
+	if (pkt->type == SR_DF_LOGIC) {
+		auto *const logic = static_cast<const struct sr_datafeed_logic *>(
+			pkt->payload);
+		if (logic->unitsize != last.logic.unitsize)
+			return false;
+		data = static_cast<const uint8_t *>(logic->data);
+		size = logic->length;
+		last.logic.length += size;
+	} else if (pkt->type == SR_DF_ANALOG) {
+		auto *const analog = static_cast<const struct sr_datafeed_analog *>(
+			pkt->payload);
+		if (!same_analog_format(analog, &last.analog))
+			return false;
+		data = static_cast<const uint8_t *>(analog->data);
+		size = analog_data_size(analog);
+		last.analog.num_samples += analog->num_samples;
+	} else {
+		return false;
+	}
+
+	last.data.insert(last.data.end(), data, data + size);
+	last.logic.data = last.analog.data = last.data.data();
+	_pending_bytes += size;
+	return true;
+}
+
+/* Add a copy of the packet to the pending list. */
+void BatchDatafeedCallbackData::append(const struct sr_datafeed_packet *pkt)
+{
+	auto entry = _pool->get();
+	entry->packet.type = pkt->type;
+	entry->packet.payload = nullptr;
+	/* Merged packets keep the time of their first sample. */
+	entry->packet.time = nullptr;
+	if (pkt->time) {
+		entry->time = *pkt->time;
+		entry->packet.time = &entry->time;
+	}
+
+	switch (pkt->type) {
+	case SR_DF_HEADER:
+		entry->header = *static_cast<const struct sr_datafeed_header *>(
+			pkt->payload);
+		entry->packet.payload = &entry->header;
+		break;
+	case SR_DF_META:
+		for (auto l = static_cast<const struct sr_datafeed_meta *>(
+				pkt->payload)->config; l; l = l->next) {
+			auto *const config = static_cast<struct sr_config *>(l->data);
+			auto *const copy = g_new(struct sr_config, 1);
+			copy->key = config->key;
+			copy->data = g_variant_ref(config->data);
+			entry->meta.config = g_slist_append(entry->meta.config, copy);
+		}
+		entry->packet.payload = &entry->meta;
+		break;
+	case SR_DF_LOGIC: {
+		auto *const logic = static_cast<const struct sr_datafeed_logic *>(
+			pkt->payload);
+		auto *const data = static_cast<const uint8_t *>(logic->data);
+		entry->data.assign(data, data + logic->length);
+		entry->logic = *logic;
+		entry->logic.data = entry->data.data();
+		entry->packet.payload = &entry->logic;
+		_pending_bytes += logic->length;
+		break;
+	}
+	case SR_DF_ANALOG: {
+		auto *const analog = static_cast<const struct sr_datafeed_analog *>(
+			pkt->payload);
+		auto *const data = static_cast<const uint8_t *>(analog->data);
+		const size_t size = analog_data_size(analog);
+		entry->data.assign(data, data + size);
+		entry->encoding = *analog->encoding;
+		entry->meaning = *analog->meaning;
+		entry->meaning.channels = g_slist_copy(analog->meaning->channels);
+		entry->spec = *analog->spec;
+		entry->analog = *analog;
+		entry->analog.data = entry->data.data();
+		entry->analog.encoding = &entry->encoding;
+		entry->analog.meaning = &entry->meaning;
+		entry->analog.spec = &entry->spec;
+		entry->packet.payload = &entry->analog;
+		_pending_bytes += size;
+		break;
+	}
+	default:
+		/* No payload. */
+		break;
+	}
+
+	_pending.push_back(move(entry));
+}
+
+/* Hand all pending packets to the callback. */
+void BatchDatafeedCallbackData::flush()
+{
+	if (_pending.empty())
+		return;
+
+	auto device = _session->get_device(_sdi);
+	weak_ptr<Pool> pool = _pool;
+	vector<shared_ptr<Packet> > packets;
+	packets.reserve(_pending.size());
+
+	for (auto &entry : _pending) {
+		/* Reuse the entry's packet object if it still fits. */
+		if (!entry->object || entry->object->_device != device
+				|| entry->object->_structure->type != entry->packet.type)
+			entry->object.reset(new Packet{device, &entry->packet});
+		auto *const raw = entry.release();
+		packets.push_back(shared_ptr<Packet>{raw->object.get(),
+			[pool, raw](Packet *) {
+				unique_ptr<Entry> owned {raw};
+				if (auto shared = pool.lock())
+					shared->put(move(owned));
+			}});
+	}
+
+	_pending.clear();
+	_pending_bytes = 0;
+	_sdi = nullptr;
+
+	_callback(move(device), move(packets));
+}
+
+void BatchDatafeedCallbackData::run(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *pkt)
+{
+	/* Batches only contain packets from a single device. */
+	if (!_pending.empty() && sdi != _sdi)
+		flush();
+	if (_pending.empty()) {
+		_sdi = sdi;
+		_first_time = g_get_monotonic_time();
+	}
+
+	if (!merge(pkt))
+		append(pkt);
+
+	if (pkt->type == SR_DF_END || _pending_bytes >= _max_bytes
+			|| g_get_monotonic_time() - _first_time >= _max_interval)
+		flush();
+}
+
 SessionDevice::SessionDevice(struct sr_dev_inst *structure) :
 	Device(structure)
 {
@@ -924,6 +1227,17 @@ shared_ptr<Device> Session::get_device(const struct sr_dev_inst *sdi)
 		throw Error(SR_ERR_BUG);
 }
 
+Device *Session::get_device_pointer(const struct sr_dev_inst *sdi)
+{
+	auto owned = _owned_devices.find(sdi);
+	if (owned != _owned_devices.end())
+		return owned->second.get();
+	auto other = _other_devices.find(sdi);
+	if (other != _other_devices.end())
+		return other->second.get();
+	throw Error(SR_ERR_BUG);
+}
+
 void Session::add_device(shared_ptr<Device> device)
 {
 	const auto dev_struct = device->_structure;
@@ -1005,10 +1319,50 @@ void Session::add_datafeed_callback(DatafeedCallbackFunction callback)
 	_datafeed_callbacks.push_back(move(cb_data));
 }
 
+static void datafeed_view_callback(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *pkt, void *cb_data) noexcept
+{
+	auto callback = static_cast<DatafeedViewCallbackData *>(cb_data);
+	callback->run(sdi, pkt);
+}
+
+void Session::add_datafeed_view_callback(DatafeedViewCallbackFunction callback)
+{
+	unique_ptr<DatafeedViewCallbackData> cb_data
+		{new DatafeedViewCallbackData{this, move(callback)}};
+	check(sr_session_datafeed_callback_add(_structure,
+			&datafeed_view_callback, cb_data.get()));
+	_datafeed_view_callbacks.push_back(move(cb_data));
+}
+
+static void batch_datafeed_callback(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *pkt, void *cb_data) noexcept
+{
+	auto callback = static_cast<BatchDatafeedCallbackData *>(cb_data);
+	callback->run(sdi, pkt);
+}
+
+void Session::add_batch_datafeed_callback(
+	BatchDatafeedCallbackFunction callback,
+	size_t max_bytes, unsigned int max_interval_ms)
+{
+	unique_ptr<BatchDatafeedCallbackData> cb_data
+		{new BatchDatafeedCallbackData{this, move(callback),
+			max_bytes, max_interval_ms}};
+	check(sr_session_datafeed_callback_add(_structure,
+			&batch_datafeed_callback, cb_data.get()));
+	_batch_datafeed_callbacks.push_back(move(cb_data));
+}
+
 void Session::remove_datafeed_callbacks()
 {
 	check(sr_session_datafeed_callback_remove_all(_structure));
 	_datafeed_callbacks.clear();
+	_datafeed_view_callbacks.clear();
+	/* Deliver the packets still held back for a batch. */
+	for (auto &cb_data : _batch_datafeed_callbacks)
+		cb_data->flush();
+	_batch_datafeed_callbacks.clear();
 }
 
 shared_ptr<Trigger> Session::trigger()
@@ -1036,6 +1390,99 @@ shared_ptr<Context> Session::context()
 	return _context;
 }
 
+void Session::set_stats_enabled(bool enabled)
+{
+	check(sr_session_stats_enable(_structure, enabled));
+}
+
+vector<shared_ptr<SessionStats>> Session::stats()
+{
+	GSList *stats;
+	check(sr_session_stats_get(_structure, &stats));
+	vector<shared_ptr<SessionStats>> result;
+	for (GSList *l = stats; l; l = l->next) {
+		auto *const st = static_cast<struct sr_session_stats *>(l->data);
+		shared_ptr<Device> device;
+		if (st->sdi && (_owned_devices.count(st->sdi)
+				|| _other_devices.count(st->sdi)))
+			device = get_device(st->sdi);
+		result.push_back(shared_ptr<SessionStats>{
+			new SessionStats{move(device), st},
+			default_delete<SessionStats>{}});
+	}
+	g_slist_free_full(stats, g_free);
+	return result;
+}
+
+void Session::reset_stats()
+{
+	check(sr_session_stats_reset(_structure));
+}
+
+void Session::set_threading(const SessionThreading *threading)
+{
+	check(sr_session_threading_set(_structure, threading->id()));
+}
+
+const SessionThreading *Session::threading() const
+{
+	int threading;
+	check(sr_session_threading_get(_structure, &threading));
+	return SessionThreading::get(threading);
+}
+
+SessionStats::SessionStats(shared_ptr<Device> device,
+		const struct sr_session_stats *structure) :
+	_device(move(device)),
+	_structure(*structure)
+{
+}
+
+SessionStats::~SessionStats()
+{
+}
+
+shared_ptr<Device> SessionStats::device() const
+{
+	return _device;
+}
+
+const SessionStage *SessionStats::stage() const
+{
+	return SessionStage::get(_structure.stage);
+}
+
+int SessionStats::index() const
+{
+	return _structure.index;
+}
+
+uint64_t SessionStats::count() const
+{
+	return _structure.count;
+}
+
+uint64_t SessionStats::bytes() const
+{
+	return _structure.bytes;
+}
+
+uint64_t SessionStats::total_ns() const
+{
+	return _structure.total_ns;
+}
+
+uint64_t SessionStats::max_ns() const
+{
+	return _structure.max_ns;
+}
+
+vector<uint64_t> SessionStats::histogram() const
+{
+	return vector<uint64_t>(_structure.histogram,
+		_structure.histogram + SR_STATS_HISTOGRAM_BUCKETS);
+}
+
 Packet::Packet(shared_ptr<Device> device,
 	const struct sr_datafeed_packet *structure) :
 	_structure(structure),
@@ -1176,6 +1623,44 @@ unsigned int Logic::unit_size() const
 	return _structure->unitsize;
 }
 
+size_t Logic::num_samples() const
+{
+	return _structure->unitsize ? _structure->length / _structure->unitsize : 0;
+}
+
+void Logic::get_channel_bits(unsigned int index, uint8_t *dest) const
+{
+	const unsigned int unitsize = _structure->unitsize;
+	if (index >= unitsize * 8)
+		throw Error(SR_ERR_ARG);
+	const auto *const src = static_cast<const uint8_t *>(_structure->data)
+		+ index / 8;
+	const unsigned int shift = index % 8;
+	const size_t count = num_samples();
+	for (size_t i = 0; i < count; i++)
+		dest[i] = (src[i * unitsize] >> shift) & 1;
+}
+
+void Logic::unpack_bits(uint8_t *dest) const
+{
+	const size_t count = num_samples();
+	for (unsigned int index = 0; index < _structure->unitsize * 8; index++)
+		get_channel_bits(index, dest + index * count);
+}
+
+static bool is_native_float_encoding(const struct sr_analog_encoding *encoding)
+{
+#ifdef WORDS_BIGENDIAN
+	const bool bigendian = true;
+#else
+	const bool bigendian = false;
+#endif
+	return encoding->is_float && encoding->unitsize == sizeof(float)
+		&& static_cast<bool>(encoding->is_bigendian) == bigendian
+		&& encoding->scale.p == 1 && encoding->scale.q == 1
+		&& encoding->offset.p == 0;
+}
+
 Analog::Analog(const struct sr_datafeed_analog *structure) :
 	PacketPayload(),
 	_structure(structure)
@@ -1227,6 +1712,173 @@ vector<const QuantityFlag *> Analog::mq_flags() const
 	return QuantityFlag::flags_from_mask(_structure->meaning->mqflags);
 }
 
+unsigned int Analog::unit_size() const
+{
+	return _structure->encoding->unitsize;
+}
+
+bool Analog::is_signed() const
+{
+	return _structure->encoding->is_signed;
+}
+
+bool Analog::is_float() const
+{
+	return _structure->encoding->is_float;
+}
+
+bool Analog::is_bigendian() const
+{
+	return _structure->encoding->is_bigendian;
+}
+
+bool Analog::is_native_float() const
+{
+	return is_native_float_encoding(_structure->encoding);
+}
+
+void Analog::get_data_as_float(float *dest)
+{
+	check(sr_analog_to_float(_structure, dest));
+}
+
+PacketView::PacketView(Device *device,
+		const struct sr_datafeed_packet *structure) :
+	_device(device),
+	_structure(structure)
+{
+}
+
+const PacketType *PacketView::type() const
+{
+	return PacketType::get(_structure->type);
+}
+
+Device *PacketView::device() const
+{
+	return _device;
+}
+
+LogicView PacketView::logic() const
+{
+	if (_structure->type != SR_DF_LOGIC)
+		throw Error(SR_ERR_NA);
+	return LogicView{static_cast<const struct sr_datafeed_logic *>(
+		_structure->payload)};
+}
+
+AnalogView PacketView::analog() const
+{
+	if (_structure->type != SR_DF_ANALOG)
+		throw Error(SR_ERR_NA);
+	return AnalogView{_device, static_cast<const struct sr_datafeed_analog *>(
+		_structure->payload)};
+}
+
+LogicView::LogicView(const struct sr_datafeed_logic *structure) :
+	_structure(structure)
+{
+}
+
+const void *LogicView::data_pointer() const
+{
+	return _structure->data;
+}
+
+size_t LogicView::data_length() const
+{
+	return _structure->length;
+}
+
+unsigned int LogicView::unit_size() const
+{
+	return _structure->unitsize;
+}
+
+size_t LogicView::num_samples() const
+{
+	return _structure->unitsize ? _structure->length / _structure->unitsize : 0;
+}
+
+AnalogView::AnalogView(Device *device,
+		const struct sr_datafeed_analog *structure) :
+	_device(device),
+	_structure(structure)
+{
+}
+
+const void *AnalogView::data_pointer() const
+{
+	return _structure->data;
+}
+
+unsigned int AnalogView::num_samples() const
+{
+	return _structure->num_samples;
+}
+
+unsigned int AnalogView::num_channels() const
+{
+	return g_slist_length(_structure->meaning->channels);
+}
+
+Channel *AnalogView::channel(unsigned int index) const
+{
+	auto *const l = g_slist_nth(_structure->meaning->channels, index);
+	if (!l)
+		throw Error(SR_ERR_ARG);
+	auto *const ch = static_cast<struct sr_channel *>(l->data);
+	auto entry = _device->_channels.find(ch);
+	if (entry == _device->_channels.end())
+		throw Error(SR_ERR_BUG);
+	return entry->second.get();
+}
+
+const Quantity *AnalogView::mq() const
+{
+	return Quantity::get(_structure->meaning->mq);
+}
+
+const Unit *AnalogView::unit() const
+{
+	return Unit::get(_structure->meaning->unit);
+}
+
+unsigned int AnalogView::mq_flags_mask() const
+{
+	return _structure->meaning->mqflags;
+}
+
+unsigned int AnalogView::unit_size() const
+{
+	return _structure->encoding->unitsize;
+}
+
+bool AnalogView::is_signed() const
+{
+	return _structure->encoding->is_signed;
+}
+
+bool AnalogView::is_float() const
+{
+	return _structure->encoding->is_float;
+}
+
+bool AnalogView::is_bigendian() const
+{
+	return _structure->encoding->is_bigendian;
+}
+
+bool AnalogView::is_native_float() const
+{
+	return is_native_float_encoding(_structure->encoding);
+}
+
+void AnalogView::get_data_as_float(float *dest) const
+{
+	check(sr_analog_to_float(_structure, dest));
+}
+
 InputFormat::InputFormat(const struct sr_input_module *structure) :
 	_structure(structure)
 {
@@ -43,7 +43,9 @@ mapping = dict([
     ('sr_datatype', ('DataType', 'Configuration data type')),
     ('sr_channeltype', ('ChannelType', 'Channel type')),
     ('sr_trigger_matches', ('TriggerMatchType', 'Trigger match type')),
-    ('sr_output_flag', ('OutputFlag', 'Flag applied to output modules'))])
+    ('sr_output_flag', ('OutputFlag', 'Flag applied to output modules')),
+    ('sr_session_stage', ('SessionStage', 'Stage of the datafeed pipeline')),
+    ('sr_session_threading', ('SessionThreading', 'Threading policy of a session'))])
 
 index = ElementTree.parse(index_file)
 
@@ -97,6 +97,9 @@ class SR_API Device;
 class SR_API HardwareDevice;
 class SR_API Channel;
 class SR_API Session;
+class SR_API SessionStats;
+class SR_API SessionStage;
+class SR_API SessionThreading;
 class SR_API ConfigKey;
 class SR_API InputFormat;
 class SR_API OutputFormat;
@@ -110,6 +113,9 @@ class SR_API TriggerMatchType;
 class SR_API ChannelType;
 class SR_API Packet;
 class SR_API PacketPayload;
+class SR_API PacketView;
+class SR_API LogicView;
+class SR_API AnalogView;
 class SR_API PacketType;
 class SR_API Quantity;
 class SR_API Unit;
@@ -393,6 +399,8 @@ public:
 	void open();
 	/** Close device. */
 	void close();
+	/** Read all cached settings from the device again. */
+	void clear_config_cache();
 protected:
 	explicit Device(struct sr_dev_inst *structure);
 	~Device();
@@ -409,6 +417,7 @@ private:
 	friend class ChannelGroup;
 	friend class Output;
 	friend class Analog;
+	friend class AnalogView;
 	friend struct std::default_delete<Device>;
 };
 
@@ -588,6 +597,59 @@ private:
 	friend class Session;
 };
 
+/** Type of datafeed view callback */
+typedef function<void(Device *, const PacketView &)>
+	DatafeedViewCallbackFunction;
+
+/* Data required for C callback function to call a C++ datafeed view
+ * callback. */
+class SR_PRIV DatafeedViewCallbackData
+{
+public:
+	void run(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *pkt);
+private:
+	DatafeedViewCallbackFunction _callback;
+	DatafeedViewCallbackData(Session *session,
+		DatafeedViewCallbackFunction callback);
+	Session *_session;
+	friend class Session;
+};
+
+/** Type of batched datafeed callback */
+typedef function<void(shared_ptr<Device>, vector<shared_ptr<Packet> >)>
+	BatchDatafeedCallbackFunction;
+
+/* Data required for C callback function to call a batched C++ datafeed
+ * callback. Packets are copied and accumulated, with consecutive logic or
+ * analog packets of the same format concatenated into one block. */
+class SR_PRIV BatchDatafeedCallbackData
+{
+public:
+	void run(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *pkt);
+	~BatchDatafeedCallbackData();
+private:
+	struct Entry;
+	class Pool;
+	BatchDatafeedCallbackFunction _callback;
+	BatchDatafeedCallbackData(Session *session,
+		BatchDatafeedCallbackFunction callback,
+		size_t max_bytes, unsigned int max_interval_ms);
+	bool merge(const struct sr_datafeed_packet *pkt);
+	void append(const struct sr_datafeed_packet *pkt);
+	void flush();
+	Session *_session;
+	size_t _max_bytes;
+	int64_t _max_interval;
+	const struct sr_dev_inst *_sdi;
+	int64_t _first_time;
+	size_t _pending_bytes;
+	vector<unique_ptr<Entry> > _pending;
+	shared_ptr<Pool> _pool;
+	friend class Session;
+};
+
 /** A virtual device associated with a stored session */
 class SR_API SessionDevice :
 	public ParentOwned<SessionDevice, Session>,
@@ -616,7 +678,31 @@ public:
 	/** Add a datafeed callback to this session.
 	 * @param callback Callback of the form callback(Device, Packet). */
 	void add_datafeed_callback(DatafeedCallbackFunction callback);
-	/** Remove all datafeed callbacks from this session. */
+	/** Add a datafeed callback receiving non-owning packet views.
+	 *
+	 * Unlike add_datafeed_callback(), no objects are allocated per
+	 * packet. The device and the view, and any LogicView or AnalogView
+	 * obtained from it, are only valid until the callback returns.
+	 *
+	 * @param callback Callback of the form callback(Device, PacketView). */
+	void add_datafeed_view_callback(DatafeedViewCallbackFunction callback);
+	/** Add a batched datafeed callback to this session.
+	 *
+	 * Packets are accumulated and delivered as a list, once the data in
+	 * them reaches max_bytes, once max_interval_ms has passed since the
+	 * first one arrived, or at the end of the acquisition. The interval is
+	 * checked as packets arrive. Consecutive logic packets with the same
+	 * unit size, and analog packets with the same channels, meaning and
+	 * encoding, are concatenated into a single packet. The packets hold
+	 * copies of the data, and remain valid after the callback returns.
+	 *
+	 * @param callback Callback of the form callback(Device, list of Packet).
+	 * @param max_bytes Amount of sample data after which to deliver.
+	 * @param max_interval_ms Maximum time to hold back packets. */
+	void add_batch_datafeed_callback(BatchDatafeedCallbackFunction callback,
+		size_t max_bytes = 1 << 20, unsigned int max_interval_ms = 100);
+	/** Remove all datafeed callbacks from this session. Batched callbacks
+	 * are called with their pending packets first. */
 	void remove_datafeed_callbacks();
 	/** Start the session. */
 	void start();
@@ -637,26 +723,78 @@ public:
 	void set_trigger(shared_ptr<Trigger> trigger);
 	/** Get filename this session was loaded from. */
 	string filename() const;
+	/** Enable or disable the pipeline statistics. Disabling them
+	 * discards them. Should be called before starting the session. */
+	void set_stats_enabled(bool enabled);
+	/** Get the pipeline statistics, one entry per stage and device.
+	 * The statistics must be enabled. */
+	vector<shared_ptr<SessionStats> > stats();
+	/** Reset the pipeline statistics to zero. */
+	void reset_stats();
+	/** Set the threading policy. Must not be called while the session
+	 * is running. */
+	void set_threading(const SessionThreading *threading);
+	/** Get the threading policy. */
+	const SessionThreading *threading() const;
 private:
 	explicit Session(shared_ptr<Context> context);
 	Session(shared_ptr<Context> context, string filename);
 	~Session();
 	shared_ptr<Device> get_device(const struct sr_dev_inst *sdi);
+	Device *get_device_pointer(const struct sr_dev_inst *sdi);
 	struct sr_session *_structure;
 	const shared_ptr<Context> _context;
 	map<const struct sr_dev_inst *, unique_ptr<SessionDevice> > _owned_devices;
 	map<const struct sr_dev_inst *, shared_ptr<Device> > _other_devices;
 	vector<unique_ptr<DatafeedCallbackData> > _datafeed_callbacks;
+	vector<unique_ptr<DatafeedViewCallbackData> > _datafeed_view_callbacks;
+	vector<unique_ptr<BatchDatafeedCallbackData> > _batch_datafeed_callbacks;
 	SessionStoppedCallback _stopped_callback;
 	string _filename;
 	shared_ptr<Trigger> _trigger;
 
 	friend class Context;
 	friend class DatafeedCallbackData;
+	friend class DatafeedViewCallbackData;
+	friend class BatchDatafeedCallbackData;
 	friend class SessionDevice;
 	friend struct std::default_delete<Session>;
 };
 
+/** Statistics of one stage of the datafeed pipeline of a session */
+class SR_API SessionStats : public UserOwned<SessionStats>
+{
+public:
+	/** Device the stage ran for. Null for event sources that are not
+	 * tied to one of the session's devices. */
+	shared_ptr<Device> device() const;
+	/** Pipeline stage. */
+	const SessionStage *stage() const;
+	/** For callback stages, the position of the callback in the order
+	 * they were added. Otherwise 0. */
+	int index() const;
+	/** Number of packets, or of event source dispatches. */
+	uint64_t count() const;
+	/** Bytes of logic and analog sample data in those packets. */
+	uint64_t bytes() const;
+	/** Total time spent, in nanoseconds. */
+	uint64_t total_ns() const;
+	/** Longest single run, in nanoseconds. */
+	uint64_t max_ns() const;
+	/** Latency histogram. Bucket i counts runs that took from 2^i up to
+	 * 2^(i+1) nanoseconds; see struct sr_session_stats. */
+	vector<uint64_t> histogram() const;
+private:
+	SessionStats(shared_ptr<Device> device,
+		const struct sr_session_stats *structure);
+	~SessionStats();
+	shared_ptr<Device> _device;
+	struct sr_session_stats _structure;
+
+	friend class Session;
+	friend struct std::default_delete<SessionStats>;
+};
+
 /** A packet on the session datafeed */
 class SR_API Packet : public UserOwned<Packet>
 {
@@ -676,6 +814,7 @@ private:
 	friend class Session;
 	friend class Output;
 	friend class DatafeedCallbackData;
+	friend class BatchDatafeedCallbackData;
 	friend class Header;
 	friend class Meta;
 	friend class Logic;
@@ -749,6 +888,17 @@ public:
 	size_t data_length() const;
 	/* Size of each sample in bytes. */
 	unsigned int unit_size() const;
+	/** Number of samples in this packet. */
+	size_t num_samples() const;
+	/** Unpack the bits of one channel, one byte (0 or 1) per sample.
+	 * @param index Index of the channel's bit within each sample.
+	 * @param dest Buffer with room for num_samples() bytes. */
+	void get_channel_bits(unsigned int index, uint8_t *dest) const;
+	/** Unpack the bits of all channels, one byte (0 or 1) per sample,
+	 * with the samples of each channel stored contiguously.
+	 * @param dest Buffer with room for unit_size() * 8 * num_samples()
+	 * bytes. */
+	void unpack_bits(uint8_t *dest) const;
 private:
 	explicit Logic(const struct sr_datafeed_logic *structure);
 	~Logic();
@@ -777,6 +927,21 @@ public:
 	const Unit *unit() const;
 	/** Measurement flags associated with the samples in this packet. */
 	vector<const QuantityFlag *> mq_flags() const;
+	/** Size of each sample value in bytes. */
+	unsigned int unit_size() const;
+	/** Whether the sample values are signed. */
+	bool is_signed() const;
+	/** Whether the sample values are floating point. */
+	bool is_float() const;
+	/** Whether the sample values are stored big endian. */
+	bool is_bigendian() const;
+	/** Whether the data consists of floats in host byte order, with no
+	 * scale or offset to apply, so that it can be used as it is. */
+	bool is_native_float() const;
+	/** Convert the samples to floats, applying the scale and offset of
+	 * their encoding.
+	 * @param dest Buffer with room for num_samples() floats per channel. */
+	void get_data_as_float(float *dest);
 private:
 	explicit Analog(const struct sr_datafeed_analog *structure);
 	~Analog();
@@ -787,6 +952,94 @@ private:
 	friend class Packet;
 };
 
+/** Non-owning view of a datafeed packet.
+ *
+ * Views wrap the packet structures passed to a datafeed view callback
+ * without allocating or taking references, and are only valid for the
+ * duration of that callback. */
+class SR_API PacketView
+{
+public:
+	/** Type of this packet. */
+	const PacketType *type() const;
+	/** Device this packet came from. */
+	Device *device() const;
+	/** View of the logic payload of this packet. */
+	LogicView logic() const;
+	/** View of the analog payload of this packet. */
+	AnalogView analog() const;
+private:
+	PacketView(Device *device, const struct sr_datafeed_packet *structure);
+
+	Device *_device;
+	const struct sr_datafeed_packet *_structure;
+
+	friend class DatafeedViewCallbackData;
+};
+
+/** Non-owning view of a datafeed packet with logic data */
+class SR_API LogicView
+{
+public:
+	/** Pointer to data. */
+	const void *data_pointer() const;
+	/** Data length in bytes. */
+	size_t data_length() const;
+	/** Size of each sample in bytes. */
+	unsigned int unit_size() const;
+	/** Number of samples in this packet. */
+	size_t num_samples() const;
+private:
+	explicit LogicView(const struct sr_datafeed_logic *structure);
+
+	const struct sr_datafeed_logic *_structure;
+
+	friend class PacketView;
+};
+
+/** Non-owning view of a datafeed packet with analog data */
+class SR_API AnalogView
+{
+public:
+	/** Pointer to data. */
+	const void *data_pointer() const;
+	/** Number of samples in this packet. */
+	unsigned int num_samples() const;
+	/** Number of channels for which this packet contains data. */
+	unsigned int num_channels() const;
+	/** Channel for which this packet contains data.
+	 * @param index Index of the channel within this packet. */
+	Channel *channel(unsigned int index) const;
+	/** Measured quantity of the samples in this packet. */
+	const Quantity *mq() const;
+	/** Unit of the samples in this packet. */
+	const Unit *unit() const;
+	/** Bitmask of the measurement flags of the samples in this packet. */
+	unsigned int mq_flags_mask() const;
+	/** Size of each sample value in bytes. */
+	unsigned int unit_size() const;
+	/** Whether the sample values are signed. */
+	bool is_signed() const;
+	/** Whether the sample values are floating point. */
+	bool is_float() const;
+	/** Whether the sample values are stored big endian. */
+	bool is_bigendian() const;
+	/** Whether the data consists of floats in host byte order, with no
+	 * scale or offset to apply, so that it can be used as it is. */
+	bool is_native_float() const;
+	/** Convert the samples to floats, applying the scale and offset of
+	 * their encoding.
+	 * @param dest Buffer with room for num_samples() floats per channel. */
+	void get_data_as_float(float *dest) const;
+private:
+	AnalogView(Device *device, const struct sr_datafeed_analog *structure);
+
+	Device *_device;
+	const struct sr_datafeed_analog *_structure;
+
+	friend class PacketView;
+};
+
 /** An input format supported by the library */
 class SR_API InputFormat :
 	public ParentOwned<InputFormat, Context>
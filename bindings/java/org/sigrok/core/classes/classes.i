@@ -411,6 +411,7 @@ typedef jobject jdatafeedcallback;
 %ignore sigrok::Context::create_analog_packet;
 %ignore sigrok::Context::create_meta_packet;
 %ignore sigrok::Meta::config;
+%ignore sigrok::Session::add_batch_datafeed_callback;
 
 %include "bindings/swig/classes.i"
 
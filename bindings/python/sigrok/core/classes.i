@@ -249,6 +249,62 @@ typedef guint pyg_flags_type;
     Py_XINCREF($input);
 }
 
+/* Map from callable PyObject to BatchDatafeedCallbackFunction */
+%typecheck(SWIG_TYPECHECK_POINTER) sigrok::BatchDatafeedCallbackFunction {
+    $1 = PyCallable_Check($input);
+}
+
+%typemap(in) sigrok::BatchDatafeedCallbackFunction {
+    if (!PyCallable_Check($input))
+        SWIG_exception(SWIG_TypeError, "Expected a callable Python object");
+
+    $1 = [=] (std::shared_ptr<sigrok::Device> device,
+            std::vector<std::shared_ptr<sigrok::Packet> > packets) {
+        auto gstate = PyGILState_Ensure();
+
+        auto device_obj = SWIG_NewPointerObj(
+            SWIG_as_voidptr(new std::shared_ptr<sigrok::Device>(device)),
+            SWIGTYPE_p_std__shared_ptrT_sigrok__Device_t, SWIG_POINTER_OWN);
+
+        auto packets_obj = PyList_New(packets.size());
+        for (size_t i = 0; i < packets.size(); i++)
+            PyList_SET_ITEM(packets_obj, i, SWIG_NewPointerObj(
+                SWIG_as_voidptr(new std::shared_ptr<sigrok::Packet>(packets[i])),
+                SWIGTYPE_p_std__shared_ptrT_sigrok__Packet_t, SWIG_POINTER_OWN));
+
+        auto arglist = Py_BuildValue("(OO)", device_obj, packets_obj);
+
+        auto result = PyEval_CallObject($input, arglist);
+
+        Py_XDECREF(arglist);
+        Py_XDECREF(device_obj);
+        Py_XDECREF(packets_obj);
+
+        bool completed = !PyErr_Occurred();
+
+        if (!completed)
+            PyErr_Print();
+
+        bool valid_result = (completed && result == Py_None);
+
+        Py_XDECREF(result);
+
+        if (completed && !valid_result)
+        {
+            PyErr_SetString(PyExc_TypeError,
+                "Datafeed callback did not return None");
+            PyErr_Print();
+        }
+
+        PyGILState_Release(gstate);
+
+        if (!valid_result)
+            throw sigrok::Error(SR_ERR);
+    };
+
+    Py_XINCREF($input);
+}
+
 /* Cast PacketPayload pointers to correct subclass type. */
 %ignore sigrok::Packet::payload;
 
@@ -363,6 +419,59 @@ Glib::VariantBase python_to_variant_by_option(PyObject *input,
         throw sigrok::Error(SR_ERR_ARG);
 }
 
+/* Wrap a memory region in a Python object supporting the buffer protocol. */
+PyObject *memory_to_python(void *data, Py_ssize_t size)
+{
+#if PY_VERSION_HEX >= 0x03030000
+    return PyMemoryView_FromMemory(static_cast<char *>(data), size, PyBUF_READ);
+#else
+    return PyBuffer_FromMemory(data, size);
+#endif
+}
+
+/*
+ * Return the given NumPy array if it is a C-contiguous array of the given
+ * type and size, or a new array of that shape if it is None.
+ */
+PyObject *numpy_output_array(PyObject *out, int nd, npy_intp *dims, int typenum)
+{
+    if (!out || out == Py_None)
+        return PyArray_SimpleNew(nd, dims, typenum);
+
+    npy_intp size = 1;
+    for (int i = 0; i < nd; i++)
+        size *= dims[i];
+
+    if (!PyArray_Check(out))
+        throw sigrok::Error(SR_ERR_ARG);
+    auto *const array = reinterpret_cast<PyArrayObject *>(out);
+    if (PyArray_TYPE(array) != typenum || PyArray_SIZE(array) != size
+            || !PyArray_IS_C_CONTIGUOUS(array) || !PyArray_ISWRITEABLE(array))
+        throw sigrok::Error(SR_ERR_ARG);
+
+    Py_INCREF(out);
+    return out;
+}
+
+/* Convert analog samples to floats, into the given NumPy array or a new one. */
+PyObject *analog_to_float_array(sigrok::Analog *analog, PyObject *out)
+{
+    npy_intp dims[2];
+    dims[0] = analog->channels().size();
+    dims[1] = analog->num_samples();
+    PyObject *array = numpy_output_array(out, 2, dims, NPY_FLOAT);
+    if (!array)
+        return nullptr;
+    try {
+        analog->get_data_as_float(static_cast<float *>(
+            PyArray_DATA(reinterpret_cast<PyArrayObject *>(array))));
+    } catch (...) {
+        Py_DECREF(array);
+        throw;
+    }
+    return array;
+}
+
 /* Convert from a Python dict to a std::map<std::string, std::string> */
 std::map<std::string, Glib::VariantBase> dict_to_map_options(PyObject *dict,
     std::map<std::string, std::shared_ptr<sigrok::Option> > options)
@@ -390,6 +499,9 @@ std::map<std::string, Glib::VariantBase> dict_to_map_options(PyObject *dict,
 
 /* Ignore these methods, we will override them below. */
 %ignore sigrok::Analog::data;
+%ignore sigrok::Analog::get_data_as_float(float *);
+%ignore sigrok::Logic::get_channel_bits(unsigned int, uint8_t *) const;
+%ignore sigrok::Logic::unpack_bits(uint8_t *) const;
 %ignore sigrok::Driver::scan;
 %ignore sigrok::InputFormat::create_input;
 %ignore sigrok::OutputFormat::create_output;
@@ -518,7 +630,11 @@ std::map<std::string, Glib::VariantBase> dict_to_map_options(PyObject *dict,
     }
 }
 
-/* Return NumPy array from Analog::data(). */
+/*
+ * Return NumPy array from Analog::data(). The array refers to the packet's
+ * data without copying if that consists of plain floats, and is only valid
+ * until the datafeed callback returns. Other encodings are converted.
+ */
 %extend sigrok::Analog
 {
     PyObject * _data()
@@ -528,13 +644,89 @@ std::map<std::string, Glib::VariantBase> dict_to_map_options(PyObject *dict,
         dims[0] = $self->channels().size();
         dims[1] = $self->num_samples();
         int typenum = NPY_FLOAT;
+        if (!$self->is_native_float())
+            return analog_to_float_array($self, nullptr);
         void *data = $self->data_pointer();
         return PyArray_SimpleNewFromData(nd, dims, typenum, data);
     }
 
+    /* Convert samples to floats, into the given array or a new one. */
+    PyObject * get_data_as_float(PyObject *out = nullptr)
+    {
+        return analog_to_float_array($self, out);
+    }
+
+    PyObject * _buffer()
+    {
+        return memory_to_python($self->data_pointer(),
+            $self->num_samples() * $self->channels().size() * $self->unit_size());
+    }
+
+%pythoncode
+{
+    data = property(_data)
+    buffer = property(_buffer)
+}
+}
+
+/*
+ * Return NumPy arrays from Logic data. The data property refers to the
+ * packet's data without copying, and is only valid until the datafeed
+ * callback returns. The unpacked arrays are new copies.
+ */
+%extend sigrok::Logic
+{
+    PyObject * _data()
+    {
+        npy_intp dims[2];
+        dims[0] = $self->num_samples();
+        dims[1] = $self->unit_size();
+        return PyArray_SimpleNewFromData(2, dims, NPY_UINT8,
+            $self->data_pointer());
+    }
+
+    /* Unpack one channel into a boolean array, given or new. */
+    PyObject * get_channel_bits(unsigned int index, PyObject *out = nullptr)
+    {
+        npy_intp dims[1];
+        dims[0] = $self->num_samples();
+        PyObject *array = numpy_output_array(out, 1, dims, NPY_BOOL);
+        if (!array)
+            return nullptr;
+        try {
+            $self->get_channel_bits(index, static_cast<uint8_t *>(
+                PyArray_DATA(reinterpret_cast<PyArrayObject *>(array))));
+        } catch (...) {
+            Py_DECREF(array);
+            throw;
+        }
+        return array;
+    }
+
+    /* Unpack all channels into a 2-D boolean array, given or new. */
+    PyObject * unpack_bits(PyObject *out = nullptr)
+    {
+        npy_intp dims[2];
+        dims[0] = $self->unit_size() * 8;
+        dims[1] = $self->num_samples();
+        PyObject *array = numpy_output_array(out, 2, dims, NPY_BOOL);
+        if (!array)
+            return nullptr;
+        $self->unpack_bits(static_cast<uint8_t *>(
+            PyArray_DATA(reinterpret_cast<PyArrayObject *>(array))));
+        return array;
+    }
+
+    PyObject * _buffer()
+    {
+        return memory_to_python($self->data_pointer(), $self->data_length());
+    }
+
 %pythoncode
 {
     data = property(_data)
+    unpacked = property(unpack_bits)
+    buffer = property(_buffer)
 }
 }
 
@@ -59,6 +59,7 @@ template< class T > class enable_shared_from_this;
 %shared_ptr(sigrok::ChannelGroup);
 %shared_ptr(sigrok::Session);
 %shared_ptr(sigrok::SessionDevice);
+%shared_ptr(sigrok::SessionStats);
 %shared_ptr(sigrok::Packet);
 %shared_ptr(sigrok::PacketPayload);
 %shared_ptr(sigrok::Header);
@@ -80,6 +81,14 @@ template< class T > class enable_shared_from_this;
 #define SR_PRIV
 
 %ignore sigrok::DatafeedCallbackData;
+%ignore sigrok::BatchDatafeedCallbackData;
+
+/* Packet views are only valid during a callback; not exposed to bindings. */
+%ignore sigrok::DatafeedViewCallbackData;
+%ignore sigrok::PacketView;
+%ignore sigrok::LogicView;
+%ignore sigrok::AnalogView;
+%ignore sigrok::Session::add_datafeed_view_callback;
 
 #ifndef SWIGJAVA
 
@@ -199,6 +208,20 @@ typedef std::map<const sigrok::ConfigKey *, Glib::VariantBase>
 
 %attributestring(sigrok::Session, std::string, filename, filename);
 
+%attributevector(Session,
+    std::vector<std::shared_ptr<sigrok::SessionStats> >,
+    stats, stats);
+
+%attributestring(sigrok::SessionStats,
+    std::shared_ptr<sigrok::Device>, device, device);
+%attribute(sigrok::SessionStats, const sigrok::SessionStage *, stage, stage);
+%attribute(sigrok::SessionStats, int, index, index);
+%attribute(sigrok::SessionStats, uint64_t, count, count);
+%attribute(sigrok::SessionStats, uint64_t, bytes, bytes);
+%attribute(sigrok::SessionStats, uint64_t, total_ns, total_ns);
+%attribute(sigrok::SessionStats, uint64_t, max_ns, max_ns);
+%attributevector(SessionStats, std::vector<uint64_t>, histogram, histogram);
+
 %attribute(sigrok::Packet,
     const sigrok::PacketType *, type, type);
 
@@ -463,6 +463,86 @@ struct sr_context;
  */
 struct sr_session;
 
+/** Stage of the datafeed pipeline, see sr_session_stats_get(). */
+enum sr_session_stage {
+	/** sr_session_send() as a whole, including the stages below. */
+	SR_STAGE_SEND,
+	/** The chain of transform modules. */
+	SR_STAGE_TRANSFORM,
+	/** One datafeed callback. */
+	SR_STAGE_CALLBACK,
+	/** Event source dispatch: USB events, serial ports, timers. */
+	SR_STAGE_SOURCE,
+};
+
+/** Relation of a device's sample clock to the session timeline. */
+struct sr_session_clock {
+	/** Nominal samplerate in Hz, 0 if unknown. */
+	uint64_t samplerate;
+	/**
+	 * Samplerate in Hz as measured against the host's monotonic clock,
+	 * 0 if there are too few observations yet.
+	 */
+	double measured_samplerate;
+	/**
+	 * Deviation of the measured from the nominal samplerate, in ppm.
+	 * 0 if either is unknown.
+	 */
+	double drift_ppm;
+	/** Time of the first sample on the timeline, in ns. */
+	int64_t offset_ns;
+	/** Number of packets the estimate is based on. */
+	uint64_t observations;
+};
+
+/**
+ * @struct sr_session_merge
+ * Opaque structure merging the packet streams of the devices in a
+ * session, see sr_session_merge_new().
+ */
+struct sr_session_merge;
+
+/** Threading policy of a session, see sr_session_threading_set(). */
+enum sr_session_threading {
+	/** All devices are handled on the thread running the session. */
+	SR_SESSION_THREADING_SINGLE,
+	/** Every device is handled on a thread of its own. */
+	SR_SESSION_THREADING_PER_DEVICE,
+};
+
+/** Number of latency histogram buckets in struct sr_session_stats. */
+#define SR_STATS_HISTOGRAM_BUCKETS 32
+
+/** Statistics of one stage of the datafeed pipeline of a session. */
+struct sr_session_stats {
+	/**
+	 * Device the stage ran for. NULL for event sources whose callback
+	 * data isn't one of the session's devices.
+	 */
+	const struct sr_dev_inst *sdi;
+	/** The stage, enum sr_session_stage. */
+	int stage;
+	/**
+	 * For SR_STAGE_CALLBACK, the position of the callback in the
+	 * order they were added, starting at 0. Otherwise 0.
+	 */
+	int index;
+	/** Number of packets, or of event source dispatches. */
+	uint64_t count;
+	/** Bytes of logic and analog sample data in those packets. */
+	uint64_t bytes;
+	/** Total time spent, in nanoseconds. */
+	uint64_t total_ns;
+	/** Longest single run, in nanoseconds. */
+	uint64_t max_ns;
+	/**
+	 * Latency histogram. Bucket i counts the runs that took from 2^i
+	 * up to 2^(i+1) nanoseconds. Bucket 0 also counts shorter runs,
+	 * and the last bucket all longer ones.
+	 */
+	uint64_t histogram[SR_STATS_HISTOGRAM_BUCKETS];
+};
+
 struct sr_rational {
 	/** Numerator of the rational number. */
 	int64_t p;
@@ -470,10 +550,39 @@ struct sr_rational {
 	uint64_t q;
 };
 
+/**
+ * Time of a datafeed packet.
+ *
+ * The sample positions count the samples of a device from its
+ * SR_DF_HEADER packet on. Analog packets for different channels which
+ * cover the same samples share positions. Packets without samples have
+ * the position of the next sample.
+ */
+struct sr_datafeed_time {
+	/** When the device sent the packet, g_get_monotonic_time(). */
+	int64_t monotonic_us;
+	/** Position of the first sample of the packet. */
+	uint64_t sample;
+	/** Samplerate of the device in Hz, 0 if unknown. */
+	uint64_t samplerate;
+	/**
+	 * Time of the first sample of the packet on the timeline shared by
+	 * the devices of the session, in ns from the session start. See
+	 * sr_session_clock_get().
+	 */
+	int64_t timeline_ns;
+};
+
 /** Packet in a sigrok data feed. */
 struct sr_datafeed_packet {
 	uint16_t type;
 	const void *payload;
+	/**
+	 * Time of the packet. Set by the session on all packets passed to
+	 * the datafeed callbacks, drivers need not set it. May be NULL
+	 * on packets from elsewhere.
+	 */
+	const struct sr_datafeed_time *time;
 };
 
 /** Header of a sigrok data feed. */
@@ -632,6 +741,16 @@ struct sr_config {
 	GVariant *data;
 };
 
+/** Counters of the config cache of a device, see sr_config_cache_stats_get(). */
+struct sr_config_cache_stats {
+	/** sr_config_get() calls answered from the cache. */
+	uint64_t hits;
+	/** sr_config_get() calls for cacheable keys passed to the driver. */
+	uint64_t misses;
+	/** Number of times the cache was cleared. */
+	uint64_t invalidations;
+};
+
 enum sr_keytype {
 	SR_KEY_CONFIG,
 	SR_KEY_MQ,
@@ -971,6 +1090,9 @@ enum sr_configkey {
 	/** Over-temperature protection (OTP) active. */
 	SR_CONF_OVER_TEMPERATURE_PROTECTION_ACTIVE,
 
+	/** Number of devices to create (demo driver). */
+	SR_CONF_NUM_DEVICES,
+
 	/* Update sr_key_info_config[] (hwdriver.c) upon changes! */
 
 	/*--- Special stuff -------------------------------------------------*/
@@ -1010,6 +1132,18 @@ enum sr_configkey {
 	/** The device supports setting a probe factor. */
 	SR_CONF_PROBE_FACTOR,
 
+	/**
+	 * Number of times the acquisition ran out of queued receive buffers,
+	 * so that the device may have had to drop data.
+	 */
+	SR_CONF_BUFFER_OVERRUNS,
+
+	/**
+	 * Number of receive buffers that were handed back only partially
+	 * filled, because the device had no more data ready.
+	 */
+	SR_CONF_BUFFER_UNDERRUNS,
+
 	/* Update sr_key_info_config[] (hwdriver.c) upon changes! */
 
 	/*--- Acquisition modes, sample limiting ----------------------------*/
@@ -1049,6 +1183,12 @@ enum sr_configkey {
 	/** Self test mode. */
 	SR_CONF_TEST_MODE,
 
+	/**
+	 * The device can acquire as fast as the session takes the data,
+	 * instead of at the pace of the samplerate.
+	 */
+	SR_CONF_UNTHROTTLED,
+
 	/* Update sr_key_info_config[] (hwdriver.c) upon changes! */
 };
 
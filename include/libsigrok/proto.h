@@ -48,6 +48,8 @@ SR_API int sr_log_loglevel_set(int loglevel);
 SR_API int sr_log_loglevel_get(void);
 SR_API int sr_log_callback_set(sr_log_callback cb, void *cb_data);
 SR_API int sr_log_callback_set_default(void);
+SR_API int sr_log_async_set(gboolean async);
+SR_API int sr_log_flush(void);
 
 /*--- device.c --------------------------------------------------------------*/
 
@@ -88,6 +90,9 @@ SR_API int sr_config_set(const struct sr_dev_inst *sdi,
 		const struct sr_channel_group *cg,
 		uint32_t key, GVariant *data);
 SR_API int sr_config_commit(const struct sr_dev_inst *sdi);
+SR_API int sr_config_cache_clear(const struct sr_dev_inst *sdi);
+SR_API int sr_config_cache_stats_get(const struct sr_dev_inst *sdi,
+		struct sr_config_cache_stats *stats);
 SR_API int sr_config_list(const struct sr_dev_driver *driver,
 		const struct sr_dev_inst *sdi,
 		const struct sr_channel_group *cg,
@@ -129,6 +134,31 @@ SR_API int sr_session_is_running(struct sr_session *session);
 SR_API int sr_session_stopped_callback_set(struct sr_session *session,
 		sr_session_stopped_callback cb, void *cb_data);
 
+/* Pipeline statistics */
+SR_API int sr_session_stats_enable(struct sr_session *session,
+		gboolean enable);
+SR_API int sr_session_stats_get(struct sr_session *session, GSList **stats);
+SR_API int sr_session_stats_reset(struct sr_session *session);
+
+/* Threading */
+SR_API int sr_session_threading_set(struct sr_session *session,
+		int threading);
+SR_API int sr_session_threading_get(struct sr_session *session,
+		int *threading);
+
+/*--- timeline.c ------------------------------------------------------------*/
+
+SR_API int sr_session_clock_get(struct sr_session *session,
+		const struct sr_dev_inst *sdi, struct sr_session_clock *clock);
+SR_API struct sr_session_merge *sr_session_merge_new(
+		struct sr_session *session, int64_t max_delay_ns,
+		sr_datafeed_callback cb, void *cb_data);
+SR_API int sr_session_merge_push(struct sr_session_merge *merge,
+		const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet);
+SR_API int sr_session_merge_flush(struct sr_session_merge *merge);
+SR_API void sr_session_merge_free(struct sr_session_merge *merge);
+
 /*--- input/input.c ---------------------------------------------------------*/
 
 SR_API const struct sr_input_module **sr_input_list(void);
@@ -146,6 +176,10 @@ SR_API struct sr_input *sr_input_new(const struct sr_input_module *imod,
 		GHashTable *options);
 SR_API int sr_input_scan_buffer(GString *buf, const struct sr_input **in);
 SR_API int sr_input_scan_file(const char *filename, const struct sr_input **in);
+SR_API int sr_input_scan_file_stream(const char *filename,
+		const struct sr_input **in, FILE **stream);
+SR_API int sr_input_scan_files(const char **filenames,
+		const struct sr_input_module **modules, int num_threads);
 SR_API struct sr_dev_inst *sr_input_dev_inst_get(const struct sr_input *in);
 SR_API int sr_input_send(const struct sr_input *in, GString *buf);
 SR_API int sr_input_end(const struct sr_input *in);
@@ -151,9 +151,83 @@ SR_PRIV int sr_analog_init(struct sr_datafeed_analog *analog,
 	return SR_OK;
 }
 
+/*
+ * Load 'count' raw values of the given encoding into 'outbuf' as floats,
+ * without applying scale or offset. Each case is a plain loop over
+ * fixed-size elements so that the compiler can vectorize it.
+ */
+static int load_samples(const struct sr_analog_encoding *encoding,
+		const uint8_t *s, float *outbuf, unsigned int count)
+{
+	unsigned int i;
+
+	if (encoding->is_float) {
+		if (encoding->unitsize != sizeof(float)) {
+			sr_err("Unsupported floating-point unit size %d.",
+			       encoding->unitsize);
+			return SR_ERR;
+		}
+		if (encoding->is_bigendian)
+			for (i = 0; i < count; i++)
+				outbuf[i] = RBFL(s + i * 4);
+		else
+			for (i = 0; i < count; i++)
+				outbuf[i] = RLFL(s + i * 4);
+		return SR_OK;
+	}
+
+	switch (encoding->unitsize) {
+	case 1:
+		if (encoding->is_signed)
+			for (i = 0; i < count; i++)
+				outbuf[i] = (int8_t)s[i];
+		else
+			for (i = 0; i < count; i++)
+				outbuf[i] = s[i];
+		break;
+	case 2:
+		if (encoding->is_bigendian && encoding->is_signed)
+			for (i = 0; i < count; i++)
+				outbuf[i] = (int16_t)RB16(s + i * 2);
+		else if (encoding->is_bigendian)
+			for (i = 0; i < count; i++)
+				outbuf[i] = RB16(s + i * 2);
+		else if (encoding->is_signed)
+			for (i = 0; i < count; i++)
+				outbuf[i] = RL16S(s + i * 2);
+		else
+			for (i = 0; i < count; i++)
+				outbuf[i] = RL16(s + i * 2);
+		break;
+	case 4:
+		if (encoding->is_bigendian && encoding->is_signed)
+			for (i = 0; i < count; i++)
+				outbuf[i] = (int32_t)RB32(s + i * 4);
+		else if (encoding->is_bigendian)
+			for (i = 0; i < count; i++)
+				outbuf[i] = (uint32_t)RB32(s + i * 4);
+		else if (encoding->is_signed)
+			for (i = 0; i < count; i++)
+				outbuf[i] = RL32S(s + i * 4);
+		else
+			for (i = 0; i < count; i++)
+				outbuf[i] = (uint32_t)RL32(s + i * 4);
+		break;
+	default:
+		sr_err("Unsupported integer unit size %d.", encoding->unitsize);
+		return SR_ERR;
+	}
+
+	return SR_OK;
+}
+
 /**
  * Convert an analog datafeed payload to an array of floats.
  *
+ * Floating-point (32-bit) and integer (8, 16 and 32-bit, signed or
+ * unsigned) encodings in either byte order are supported. The encoding's
+ * scale and offset are applied to every value.
+ *
  * @param[in] analog The analog payload to convert. Must not be NULL.
  *                   analog->data, analog->meaning, and analog->encoding
  *                   must not be NULL.
@@ -171,14 +245,17 @@ SR_PRIV int sr_analog_init(struct sr_datafeed_analog *analog,
 SR_API int sr_analog_to_float(const struct sr_datafeed_analog *analog,
 		float *outbuf)
 {
-	float offset;
-	unsigned int b, i, count;
+	const struct sr_analog_encoding *encoding;
+	float scale_p, scale_q, offset;
+	unsigned int i, count;
 	gboolean bigendian;
+	int ret;
 
 	if (!analog || !(analog->data) || !(analog->meaning)
 			|| !(analog->encoding) || !outbuf)
 		return SR_ERR_ARG;
 
+	encoding = analog->encoding;
 	count = analog->num_samples * g_slist_length(analog->meaning->channels);
 
 #ifdef WORDS_BIGENDIAN
@@ -186,37 +263,30 @@ SR_API int sr_analog_to_float(const struct sr_datafeed_analog *analog,
 #else
 	bigendian = FALSE;
 #endif
-	if (!analog->encoding->is_float) {
-		/* TODO */
-		sr_err("Only floating-point encoding supported so far.");
-		return SR_ERR;
-	}
+	offset = encoding->offset.p / (float)encoding->offset.q;
 
-	if (analog->encoding->unitsize == sizeof(float)
-			&& analog->encoding->is_bigendian == bigendian
-			&& analog->encoding->scale.p == 1
-			&& analog->encoding->scale.q == 1
-			&& analog->encoding->offset.p / (float)analog->encoding->offset.q == 0) {
+	if (encoding->is_float && encoding->unitsize == sizeof(float)
+			&& encoding->is_bigendian == bigendian
+			&& encoding->scale.p == 1 && encoding->scale.q == 1
+			&& offset == 0) {
 		/* The data is already in the right format. */
 		memcpy(outbuf, analog->data, count * sizeof(float));
-	} else {
-		for (i = 0; i < count; i += analog->encoding->unitsize) {
-			for (b = 0; b < analog->encoding->unitsize; b++) {
-				if (analog->encoding->is_bigendian == bigendian)
-					((uint8_t *)outbuf)[i + b] =
-						((uint8_t *)analog->data)[i * analog->encoding->unitsize + b];
-				else
-					((uint8_t *)outbuf)[i + (analog->encoding->unitsize - b)] =
-						((uint8_t *)analog->data)[i * analog->encoding->unitsize + b];
-			}
-			if (analog->encoding->scale.p != 1
-					|| analog->encoding->scale.q != 1)
-				outbuf[i] = (outbuf[i] * analog->encoding->scale.p) / analog->encoding->scale.q;
-			offset = ((float)analog->encoding->offset.p / (float)analog->encoding->offset.q);
-			outbuf[i] += offset;
-		}
+		return SR_OK;
 	}
 
+	if ((ret = load_samples(encoding, analog->data, outbuf, count)) != SR_OK)
+		return ret;
+
+	if (encoding->scale.p != 1 || encoding->scale.q != 1) {
+		scale_p = encoding->scale.p;
+		scale_q = encoding->scale.q;
+		for (i = 0; i < count; i++)
+			outbuf[i] = (outbuf[i] * scale_p) / scale_q;
+	}
+	if (offset != 0)
+		for (i = 0; i < count; i++)
+			outbuf[i] += offset;
+
 	return SR_OK;
 }
 
@@ -129,6 +129,9 @@ SR_API int sr_dev_channel_enable(struct sr_channel *channel,
 		if (ret != SR_OK)
 			return ret;
 	}
+	/* The samplerate and others can depend on the enabled channels. */
+	if (!state != !was_enabled)
+		sr_config_cache_clear(sdi);
 
 	return SR_OK;
 }
@@ -264,6 +267,7 @@ SR_PRIV void sr_dev_inst_free(struct sr_dev_inst *sdi)
 	if (sdi->session)
 		sr_session_dev_remove(sdi->session, sdi);
 
+	sr_config_cache_free(sdi->config_cache);
 	g_free(sdi->vendor);
 	g_free(sdi->model);
 	g_free(sdi->version);
@@ -432,6 +436,7 @@ SR_API int sr_dev_open(struct sr_dev_inst *sdi)
 		return SR_ERR;
 
 	ret = sdi->driver->dev_open(sdi);
+	sr_config_cache_clear(sdi);
 
 	return ret;
 }
@@ -453,6 +458,7 @@ SR_API int sr_dev_close(struct sr_dev_inst *sdi)
 		return SR_ERR;
 
 	ret = sdi->driver->dev_close(sdi);
+	sr_config_cache_clear(sdi);
 
 	return ret;
 }
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "framing"
+/** @endcond */
+
+/**
+ * @file
+ *
+ * Packet framing for byte stream protocols.
+ */
+
+/**
+ * Find the next candidate packet start.
+ *
+ * @return TRUE if data[*offset] may start a packet. Otherwise FALSE, with
+ *         *offset set to the first byte that may still turn out to start
+ *         one once more data has arrived.
+ */
+static gboolean framing_sync(const struct sr_framing *framing,
+		const uint8_t *data, size_t len, size_t *offset)
+{
+	const uint8_t *p;
+	size_t sync_offset;
+	uint8_t sync;
+
+	if (framing->type == SR_FRAMING_DELIMITED) {
+		sync = framing->start;
+		sync_offset = 0;
+	} else if (framing->has_sync) {
+		sync = framing->sync;
+		sync_offset = framing->sync_offset;
+	} else {
+		return *offset < len;
+	}
+
+	if (len - *offset <= sync_offset)
+		return FALSE;
+
+	p = memchr(data + *offset + sync_offset, sync,
+			len - *offset - sync_offset);
+	if (!p) {
+		*offset = len - sync_offset;
+		return FALSE;
+	}
+	*offset = p - data - sync_offset;
+
+	return TRUE;
+}
+
+/**
+ * Find the first packet in a chunk of a byte stream.
+ *
+ * @param framing Description of the packets.
+ * @param data The received bytes.
+ * @param len The number of bytes at data.
+ * @param[out] offset The offset of the packet. If there is none, the number
+ *                    of bytes that can be discarded, as they can't be part
+ *                    of a packet.
+ *
+ * @retval SR_ERR_NA No complete packet has been found.
+ * @retval other     The size of the packet.
+ *
+ * @private
+ */
+SR_PRIV int sr_framing_find(const struct sr_framing *framing,
+		const uint8_t *data, size_t len, size_t *offset)
+{
+	const uint8_t *end;
+	size_t size;
+	int ret;
+
+	*offset = 0;
+	while (framing_sync(framing, data, len, offset)) {
+		switch (framing->type) {
+		case SR_FRAMING_FIXED:
+			size = framing->size;
+			break;
+		case SR_FRAMING_LENGTH:
+			ret = framing->packet_length(data + *offset, len - *offset);
+			if (ret == 0)
+				return SR_ERR_NA;
+			if (ret < 0 || (size_t)ret > framing->size) {
+				(*offset)++;
+				continue;
+			}
+			size = ret;
+			break;
+		case SR_FRAMING_DELIMITED:
+			end = NULL;
+			if (len - *offset > 1)
+				end = memchr(data + *offset + 1, framing->end,
+					MIN(len - *offset, framing->size) - 1);
+			if (!end) {
+				/* Too long to be a packet? */
+				if (len - *offset >= framing->size) {
+					(*offset)++;
+					continue;
+				}
+				return SR_ERR_NA;
+			}
+			size = end - data - *offset + 1;
+			break;
+		default:
+			sr_err("Invalid framing type %d.", framing->type);
+			*offset = len;
+			return SR_ERR_NA;
+		}
+
+		if (len - *offset < size)
+			return SR_ERR_NA;
+
+		if (!framing->is_valid || framing->is_valid(data + *offset))
+			return size;
+
+		(*offset)++;
+	}
+
+	return SR_ERR_NA;
+}
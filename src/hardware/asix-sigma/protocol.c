@@ -185,8 +185,24 @@ static int sigma_read_pos(uint32_t *stoppos, uint32_t *triggerpos,
 	return 1;
 }
 
-static int sigma_read_dram(uint16_t startchunk, size_t numchunks,
-			   uint8_t *data, struct dev_context *devc)
+/* A DRAM read, possibly still in progress. */
+struct sigma_dram_read {
+#ifdef HAVE_FTDI_READ_DATA_SUBMIT
+	struct ftdi_transfer_control *tc;
+#endif
+	int ret;
+};
+
+/*
+ * Request numchunks DRAM lines from the Sigma, and start reading them
+ * into data. Where libftdi supports asynchronous reads, this returns
+ * while the data is still being transferred, so that previously read
+ * lines can be decoded meanwhile. sigma_read_dram_finish() waits for
+ * the read to complete.
+ */
+static void sigma_read_dram_start(uint16_t startchunk, size_t numchunks,
+			uint8_t *data, struct sigma_dram_read *rd,
+			struct dev_context *devc)
 {
 	size_t i;
 	uint8_t buf[4096];
@@ -214,7 +230,32 @@ static int sigma_read_dram(uint16_t startchunk, size_t numchunks,
 
 	sigma_write(buf, idx, devc);
 
-	return sigma_read(data, numchunks * CHUNK_SIZE, devc);
+#ifdef HAVE_FTDI_READ_DATA_SUBMIT
+	rd->tc = ftdi_read_data_submit(&devc->ftdic, data,
+			numchunks * CHUNK_SIZE);
+	if (rd->tc)
+		return;
+	sr_dbg("Asynchronous read failed, reading synchronously.");
+#endif
+	rd->ret = sigma_read(data, numchunks * CHUNK_SIZE, devc);
+}
+
+static int sigma_read_dram_finish(struct sigma_dram_read *rd,
+			struct dev_context *devc)
+{
+#ifdef HAVE_FTDI_READ_DATA_SUBMIT
+	if (rd->tc) {
+		rd->ret = ftdi_transfer_data_done(rd->tc);
+		rd->tc = NULL;
+		if (rd->ret < 0)
+			sr_err("ftdi_transfer_data_done failed: %s",
+			       ftdi_get_error_string(&devc->ftdic));
+	}
+#else
+	(void)devc;
+#endif
+
+	return rd->ret;
 }
 
 /* Upload trigger look-up tables to Sigma. */
@@ -678,6 +719,59 @@ static uint16_t sigma_dram_cluster_ts(struct sigma_dram_cluster *cluster)
 	return (cluster->timestamp_hi << 8) | cluster->timestamp_lo;
 }
 
+/* Send the collected samples as one packet. */
+static void sigma_flush_samples(struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc = sdi->priv;
+	struct sigma_state *ss = &devc->state;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+
+	if (!ss->num_samples)
+		return;
+
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &logic;
+	logic.unitsize = 2;
+	logic.length = ss->num_samples * logic.unitsize;
+	logic.data = ss->samples;
+	sr_session_send(sdi, &packet);
+
+	ss->num_samples = 0;
+}
+
+/*
+ * Append count copies of a sample. Runs are filled in bulk, doubling
+ * the filled span with each copy.
+ */
+static void sigma_add_run(struct sr_dev_inst *sdi, uint16_t sample,
+			  size_t count)
+{
+	struct dev_context *devc = sdi->priv;
+	struct sigma_state *ss = &devc->state;
+	uint8_t *dest;
+	size_t n, done;
+
+	while (count) {
+		n = MIN(count, SAMPLE_BUF_SAMPLES - ss->num_samples);
+		dest = ss->samples + ss->num_samples * 2;
+		dest[0] = sample & 0xff;
+		dest[1] = sample >> 8;
+		if (dest[0] == dest[1]) {
+			memset(dest, dest[0], n * 2);
+		} else {
+			for (done = 1; done < n; done *= 2)
+				memcpy(dest + done * 2, dest,
+				       MIN(done, n - done) * 2);
+		}
+
+		ss->num_samples += n;
+		count -= n;
+		if (ss->num_samples == SAMPLE_BUF_SAMPLES)
+			sigma_flush_samples(sdi);
+	}
+}
+
 static void sigma_decode_dram_cluster(struct sigma_dram_cluster *dram_cluster,
 				      unsigned int events_in_cluster,
 				      unsigned int triggered,
@@ -686,20 +780,14 @@ static void sigma_decode_dram_cluster(struct sigma_dram_cluster *dram_cluster,
 	struct dev_context *devc = sdi->priv;
 	struct sigma_state *ss = &devc->state;
 	struct sr_datafeed_packet packet;
-	struct sr_datafeed_logic logic;
-	uint16_t tsdiff, ts;
-	uint8_t samples[2048];
-	unsigned int i;
+	uint16_t tsdiff, ts, lastsample;
+	uint8_t *samples;
+	unsigned int i, trigger_offset;
 
 	ts = sigma_dram_cluster_ts(dram_cluster);
 	tsdiff = ts - ss->lastts;
 	ss->lastts = ts;
 
-	packet.type = SR_DF_LOGIC;
-	packet.payload = &logic;
-	logic.unitsize = 2;
-	logic.data = samples;
-
 	/*
 	 * First of all, send Sigrok a copy of the last sample from
 	 * previous cluster as many times as needed to make up for
@@ -711,34 +799,31 @@ static void sigma_decode_dram_cluster(struct sigma_dram_cluster *dram_cluster,
 	 * sample in the cluster happens at the time of the timestamp
 	 * and the remaining samples happen at timestamp +1...+6 .
 	 */
-	for (ts = 0; ts < tsdiff - (EVENTS_PER_CLUSTER - 1); ts++) {
-		i = ts % 1024;
-		samples[2 * i + 0] = ss->lastsample & 0xff;
-		samples[2 * i + 1] = ss->lastsample >> 8;
-
-		/*
-		 * If we have 1024 samples ready or we're at the
-		 * end of submitting the padding samples, submit
-		 * the packet to Sigrok.
-		 */
-		if ((i == 1023) || (ts == (tsdiff - EVENTS_PER_CLUSTER))) {
-			logic.length = (i + 1) * logic.unitsize;
-			sr_session_send(sdi, &packet);
-		}
-	}
+	if (tsdiff > EVENTS_PER_CLUSTER - 1)
+		sigma_add_run(sdi, ss->lastsample,
+			      tsdiff - (EVENTS_PER_CLUSTER - 1));
 
 	/*
-	 * Parse the samples in current cluster and prepare them
-	 * to be submitted to Sigrok.
+	 * Parse the samples in current cluster straight into the sample
+	 * buffer. Leave one sample of slack, get_trigger_offset() looks
+	 * at eight samples.
 	 */
+	if (ss->num_samples + EVENTS_PER_CLUSTER + 1 > SAMPLE_BUF_SAMPLES)
+		sigma_flush_samples(sdi);
+
+	samples = ss->samples + ss->num_samples * 2;
 	for (i = 0; i < events_in_cluster; i++) {
 		samples[2 * i + 1] = dram_cluster->samples[i].sample_lo;
 		samples[2 * i + 0] = dram_cluster->samples[i].sample_hi;
 	}
+	lastsample = ss->lastsample;
+	if (events_in_cluster > 0)
+		lastsample = samples[2 * (events_in_cluster - 1) + 0] |
+			(samples[2 * (events_in_cluster - 1) + 1] << 8);
 
-	/* Send data up to trigger point (if triggered). */
-	int trigger_offset = 0;
-	if (triggered) {
+	if (!triggered) {
+		ss->num_samples += events_in_cluster;
+	} else {
 		/*
 		 * Trigger is not always accurate to sample because of
 		 * pipeline delay. However, it always triggers before
@@ -747,32 +832,26 @@ static void sigma_decode_dram_cluster(struct sigma_dram_cluster *dram_cluster,
 		 */
 		trigger_offset = get_trigger_offset(samples,
 					ss->lastsample, &devc->trigger);
+		trigger_offset = MIN(trigger_offset, events_in_cluster);
 
-		if (trigger_offset > 0) {
-			packet.type = SR_DF_LOGIC;
-			logic.length = trigger_offset * logic.unitsize;
-			sr_session_send(sdi, &packet);
-			events_in_cluster -= trigger_offset;
-		}
+		/* Send data up to trigger point. */
+		ss->num_samples += trigger_offset;
+		sigma_flush_samples(sdi);
 
 		/* Only send trigger if explicitly enabled. */
 		if (devc->use_triggers) {
 			packet.type = SR_DF_TRIGGER;
+			packet.payload = NULL;
 			sr_session_send(sdi, &packet);
 		}
-	}
 
-	if (events_in_cluster > 0) {
-		packet.type = SR_DF_LOGIC;
-		logic.length = events_in_cluster * logic.unitsize;
-		logic.data = samples + (trigger_offset * logic.unitsize);
-		sr_session_send(sdi, &packet);
+		/* Move the rest of the cluster to the start of the buffer. */
+		memmove(ss->samples, samples + trigger_offset * 2,
+			(events_in_cluster - trigger_offset) * 2);
+		ss->num_samples = events_in_cluster - trigger_offset;
 	}
 
-	ss->lastsample =
-		samples[2 * (events_in_cluster - 1) + 0] |
-		(samples[2 * (events_in_cluster - 1) + 1] << 8);
-
+	ss->lastsample = lastsample;
 }
 
 /*
@@ -832,21 +911,30 @@ static int download_capture(struct sr_dev_inst *sdi)
 {
 	struct dev_context *devc = sdi->priv;
 	const uint32_t chunks_per_read = 32;
-	struct sigma_dram_line *dram_line;
-	int bufsz;
+	struct sigma_dram_line *dram_line, *cur_line, *next_line;
+	struct sigma_dram_read rd;
 	uint32_t stoppos, triggerpos;
 	struct sr_datafeed_packet packet;
 	uint8_t modestatus;
 
 	uint32_t i;
-	uint32_t dl_lines_total, dl_lines_curr, dl_lines_done;
+	uint32_t dl_lines_total, dl_lines_curr, dl_lines_done, dl_lines_next;
 	uint32_t dl_events_in_line = 64 * 7;
 	uint32_t trg_line = ~0, trg_event = ~0;
+	int ret;
 
-	dram_line = g_try_malloc0(chunks_per_read * sizeof(*dram_line));
+	/* Two blocks of lines: one being decoded, one being downloaded. */
+	dram_line = g_try_malloc0(2 * chunks_per_read * sizeof(*dram_line));
 	if (!dram_line)
 		return FALSE;
 
+	devc->state.samples = g_try_malloc(SAMPLE_BUF_SAMPLES * 2);
+	if (!devc->state.samples) {
+		g_free(dram_line);
+		return FALSE;
+	}
+	devc->state.num_samples = 0;
+
 	sr_info("Downloading sample data.");
 
 	/* Stop acquisition. */
@@ -873,20 +961,37 @@ static int download_capture(struct sr_dev_inst *sdi)
 	dl_lines_total = (stoppos >> 9) + 1;
 
 	dl_lines_done = 0;
+	cur_line = dram_line;
+	next_line = dram_line + chunks_per_read;
+
+	/*
+	 * We can download only up-to 32 DRAM lines in one go! Every line is
+	 * read once: the first block here, each following one while the
+	 * previous one is being decoded.
+	 */
+	dl_lines_curr = MIN(chunks_per_read, dl_lines_total);
+	sigma_read_dram_start(0, dl_lines_curr, (uint8_t *)cur_line, &rd, devc);
+	ret = sigma_read_dram_finish(&rd, devc);
 
 	while (dl_lines_total > dl_lines_done) {
-		/* We can download only up-to 32 DRAM lines in one go! */
-		dl_lines_curr = MIN(chunks_per_read, dl_lines_total);
+		if (ret != (int)(dl_lines_curr * CHUNK_SIZE)) {
+			sr_err("Failed to read DRAM lines %u-%u.", dl_lines_done,
+			       dl_lines_done + dl_lines_curr - 1);
+			break;
+		}
 
-		bufsz = sigma_read_dram(dl_lines_done, dl_lines_curr,
-					(uint8_t *)dram_line, devc);
-		/* TODO: Check bufsz. For now, just avoid compiler warnings. */
-		(void)bufsz;
+		/* Start downloading the next lines while decoding these. */
+		dl_lines_next = MIN(chunks_per_read,
+				    dl_lines_total - dl_lines_done - dl_lines_curr);
+		if (dl_lines_next)
+			sigma_read_dram_start(dl_lines_done + dl_lines_curr,
+					      dl_lines_next, (uint8_t *)next_line,
+					      &rd, devc);
 
 		/* This is the first DRAM line, so find the initial timestamp. */
 		if (dl_lines_done == 0) {
 			devc->state.lastts =
-				sigma_dram_cluster_ts(&dram_line[0].cluster[0]);
+				sigma_dram_cluster_ts(&cur_line[0].cluster[0]);
 			devc->state.lastsample = 0;
 		}
 
@@ -900,19 +1005,30 @@ static int download_capture(struct sr_dev_inst *sdi)
 			if (dl_lines_done + i == trg_line)
 				trigger_event = trg_event;
 
-			decode_chunk_ts(dram_line + i, dl_events_in_line,
+			decode_chunk_ts(cur_line + i, dl_events_in_line,
 					trigger_event, sdi);
 		}
 
 		dl_lines_done += dl_lines_curr;
+		dl_lines_curr = dl_lines_next;
+		if (dl_lines_next) {
+			ret = sigma_read_dram_finish(&rd, devc);
+			cur_line = next_line;
+			next_line = (next_line == dram_line) ?
+				dram_line + chunks_per_read : dram_line;
+		}
 	}
 
+	sigma_flush_samples(sdi);
+
 	/* All done. */
 	packet.type = SR_DF_END;
 	sr_session_send(sdi, &packet);
 
 	sdi->driver->dev_acquisition_stop(sdi, sdi);
 
+	g_free(devc->state.samples);
+	devc->state.samples = NULL;
 	g_free(dram_line);
 
 	return TRUE;
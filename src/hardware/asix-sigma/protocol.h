@@ -89,6 +89,9 @@ enum sigma_read_register {
 
 #define CHUNK_SIZE		1024
 
+/* Decoded samples are collected and sent in packets of this many samples. */
+#define SAMPLE_BUF_SAMPLES	(64 * 1024)
+
 /*
  * The entire ASIX Sigma DRAM is an array of struct sigma_dram_line[1024];
  */
@@ -201,6 +204,10 @@ struct sigma_state {
 
 	uint16_t lastts;
 	uint16_t lastsample;
+
+	/* Decoded samples not yet sent. */
+	uint8_t *samples;
+	size_t num_samples;
 };
 
 /* Private, per-device-instance driver context. */
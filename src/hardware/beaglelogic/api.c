@@ -254,7 +254,6 @@ static int config_set(uint32_t key, GVariant *data, const struct sr_dev_inst *sd
 		const struct sr_channel_group *cg)
 {
 	struct dev_context *devc = sdi->priv;
-	uint64_t tmp_u64;
 
 	(void)cg;
 
@@ -266,22 +265,8 @@ static int config_set(uint32_t key, GVariant *data, const struct sr_dev_inst *sd
 		devc->cur_samplerate = g_variant_get_uint64(data);
 		return beaglelogic_set_samplerate(devc);
 	case SR_CONF_LIMIT_SAMPLES:
-		tmp_u64 = g_variant_get_uint64(data);
-		devc->limit_samples = tmp_u64;
-		devc->triggerflags = BL_TRIGGERFLAGS_ONESHOT;
-
-		/* Check if we have sufficient buffer size */
-		tmp_u64 *= SAMPLEUNIT_TO_BYTES(devc->sampleunit);
-		if (tmp_u64 > devc->buffersize) {
-			sr_warn("Insufficient buffer space has been allocated.");
-			sr_warn("Please use \'echo <size in bytes> > "\
-				BEAGLELOGIC_SYSFS_ATTR(memalloc) \
-				"\' as root to increase the buffer size, this"\
-				" capture is now truncated to %d Msamples",
-				devc->buffersize /
-				(SAMPLEUNIT_TO_BYTES(devc->sampleunit) * 1000000));
-		}
-		return beaglelogic_set_triggerflags(devc);
+		devc->limit_samples = g_variant_get_uint64(data);
+		return SR_OK;
 	case SR_CONF_CAPTURE_RATIO:
 		devc->capture_ratio = g_variant_get_uint64(data);
 		if (devc->capture_ratio > 100)
@@ -343,6 +328,7 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi,
 	(void)cb_data;
 	struct dev_context *devc = sdi->priv;
 	struct sr_trigger *trigger;
+	uint64_t limit_bytes;
 
 	if (sdi->status != SR_ST_ACTIVE)
 		return SR_ERR_DEV_CLOSED;
@@ -359,6 +345,27 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi,
 			BL_SAMPLEUNIT_16_BITS : BL_SAMPLEUNIT_8_BITS;
 	beaglelogic_set_sampleunit(devc);
 
+	/*
+	 * Untriggered captures that fit the kernel buffer are taken in one
+	 * shot. Longer, unlimited or triggered ones (which would otherwise
+	 * end when the buffer is full, however late the trigger came) stream
+	 * continuously, with the buffer used as a ring that is consumed as
+	 * it fills.
+	 */
+	limit_bytes = devc->limit_samples * SAMPLEUNIT_TO_BYTES(devc->sampleunit);
+	if (limit_bytes && limit_bytes <= devc->buffersize
+			&& !sr_session_trigger_get(sdi->session)) {
+		devc->triggerflags = BL_TRIGGERFLAGS_ONESHOT;
+	} else {
+		devc->triggerflags = BL_TRIGGERFLAGS_CONTINUOUS;
+		sr_info("Streaming continuously from the %u byte buffer.",
+			devc->buffersize);
+	}
+	if (beaglelogic_set_triggerflags(devc) != SR_OK) {
+		sr_err("Unable to set trigger flags: %s", g_strerror(errno));
+		return SR_ERR;
+	}
+
 	/* Configure triggers & send header packet */
 	if ((trigger = sr_session_trigger_get(sdi->session))) {
 		int pre_trigger_samples = 0;
@@ -21,85 +21,137 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <poll.h>
 #include "protocol.h"
 
-/* Define data packet size independent of packet (bufunitsize bytes) size
- * from the BeagleLogic kernel module */
-#define PACKET_SIZE	(512 * 1024)
-
-/* This implementation is zero copy from the libsigrok side.
+/*
+ * This implementation is zero copy from the libsigrok side.
  * It does not copy any data, just passes a pointer from the mmap'ed
  * kernel buffers appropriately. It is up to the application which is
  * using libsigrok to decide how to deal with the data.
+ *
+ * The kernel only reports whether the buffer unit at the read position
+ * has been filled. On each wakeup all consecutive units that are ready,
+ * up to the end of the ring, are collected and sent as one packet.
+ */
+
+/*
+ * Hand the buffer units at the read position back to the kernel. Their
+ * contents stay intact until the capture has gone around the whole ring
+ * once more, so data that was collected but not sent yet is safe.
  */
+static void release_units(struct dev_context *devc, uint32_t length)
+{
+	lseek(devc->fd, length, SEEK_CUR);
+}
+
+/*
+ * Return the number of bytes ready at the current offset, stepping the
+ * read position unit by unit while the kernel reports the next one as
+ * filled. The unit at the current offset is known to be ready.
+ */
+static uint32_t collect_ready(struct dev_context *devc, uint64_t max_bytes)
+{
+	struct pollfd pfd;
+	uint32_t length, ring_left;
+
+	ring_left = devc->buffersize - devc->offset;
+	length = MIN(devc->bufunitsize, ring_left);
+	release_units(devc, length);
+
+	pfd.fd = devc->fd;
+	pfd.events = POLLIN;
+
+	while (length < ring_left && length < max_bytes) {
+		pfd.revents = 0;
+		if (poll(&pfd, 1, 0) != 1 || !(pfd.revents & POLLIN))
+			break;
+		release_units(devc, MIN(devc->bufunitsize, ring_left - length));
+		length += MIN(devc->bufunitsize, ring_left - length);
+	}
+
+	return length;
+}
+
+static void send_data(struct dev_context *devc, uint8_t *data, uint64_t length)
+{
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+	int trigger_offset, pre_trigger_samples;
+	uint64_t limit_bytes;
+
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &logic;
+	logic.unitsize = SAMPLEUNIT_TO_BYTES(devc->sampleunit);
+	logic.data = data;
+	logic.length = length;
+
+	if (!devc->trigger_fired) {
+		/* Check for trigger, only within the data just collected. */
+		trigger_offset = soft_trigger_logic_check(devc->stl,
+				data, length, &pre_trigger_samples);
+		if (trigger_offset < 0)
+			return;
+		devc->bytes_read += pre_trigger_samples * logic.unitsize;
+		trigger_offset *= logic.unitsize;
+		logic.data = data + trigger_offset;
+		logic.length = length - trigger_offset;
+		limit_bytes = devc->limit_samples * logic.unitsize;
+		if (limit_bytes)
+			logic.length = (devc->bytes_read < limit_bytes) ?
+				MIN(logic.length, limit_bytes - devc->bytes_read) : 0;
+		devc->trigger_fired = TRUE;
+	}
+
+	if (logic.length)
+		sr_session_send(devc->cb_data, &packet);
+	devc->bytes_read += logic.length;
+}
+
 SR_PRIV int beaglelogic_receive_data(int fd, int revents, void *cb_data)
 {
 	const struct sr_dev_inst *sdi;
 	struct dev_context *devc;
 	struct sr_datafeed_packet packet;
-	struct sr_datafeed_logic logic;
+	uint64_t unitsize, limit_bytes, bytes_remaining;
+	uint32_t length;
+	gboolean done;
 
-	int trigger_offset;
-	int pre_trigger_samples;
-	uint32_t packetsize;
-	uint64_t bytes_remaining;
+	(void)fd;
 
 	if (!(sdi = cb_data) || !(devc = sdi->priv))
 		return TRUE;
 
-	packetsize = PACKET_SIZE;
-	logic.unitsize = SAMPLEUNIT_TO_BYTES(devc->sampleunit);
+	unitsize = SAMPLEUNIT_TO_BYTES(devc->sampleunit);
+	limit_bytes = devc->limit_samples * unitsize;
+	done = FALSE;
 
 	if (revents == G_IO_IN) {
-		sr_info("In callback G_IO_IN, offset=%d", devc->offset);
-
-		bytes_remaining = (devc->limit_samples * logic.unitsize) -
-				devc->bytes_read;
-
-		/* Configure data packet */
-		packet.type = SR_DF_LOGIC;
-		packet.payload = &logic;
-		logic.data = devc->sample_buf + devc->offset;
-		logic.length = MIN(packetsize, bytes_remaining);
-
-		if (devc->trigger_fired) {
-			/* Send the incoming transfer to the session bus. */
-			sr_session_send(devc->cb_data, &packet);
-		} else {
-			/* Check for trigger */
-			trigger_offset = soft_trigger_logic_check(devc->stl,
-					logic.data, packetsize, &pre_trigger_samples);
-			if (trigger_offset > -1) {
-				devc->bytes_read += pre_trigger_samples * logic.unitsize;
-				trigger_offset *= logic.unitsize;
-				logic.length = MIN(packetsize - trigger_offset,
-						bytes_remaining);
-				logic.data += trigger_offset;
-
-				sr_session_send(devc->cb_data, &packet);
-
-				devc->trigger_fired = TRUE;
-			}
-		}
+		bytes_remaining = limit_bytes ? limit_bytes - devc->bytes_read
+				: G_MAXUINT64;
+		/* Before the trigger, look at everything that is ready. */
+		length = collect_ready(devc, devc->trigger_fired ?
+				bytes_remaining : G_MAXUINT64);
+
+		sr_spew("Collected %u bytes at offset %u.", length, devc->offset);
 
-		/* Move the read pointer forward */
-		lseek(fd, packetsize, SEEK_CUR);
+		send_data(devc, devc->sample_buf + devc->offset,
+				devc->trigger_fired ? MIN(length, bytes_remaining)
+				: length);
 
-		/* Update byte count and offset (roll over if needed) */
-		devc->bytes_read += logic.length;
-		if ((devc->offset += packetsize) >= devc->buffersize) {
+		/* Update offset, rolling over in continuous mode. */
+		if ((devc->offset += length) >= devc->buffersize) {
 			/* One shot capture, we abort and settle with less than
 			 * the required number of samples */
 			if (devc->triggerflags)
 				devc->offset = 0;
 			else
-				packetsize = 0;
+				done = TRUE;
 		}
 	}
 
 	/* EOF Received or we have reached the limit */
-	if (devc->bytes_read >= devc->limit_samples * logic.unitsize ||
-			packetsize == 0) {
+	if ((limit_bytes && devc->bytes_read >= limit_bytes) || done) {
 		/* Send EOA Packet, stop polling */
 		packet.type = SR_DF_END;
 		packet.payload = NULL;
@@ -48,8 +48,6 @@ static GSList *brymen_scan(const char *conn, const char *serialcomm)
 	struct sr_serial_dev_inst *serial;
 	GSList *devices;
 	int ret;
-	uint8_t buf[128];
-	size_t len;
 
 	serial = sr_serial_dev_inst_new(conn, serialcomm);
 
@@ -66,9 +64,7 @@ static GSList *brymen_scan(const char *conn, const char *serialcomm)
 		goto scan_cleanup;
 	}
 
-	len = 128;
-	ret = brymen_stream_detect(serial, buf, &len, brymen_packet_length,
-			     brymen_packet_is_valid, 1000, 9600);
+	ret = serial_rx_frame_detect(serial, &brymen_framing, 1000);
 	if (ret != SR_OK)
 		goto scan_cleanup;
 
@@ -92,21 +92,19 @@ SR_PRIV int brymen_packet_request(struct sr_serial_dev_inst *serial)
 	return bm_send_command(BM_CMD_REQUEST_READING, 0, 0, serial);
 }
 
-SR_PRIV int brymen_packet_length(const uint8_t *buf, int *len)
+SR_PRIV int brymen_packet_length(const uint8_t *buf, size_t len)
 {
-	struct brymen_header *hdr;
+	const struct brymen_header *hdr;
 	int packet_len;
-	size_t buflen;
 
-	buflen = *len;
-	hdr = (void *)buf;
+	hdr = (const void *)buf;
 
 	/* Did we receive a complete header yet? */
-	if (buflen < sizeof(*hdr))
-		return PACKET_NEED_MORE_DATA;
+	if (len < sizeof(*hdr))
+		return 0;
 
 	if (hdr->dle != 0x10 || hdr->stx != 0x02)
-		return PACKET_INVALID_HEADER;
+		return -1;
 
 	/* Our packet includes the header, the payload, and the tail. */
 	packet_len = sizeof(*hdr) + hdr->len + sizeof(struct brymen_tail);
@@ -115,12 +113,12 @@ SR_PRIV int brymen_packet_length(const uint8_t *buf, int *len)
 	if (packet_len > MAX_PACKET_LEN) {
 		sr_spew("Header specifies an invalid payload length: %i.",
 			hdr->len);
-		return PACKET_INVALID_HEADER;
+		return -1;
 	}
 
-	*len = packet_len;
-	sr_spew("Expecting a %d-byte packet.", *len);
-	return PACKET_HEADER_OK;
+	sr_spew("Expecting a %d-byte packet.", packet_len);
+
+	return packet_len;
 }
 
 SR_PRIV gboolean brymen_packet_is_valid(const uint8_t *buf)
@@ -148,6 +146,16 @@ SR_PRIV gboolean brymen_packet_is_valid(const uint8_t *buf)
 	return TRUE;
 }
 
+SR_PRIV const struct sr_framing brymen_framing = {
+	.type = SR_FRAMING_LENGTH,
+	.size = MAX_PACKET_LEN,
+	.has_sync = TRUE,
+	.sync = 0x10,
+	.sync_offset = 0,
+	.packet_length = brymen_packet_length,
+	.is_valid = brymen_packet_is_valid,
+};
+
 static int parse_value(const char *strbuf, int len, float *floatval)
 {
 	int s, d;
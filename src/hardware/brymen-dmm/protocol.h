@@ -30,14 +30,6 @@
 
 #define LOG_PREFIX "brymen-dmm"
 
-#define DMM_BUFSIZE 256
-
-enum packet_len_status {
-	PACKET_HEADER_OK,
-	PACKET_NEED_MORE_DATA,
-	PACKET_INVALID_HEADER,
-};
-
 /** Private, per-device-instance driver context. */
 struct dev_context {
 	/** The current sampling limit (in number of samples). */
@@ -54,35 +46,17 @@ struct dev_context {
 
 	/** Start time of acquisition session */
 	int64_t starttime;
-
-	uint8_t buf[DMM_BUFSIZE];
-	int bufoffset;
-	int buflen;
-	int next_packet_len;
 };
 
-/**
- * Callback that assesses the size and status of the incoming packet.
- *
- * @return PACKET_HEADER_OK - This is a proper packet header.
- *         PACKET_NEED_MORE_DATA The buffer does not contain the entire header.
- *         PACKET_INVALID_HEADER Not a valid start of packet.
- */
-typedef int (*packet_length_t)(const uint8_t *buf, int *len);
+SR_PRIV extern const struct sr_framing brymen_framing;
 
 SR_PRIV int brymen_dmm_receive_data(int fd, int revents, void *cb_data);
 SR_PRIV int brymen_packet_request(struct sr_serial_dev_inst *serial);
 
-SR_PRIV int brymen_packet_length(const uint8_t *buf, int *len);
+SR_PRIV int brymen_packet_length(const uint8_t *buf, size_t len);
 SR_PRIV gboolean brymen_packet_is_valid(const uint8_t *buf);
 
 SR_PRIV int brymen_parse(const uint8_t *buf, float *floatval,
 		struct sr_datafeed_analog_old *analog, void *info);
 
-SR_PRIV int brymen_stream_detect(struct sr_serial_dev_inst *serial,
-				 uint8_t *buf, size_t *buflen,
-				 packet_length_t get_packet_size,
-				 packet_valid_callback is_valid,
-				 uint64_t timeout_ms, int baudrate);
-
 #endif
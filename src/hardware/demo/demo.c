@@ -33,10 +33,21 @@
 #define DEFAULT_NUM_LOGIC_CHANNELS     8
 #define DEFAULT_NUM_ANALOG_CHANNELS    4
 
-/* The size in bytes of chunks to send through the session bus. */
+/* The default size in bytes of chunks to send through the session bus. */
 #define LOGIC_BUFSIZE        4096
+/* The largest chunk size that can be configured. */
+#define MAX_LOGIC_BUFSIZE    (64 * 1024 * 1024)
 /* Size of the analog pattern space per channel. */
 #define ANALOG_BUFSIZE       4096
+/*
+ * Largest analog packet, in samples. Kept apart from the logic packet
+ * size, which can be large enough to make the patterns huge.
+ */
+#define ANALOG_PACKET_SAMPLES (ANALOG_BUFSIZE / sizeof(float))
+/* Number of pseudo-random logic samples generated, then repeated. */
+#define RANDOM_RING_SAMPLES  (4 * 1024 * 1024)
+/* Minimum number of samples sent per round when unthrottled. */
+#define UNTHROTTLED_BURST    (1024 * 1024)
 
 #define DEFAULT_ANALOG_AMPLITUDE 25
 #define ANALOG_SAMPLES_PER_PERIOD 20
@@ -96,7 +107,11 @@ static const char *analog_pattern_str[] = {
 struct analog_gen {
 	int pattern;
 	float amplitude;
-	float pattern_data[ANALOG_BUFSIZE];
+	/*
+	 * One or more periods of the pattern, followed by an analog packet's
+	 * worth of samples repeating its start.
+	 */
+	float *pattern_data;
 	unsigned int num_samples;
 	struct sr_datafeed_analog_old packet;
 	float avg_val; /* Average value */
@@ -111,13 +126,25 @@ struct dev_context {
 	uint64_t sent_samples;
 	int64_t start_us;
 	int64_t spent_us;
-	uint64_t step;
+	/* Size of the logic packets in bytes, and in samples. */
+	uint64_t packet_size;
+	uint64_t packet_samples;
+	/* Send data as fast as the session takes it. */
+	gboolean unthrottled;
 	/* Logic */
 	int32_t num_logic_channels;
 	unsigned int logic_unitsize;
 	/* There is only ever one logic channel group, so its pattern goes here. */
 	uint8_t logic_pattern;
-	unsigned char logic_data[LOGIC_BUFSIZE];
+	/*
+	 * One period of the logic pattern, followed by a packet's worth of
+	 * samples repeating its start. Packets point straight into it.
+	 */
+	uint8_t *logic_ring;
+	uint64_t logic_ring_samples;
+	uint64_t logic_pos;
+	/* The pattern was changed, the ring is rebuilt before the next send. */
+	gboolean logic_ring_stale;
 	/* Analog */
 	int32_t num_analog_channels;
 	GHashTable *ch_ag;
@@ -134,6 +161,7 @@ static const uint32_t drvopts[] = {
 static const uint32_t scanopts[] = {
 	SR_CONF_NUM_LOGIC_CHANNELS,
 	SR_CONF_NUM_ANALOG_CHANNELS,
+	SR_CONF_NUM_DEVICES,
 };
 
 static const uint32_t devopts[] = {
@@ -143,6 +171,8 @@ static const uint32_t devopts[] = {
 	SR_CONF_SAMPLERATE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
 	SR_CONF_AVERAGING | SR_CONF_GET | SR_CONF_SET,
 	SR_CONF_AVG_SAMPLES | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_BUFFERSIZE | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_UNTHROTTLED | SR_CONF_GET | SR_CONF_SET,
 };
 
 static const uint32_t devopts_cg_logic[] = {
@@ -184,7 +214,7 @@ static int init(struct sr_dev_driver *di, struct sr_context *sr_ctx)
 	return std_init(sr_ctx, di, LOG_PREFIX);
 }
 
-static void generate_analog_pattern(struct analog_gen *ag, uint64_t sample_rate)
+static int generate_analog_pattern(struct analog_gen *ag, uint64_t sample_rate)
 {
 	double t, frequency;
 	float value;
@@ -195,6 +225,14 @@ static void generate_analog_pattern(struct analog_gen *ag, uint64_t sample_rate)
 
 	num_samples = ANALOG_BUFSIZE / sizeof(float);
 
+	g_free(ag->pattern_data);
+	ag->pattern_data = g_try_malloc((num_samples + ANALOG_PACKET_SAMPLES)
+			* sizeof(float));
+	if (!ag->pattern_data) {
+		sr_err("Analog pattern malloc failed.");
+		return SR_ERR_MALLOC;
+	}
+
 	switch (ag->pattern) {
 	case PATTERN_SQUARE:
 		value = ag->amplitude;
@@ -255,6 +293,82 @@ static void generate_analog_pattern(struct analog_gen *ag, uint64_t sample_rate)
 		ag->num_samples = num_samples;
 		break;
 	}
+
+	/* Any packet starting within the pattern can be sent in one go. */
+	for (i = 0; i < ANALOG_PACKET_SAMPLES; i++)
+		ag->pattern_data[ag->num_samples + i] =
+			ag->pattern_data[i % ag->num_samples];
+
+	return SR_OK;
+}
+
+static uint8_t logic_pattern_byte(struct dev_context *devc, uint64_t sample,
+		unsigned int byte)
+{
+	switch (devc->logic_pattern) {
+	case PATTERN_SIGROK:
+		return ~(pattern_sigrok[(sample + byte)
+				% sizeof(pattern_sigrok)] >> 1);
+	case PATTERN_RANDOM:
+		return rand() & 0xff;
+	case PATTERN_INC:
+		return sample & 0xff;
+	case PATTERN_ALL_HIGH:
+		return 0xff;
+	case PATTERN_ALL_LOW:
+	default:
+		return 0x00;
+	}
+}
+
+/*
+ * Generate one period of the logic pattern, followed by a copy of its
+ * start, so that any packet starting within the period is contiguous.
+ */
+static int generate_logic_pattern(struct dev_context *devc)
+{
+	uint64_t period, i, len, done;
+	unsigned int j, unitsize;
+	uint8_t *p;
+
+	switch (devc->logic_pattern) {
+	case PATTERN_SIGROK:
+		period = sizeof(pattern_sigrok);
+		break;
+	case PATTERN_RANDOM:
+		period = RANDOM_RING_SAMPLES;
+		break;
+	case PATTERN_INC:
+		period = 256;
+		break;
+	default:
+		period = 1;
+		break;
+	}
+
+	unitsize = devc->logic_unitsize;
+	if (unitsize == 0)
+		return SR_OK;
+	len = (period + devc->packet_samples) * unitsize;
+	g_free(devc->logic_ring);
+	if (!(devc->logic_ring = g_try_malloc(len))) {
+		sr_err("Logic pattern malloc failed.");
+		return SR_ERR_MALLOC;
+	}
+
+	p = devc->logic_ring;
+	for (i = 0; i < period; i++)
+		for (j = 0; j < unitsize; j++)
+			*p++ = logic_pattern_byte(devc, i, j);
+	for (done = period * unitsize; done < len; done *= 2)
+		memcpy(devc->logic_ring + done, devc->logic_ring,
+			MIN(done, len - done));
+
+	devc->logic_ring_samples = period;
+	devc->logic_pos = 0;
+	devc->logic_ring_stale = FALSE;
+
+	return SR_OK;
 }
 
 static GSList *scan(struct sr_dev_driver *di, GSList *options)
@@ -267,13 +381,15 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 	struct sr_config *src;
 	struct analog_gen *ag;
 	GSList *devices, *l;
-	int num_logic_channels, num_analog_channels, pattern, i;
+	int num_logic_channels, num_analog_channels, num_devices;
+	int pattern, i, n;
 	char channel_name[16];
 
 	drvc = di->context;
 
 	num_logic_channels = DEFAULT_NUM_LOGIC_CHANNELS;
 	num_analog_channels = DEFAULT_NUM_ANALOG_CHANNELS;
+	num_devices = 1;
 	for (l = options; l; l = l->next) {
 		src = l->data;
 		switch (src->key) {
@@ -283,74 +399,85 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 		case SR_CONF_NUM_ANALOG_CHANNELS:
 			num_analog_channels = g_variant_get_int32(src->data);
 			break;
+		case SR_CONF_NUM_DEVICES:
+			num_devices = g_variant_get_int32(src->data);
+			break;
 		}
 	}
 
 	devices = NULL;
 
-	sdi = g_malloc0(sizeof(struct sr_dev_inst));
-	sdi->status = SR_ST_ACTIVE;
-	sdi->model = g_strdup("Demo device");
-	sdi->driver = di;
-
-	devc = g_malloc0(sizeof(struct dev_context));
-	devc->cur_samplerate = SR_KHZ(200);
-	devc->num_logic_channels = num_logic_channels;
-	devc->logic_unitsize = (devc->num_logic_channels + 7) / 8;
-	devc->logic_pattern = PATTERN_SIGROK;
-	devc->num_analog_channels = num_analog_channels;
-
-	/* Logic channels, all in one channel group. */
-	cg = g_malloc0(sizeof(struct sr_channel_group));
-	cg->name = g_strdup("Logic");
-	for (i = 0; i < num_logic_channels; i++) {
-		sprintf(channel_name, "D%d", i);
-		ch = sr_channel_new(sdi, i, SR_CHANNEL_LOGIC, TRUE, channel_name);
-		cg->channels = g_slist_append(cg->channels, ch);
-	}
-	sdi->channel_groups = g_slist_append(NULL, cg);
-
-	/* Analog channels, channel groups and pattern generators. */
-	pattern = 0;
-	/* An "Analog" channel group with all analog channels in it. */
-	acg = g_malloc0(sizeof(struct sr_channel_group));
-	acg->name = g_strdup("Analog");
-	sdi->channel_groups = g_slist_append(sdi->channel_groups, acg);
-
-	devc->ch_ag = g_hash_table_new(g_direct_hash, g_direct_equal);
-	for (i = 0; i < num_analog_channels; i++) {
-		snprintf(channel_name, 16, "A%d", i);
-		ch = sr_channel_new(sdi, i + num_logic_channels, SR_CHANNEL_ANALOG,
-				TRUE, channel_name);
-		acg->channels = g_slist_append(acg->channels, ch);
-
-		/* Every analog channel gets its own channel group as well. */
+	for (n = 0; n < num_devices; n++) {
+		sdi = g_malloc0(sizeof(struct sr_dev_inst));
+		sdi->status = SR_ST_ACTIVE;
+		sdi->model = g_strdup("Demo device");
+		sdi->driver = di;
+		/* Tell multiple devices apart. */
+		if (num_devices > 1)
+			sdi->connection_id = g_strdup_printf("demo%d", n);
+
+		devc = g_malloc0(sizeof(struct dev_context));
+		devc->cur_samplerate = SR_KHZ(200);
+		devc->packet_size = LOGIC_BUFSIZE;
+		devc->num_logic_channels = num_logic_channels;
+		devc->logic_unitsize = (devc->num_logic_channels + 7) / 8;
+		devc->logic_pattern = PATTERN_SIGROK;
+		devc->num_analog_channels = num_analog_channels;
+
+		/* Logic channels, all in one channel group. */
 		cg = g_malloc0(sizeof(struct sr_channel_group));
-		cg->name = g_strdup(channel_name);
-		cg->channels = g_slist_append(NULL, ch);
-		sdi->channel_groups = g_slist_append(sdi->channel_groups, cg);
-
-		/* Every channel gets a generator struct. */
-		ag = g_malloc(sizeof(struct analog_gen));
-		ag->amplitude = DEFAULT_ANALOG_AMPLITUDE;
-		ag->packet.channels = cg->channels;
-		ag->packet.mq = 0;
-		ag->packet.mqflags = 0;
-		ag->packet.unit = SR_UNIT_VOLT;
-		ag->packet.data = ag->pattern_data;
-		ag->pattern = pattern;
-		ag->avg_val = 0.0f;
-		ag->num_avgs = 0;
-		g_hash_table_insert(devc->ch_ag, ch, ag);
+		cg->name = g_strdup("Logic");
+		for (i = 0; i < num_logic_channels; i++) {
+			sprintf(channel_name, "D%d", i);
+			ch = sr_channel_new(sdi, i, SR_CHANNEL_LOGIC, TRUE, channel_name);
+			cg->channels = g_slist_append(cg->channels, ch);
+		}
+		sdi->channel_groups = g_slist_append(NULL, cg);
+
+		/* Analog channels, channel groups and pattern generators. */
+		pattern = 0;
+		/* An "Analog" channel group with all analog channels in it. */
+		acg = g_malloc0(sizeof(struct sr_channel_group));
+		acg->name = g_strdup("Analog");
+		sdi->channel_groups = g_slist_append(sdi->channel_groups, acg);
+
+		devc->ch_ag = g_hash_table_new(g_direct_hash, g_direct_equal);
+		for (i = 0; i < num_analog_channels; i++) {
+			snprintf(channel_name, 16, "A%d", i);
+			ch = sr_channel_new(sdi, i + num_logic_channels, SR_CHANNEL_ANALOG,
+					TRUE, channel_name);
+			acg->channels = g_slist_append(acg->channels, ch);
+
+			/* Every analog channel gets its own channel group as well. */
+			cg = g_malloc0(sizeof(struct sr_channel_group));
+			cg->name = g_strdup(channel_name);
+			cg->channels = g_slist_append(NULL, ch);
+			sdi->channel_groups = g_slist_append(sdi->channel_groups, cg);
+
+			/* Every channel gets a generator struct. */
+			ag = g_malloc(sizeof(struct analog_gen));
+			ag->amplitude = DEFAULT_ANALOG_AMPLITUDE;
+			ag->packet.channels = cg->channels;
+			ag->packet.mq = 0;
+			ag->packet.mqflags = 0;
+			ag->packet.unit = SR_UNIT_VOLT;
+			/* Generated at acquisition start. */
+			ag->pattern_data = NULL;
+			ag->packet.data = NULL;
+			ag->pattern = pattern;
+			ag->avg_val = 0.0f;
+			ag->num_avgs = 0;
+			g_hash_table_insert(devc->ch_ag, ch, ag);
+
+			if (++pattern == ARRAY_SIZE(analog_pattern_str))
+				pattern = 0;
+		}
 
-		if (++pattern == ARRAY_SIZE(analog_pattern_str))
-			pattern = 0;
+		sdi->priv = devc;
+		devices = g_slist_append(devices, sdi);
+		drvc->instances = g_slist_append(drvc->instances, sdi);
 	}
 
-	sdi->priv = devc;
-	devices = g_slist_append(devices, sdi);
-	drvc->instances = g_slist_append(drvc->instances, sdi);
-
 	return devices;
 }
 
@@ -376,6 +503,7 @@ static int dev_close(struct sr_dev_inst *sdi)
 static void clear_helper(void *priv)
 {
 	struct dev_context *devc;
+	struct analog_gen *ag;
 	GHashTableIter iter;
 	void *value;
 
@@ -383,9 +511,13 @@ static void clear_helper(void *priv)
 
 	/* Analog generators. */
 	g_hash_table_iter_init(&iter, devc->ch_ag);
-	while (g_hash_table_iter_next(&iter, NULL, &value))
-		g_free(value);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		ag = value;
+		g_free(ag->pattern_data);
+		g_free(ag);
+	}
 	g_hash_table_unref(devc->ch_ag);
+	g_free(devc->logic_ring);
 	g_free(devc);
 }
 
@@ -422,6 +554,12 @@ static int config_get(uint32_t key, GVariant **data, const struct sr_dev_inst *s
 	case SR_CONF_AVG_SAMPLES:
 		*data = g_variant_new_uint64(devc->avg_samples);
 		break;
+	case SR_CONF_BUFFERSIZE:
+		*data = g_variant_new_uint64(devc->packet_size);
+		break;
+	case SR_CONF_UNTHROTTLED:
+		*data = g_variant_new_boolean(devc->unthrottled);
+		break;
 	case SR_CONF_PATTERN_MODE:
 		if (!cg)
 			return SR_ERR_CHANNEL_GROUP;
@@ -463,6 +601,7 @@ static int config_set(uint32_t key, GVariant *data, const struct sr_dev_inst *sd
 	GSList *l;
 	int logic_pattern, analog_pattern, ret;
 	unsigned int i;
+	uint64_t size;
 	const char *stropt;
 
 	devc = sdi->priv;
@@ -491,6 +630,17 @@ static int config_set(uint32_t key, GVariant *data, const struct sr_dev_inst *sd
 		devc->avg_samples = g_variant_get_uint64(data);
 		sr_dbg("Setting averaging rate to %" PRIu64, devc->avg_samples);
 		break;
+	case SR_CONF_BUFFERSIZE:
+		size = g_variant_get_uint64(data);
+		if (size == 0 || size > MAX_LOGIC_BUFSIZE)
+			return SR_ERR_ARG;
+		devc->packet_size = size;
+		break;
+	case SR_CONF_UNTHROTTLED:
+		devc->unthrottled = g_variant_get_boolean(data);
+		sr_dbg("%s unthrottled mode",
+				devc->unthrottled ? "Enabling" : "Disabling");
+		break;
 	case SR_CONF_PATTERN_MODE:
 		if (!cg)
 			return SR_ERR_CHANNEL_GROUP;
@@ -518,11 +668,7 @@ static int config_set(uint32_t key, GVariant *data, const struct sr_dev_inst *sd
 				sr_dbg("Setting logic pattern to %s",
 						logic_pattern_str[logic_pattern]);
 				devc->logic_pattern = logic_pattern;
-				/* Might as well do this now, these are static. */
-				if (logic_pattern == PATTERN_ALL_LOW)
-					memset(devc->logic_data, 0x00, LOGIC_BUFSIZE);
-				else if (logic_pattern == PATTERN_ALL_HIGH)
-					memset(devc->logic_data, 0xff, LOGIC_BUFSIZE);
+				devc->logic_ring_stale = TRUE;
 			} else if (ch->type == SR_CHANNEL_ANALOG) {
 				if (analog_pattern == -1)
 					return SR_ERR_ARG;
@@ -633,47 +779,6 @@ static int config_list(uint32_t key, GVariant **data, const struct sr_dev_inst *
 	return SR_OK;
 }
 
-static void logic_generator(struct sr_dev_inst *sdi, uint64_t size)
-{
-	struct dev_context *devc;
-	uint64_t i, j;
-	uint8_t pat;
-
-	devc = sdi->priv;
-
-	switch (devc->logic_pattern) {
-	case PATTERN_SIGROK:
-		memset(devc->logic_data, 0x00, size);
-		for (i = 0; i < size; i += devc->logic_unitsize) {
-			for (j = 0; j < devc->logic_unitsize; j++) {
-				pat = pattern_sigrok[(devc->step + j) % sizeof(pattern_sigrok)] >> 1;
-				devc->logic_data[i + j] = ~pat;
-			}
-			devc->step++;
-		}
-		break;
-	case PATTERN_RANDOM:
-		for (i = 0; i < size; i++)
-			devc->logic_data[i] = (uint8_t)(rand() & 0xff);
-		break;
-	case PATTERN_INC:
-		for (i = 0; i < size; i++) {
-			for (j = 0; j < devc->logic_unitsize; j++) {
-				devc->logic_data[i + j] = devc->step;
-			}
-			devc->step++;
-		}
-		break;
-	case PATTERN_ALL_LOW:
-	case PATTERN_ALL_HIGH:
-		/* These were set when the pattern mode was selected. */
-		break;
-	default:
-		sr_err("Unknown pattern: %d.", devc->logic_pattern);
-		break;
-	}
-}
-
 static void send_analog_packet(struct analog_gen *ag,
 			       struct sr_dev_inst *sdi,
 			       uint64_t *analog_sent,
@@ -691,8 +796,10 @@ static void send_analog_packet(struct analog_gen *ag,
 	packet.payload = &ag->packet;
 
 	if (!devc->avg) {
+		/* The pattern extends a packet beyond its end. */
 		ag_pattern_pos = analog_pos % ag->num_samples;
-		sending_now = MIN(analog_todo, ag->num_samples-ag_pattern_pos);
+		sending_now = MIN(analog_todo,
+				MIN(devc->packet_samples, ANALOG_PACKET_SAMPLES));
 		ag->packet.data = ag->pattern_data + ag_pattern_pos;
 		ag->packet.num_samples = sending_now;
 		sr_session_send(sdi, &packet);
@@ -769,9 +876,18 @@ static int prepare_data(int fd, int revents, void *cb_data)
 	else
 		todo_us = MAX(0, elapsed_us - devc->spent_us);
 
-	/* How many samples are outstanding since the last round? */
-	samples_todo = (todo_us * devc->cur_samplerate + G_USEC_PER_SEC - 1)
-			/ G_USEC_PER_SEC;
+	if (devc->unthrottled) {
+		/*
+		 * Send a burst of whole packets per round, regardless of
+		 * the samplerate. The session loop paces us.
+		 */
+		samples_todo = MAX(1, UNTHROTTLED_BURST / devc->packet_samples)
+				* devc->packet_samples;
+	} else {
+		/* How many samples are outstanding since the last round? */
+		samples_todo = (todo_us * devc->cur_samplerate + G_USEC_PER_SEC - 1)
+				/ G_USEC_PER_SEC;
+	}
 	if (devc->limit_samples > 0) {
 		if (devc->limit_samples < devc->sent_samples)
 			samples_todo = 0;
@@ -782,7 +898,14 @@ static int prepare_data(int fd, int revents, void *cb_data)
 	 * count, rounded towards zero. This avoids getting stuck on a too-low
 	 * time delta with no samples being sent due to round-off.
 	 */
-	todo_us = samples_todo * G_USEC_PER_SEC / devc->cur_samplerate;
+	if (!devc->unthrottled)
+		todo_us = samples_todo * G_USEC_PER_SEC / devc->cur_samplerate;
+
+	/* Pick up a pattern change made while running. */
+	if (devc->logic_ring_stale && generate_logic_pattern(devc) != SR_OK) {
+		dev_acquisition_stop(sdi, sdi);
+		return G_SOURCE_CONTINUE;
+	}
 
 	logic_done = 0;
 	analog_done = 0;
@@ -791,14 +914,16 @@ static int prepare_data(int fd, int revents, void *cb_data)
 		/* Logic */
 		if (logic_done < samples_todo) {
 			sending_now = MIN(samples_todo - logic_done,
-					LOGIC_BUFSIZE / devc->logic_unitsize);
-			logic_generator(sdi, sending_now * devc->logic_unitsize);
+					devc->packet_samples);
 			packet.type = SR_DF_LOGIC;
 			packet.payload = &logic;
 			logic.length = sending_now * devc->logic_unitsize;
 			logic.unitsize = devc->logic_unitsize;
-			logic.data = devc->logic_data;
+			logic.data = devc->logic_ring
+					+ devc->logic_pos * devc->logic_unitsize;
 			sr_session_send(sdi, &packet);
+			devc->logic_pos = (devc->logic_pos + sending_now)
+					% devc->logic_ring_samples;
 			logic_done += sending_now;
 		}
 
@@ -825,6 +950,10 @@ static int prepare_data(int fd, int revents, void *cb_data)
 	devc->sent_samples += samples_todo;
 	devc->spent_us += todo_us;
 
+	/* Unthrottled, a time limit is wall clock time. */
+	if (devc->unthrottled)
+		devc->spent_us = elapsed_us;
+
 	if ((devc->limit_samples > 0 && devc->sent_samples >= devc->limit_samples)
 			|| (limit_us > 0 && devc->spent_us >= limit_us)) {
 
@@ -852,6 +981,7 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi, void *cb_data)
 	struct dev_context *devc;
 	GHashTableIter iter;
 	void *value;
+	int ret;
 
 	(void)cb_data;
 
@@ -860,12 +990,24 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi, void *cb_data)
 
 	devc = sdi->priv;
 	devc->sent_samples = 0;
+	devc->packet_samples = MAX(1, devc->packet_size
+			/ MAX(1, devc->logic_unitsize));
 
+	if ((ret = generate_logic_pattern(devc)) != SR_OK)
+		return ret;
 	g_hash_table_iter_init(&iter, devc->ch_ag);
-	while (g_hash_table_iter_next(&iter, NULL, &value))
-		generate_analog_pattern(value, devc->cur_samplerate);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		ret = generate_analog_pattern(value, devc->cur_samplerate);
+		if (ret != SR_OK)
+			return ret;
+	}
 
-	sr_session_source_add(sdi->session, -1, 0, 100,
+	/*
+	 * Keyed by device rather than by fd, so that several demo devices
+	 * can run in the same session.
+	 */
+	sr_session_fd_source_add(sdi->session, (void *)sdi, -1, 0,
+			devc->unthrottled ? 0 : 100,
 			prepare_data, (struct sr_dev_inst *)sdi);
 
 	/* Send header packet to the session bus. */
@@ -880,13 +1022,22 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi, void *cb_data)
 
 static int dev_acquisition_stop(struct sr_dev_inst *sdi, void *cb_data)
 {
+	struct dev_context *devc;
 	struct sr_datafeed_packet packet;
+	int64_t elapsed_us;
 
 	(void)cb_data;
 
+	devc = sdi->priv;
+
 	sr_dbg("Stopping acquisition.");
 
-	sr_session_source_remove(sdi->session, -1);
+	sr_session_source_remove_internal(sdi->session, (void *)sdi);
+
+	elapsed_us = MAX(1, g_get_monotonic_time() - devc->start_us);
+	sr_info("Sent %" PRIu64 " samples in %" PRIi64 " ms (%.3f MS/s).",
+			devc->sent_samples, elapsed_us / 1000,
+			(double)devc->sent_samples / elapsed_us);
 
 	/* Send last packet. */
 	packet.type = SR_DF_END;
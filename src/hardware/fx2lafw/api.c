@@ -131,6 +131,8 @@ static const uint32_t devopts[] = {
 	SR_CONF_SAMPLERATE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
 	SR_CONF_TRIGGER_MATCH | SR_CONF_LIST,
 	SR_CONF_CAPTURE_RATIO | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_BUFFER_OVERRUNS | SR_CONF_GET,
+	SR_CONF_BUFFER_UNDERRUNS | SR_CONF_GET,
 };
 
 static const char *channel_names[] = {
@@ -458,14 +460,42 @@ static int dev_open(struct sr_dev_inst *sdi)
 
 static int dev_close(struct sr_dev_inst *sdi)
 {
+	struct sr_dev_driver *di;
+	struct drv_context *drvc;
+	struct dev_context *devc;
 	struct sr_usb_dev_inst *usb;
+	struct timeval tv;
+	int64_t deadline;
 
+	di = sdi->driver;
+	drvc = di->context;
+	devc = sdi->priv;
 	usb = sdi->conn;
 	if (!usb->devhdl)
 		return SR_ERR;
 
 	sr_info("fx2lafw: Closing device on %d.%d (logical) / %s (physical) interface %d.",
 		usb->bus, usb->address, sdi->connection_id, USB_INTERFACE);
+
+	/*
+	 * Transfers cancelled by stopping the acquisition may not have
+	 * come back yet, and they still point into the buffer pool.
+	 */
+	deadline = g_get_monotonic_time() + CLOSE_TIMEOUT_MS * 1000;
+	while (devc->submitted_transfers > 0
+			&& g_get_monotonic_time() < deadline) {
+		tv.tv_sec = 0;
+		tv.tv_usec = 10 * 1000;
+		libusb_handle_events_timeout(drvc->sr_ctx->libusb_ctx, &tv);
+	}
+	if (devc->submitted_transfers > 0) {
+		/* Rather leak the buffers than have the kernel write to them. */
+		sr_warn("%d transfers still pending, not freeing their buffers.",
+			devc->submitted_transfers);
+		devc->pool_malloc = NULL;
+		devc->pool_dev_mem = FALSE;
+	}
+	fx2lafw_pool_free(sdi);
 	libusb_release_interface(usb->devhdl, USB_INTERFACE);
 	libusb_close(usb->devhdl);
 	usb->devhdl = NULL;
@@ -524,6 +554,12 @@ static int config_get(uint32_t key, GVariant **data, const struct sr_dev_inst *s
 	case SR_CONF_CAPTURE_RATIO:
 		*data = g_variant_new_uint64(devc->capture_ratio);
 		break;
+	case SR_CONF_BUFFER_OVERRUNS:
+		*data = g_variant_new_uint64(devc->buffer_overruns);
+		break;
+	case SR_CONF_BUFFER_UNDERRUNS:
+		*data = g_variant_new_uint64(devc->buffer_underruns);
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -639,16 +675,12 @@ static int receive_data(int fd, int revents, void *cb_data)
 static int start_transfers(const struct sr_dev_inst *sdi)
 {
 	struct dev_context *devc;
-	struct sr_usb_dev_inst *usb;
 	struct sr_trigger *trigger;
-	struct libusb_transfer *transfer;
 	unsigned int i, num_transfers;
-	int endpoint, timeout, ret;
-	unsigned char *buf;
+	int ret;
 	size_t size;
 
 	devc = sdi->priv;
-	usb = sdi->conn;
 
 	devc->sent_samples = 0;
 	devc->acq_aborted = FALSE;
@@ -668,35 +700,31 @@ static int start_transfers(const struct sr_dev_inst *sdi)
 	num_transfers = fx2lafw_get_number_of_transfers(devc);
 	size = fx2lafw_get_buffer_size(devc);
 	devc->submitted_transfers = 0;
+	devc->active_transfers = 0;
+	devc->num_transfers = 0;
 
-	devc->transfers = g_try_malloc0(sizeof(*devc->transfers) * num_transfers);
+	if ((ret = fx2lafw_pool_alloc(sdi, size * POOL_GROWTH_FACTOR,
+			num_transfers * POOL_GROWTH_FACTOR)) != SR_OK)
+		return ret;
+
+	devc->transfers = g_try_malloc0(sizeof(*devc->transfers) * devc->pool_size);
 	if (!devc->transfers) {
 		sr_err("USB transfers malloc failed.");
 		return SR_ERR_MALLOC;
 	}
 
-	timeout = fx2lafw_get_timeout(devc);
-	endpoint = devc->dslogic ? 6 : 2;
-	devc->num_transfers = num_transfers;
+	devc->base_transfer_size = size;
+	devc->transfer_size = size;
+	devc->transfer_timeout = fx2lafw_get_timeout(devc);
+	devc->consumer_time = 0;
+	devc->buffer_overruns = 0;
+	devc->buffer_underruns = 0;
+
 	for (i = 0; i < num_transfers; i++) {
-		if (!(buf = g_try_malloc(size))) {
-			sr_err("USB transfer buffer malloc failed.");
-			return SR_ERR_MALLOC;
-		}
-		transfer = libusb_alloc_transfer(0);
-		libusb_fill_bulk_transfer(transfer, usb->devhdl,
-				endpoint | LIBUSB_ENDPOINT_IN, buf, size,
-				fx2lafw_receive_transfer, (void *)sdi, timeout);
-		if ((ret = libusb_submit_transfer(transfer)) != 0) {
-			sr_err("Failed to submit transfer: %s.",
-			       libusb_error_name(ret));
-			libusb_free_transfer(transfer);
-			g_free(buf);
+		if ((ret = fx2lafw_add_transfer(sdi)) != SR_OK) {
 			fx2lafw_abort_acquisition(devc);
-			return SR_ERR;
+			return ret;
 		}
-		devc->transfers[i] = transfer;
-		devc->submitted_transfers++;
 	}
 
 	/* Send header packet to the session bus. */
@@ -353,7 +353,7 @@ static void free_transfer(struct libusb_transfer *transfer)
 	sdi = transfer->user_data;
 	devc = sdi->priv;
 
-	g_free(transfer->buffer);
+	/* The buffer belongs to the pool. */
 	transfer->buffer = NULL;
 	libusb_free_transfer(transfer);
 
@@ -371,16 +371,215 @@ static void free_transfer(struct libusb_transfer *transfer)
 
 static void resubmit_transfer(struct libusb_transfer *transfer)
 {
+	struct sr_dev_inst *sdi;
+	struct dev_context *devc;
 	int ret;
 
-	if ((ret = libusb_submit_transfer(transfer)) == LIBUSB_SUCCESS)
+	sdi = transfer->user_data;
+	devc = sdi->priv;
+
+	/* Pick up any changes made by adapt_transfers(). */
+	transfer->length = devc->transfer_size;
+	transfer->timeout = devc->transfer_timeout;
+
+	if ((ret = libusb_submit_transfer(transfer)) == LIBUSB_SUCCESS) {
+		devc->active_transfers++;
 		return;
+	}
 
 	sr_err("%s: %s", __func__, libusb_error_name(ret));
 	free_transfer(transfer);
 
 }
 
+static unsigned int to_bytes_per_ms(unsigned int samplerate)
+{
+	return samplerate / 1000;
+}
+
+/* The rate at which the device fills the transfers. */
+static unsigned int transfer_bytes_per_ms(const struct dev_context *devc)
+{
+	return to_bytes_per_ms(devc->cur_samplerate) * (devc->sample_wide ? 2 : 1);
+}
+
+SR_PRIV int fx2lafw_pool_alloc(const struct sr_dev_inst *sdi,
+		size_t buffer_size, unsigned int num_buffers)
+{
+	struct dev_context *devc;
+	struct sr_usb_dev_inst *usb;
+	size_t total;
+
+	devc = sdi->priv;
+	usb = sdi->conn;
+
+	/* Page aligned buffers, so that each can be mapped on its own. */
+	buffer_size = (buffer_size + POOL_ALIGNMENT - 1) & ~(POOL_ALIGNMENT - 1);
+
+	if (devc->pool && devc->pool_buffer_size == buffer_size
+			&& devc->pool_size >= num_buffers)
+		return SR_OK;
+
+	fx2lafw_pool_free(sdi);
+
+	total = buffer_size * num_buffers;
+
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+	/*
+	 * Where the kernel supports it, let the USB stack DMA straight
+	 * into the buffers instead of copying the data out of its own.
+	 */
+	devc->pool = libusb_dev_mem_alloc(usb->devhdl, total);
+	if (devc->pool) {
+		devc->pool_dev_mem = TRUE;
+		sr_dbg("Using %zu bytes of device memory for transfers.", total);
+	}
+#else
+	(void)usb;
+#endif
+
+	if (!devc->pool) {
+		devc->pool_malloc = g_try_malloc(total + POOL_ALIGNMENT - 1);
+		if (!devc->pool_malloc) {
+			sr_err("USB transfer buffer pool malloc failed.");
+			return SR_ERR_MALLOC;
+		}
+		devc->pool = (unsigned char *)(((uintptr_t)devc->pool_malloc
+			+ POOL_ALIGNMENT - 1) & ~(uintptr_t)(POOL_ALIGNMENT - 1));
+	}
+
+	devc->pool_buffer_size = buffer_size;
+	devc->pool_size = num_buffers;
+
+	return SR_OK;
+}
+
+SR_PRIV void fx2lafw_pool_free(const struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	struct sr_usb_dev_inst *usb;
+
+	devc = sdi->priv;
+	usb = sdi->conn;
+
+	if (!devc->pool)
+		return;
+
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+	if (devc->pool_dev_mem)
+		libusb_dev_mem_free(usb->devhdl, devc->pool,
+			devc->pool_buffer_size * devc->pool_size);
+#else
+	(void)usb;
+#endif
+
+	g_free(devc->pool_malloc);
+	devc->pool_malloc = NULL;
+	devc->pool = NULL;
+	devc->pool_dev_mem = FALSE;
+	devc->pool_buffer_size = 0;
+	devc->pool_size = 0;
+}
+
+static void update_transfer_timeout(struct dev_context *devc)
+{
+	unsigned int bytes_per_ms, timeout;
+
+	bytes_per_ms = transfer_bytes_per_ms(devc);
+	if (!bytes_per_ms)
+		return;
+
+	timeout = devc->transfer_size * MAX(devc->num_transfers, 1) / bytes_per_ms;
+	devc->transfer_timeout = timeout + timeout / 4;
+}
+
+/* Queue a transfer using the next unused buffer of the pool. */
+SR_PRIV int fx2lafw_add_transfer(const struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	struct sr_usb_dev_inst *usb;
+	struct libusb_transfer *transfer;
+	unsigned int i;
+	int endpoint, ret;
+
+	devc = sdi->priv;
+	usb = sdi->conn;
+
+	i = devc->num_transfers;
+	if (i >= devc->pool_size)
+		return SR_ERR;
+
+	if (!(transfer = libusb_alloc_transfer(0)))
+		return SR_ERR_MALLOC;
+
+	endpoint = devc->dslogic ? 6 : 2;
+	libusb_fill_bulk_transfer(transfer, usb->devhdl,
+			endpoint | LIBUSB_ENDPOINT_IN,
+			devc->pool + i * devc->pool_buffer_size,
+			devc->transfer_size, fx2lafw_receive_transfer,
+			(void *)sdi, devc->transfer_timeout);
+	if ((ret = libusb_submit_transfer(transfer)) != 0) {
+		sr_err("Failed to submit transfer: %s.",
+		       libusb_error_name(ret));
+		libusb_free_transfer(transfer);
+		return SR_ERR;
+	}
+
+	devc->transfers[i] = transfer;
+	devc->num_transfers++;
+	devc->submitted_transfers++;
+	devc->active_transfers++;
+
+	return SR_OK;
+}
+
+/*
+ * Adapt the transfers to the time the session took to process the last
+ * one. When that is a large share of the time it takes the device to
+ * fill a transfer, or the queue ran dry, queue another transfer so that
+ * the device always has a buffer to write to, and make the transfers
+ * larger so that the per-packet cost is spread over more samples. Make
+ * them smaller again when the device doesn't fill them.
+ */
+static void adapt_transfers(const struct sr_dev_inst *sdi,
+		gboolean overrun, gboolean underrun, int64_t elapsed)
+{
+	struct dev_context *devc;
+	unsigned int bytes_per_ms;
+	int64_t period;
+	size_t size;
+
+	devc = sdi->priv;
+
+	devc->consumer_time = (devc->consumer_time * 7 + elapsed) / 8;
+
+	bytes_per_ms = transfer_bytes_per_ms(devc);
+	if (!bytes_per_ms)
+		return;
+	period = (int64_t)devc->transfer_size * 1000 / bytes_per_ms;
+
+	size = devc->transfer_size;
+	if (devc->consumer_time > period / 4)
+		size = MIN(size * 2, devc->pool_buffer_size);
+	else if (underrun)
+		size = MAX(size / 2, devc->base_transfer_size);
+	if (size != devc->transfer_size) {
+		sr_dbg("Transfer size %zu -> %zu bytes (consumer %" PRIi64
+			" us per transfer).", devc->transfer_size, size,
+			devc->consumer_time);
+		devc->transfer_size = size;
+		update_transfer_timeout(devc);
+	}
+
+	if ((overrun || devc->consumer_time > period / 2)
+			&& devc->num_transfers < devc->pool_size) {
+		if (fx2lafw_add_transfer(sdi) == SR_OK) {
+			sr_dbg("Queueing %u transfers.", devc->num_transfers);
+			update_transfer_timeout(devc);
+		}
+	}
+}
+
 SR_PRIV void LIBUSB_CALL fx2lafw_receive_transfer(struct libusb_transfer *transfer)
 {
 	struct sr_dev_inst *sdi;
@@ -391,10 +590,15 @@ SR_PRIV void LIBUSB_CALL fx2lafw_receive_transfer(struct libusb_transfer *transf
 	unsigned int num_samples;
 	int trigger_offset, cur_sample_count, unitsize;
 	int pre_trigger_samples;
+	gboolean overrun, underrun;
+	int64_t start;
 
 	sdi = transfer->user_data;
 	devc = sdi->priv;
 
+	/* This one is back from the device. */
+	devc->active_transfers--;
+
 	/*
 	 * If acquisition has already ended, just free any queued up
 	 * transfer that come in.
@@ -407,6 +611,9 @@ SR_PRIV void LIBUSB_CALL fx2lafw_receive_transfer(struct libusb_transfer *transf
 	sr_dbg("receive_transfer(): status %s received %d bytes.",
 		libusb_error_name(transfer->status), transfer->actual_length);
 
+	/* No other transfer queued: the device had nowhere to put data. */
+	overrun = devc->active_transfers == 0;
+
 	/* Save incoming transfer before reusing the transfer struct. */
 	unitsize = devc->sample_wide ? 2 : 1;
 	cur_sample_count = transfer->actual_length / unitsize;
@@ -424,6 +631,9 @@ SR_PRIV void LIBUSB_CALL fx2lafw_receive_transfer(struct libusb_transfer *transf
 		break;
 	}
 
+	/* The device didn't have enough data to fill the buffer. */
+	underrun = transfer->actual_length < transfer->length;
+
 	if (transfer->actual_length == 0 || packet_has_error) {
 		devc->empty_transfer_count++;
 		if (devc->empty_transfer_count > MAX_EMPTY_TRANSFERS) {
@@ -441,6 +651,8 @@ SR_PRIV void LIBUSB_CALL fx2lafw_receive_transfer(struct libusb_transfer *transf
 		devc->empty_transfer_count = 0;
 	}
 
+	start = g_get_monotonic_time();
+
 	if (devc->trigger_fired) {
 		if (!devc->limit_samples || devc->sent_samples < devc->limit_samples) {
 			/* Send the incoming transfer to the session bus. */
@@ -480,13 +692,19 @@ SR_PRIV void LIBUSB_CALL fx2lafw_receive_transfer(struct libusb_transfer *transf
 	if (devc->limit_samples && devc->sent_samples >= devc->limit_samples) {
 		fx2lafw_abort_acquisition(devc);
 		free_transfer(transfer);
-	} else
+	} else {
+		/*
+		 * Only count transfers the acquisition goes on after, not
+		 * the final one, which may well be short.
+		 */
+		if (overrun)
+			devc->buffer_overruns++;
+		if (underrun)
+			devc->buffer_underruns++;
+		adapt_transfers(sdi, overrun, underrun,
+			g_get_monotonic_time() - start);
 		resubmit_transfer(transfer);
-}
-
-static unsigned int to_bytes_per_ms(unsigned int samplerate)
-{
-	return samplerate / 1000;
+	}
 }
 
 SR_PRIV size_t fx2lafw_get_buffer_size(struct dev_context *devc)
@@ -39,6 +39,16 @@
 #define NUM_SIMUL_TRANSFERS	32
 #define MAX_EMPTY_TRANSFERS	(NUM_SIMUL_TRANSFERS * 2)
 
+/*
+ * The buffer pool leaves room for the transfers to grow to twice their
+ * initial size and number while the acquisition is running.
+ */
+#define POOL_GROWTH_FACTOR	2
+#define POOL_ALIGNMENT		4096
+
+/* How long dev_close() waits for cancelled transfers to come back. */
+#define CLOSE_TIMEOUT_MS	1000
+
 #define FX2LAFW_REQUIRED_VERSION_MAJOR	1
 
 #define MAX_8BIT_SAMPLE_RATE	SR_MHZ(24)
@@ -112,6 +122,8 @@ struct dev_context {
 
 	unsigned int sent_samples;
 	int submitted_transfers;
+	/* Transfers submitted and not yet returned by the device. */
+	int active_transfers;
 	int empty_transfer_count;
 
 	void *cb_data;
@@ -119,6 +131,21 @@ struct dev_context {
 	struct libusb_transfer **transfers;
 	struct sr_context *ctx;
 
+	/* Transfer buffers, kept across acquisitions. */
+	unsigned char *pool;
+	void *pool_malloc;
+	gboolean pool_dev_mem;
+	size_t pool_buffer_size;
+	unsigned int pool_size;
+
+	/* Transfer sizing, adapted to the observed consumer latency. */
+	size_t base_transfer_size;
+	size_t transfer_size;
+	unsigned int transfer_timeout;
+	int64_t consumer_time;
+	uint64_t buffer_overruns;
+	uint64_t buffer_underruns;
+
 	/* Is this a DSLogic? */
 	gboolean dslogic;
 	uint16_t dslogic_mode;
@@ -132,6 +159,10 @@ SR_PRIV int fx2lafw_dev_open(struct sr_dev_inst *sdi, struct sr_dev_driver *di);
 SR_PRIV struct dev_context *fx2lafw_dev_new(void);
 SR_PRIV void fx2lafw_abort_acquisition(struct dev_context *devc);
 SR_PRIV void LIBUSB_CALL fx2lafw_receive_transfer(struct libusb_transfer *transfer);
+SR_PRIV int fx2lafw_pool_alloc(const struct sr_dev_inst *sdi,
+		size_t buffer_size, unsigned int num_buffers);
+SR_PRIV void fx2lafw_pool_free(const struct sr_dev_inst *sdi);
+SR_PRIV int fx2lafw_add_transfer(const struct sr_dev_inst *sdi);
 SR_PRIV size_t fx2lafw_get_buffer_size(struct dev_context *devc);
 SR_PRIV unsigned int fx2lafw_get_number_of_transfers(struct dev_context *devc);
 SR_PRIV unsigned int fx2lafw_get_timeout(struct dev_context *devc);
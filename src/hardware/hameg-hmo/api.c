@@ -39,6 +39,19 @@ static const uint32_t scanopts[] = {
 	SR_CONF_SERIALCOMM,
 };
 
+/* Settings served from the scope state, which is only changed by us. */
+static const uint32_t cached_keys[] = {
+	SR_CONF_NUM_HDIV,
+	SR_CONF_NUM_VDIV,
+	SR_CONF_TIMEBASE,
+	SR_CONF_VDIV,
+	SR_CONF_COUPLING,
+	SR_CONF_TRIGGER_SOURCE,
+	SR_CONF_TRIGGER_SLOPE,
+	SR_CONF_HORIZ_TRIGGERPOS,
+	SR_CONF_SAMPLERATE,
+};
+
 enum {
 	CG_INVALID = -1,
 	CG_NONE,
@@ -95,6 +108,7 @@ static struct sr_dev_inst *hmo_probe_serial_device(struct sr_scpi_dev_inst *scpi
 	devc = g_malloc0(sizeof(struct dev_context));
 
 	sdi->priv = devc;
+	sr_config_cache_enable(sdi, ARRAY_AND_SIZE(cached_keys), 0);
 
 	if (hmo_init_device(sdi) != SR_OK)
 		goto fail;
@@ -22,14 +22,16 @@
 #include "protocol.h"
 
 static const char *hameg_scpi_dialect[] = {
-	[SCPI_CMD_GET_DIG_DATA]		    = ":POD%d:DATA?",
+	/* Waveforms are transferred as binary blocks. */
+	[SCPI_CMD_GET_DIG_DATA]		    = ":FORM UINT,8;:POD%d:DATA?",
 	[SCPI_CMD_GET_TIMEBASE]		    = ":TIM:SCAL?",
 	[SCPI_CMD_SET_TIMEBASE]		    = ":TIM:SCAL %s",
 	[SCPI_CMD_GET_COUPLING]		    = ":CHAN%d:COUP?",
 	[SCPI_CMD_SET_COUPLING]		    = ":CHAN%d:COUP %s",
 	[SCPI_CMD_GET_SAMPLE_RATE]	    = ":ACQ:SRAT?",
 	[SCPI_CMD_GET_SAMPLE_RATE_LIVE]	    = ":%s:DATA:POINTS?",
-	[SCPI_CMD_GET_ANALOG_DATA]	    = ":CHAN%d:DATA?",
+	[SCPI_CMD_GET_ANALOG_DATA]	    = ":FORM:BORD LSBF;:FORM REAL,32;"
+					      ":CHAN%d:DATA?",
 	[SCPI_CMD_GET_VERTICAL_DIV]	    = ":CHAN%d:SCAL?",
 	[SCPI_CMD_SET_VERTICAL_DIV]	    = ":CHAN%d:SCAL %s",
 	[SCPI_CMD_GET_DIG_POD_STATE]	    = ":POD%d:STAT?",
@@ -299,60 +301,68 @@ static void scope_state_dump(const struct scope_config *config,
 		state->horiz_triggerpos);
 }
 
-static int scope_state_get_array_option(struct sr_scpi_dev_inst *scpi,
-		const char *command, const char *(*array)[], int *result)
+static int array_option_index(const char *value, const char *(*array)[],
+		int *result)
 {
-	char *tmp;
 	unsigned int i;
 
-	if (sr_scpi_get_string(scpi, command, &tmp) != SR_OK) {
-		g_free(tmp);
+	if (!value)
 		return SR_ERR;
-	}
 
 	for (i = 0; (*array)[i]; ++i) {
-		if (!g_strcmp0(tmp, (*array)[i])) {
+		if (!g_strcmp0(value, (*array)[i])) {
 			*result = i;
-			g_free(tmp);
-			tmp = NULL;
-			break;
+			return SR_OK;
 		}
 	}
 
-	if (tmp) {
-		g_free(tmp);
-		return SR_ERR;
-	}
-
-	return SR_OK;
+	return SR_ERR;
 }
 
-static int analog_channel_state_get(struct sr_scpi_dev_inst *scpi,
-				    const struct scope_config *config,
-				    struct scope_state *state)
+/* Responses to the state queries which need a lookup in the model tables. */
+struct scope_state_responses {
+	float *vdivs;
+	char **couplings;
+	float timebase;
+	float horiz_triggerpos;
+	char *trigger_source;
+	char *trigger_slope;
+};
+
+static void analog_channel_state_add(struct sr_scpi_batch *batch,
+				     const struct scope_config *config,
+				     struct scope_state *state,
+				     struct scope_state_responses *resp)
 {
-	unsigned int i, j;
-	float tmp_float;
-	char command[MAX_COMMAND_SIZE];
+	unsigned int i;
 
 	for (i = 0; i < config->analog_channels; ++i) {
-		g_snprintf(command, sizeof(command),
-			   (*config->scpi_dialect)[SCPI_CMD_GET_ANALOG_CHAN_STATE],
-			   i + 1);
-
-		if (sr_scpi_get_bool(scpi, command,
-				     &state->analog_channels[i].state) != SR_OK)
-			return SR_ERR;
+		sr_scpi_batch_add_bool(batch, &state->analog_channels[i].state,
+			(*config->scpi_dialect)[SCPI_CMD_GET_ANALOG_CHAN_STATE],
+			i + 1);
+		sr_scpi_batch_add_float(batch, &resp->vdivs[i],
+			(*config->scpi_dialect)[SCPI_CMD_GET_VERTICAL_DIV],
+			i + 1);
+		sr_scpi_batch_add_float(batch,
+			&state->analog_channels[i].vertical_offset,
+			(*config->scpi_dialect)[SCPI_CMD_GET_VERTICAL_OFFSET],
+			i + 1);
+		sr_scpi_batch_add_string(batch, &resp->couplings[i],
+			(*config->scpi_dialect)[SCPI_CMD_GET_COUPLING],
+			i + 1);
+	}
+}
 
-		g_snprintf(command, sizeof(command),
-			   (*config->scpi_dialect)[SCPI_CMD_GET_VERTICAL_DIV],
-			   i + 1);
+static int analog_channel_state_update(const struct scope_config *config,
+				       struct scope_state *state,
+				       const struct scope_state_responses *resp)
+{
+	unsigned int i, j;
 
-		if (sr_scpi_get_float(scpi, command, &tmp_float) != SR_OK)
-			return SR_ERR;
+	for (i = 0; i < config->analog_channels; ++i) {
 		for (j = 0; j < config->num_vdivs; j++) {
-			if (tmp_float == ((float) (*config->vdivs)[j][0] /
-					  (*config->vdivs)[j][1])) {
+			if (resp->vdivs[i] == ((float) (*config->vdivs)[j][0] /
+					       (*config->vdivs)[j][1])) {
 				state->analog_channels[i].vdiv = j;
 				break;
 			}
@@ -362,54 +372,30 @@ static int analog_channel_state_get(struct sr_scpi_dev_inst *scpi,
 			return SR_ERR;
 		}
 
-		g_snprintf(command, sizeof(command),
-			   (*config->scpi_dialect)[SCPI_CMD_GET_VERTICAL_OFFSET],
-			   i + 1);
-
-		if (sr_scpi_get_float(scpi, command,
-				     &state->analog_channels[i].vertical_offset) != SR_OK)
-			return SR_ERR;
-
-		g_snprintf(command, sizeof(command),
-			   (*config->scpi_dialect)[SCPI_CMD_GET_COUPLING],
-			   i + 1);
-
-		if (scope_state_get_array_option(scpi, command, config->coupling_options,
-					 &state->analog_channels[i].coupling) != SR_OK)
+		if (array_option_index(resp->couplings[i],
+				config->coupling_options,
+				&state->analog_channels[i].coupling) != SR_OK)
 			return SR_ERR;
 	}
 
 	return SR_OK;
 }
 
-static int digital_channel_state_get(struct sr_scpi_dev_inst *scpi,
-				     const struct scope_config *config,
-				     struct scope_state *state)
+static void digital_channel_state_add(struct sr_scpi_batch *batch,
+				      const struct scope_config *config,
+				      struct scope_state *state)
 {
 	unsigned int i;
-	char command[MAX_COMMAND_SIZE];
-
-	for (i = 0; i < config->digital_channels; ++i) {
-		g_snprintf(command, sizeof(command),
-			   (*config->scpi_dialect)[SCPI_CMD_GET_DIG_CHAN_STATE],
-			   i);
 
-		if (sr_scpi_get_bool(scpi, command,
-				     &state->digital_channels[i]) != SR_OK)
-			return SR_ERR;
-	}
+	for (i = 0; i < config->digital_channels; ++i)
+		sr_scpi_batch_add_bool(batch, &state->digital_channels[i],
+			(*config->scpi_dialect)[SCPI_CMD_GET_DIG_CHAN_STATE],
+			i);
 
-	for (i = 0; i < config->digital_pods; ++i) {
-		g_snprintf(command, sizeof(command),
-			   (*config->scpi_dialect)[SCPI_CMD_GET_DIG_POD_STATE],
-			   i + 1);
-
-		if (sr_scpi_get_bool(scpi, command,
-				     &state->digital_pods[i]) != SR_OK)
-			return SR_ERR;
-	}
-
-	return SR_OK;
+	for (i = 0; i < config->digital_pods; ++i)
+		sr_scpi_batch_add_bool(batch, &state->digital_pods[i],
+			(*config->scpi_dialect)[SCPI_CMD_GET_DIG_POD_STATE],
+			i + 1);
 }
 
 SR_PRIV int hmo_update_sample_rate(const struct sr_dev_inst *sdi)
@@ -474,34 +460,18 @@ SR_PRIV int hmo_update_sample_rate(const struct sr_dev_inst *sdi)
 	return SR_OK;
 }
 
-SR_PRIV int hmo_scope_state_get(struct sr_dev_inst *sdi)
+static int scope_state_update(const struct scope_config *config,
+			      struct scope_state *state,
+			      const struct scope_state_responses *resp)
 {
-	struct dev_context *devc;
-	struct scope_state *state;
-	const struct scope_config *config;
-	float tmp_float;
 	unsigned int i;
 
-	devc = sdi->priv;
-	config = devc->model_config;
-	state = devc->model_state;
-
-	sr_info("Fetching scope state");
-
-	if (analog_channel_state_get(sdi->conn, config, state) != SR_OK)
-		return SR_ERR;
-
-	if (digital_channel_state_get(sdi->conn, config, state) != SR_OK)
-		return SR_ERR;
-
-	if (sr_scpi_get_float(sdi->conn,
-			(*config->scpi_dialect)[SCPI_CMD_GET_TIMEBASE],
-			&tmp_float) != SR_OK)
+	if (analog_channel_state_update(config, state, resp) != SR_OK)
 		return SR_ERR;
 
 	for (i = 0; i < config->num_timebases; i++) {
-		if (tmp_float == ((float) (*config->timebases)[i][0] /
-				  (*config->timebases)[i][1])) {
+		if (resp->timebase == ((float) (*config->timebases)[i][0] /
+				       (*config->timebases)[i][1])) {
 			state->timebase = i;
 			break;
 		}
@@ -511,24 +481,70 @@ SR_PRIV int hmo_scope_state_get(struct sr_dev_inst *sdi)
 		return SR_ERR;
 	}
 
-	if (sr_scpi_get_float(sdi->conn,
-			(*config->scpi_dialect)[SCPI_CMD_GET_HORIZ_TRIGGERPOS],
-			&tmp_float) != SR_OK)
-		return SR_ERR;
-	state->horiz_triggerpos = tmp_float /
+	state->horiz_triggerpos = resp->horiz_triggerpos /
 		(((double) (*config->timebases)[state->timebase][0] /
 		  (*config->timebases)[state->timebase][1]) * config->num_xdivs);
 	state->horiz_triggerpos -= 0.5;
 	state->horiz_triggerpos *= -1;
 
-	if (scope_state_get_array_option(sdi->conn,
-			(*config->scpi_dialect)[SCPI_CMD_GET_TRIGGER_SOURCE],
-			config->trigger_sources, &state->trigger_source) != SR_OK)
+	if (array_option_index(resp->trigger_source, config->trigger_sources,
+			&state->trigger_source) != SR_OK)
+		return SR_ERR;
+
+	if (array_option_index(resp->trigger_slope, config->trigger_slopes,
+			&state->trigger_slope) != SR_OK)
 		return SR_ERR;
 
-	if (scope_state_get_array_option(sdi->conn,
-		(*config->scpi_dialect)[SCPI_CMD_GET_TRIGGER_SLOPE],
-		config->trigger_slopes, &state->trigger_slope) != SR_OK)
+	return SR_OK;
+}
+
+SR_PRIV int hmo_scope_state_get(struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	struct scope_state *state;
+	const struct scope_config *config;
+	struct scope_state_responses resp;
+	struct sr_scpi_batch *batch;
+	unsigned int i;
+	int ret;
+
+	devc = sdi->priv;
+	config = devc->model_config;
+	state = devc->model_state;
+
+	sr_info("Fetching scope state");
+
+	/* Query everything in as few round trips as possible. */
+	memset(&resp, 0, sizeof(resp));
+	resp.vdivs = g_malloc0_n(config->analog_channels, sizeof(float));
+	resp.couplings = g_malloc0_n(config->analog_channels, sizeof(char *));
+
+	batch = sr_scpi_batch_new();
+	analog_channel_state_add(batch, config, state, &resp);
+	digital_channel_state_add(batch, config, state);
+	sr_scpi_batch_add_float(batch, &resp.timebase,
+		(*config->scpi_dialect)[SCPI_CMD_GET_TIMEBASE]);
+	sr_scpi_batch_add_float(batch, &resp.horiz_triggerpos,
+		(*config->scpi_dialect)[SCPI_CMD_GET_HORIZ_TRIGGERPOS]);
+	sr_scpi_batch_add_string(batch, &resp.trigger_source,
+		(*config->scpi_dialect)[SCPI_CMD_GET_TRIGGER_SOURCE]);
+	sr_scpi_batch_add_string(batch, &resp.trigger_slope,
+		(*config->scpi_dialect)[SCPI_CMD_GET_TRIGGER_SLOPE]);
+
+	ret = sr_scpi_batch_run(sdi->conn, batch);
+	sr_scpi_batch_free(batch);
+
+	if (ret == SR_OK)
+		ret = scope_state_update(config, state, &resp);
+
+	for (i = 0; i < config->analog_channels; ++i)
+		g_free(resp.couplings[i]);
+	g_free(resp.couplings);
+	g_free(resp.vdivs);
+	g_free(resp.trigger_source);
+	g_free(resp.trigger_slope);
+
+	if (ret != SR_OK)
 		return SR_ERR;
 
 	if (hmo_update_sample_rate(sdi) != SR_OK)
@@ -648,9 +664,10 @@ SR_PRIV int hmo_receive_data(int fd, int revents, void *cb_data)
 	struct sr_dev_inst *sdi;
 	struct dev_context *devc;
 	struct sr_datafeed_packet packet;
-	GArray *data;
+	GByteArray *data;
 	struct sr_datafeed_analog_old analog;
 	struct sr_datafeed_logic logic;
+	unsigned int i, num_samples;
 
 	(void)fd;
 
@@ -669,18 +686,23 @@ SR_PRIV int hmo_receive_data(int fd, int revents, void *cb_data)
 
 	switch (ch->type) {
 	case SR_CHANNEL_ANALOG:
-		if (sr_scpi_get_floatv(sdi->conn, NULL, &data) != SR_OK) {
+		if (sr_scpi_get_block(sdi->conn, NULL, &data) != SR_OK) {
 			if (data)
-				g_array_free(data, TRUE);
+				g_byte_array_free(data, TRUE);
 
 			return TRUE;
 		}
 
+		/* Little endian, as requested, to host byte order. */
+		num_samples = data->len / sizeof(float);
+		for (i = 0; i < num_samples; i++)
+			((float *)data->data)[i] = RLFL(data->data + i * sizeof(float));
+
 		packet.type = SR_DF_FRAME_BEGIN;
 		sr_session_send(sdi, &packet);
 
 		analog.channels = g_slist_append(NULL, ch);
-		analog.num_samples = data->len;
+		analog.num_samples = num_samples;
 		analog.data = (float *) data->data;
 		analog.mq = SR_MQ_VOLTAGE;
 		analog.unit = SR_UNIT_VOLT;
@@ -689,12 +711,14 @@ SR_PRIV int hmo_receive_data(int fd, int revents, void *cb_data)
 		packet.payload = &analog;
 		sr_session_send(cb_data, &packet);
 		g_slist_free(analog.channels);
-		g_array_free(data, TRUE);
+		g_byte_array_free(data, TRUE);
 		data = NULL;
 		break;
 	case SR_CHANNEL_LOGIC:
-		if (sr_scpi_get_uint8v(sdi->conn, NULL, &data) != SR_OK) {
-			g_free(data);
+		if (sr_scpi_get_block(sdi->conn, NULL, &data) != SR_OK) {
+			if (data)
+				g_byte_array_free(data, TRUE);
+
 			return TRUE;
 		}
 
@@ -707,7 +731,7 @@ SR_PRIV int hmo_receive_data(int fd, int revents, void *cb_data)
 		packet.type = SR_DF_LOGIC;
 		packet.payload = &logic;
 		sr_session_send(cb_data, &packet);
-		g_array_free(data, TRUE);
+		g_byte_array_free(data, TRUE);
 		data = NULL;
 		break;
 	default:
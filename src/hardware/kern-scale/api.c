@@ -110,6 +110,9 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 	sdi->vendor = g_strdup(scale->vendor);
 	sdi->model = g_strdup(scale->device);
 	devc = g_malloc0(sizeof(struct dev_context));
+	devc->framing.type = SR_FRAMING_FIXED;
+	devc->framing.size = scale->packet_size;
+	devc->framing.is_valid = scale->packet_valid;
 	sdi->inst_type = SR_INST_SERIAL;
 	sdi->conn = serial;
 	sdi->priv = devc;
@@ -60,41 +60,24 @@ static void handle_packet(const uint8_t *buf, struct sr_dev_inst *sdi,
 
 static void handle_new_data(struct sr_dev_inst *sdi, void *info)
 {
-	struct scale_info *scale;
 	struct dev_context *devc;
-	int len, i, offset = 0;
+	int len;
 	struct sr_serial_dev_inst *serial;
-
-	scale = (struct scale_info *)sdi->driver;
+	const uint8_t *pkt;
 
 	devc = sdi->priv;
 	serial = sdi->conn;
 
-	/* Try to get as much data as the buffer can hold. */
-	len = SCALE_BUFSIZE - devc->buflen;
-	len = serial_read_nonblocking(serial, devc->buf + devc->buflen, len);
-	if (len == 0)
-		return; /* No new bytes, nothing to do. */
+	/* Get all data that has arrived, at once. */
+	len = serial_rx_fill(serial, 0);
 	if (len < 0) {
 		sr_err("Serial port read error: %d.", len);
 		return;
 	}
-	devc->buflen += len;
 
 	/* Now look for packets in that data. */
-	while ((devc->buflen - offset) >= scale->packet_size) {
-		if (scale->packet_valid(devc->buf + offset)) {
-			handle_packet(devc->buf + offset, sdi, info);
-			offset += scale->packet_size;
-		} else {
-			offset++;
-		}
-	}
-
-	/* If we have any data left, move it to the beginning of our buffer. */
-	for (i = 0; i < devc->buflen - offset; i++)
-		devc->buf[i] = devc->buf[offset + i];
-	devc->buflen -= offset;
+	while (serial_rx_frame(serial, &devc->framing, &pkt) > 0)
+		handle_packet(pkt, sdi, info);
 }
 
 SR_PRIV int kern_scale_receive_data(int fd, int revents, void *cb_data)
@@ -45,8 +45,6 @@ struct scale_info {
 	gsize info_size;
 };
 
-#define SCALE_BUFSIZE 256
-
 /** Private, per-device-instance driver context. */
 struct dev_context {
 	/** The current sampling limit (in number of samples). */
@@ -64,9 +62,8 @@ struct dev_context {
 	/** The starting time of current sampling run. */
 	int64_t starttime;
 
-	uint8_t buf[SCALE_BUFSIZE];
-	int bufoffset;
-	int buflen;
+	/** How packets are found in the received data. */
+	struct sr_framing framing;
 };
 
 SR_PRIV int kern_scale_receive_data(int fd, int revents, void *cb_data);
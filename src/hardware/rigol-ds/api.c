@@ -49,6 +49,19 @@ static const uint32_t devopts[] = {
 	SR_CONF_DATA_SOURCE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
 };
 
+/* Settings served from the device context, which is only changed by us. */
+static const uint32_t cached_keys[] = {
+	SR_CONF_NUM_HDIV,
+	SR_CONF_NUM_VDIV,
+	SR_CONF_DATA_SOURCE,
+	SR_CONF_SAMPLERATE,
+	SR_CONF_TRIGGER_SOURCE,
+	SR_CONF_TRIGGER_SLOPE,
+	SR_CONF_TIMEBASE,
+	SR_CONF_VDIV,
+	SR_CONF_COUPLING,
+};
+
 static const uint32_t analog_devopts[] = {
 	SR_CONF_NUM_VDIV | SR_CONF_GET,
 	SR_CONF_VDIV | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
@@ -257,7 +270,6 @@ static void clear_helper(void *priv)
 	unsigned int i;
 
 	devc = priv;
-	g_free(devc->data);
 	g_free(devc->buffer);
 	for (i = 0; i < ARRAY_SIZE(devc->coupling); i++)
 		g_free(devc->coupling[i]);
@@ -320,6 +332,7 @@ static struct sr_dev_inst *probe_device(struct sr_scpi_dev_inst *scpi)
 	sdi->driver = &rigol_ds_driver_info;
 	sdi->inst_type = SR_INST_SCPI;
 	sdi->serial_num = g_strdup(hw_info->serial_number);
+	sr_config_cache_enable(sdi, ARRAY_AND_SIZE(cached_keys), 0);
 	devc = g_malloc0(sizeof(struct dev_context));
 	devc->limit_frames = 0;
 	devc->model = model;
@@ -397,7 +410,6 @@ static struct sr_dev_inst *probe_device(struct sr_scpi_dev_inst *scpi)
 	}
 
 	devc->buffer = g_malloc(ACQ_BUFFER_SIZE);
-	devc->data = g_malloc(ACQ_BUFFER_SIZE * sizeof(float));
 
 	devc->data_source = DATA_SOURCE_LIVE;
 
@@ -504,6 +516,42 @@ static int digital_frame_size(const struct sr_dev_inst *sdi)
 	}
 }
 
+/* Get the number of recorded frames and the size of each of them. */
+static int segmented_setup(const struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc = sdi->priv;
+	char *mdep;
+	float samplerate;
+	int frames;
+
+	if (sr_scpi_get_int(sdi->conn, ":FUNC:WREP:FEND?", &frames) != SR_OK)
+		return SR_ERR;
+	if (frames <= 0) {
+		sr_err("No recorded frames available.");
+		return SR_ERR;
+	}
+	devc->num_frames_segmented = frames;
+
+	/* The memory depth reads "AUTO" unless it was set explicitly. */
+	if (sr_scpi_get_string(sdi->conn, ":ACQ:MDEP?", &mdep) != SR_OK)
+		return SR_ERR;
+	devc->analog_frame_size = g_ascii_strtoull(mdep, NULL, 10);
+	g_free(mdep);
+	if (!devc->analog_frame_size) {
+		if (sr_scpi_get_float(sdi->conn, ":ACQ:SRAT?",
+				&samplerate) != SR_OK)
+			return SR_ERR;
+		devc->analog_frame_size = samplerate * devc->timebase *
+			devc->model->series->num_horizontal_divs + 0.5;
+	}
+	devc->digital_frame_size = devc->analog_frame_size;
+
+	sr_dbg("%d recorded frames of %" PRIu64 " samples.", frames,
+			devc->analog_frame_size);
+
+	return SR_OK;
+}
+
 static int config_get(uint32_t key, GVariant **data, const struct sr_dev_inst *sdi,
 		const struct sr_channel_group *cg)
 {
@@ -994,21 +1042,23 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi, void *cb_data)
 					":LA:STAT OFF" : ":LA:DISP OFF") != SR_OK)
 			return SR_ERR;
 
-	/* Set memory mode. */
-	if (devc->data_source == DATA_SOURCE_SEGMENTED) {
-		sr_err("Data source 'Segmented' not yet supported");
-		return SR_ERR;
-	}
-
 	devc->analog_frame_size = analog_frame_size(sdi);
 	devc->digital_frame_size = digital_frame_size(sdi);
 
+	/* Download the frames recorded on the scope, as they are. */
+	if (devc->data_source == DATA_SOURCE_SEGMENTED)
+		if (segmented_setup(sdi) != SR_OK)
+			return SR_ERR;
+
 	switch (devc->model->series->protocol) {
 	case PROTOCOL_V2:
 		if (rigol_ds_config_set(sdi, ":ACQ:MEMD LONG") != SR_OK)
 			return SR_ERR;
 		break;
 	case PROTOCOL_V3:
+		/* Changing the memory depth would clear the recording. */
+		if (devc->data_source == DATA_SOURCE_SEGMENTED)
+			break;
 		/* Apparently for the DS2000 the memory
 		 * depth can only be set in Running state -
 		 * this matches the behaviour of the UI. */
@@ -369,7 +369,7 @@ SR_PRIV int rigol_ds_capture_start(const struct sr_dev_inst *sdi)
 			if (devc->model->series->protocol == PROTOCOL_V3) {
 				if (rigol_ds_config_set(sdi, ":WAV:MODE RAW") != SR_OK)
 					return SR_ERR;
-			} else if (devc->model->series->protocol == PROTOCOL_V4) {
+			} else if (devc->data_source == DATA_SOURCE_MEMORY) {
 				num_channels = 0;
 
 				/* Channels 3 and 4 are multiplexed with D0-7 and D8-15 */
@@ -394,6 +394,14 @@ SR_PRIV int rigol_ds_capture_start(const struct sr_dev_inst *sdi)
 								devc->model->series->buffer_samples / 4;
 			}
 
+			if (devc->data_source == DATA_SOURCE_SEGMENTED) {
+				/* Read back the next recorded frame, no new capture. */
+				if (rigol_ds_config_set(sdi, ":FUNC:WREP:FCUR %" PRIu64,
+						devc->num_frames + 1) != SR_OK)
+					return SR_ERR;
+				return rigol_ds_channel_start(sdi);
+			}
+
 			if (rigol_ds_config_set(sdi, ":SING") != SR_OK)
 				return SR_ERR;
 			rigol_ds_set_wait_event(devc, WAIT_STOP);
@@ -472,6 +480,33 @@ SR_PRIV int rigol_ds_channel_start(const struct sr_dev_inst *sdi)
 	devc->num_channel_bytes = 0;
 	devc->num_header_bytes = 0;
 	devc->num_block_bytes = 0;
+	devc->block_requested = FALSE;
+
+	return SR_OK;
+}
+
+/* Request the next data block of the current channel. */
+static int rigol_ds_block_request(const struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc = sdi->priv;
+	struct sr_channel *ch = devc->channel_entry->data;
+	uint64_t frame_size;
+
+	if (devc->model->series->protocol >= PROTOCOL_V4) {
+		frame_size = ch->type == SR_CHANNEL_ANALOG ?
+				devc->analog_frame_size : devc->digital_frame_size;
+		if (sr_scpi_send(sdi->conn, ":WAV:START %" PRIu64,
+				devc->num_channel_bytes + 1) != SR_OK)
+			return SR_ERR;
+		if (sr_scpi_send(sdi->conn, ":WAV:STOP %" PRIu64,
+				MIN(devc->num_channel_bytes + ACQ_BLOCK_SIZE,
+					frame_size)) != SR_OK)
+			return SR_ERR;
+	}
+
+	if (devc->model->series->protocol >= PROTOCOL_V3)
+		if (sr_scpi_send(sdi->conn, ":WAV:DATA?") != SR_OK)
+			return SR_ERR;
 
 	return SR_OK;
 }
@@ -533,16 +568,92 @@ static int rigol_ds_read_header(struct sr_dev_inst *sdi)
 	return ret;
 }
 
+/* Approximate a value as a rational number, to a resolution of 1e-12. */
+static void rational_from_double(struct sr_rational *r, double value)
+{
+	sr_rational_set(r, llround(value * 1e12), 1000000000000ULL);
+}
+
+/*
+ * Set up the encoding of raw 8-bit samples, with the conversion to volts
+ * expressed as scale and offset: (sample - vref) * vdiv - offset on
+ * DS2000 and later, (128 - sample) * vdiv - offset on older models. One
+ * vertical division spans 25.6 sample values.
+ */
+SR_PRIV void rigol_ds_analog_encoding(struct sr_analog_encoding *encoding,
+		enum protocol_version protocol, float vdiv, float offset,
+		int vref)
+{
+	double scale;
+
+	scale = vdiv / 25.6;
+	encoding->unitsize = 1;
+	encoding->is_float = FALSE;
+	encoding->is_signed = FALSE;
+	if (protocol >= PROTOCOL_V3) {
+		rational_from_double(&encoding->scale, scale);
+		rational_from_double(&encoding->offset, -vref * scale - offset);
+	} else {
+		rational_from_double(&encoding->scale, -scale);
+		rational_from_double(&encoding->offset, 128 * scale - offset);
+	}
+}
+
+/* Send the data just read into the acquisition buffer to the session. */
+static void rigol_ds_send_data(const struct sr_dev_inst *sdi,
+		struct sr_channel *ch, int len)
+{
+	struct dev_context *devc = sdi->priv;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	struct sr_datafeed_logic logic;
+	double resolution;
+
+	if (ch->type == SR_CHANNEL_ANALOG) {
+		/* Volts per sample value. */
+		resolution = devc->vdiv[ch->index] / 25.6;
+		sr_analog_init(&analog, &encoding, &meaning, &spec,
+				MAX(0, (int)ceil(-log10(resolution))));
+		/*
+		 * The samples are passed on as they came from the scope,
+		 * the conversion to volts is left to the encoding.
+		 */
+		rigol_ds_analog_encoding(&encoding, devc->model->series->protocol,
+				devc->vdiv[ch->index], devc->vert_offset[ch->index],
+				devc->vert_reference[ch->index]);
+		meaning.channels = g_slist_append(NULL, ch);
+		meaning.mq = SR_MQ_VOLTAGE;
+		meaning.unit = SR_UNIT_VOLT;
+		analog.num_samples = len;
+		analog.data = devc->buffer;
+		packet.type = SR_DF_ANALOG;
+		packet.payload = &analog;
+		sr_session_send(sdi, &packet);
+		g_slist_free(meaning.channels);
+	} else {
+		logic.length = len;
+		// TODO: For the MSO1000Z series, we need a way to express that
+		// this data is in fact just for a single channel, with the valid
+		// data for that channel in the LSB of each byte.
+		logic.unitsize = devc->model->series->protocol == PROTOCOL_V4 ? 1 : 2;
+		logic.data = devc->buffer;
+		packet.type = SR_DF_LOGIC;
+		packet.payload = &logic;
+		sr_session_send(sdi, &packet);
+	}
+}
+
 SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
 {
 	struct sr_dev_inst *sdi;
 	struct sr_scpi_dev_inst *scpi;
 	struct dev_context *devc;
 	struct sr_datafeed_packet packet;
-	struct sr_datafeed_analog_old analog;
-	struct sr_datafeed_logic logic;
-	double vdiv, offset;
-	int len, i, vref;
+	int len;
+	char lf;
 	struct sr_channel *ch;
 	gsize expected_data_bytes;
 
@@ -591,20 +702,12 @@ SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
 			devc->analog_frame_size : devc->digital_frame_size;
 
 	if (devc->num_block_bytes == 0) {
-		if (devc->model->series->protocol >= PROTOCOL_V4) {
-			if (sr_scpi_send(sdi->conn, ":WAV:START %d",
-					devc->num_channel_bytes + 1) != SR_OK)
-				return TRUE;
-			if (sr_scpi_send(sdi->conn, ":WAV:STOP %d",
-					MIN(devc->num_channel_bytes + ACQ_BLOCK_SIZE,
-						devc->analog_frame_size)) != SR_OK)
+		if (!devc->block_requested) {
+			if (rigol_ds_block_request(sdi) != SR_OK)
 				return TRUE;
+			devc->block_requested = TRUE;
 		}
 
-		if (devc->model->series->protocol >= PROTOCOL_V3)
-			if (sr_scpi_send(sdi->conn, ":WAV:DATA?") != SR_OK)
-				return TRUE;
-
 		if (sr_scpi_read_begin(scpi) != SR_OK)
 			return TRUE;
 
@@ -631,6 +734,8 @@ SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
 					&& (unsigned)len < expected_data_bytes) {
 				sr_dbg("Discarding short data block");
 				sr_scpi_read_data(scpi, (char *)devc->buffer, len + 1);
+				devc->num_header_bytes = 0;
+				devc->block_requested = FALSE;
 				return TRUE;
 			}
 			devc->num_block_bytes = len;
@@ -638,6 +743,7 @@ SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
 			devc->num_block_bytes = expected_data_bytes;
 		}
 		devc->num_block_read = 0;
+		devc->block_requested = FALSE;
 	}
 
 	len = devc->num_block_bytes - devc->num_block_read;
@@ -659,43 +765,11 @@ SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
 
 	devc->num_block_read += len;
 
-	if (ch->type == SR_CHANNEL_ANALOG) {
-		vref = devc->vert_reference[ch->index];
-		vdiv = devc->vdiv[ch->index] / 25.6;
-		offset = devc->vert_offset[ch->index];
-		if (devc->model->series->protocol >= PROTOCOL_V3)
-			for (i = 0; i < len; i++)
-				devc->data[i] = ((int)devc->buffer[i] - vref) * vdiv - offset;
-		else
-			for (i = 0; i < len; i++)
-				devc->data[i] = (128 - devc->buffer[i]) * vdiv - offset;
-		analog.channels = g_slist_append(NULL, ch);
-		analog.num_samples = len;
-		analog.data = devc->data;
-		analog.mq = SR_MQ_VOLTAGE;
-		analog.unit = SR_UNIT_VOLT;
-		analog.mqflags = 0;
-		packet.type = SR_DF_ANALOG_OLD;
-		packet.payload = &analog;
-		sr_session_send(cb_data, &packet);
-		g_slist_free(analog.channels);
-	} else {
-		logic.length = len;
-		// TODO: For the MSO1000Z series, we need a way to express that
-		// this data is in fact just for a single channel, with the valid
-		// data for that channel in the LSB of each byte.
-		logic.unitsize = devc->model->series->protocol == PROTOCOL_V4 ? 1 : 2;
-		logic.data = devc->buffer;
-		packet.type = SR_DF_LOGIC;
-		packet.payload = &logic;
-		sr_session_send(cb_data, &packet);
-	}
-
 	if (devc->num_block_read == devc->num_block_bytes) {
 		sr_dbg("Block has been completed");
 		if (devc->model->series->protocol >= PROTOCOL_V3) {
 			/* Discard the terminating linefeed */
-			sr_scpi_read_data(scpi, (char *)devc->buffer, 1);
+			sr_scpi_read_data(scpi, &lf, 1);
 		}
 		if (devc->format == FORMAT_IEEE488_2) {
 			/* Prepare for possible next block */
@@ -719,9 +793,20 @@ SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
 
 	devc->num_channel_bytes += len;
 
-	if (devc->num_channel_bytes < expected_data_bytes)
-		/* Don't have the full data for this channel yet, re-run. */
+	if (devc->num_channel_bytes < expected_data_bytes) {
+		/*
+		 * Don't have the full data for this channel yet. On the
+		 * DS1000Z, where the driver picks the blocks, ask for the
+		 * next one before passing this one on, so the scope can
+		 * prepare it in the meantime.
+		 */
+		if (devc->num_block_bytes == 0
+				&& devc->model->series->protocol >= PROTOCOL_V4
+				&& rigol_ds_block_request(sdi) == SR_OK)
+			devc->block_requested = TRUE;
+		rigol_ds_send_data(sdi, ch, len);
 		return TRUE;
+	}
 
 	/* End of data for this channel. */
 	if (devc->model->series->protocol == PROTOCOL_V3) {
@@ -736,15 +821,30 @@ SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data)
 	}
 
 	if (devc->channel_entry->next) {
-		/* We got the frame for this channel, now get the next channel. */
+		/*
+		 * We got the frame for this channel, now get the next
+		 * channel. The switch is done before the data of this
+		 * channel is passed on, on all models. The DS1000Z also
+		 * gets its first block requested right away; the DS2000
+		 * has to report it ready (:WAV:STAT?) first, which is
+		 * polled in WAIT_BLOCK.
+		 */
 		devc->channel_entry = devc->channel_entry->next;
-		rigol_ds_channel_start(sdi);
+		if (rigol_ds_channel_start(sdi) == SR_OK
+				&& devc->model->series->protocol >= PROTOCOL_V4
+				&& rigol_ds_block_request(sdi) == SR_OK)
+			devc->block_requested = TRUE;
+		rigol_ds_send_data(sdi, ch, len);
 	} else {
+		rigol_ds_send_data(sdi, ch, len);
+
 		/* Done with this frame. */
 		packet.type = SR_DF_FRAME_END;
 		sr_session_send(cb_data, &packet);
 
-		if (++devc->num_frames == devc->limit_frames) {
+		if (++devc->num_frames == devc->limit_frames
+				|| (devc->data_source == DATA_SOURCE_SEGMENTED
+				&& devc->num_frames == devc->num_frames_segmented)) {
 			/* Last frame, stop capture. */
 			sdi->driver->dev_acquisition_stop(sdi, cb_data);
 		} else {
@@ -29,10 +29,10 @@
 #define LOG_PREFIX "rigol-ds"
 
 /* Size of acquisition buffers */
-#define ACQ_BUFFER_SIZE (32 * 1024)
+#define ACQ_BUFFER_SIZE (256 * 1024)
 
-/* Maximum number of samples to retrieve at once. */
-#define ACQ_BLOCK_SIZE (30 * 1000)
+/* Maximum number of samples to retrieve at once (DS1000Z, BYTE format). */
+#define ACQ_BLOCK_SIZE (250 * 1000)
 
 #define MAX_ANALOG_CHANNELS 4
 #define MAX_DIGITAL_CHANNELS 16
@@ -140,13 +140,16 @@ struct dev_context {
 	uint64_t num_block_bytes;
 	/* Number of data block bytes already read */
 	uint64_t num_block_read;
+	/* Next data block has already been requested */
+	gboolean block_requested;
+	/* Number of frames in the scope's segmented (recorded) memory */
+	uint64_t num_frames_segmented;
 	/* What to wait for in *_receive */
 	enum wait_events wait_event;
 	/* Trigger/block copying/stop waiting status */
 	int wait_status;
-	/* Acq buffers used for reading from the scope and sending data to app */
+	/* Acq buffer used for reading from the scope and sending data to app */
 	unsigned char *buffer;
-	float *data;
 };
 
 SR_PRIV int rigol_ds_config_set(const struct sr_dev_inst *sdi, const char *format, ...);
@@ -154,5 +157,8 @@ SR_PRIV int rigol_ds_capture_start(const struct sr_dev_inst *sdi);
 SR_PRIV int rigol_ds_channel_start(const struct sr_dev_inst *sdi);
 SR_PRIV int rigol_ds_receive(int fd, int revents, void *cb_data);
 SR_PRIV int rigol_ds_get_dev_cfg(const struct sr_dev_inst *sdi);
+SR_PRIV void rigol_ds_analog_encoding(struct sr_analog_encoding *encoding,
+		enum protocol_version protocol, float vdiv, float offset,
+		int vref);
 
 #endif
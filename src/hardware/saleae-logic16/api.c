@@ -717,8 +717,8 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi, void *cb_data)
 	devc->cb_data = cb_data;
 	devc->sent_samples = 0;
 	devc->empty_transfer_count = 0;
-	devc->cur_channel = 0;
-	memset(devc->channel_data, 0, sizeof(devc->channel_data));
+	logic16_converter_init(&devc->conv, devc->channel_masks,
+			devc->num_channels);
 
 	if ((trigger = sr_session_trigger_get(sdi->session))) {
 		int pre_trigger_samples = 0;
@@ -0,0 +1,125 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include "convert.h"
+
+/*
+ * Spread the 8 bits of a byte over the 8 bytes of a 64-bit word, MSB
+ * first: byte n of the result holds bit (7 - n) of the input in its
+ * least significant bit.
+ */
+#define SPREAD(b) ( \
+	((uint64_t)(((b) >> 7) & 1) <<  0) | \
+	((uint64_t)(((b) >> 6) & 1) <<  8) | \
+	((uint64_t)(((b) >> 5) & 1) << 16) | \
+	((uint64_t)(((b) >> 4) & 1) << 24) | \
+	((uint64_t)(((b) >> 3) & 1) << 32) | \
+	((uint64_t)(((b) >> 2) & 1) << 40) | \
+	((uint64_t)(((b) >> 1) & 1) << 48) | \
+	((uint64_t)(((b) >> 0) & 1) << 56))
+#define SPREAD4(b) SPREAD(b), SPREAD(b + 1), SPREAD(b + 2), SPREAD(b + 3)
+#define SPREAD16(b) SPREAD4(b), SPREAD4(b + 4), SPREAD4(b + 8), SPREAD4(b + 12)
+#define SPREAD64(b) SPREAD16(b), SPREAD16(b + 16), SPREAD16(b + 32), \
+	SPREAD16(b + 48)
+
+static const uint64_t spread[256] = {
+	SPREAD64(0), SPREAD64(64), SPREAD64(128), SPREAD64(192),
+};
+
+SR_PRIV void logic16_converter_init(struct logic16_converter *conv,
+		const uint16_t *channel_masks, int num_channels)
+{
+	int i, bit;
+
+	memset(conv, 0, sizeof(*conv));
+	conv->num_channels = num_channels;
+
+	for (i = 0; i < num_channels; i++) {
+		for (bit = 0; bit < 15; bit++)
+			if (channel_masks[i] & (1 << bit))
+				break;
+		conv->acc_index[i] = (bit >= 8) ? 2 : 0;
+		conv->shift[i] = bit & 7;
+	}
+}
+
+static void store_block(uint8_t *dest, const uint64_t *acc)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		dest[2 * i] = acc[0] >> (8 * i);
+		dest[2 * i + 1] = acc[2] >> (8 * i);
+		dest[16 + 2 * i] = acc[1] >> (8 * i);
+		dest[16 + 2 * i + 1] = acc[3] >> (8 * i);
+	}
+}
+
+/*
+ * Convert srccnt bytes of FPGA data into dest, which must have room for
+ * 32 bytes per complete block of words. Partial blocks are kept in the
+ * converter until the next call. Returns the number of samples written.
+ */
+SR_PRIV size_t logic16_convert(struct logic16_converter *conv,
+		uint8_t *dest, const uint8_t *src, size_t srccnt)
+{
+	const int num_channels = conv->num_channels;
+	uint64_t acc0, acc1, acc2, acc3;
+	uint64_t lo, hi;
+	int cur_channel;
+	size_t ret = 0;
+
+	acc0 = conv->acc[0];
+	acc1 = conv->acc[1];
+	acc2 = conv->acc[2];
+	acc3 = conv->acc[3];
+	cur_channel = conv->cur_channel;
+
+	for (srccnt /= 2; srccnt; srccnt--, src += 2) {
+		/* src[1] holds samples 0-7, src[0] samples 8-15. */
+		lo = spread[src[1]] << conv->shift[cur_channel];
+		hi = spread[src[0]] << conv->shift[cur_channel];
+		if (conv->acc_index[cur_channel]) {
+			acc2 |= lo;
+			acc3 |= hi;
+		} else {
+			acc0 |= lo;
+			acc1 |= hi;
+		}
+
+		if (++cur_channel == num_channels) {
+			const uint64_t acc[4] = { acc0, acc1, acc2, acc3 };
+			store_block(dest, acc);
+			dest += 16 * 2;
+			ret += 16;
+			acc0 = acc1 = acc2 = acc3 = 0;
+			cur_channel = 0;
+		}
+	}
+
+	conv->acc[0] = acc0;
+	conv->acc[1] = acc1;
+	conv->acc[2] = acc2;
+	conv->acc[3] = acc3;
+	conv->cur_channel = cur_channel;
+
+	return ret;
+}
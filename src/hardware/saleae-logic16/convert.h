@@ -0,0 +1,51 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBSIGROK_HARDWARE_SALEAE_LOGIC16_CONVERT_H
+#define LIBSIGROK_HARDWARE_SALEAE_LOGIC16_CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <libsigrok/libsigrok.h>
+
+/*
+ * The FPGA sends one little endian 16-bit word per enabled channel in
+ * turn, each holding 16 consecutive samples of that channel, MSB first.
+ * The converter transposes these back into 16-bit samples.
+ */
+struct logic16_converter {
+	int num_channels;
+	/* Position of the next word within a block of num_channels words. */
+	int cur_channel;
+	/* Per enabled channel: accumulator half and bit position within it. */
+	uint8_t acc_index[16];
+	uint8_t shift[16];
+	/*
+	 * One byte per sample: low output bytes of samples 0-7 and 8-15,
+	 * then high output bytes of samples 0-7 and 8-15.
+	 */
+	uint64_t acc[4];
+};
+
+SR_PRIV void logic16_converter_init(struct logic16_converter *conv,
+		const uint16_t *channel_masks, int num_channels);
+SR_PRIV size_t logic16_convert(struct logic16_converter *conv,
+		uint8_t *dest, const uint8_t *src, size_t srccnt);
+
+#endif
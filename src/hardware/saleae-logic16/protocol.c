@@ -819,43 +819,21 @@ static void resubmit_transfer(struct libusb_transfer *transfer)
 static size_t convert_sample_data(struct dev_context *devc,
 		uint8_t *dest, size_t destcnt, const uint8_t *src, size_t srccnt)
 {
-	uint16_t *channel_data;
-	int i, cur_channel;
-	size_t ret = 0;
-	uint16_t sample, channel_mask;
+	size_t num_words, max_words;
 
-	srccnt /= 2;
-
-	channel_data = devc->channel_data;
-	cur_channel = devc->cur_channel;
-
-	while (srccnt--) {
-		sample = src[0] | (src[1] << 8);
-		src += 2;
-
-		channel_mask = devc->channel_masks[cur_channel];
-
-		for (i = 15; i >= 0; --i, sample >>= 1)
-			if (sample & 1)
-				channel_data[i] |= channel_mask;
-
-		if (++cur_channel == devc->num_channels) {
-			cur_channel = 0;
-			if (destcnt < 16 * 2) {
-				sr_err("Conversion buffer too small!");
-				break;
-			}
-			memcpy(dest, channel_data, 16 * 2);
-			memset(channel_data, 0, 16 * 2);
-			dest += 16 * 2;
-			ret += 16;
-			destcnt -= 16 * 2;
-		}
+	num_words = srccnt / 2;
+	/* Words which complete no more blocks than there is room for. */
+	max_words = destcnt / (16 * 2) * devc->num_channels;
+	if (max_words > (size_t)devc->conv.cur_channel)
+		max_words -= devc->conv.cur_channel;
+	else
+		max_words = 0;
+	if (num_words > max_words) {
+		sr_err("Conversion buffer too small!");
+		num_words = max_words;
 	}
 
-	devc->cur_channel = cur_channel;
-
-	return ret;
+	return logic16_convert(&devc->conv, dest, src, num_words * 2);
 }
 
 SR_PRIV void LIBUSB_CALL logic16_receive_transfer(struct libusb_transfer *transfer)
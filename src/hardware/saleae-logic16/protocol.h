@@ -26,6 +26,7 @@
 #include <glib.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
+#include "convert.h"
 
 #define LOG_PREFIX "saleae-logic16"
 
@@ -79,9 +80,8 @@ struct dev_context {
 	int submitted_transfers;
 	int empty_transfer_count;
 	int num_channels;
-	int cur_channel;
 	uint16_t channel_masks[16];
-	uint16_t channel_data[16];
+	struct logic16_converter conv;
 	uint8_t *convbuffer;
 	size_t convbuffer_size;
 	struct soft_trigger_logic *stl;
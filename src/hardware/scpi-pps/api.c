@@ -34,6 +34,23 @@ static const uint32_t drvopts[] = {
 	SR_CONF_POWER_SUPPLY,
 };
 
+/*
+ * Settings that are only read back, not measured. They can also be
+ * changed on the front panel, so don't trust them for too long.
+ */
+static const uint32_t cached_keys[] = {
+	SR_CONF_VOLTAGE_TARGET,
+	SR_CONF_OUTPUT_FREQUENCY_TARGET,
+	SR_CONF_CURRENT_LIMIT,
+	SR_CONF_OVER_VOLTAGE_PROTECTION_ENABLED,
+	SR_CONF_OVER_VOLTAGE_PROTECTION_THRESHOLD,
+	SR_CONF_OVER_CURRENT_PROTECTION_ENABLED,
+	SR_CONF_OVER_CURRENT_PROTECTION_THRESHOLD,
+	SR_CONF_OVER_TEMPERATURE_PROTECTION,
+};
+
+#define CONFIG_CACHE_TTL_US (1000 * 1000)
+
 static const struct pps_channel_instance pci[] = {
 	{ SR_MQ_VOLTAGE, SCPI_CMD_GET_MEAS_VOLTAGE, "V" },
 	{ SR_MQ_CURRENT, SCPI_CMD_GET_MEAS_CURRENT, "I" },
@@ -102,6 +119,8 @@ static struct sr_dev_inst *probe_device(struct sr_scpi_dev_inst *scpi)
 	devc = g_malloc0(sizeof(struct dev_context));
 	devc->device = device;
 	sdi->priv = devc;
+	sr_config_cache_enable(sdi, ARRAY_AND_SIZE(cached_keys),
+			CONFIG_CACHE_TTL_US);
 
 	if (device->num_channels) {
 		/* Static channels and groups. */
@@ -579,39 +598,22 @@ static int config_list(uint32_t key, GVariant **data, const struct sr_dev_inst *
 static int dev_acquisition_start(const struct sr_dev_inst *sdi, void *cb_data)
 {
 	struct dev_context *devc;
-	struct sr_scpi_dev_inst *scpi;
 	struct sr_channel *ch;
-	struct pps_channel *pch;
-	int cmd, ret;
+	int ret;
 
 	if (sdi->status != SR_ST_ACTIVE)
 		return SR_ERR_DEV_CLOSED;
 
 	devc = sdi->priv;
-	scpi = sdi->conn;
 	devc->cb_data = cb_data;
 
-	if ((ret = sr_scpi_source_add(sdi->session, scpi, G_IO_IN, 10,
-			scpi_pps_receive_data, (void *)sdi)) != SR_OK)
-		return ret;
-	std_session_send_df_header(sdi, LOG_PREFIX);
-
 	/* Prime the pipe with the first channel's fetch. */
 	ch = sr_next_enabled_channel(sdi, NULL);
-	pch = ch->priv;
 	if ((ret = select_channel(sdi, ch)) < 0)
 		return ret;
-	if (pch->mq == SR_MQ_VOLTAGE)
-		cmd = SCPI_CMD_GET_MEAS_VOLTAGE;
-	else if (pch->mq == SR_MQ_FREQUENCY)
-		cmd = SCPI_CMD_GET_MEAS_FREQUENCY;
-	else if (pch->mq == SR_MQ_CURRENT)
-		cmd = SCPI_CMD_GET_MEAS_CURRENT;
-	else if (pch->mq == SR_MQ_POWER)
-		cmd = SCPI_CMD_GET_MEAS_POWER;
-	else
-		return SR_ERR;
-	scpi_cmd(sdi, devc->device->commands, cmd, pch->hwname);
+	if ((ret = scpi_pps_request_measurement(sdi)) != SR_OK)
+		return ret;
+	std_session_send_df_header(sdi, LOG_PREFIX);
 
 	return SR_OK;
 }
@@ -619,23 +621,18 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi, void *cb_data)
 static int dev_acquisition_stop(struct sr_dev_inst *sdi, void *cb_data)
 {
 	struct sr_datafeed_packet packet;
-	struct sr_scpi_dev_inst *scpi;
-	float f;
 
 	(void)cb_data;
 
 	if (sdi->status != SR_ST_ACTIVE)
 		return SR_ERR_DEV_CLOSED;
 
-	scpi = sdi->conn;
-
 	/*
-	 * A requested value is certainly on the way. Retrieve it now,
+	 * A requested value is certainly on the way. This retrieves it,
 	 * to avoid leaving the device in a state where it's not expecting
 	 * commands.
 	 */
-	sr_scpi_get_float(scpi, NULL, &f);
-	sr_scpi_source_remove(sdi->session, scpi);
+	sr_scpi_async_cancel(sdi->conn);
 
 	packet.type = SR_DF_END;
 	sr_session_send(sdi, &packet);
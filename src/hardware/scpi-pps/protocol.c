@@ -54,31 +54,60 @@ SR_PRIV int select_channel(const struct sr_dev_inst *sdi, struct sr_channel *ch)
 	return ret;
 }
 
-SR_PRIV int scpi_pps_receive_data(int fd, int revents, void *cb_data)
+/* Request the measurement of the current channel. */
+SR_PRIV int scpi_pps_request_measurement(const struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	struct pps_channel *pch;
+	const char *cmd_str;
+	int cmd;
+
+	devc = sdi->priv;
+	pch = devc->cur_channel->priv;
+	if (pch->mq == SR_MQ_VOLTAGE)
+		cmd = SCPI_CMD_GET_MEAS_VOLTAGE;
+	else if (pch->mq == SR_MQ_FREQUENCY)
+		cmd = SCPI_CMD_GET_MEAS_FREQUENCY;
+	else if (pch->mq == SR_MQ_CURRENT)
+		cmd = SCPI_CMD_GET_MEAS_CURRENT;
+	else if (pch->mq == SR_MQ_POWER)
+		cmd = SCPI_CMD_GET_MEAS_POWER;
+	else
+		return SR_ERR;
+
+	if (!(cmd_str = scpi_cmd_get(devc->device->commands, cmd)))
+		return SR_ERR_NA;
+
+	return sr_scpi_get_string_async(sdi->session, sdi->conn,
+			scpi_pps_receive_data, (void *)sdi, cmd_str, pch->hwname);
+}
+
+/*
+ * Called with each measurement. Runs from the main loop without ever
+ * waiting for the device, so other devices in the session aren't held
+ * up by a slow power supply.
+ */
+SR_PRIV void scpi_pps_receive_data(struct sr_scpi_dev_inst *scpi,
+		int result, const char *response, void *cb_data)
 {
 	struct dev_context *devc;
 	struct sr_datafeed_packet packet;
 	struct sr_datafeed_analog_old analog;
 	const struct sr_dev_inst *sdi;
 	struct sr_channel *next_channel;
-	struct sr_scpi_dev_inst *scpi;
 	struct pps_channel *pch;
 	float f;
-	int cmd;
 
-	(void)fd;
-	(void)revents;
+	(void)scpi;
 
 	if (!(sdi = cb_data))
-		return TRUE;
+		return;
 
 	if (!(devc = sdi->priv))
-		return TRUE;
-
-	scpi = sdi->conn;
+		return;
 
 	/* Retrieve requested value for this state. */
-	if (sr_scpi_get_float(scpi, NULL, &f) == SR_OK) {
+	if (result == SR_OK && sr_atof_ascii(response, &f) == SR_OK) {
 		pch = devc->cur_channel->priv;
 		packet.type = SR_DF_ANALOG_OLD;
 		packet.payload = &analog;
@@ -101,22 +130,15 @@ SR_PRIV int scpi_pps_receive_data(int fd, int revents, void *cb_data)
 		next_channel = sr_next_enabled_channel(sdi, devc->cur_channel);
 		if (select_channel(sdi, next_channel) != SR_OK) {
 			sr_err("Failed to select channel %s", next_channel->name);
-			return FALSE;
+			sdi->driver->dev_acquisition_stop((struct sr_dev_inst *)sdi,
+					devc->cb_data);
+			return;
 		}
 	}
 
-	pch = devc->cur_channel->priv;
-	if (pch->mq == SR_MQ_VOLTAGE)
-		cmd = SCPI_CMD_GET_MEAS_VOLTAGE;
-	else if (pch->mq == SR_MQ_FREQUENCY)
-		cmd = SCPI_CMD_GET_MEAS_FREQUENCY;
-	else if (pch->mq == SR_MQ_CURRENT)
-		cmd = SCPI_CMD_GET_MEAS_CURRENT;
-	else if (pch->mq == SR_MQ_POWER)
-		cmd = SCPI_CMD_GET_MEAS_POWER;
-	else
-		return SR_ERR;
-	scpi_cmd(sdi, devc->device->commands, cmd);
-
-	return TRUE;
+	if (scpi_pps_request_measurement(sdi) != SR_OK) {
+		sr_err("Failed to request measurement.");
+		sdi->driver->dev_acquisition_stop((struct sr_dev_inst *)sdi,
+				devc->cb_data);
+	}
 }
@@ -156,6 +156,8 @@ SR_PRIV extern const struct scpi_pps pps_profiles[];
 
 SR_PRIV const char *get_vendor(const char *raw_vendor);
 SR_PRIV int select_channel(const struct sr_dev_inst *sdi, struct sr_channel *ch);
-SR_PRIV int scpi_pps_receive_data(int fd, int revents, void *cb_data);
+SR_PRIV int scpi_pps_request_measurement(const struct sr_dev_inst *sdi);
+SR_PRIV void scpi_pps_receive_data(struct sr_scpi_dev_inst *scpi,
+		int result, const char *response, void *cb_data);
 
 #endif
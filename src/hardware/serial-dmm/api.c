@@ -136,6 +136,9 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 	sdi->vendor = g_strdup(dmm->vendor);
 	sdi->model = g_strdup(dmm->device);
 	devc = g_malloc0(sizeof(struct dev_context));
+	devc->framing.type = SR_FRAMING_FIXED;
+	devc->framing.size = dmm->packet_size;
+	devc->framing.is_valid = dmm->packet_valid;
 	sdi->inst_type = SR_INST_SERIAL;
 	sdi->conn = serial;
 	sdi->priv = devc;
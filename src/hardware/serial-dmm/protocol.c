@@ -112,47 +112,34 @@ static void handle_new_data(struct sr_dev_inst *sdi, void *info)
 {
 	struct dmm_info *dmm;
 	struct dev_context *devc;
-	int len, i, offset = 0;
+	int len;
 	struct sr_serial_dev_inst *serial;
+	const uint8_t *pkt;
 
 	dmm = (struct dmm_info *)sdi->driver;
 
 	devc = sdi->priv;
 	serial = sdi->conn;
 
-	/* Try to get as much data as the buffer can hold. */
-	len = DMM_BUFSIZE - devc->buflen;
-	len = serial_read_nonblocking(serial, devc->buf + devc->buflen, len);
-	if (len == 0)
-		return; /* No new bytes, nothing to do. */
+	/* Get all data that has arrived, at once. */
+	len = serial_rx_fill(serial, 0);
 	if (len < 0) {
 		sr_err("Serial port read error: %d.", len);
 		return;
 	}
-	devc->buflen += len;
 
 	/* Now look for packets in that data. */
-	while ((devc->buflen - offset) >= dmm->packet_size) {
-		if (dmm->packet_valid(devc->buf + offset)) {
-			handle_packet(devc->buf + offset, sdi, info);
-			offset += dmm->packet_size;
-
-			/* Request next packet, if required. */
-			if (!dmm->packet_request)
-				break;
-			if (dmm->req_timeout_ms || dmm->req_delay_ms)
-				devc->req_next_at = g_get_monotonic_time() +
-					dmm->req_delay_ms * 1000;
-			req_packet(sdi);
-		} else {
-			offset++;
-		}
+	while (serial_rx_frame(serial, &devc->framing, &pkt) > 0) {
+		handle_packet(pkt, sdi, info);
+
+		/* Request next packet, if required. */
+		if (!dmm->packet_request)
+			break;
+		if (dmm->req_timeout_ms || dmm->req_delay_ms)
+			devc->req_next_at = g_get_monotonic_time() +
+				dmm->req_delay_ms * 1000;
+		req_packet(sdi);
 	}
-
-	/* If we have any data left, move it to the beginning of our buffer. */
-	for (i = 0; i < devc->buflen - offset; i++)
-		devc->buf[i] = devc->buf[offset + i];
-	devc->buflen -= offset;
 }
 
 int receive_data(int fd, int revents, void *cb_data)
@@ -54,8 +54,6 @@ struct dmm_info {
 	gsize info_size;
 };
 
-#define DMM_BUFSIZE 256
-
 /** Private, per-device-instance driver context. */
 struct dev_context {
 	/** The current sampling limit (in number of samples). */
@@ -73,9 +71,8 @@ struct dev_context {
 	/** The starting time of current sampling run. */
 	int64_t starttime;
 
-	uint8_t buf[DMM_BUFSIZE];
-	int bufoffset;
-	int buflen;
+	/** How packets are found in the received data. */
+	struct sr_framing framing;
 
 	/** The timestamp [µs] to send the next request.
 	 *  Used only if device needs polling. */
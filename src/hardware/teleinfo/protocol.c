@@ -29,6 +29,17 @@
 #define LF   0x0A
 #define CR   0x0D
 
+/* Longest group: LF, 8 char label, SP, 12 char data, SP, checksum, CR. */
+#define GROUP_MAX_SIZE 25
+
+/* A group, which holds a single measurement. */
+static const struct sr_framing group_framing = {
+	.type = SR_FRAMING_DELIMITED,
+	.size = GROUP_MAX_SIZE,
+	.start = LF,
+	.end = CR,
+};
+
 static gboolean teleinfo_control_check(char *label, char *data, char control)
 {
 	int sum = 0;
@@ -184,7 +195,8 @@ SR_PRIV int teleinfo_receive_data(int fd, int revents, void *cb_data)
 	struct sr_dev_inst *sdi;
 	struct dev_context *devc;
 	struct sr_serial_dev_inst *serial;
-	const uint8_t *ptr, *next_ptr, *end_ptr;
+	const uint8_t *pkt;
+	uint8_t group[GROUP_MAX_SIZE + 1];
 	int len;
 	int64_t time;
 
@@ -194,29 +206,18 @@ SR_PRIV int teleinfo_receive_data(int fd, int revents, void *cb_data)
 		return TRUE;
 	serial = sdi->conn;
 
-	/* Try to get as much data as the buffer can hold. */
-	len = TELEINFO_BUF_SIZE - devc->buf_len;
-	len = serial_read_nonblocking(serial, devc->buf + devc->buf_len, len);
-	if (len < 1) {
+	/* Get all data that has arrived, at once. */
+	len = serial_rx_fill(serial, 0);
+	if (len < 0) {
 		sr_err("Serial port read error: %d.", len);
 		return FALSE;
 	}
-	devc->buf_len += len;
-
-	/* Now look for packets in that data. */
-	ptr = devc->buf;
-	end_ptr = ptr + devc->buf_len;
-	while ((next_ptr = teleinfo_parse_data(sdi, ptr, end_ptr - ptr, NULL)))
-		ptr = next_ptr;
 
-	/* If we have any data left, move it to the beginning of our buffer. */
-	memmove(devc->buf, ptr, end_ptr - ptr);
-	devc->buf_len -= ptr - devc->buf;
-
-	/* If buffer is full and no valid packet was found, wipe buffer. */
-	if (devc->buf_len >= TELEINFO_BUF_SIZE) {
-		devc->buf_len = 0;
-		return FALSE;
+	/* Now look for groups in that data. NUL terminate them for sscanf(). */
+	while ((len = serial_rx_frame(serial, &group_framing, &pkt)) > 0) {
+		memcpy(group, pkt, len);
+		group[len] = '\0';
+		teleinfo_parse_group(sdi, group, NULL);
 	}
 
 	if (devc->limit_samples && devc->num_samples >= devc->limit_samples) {
@@ -35,8 +35,6 @@ enum optarif {
 	OPTARIF_BBR,
 };
 
-#define TELEINFO_BUF_SIZE 256
-
 /** Private, per-device-instance driver context. */
 struct dev_context {
 	/* Acquisition settings */
@@ -48,10 +46,6 @@ struct dev_context {
 	enum optarif optarif;     /**< The device mode (which measures are reported) */
 	uint64_t num_samples;     /**< The number of already received samples. */
 	int64_t start_time;       /**< The time at which sampling started. */
-
-	/* Temporary state across callbacks */
-	uint8_t buf[TELEINFO_BUF_SIZE];
-	int buf_len;
 };
 
 SR_PRIV gboolean teleinfo_packet_valid(const uint8_t *buf);
@@ -182,13 +182,20 @@ static int get_and_handle_data(struct sr_dev_inst *sdi)
 	struct dmm_info *dmm;
 	uint8_t buf[CHUNK_SIZE], *pbuf;
 	int i, ret, len, num_databytes_in_chunk;
+	size_t offset;
 	struct sr_usb_dev_inst *usb;
+	struct sr_framing framing;
 
 	devc = sdi->priv;
 	dmm = (struct dmm_info *)sdi->driver;
 	usb = sdi->conn;
 	pbuf = devc->protocol_buf;
 
+	memset(&framing, 0, sizeof(framing));
+	framing.type = SR_FRAMING_FIXED;
+	framing.size = dmm->packet_size;
+	framing.is_valid = dmm->packet_valid;
+
 	/* On the first run, we need to init the HID chip. */
 	if (devc->first_run) {
 		if ((ret = hid_chip_init(sdi, dmm->baudrate)) != SR_OK) {
@@ -251,15 +258,14 @@ static int get_and_handle_data(struct sr_dev_inst *sdi)
 	}
 
 	/* Now look for packets in that data. */
-	while ((devc->buflen - devc->bufoffset) >= dmm->packet_size) {
-		if (dmm->packet_valid(pbuf + devc->bufoffset)) {
-			log_dmm_packet(pbuf + devc->bufoffset);
-			decode_packet(sdi, pbuf + devc->bufoffset);
-			devc->bufoffset += dmm->packet_size;
-		} else {
-			devc->bufoffset++;
-		}
+	while ((ret = sr_framing_find(&framing, pbuf + devc->bufoffset,
+			devc->buflen - devc->bufoffset, &offset)) > 0) {
+		devc->bufoffset += offset;
+		log_dmm_packet(pbuf + devc->bufoffset);
+		decode_packet(sdi, pbuf + devc->bufoffset);
+		devc->bufoffset += ret;
 	}
+	devc->bufoffset += offset;
 
 	/* Move remaining bytes to beginning of buffer. */
 	for (i = 0; i < devc->buflen - devc->bufoffset; i++)
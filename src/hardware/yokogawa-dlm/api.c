@@ -56,6 +56,19 @@ static const uint32_t dlm_analog_devopts[] = {
 static const uint32_t dlm_digital_devopts[] = {
 };
 
+/* Settings served from the scope state, which is only changed by us. */
+static const uint32_t dlm_cached_keys[] = {
+	SR_CONF_NUM_HDIV,
+	SR_CONF_NUM_VDIV,
+	SR_CONF_TIMEBASE,
+	SR_CONF_VDIV,
+	SR_CONF_COUPLING,
+	SR_CONF_TRIGGER_SOURCE,
+	SR_CONF_TRIGGER_SLOPE,
+	SR_CONF_HORIZ_TRIGGERPOS,
+	SR_CONF_SAMPLERATE,
+};
+
 enum {
 	CG_INVALID = -1,
 	CG_NONE,
@@ -107,6 +120,7 @@ static struct sr_dev_inst *probe_usbtmc_device(struct sr_scpi_dev_inst *scpi)
 	sdi->priv = devc;
 	sdi->inst_type = SR_INST_SCPI;
 	sdi->conn = scpi;
+	sr_config_cache_enable(sdi, ARRAY_AND_SIZE(dlm_cached_keys), 0);
 
 	if (dlm_device_init(sdi, model_index) != SR_OK)
 		goto fail;
@@ -411,34 +411,67 @@ static int array_float_get(gchar *value, const uint64_t array[][2],
 	return SR_ERR;
 }
 
+/* Responses to the state queries which need further processing. */
+struct scope_state_responses {
+	gchar **vdivs;
+	gchar **couplings;
+	gchar *timebase;
+	float horiz_triggerpos;
+	gchar *trigger_source;
+	gchar *trigger_slope;
+	int acq_length;
+};
+
 /**
- * Obtains information about all analog channels from the oscilloscope.
- * The internal state information is updated accordingly.
+ * Adds the queries about all analog channels to a batch.
+ *
+ * @param batch The batch to add the queries to.
+ * @param config The device's device configuration.
+ * @param state The device's state information.
+ * @param resp Storage for the responses which need further processing.
+ */
+static void analog_channel_state_query(struct sr_scpi_batch *batch,
+		const struct scope_config *config,
+		struct scope_state *state,
+		struct scope_state_responses *resp)
+{
+	int i;
+
+	for (i = 0; i < config->analog_channels; i++) {
+		dlm_analog_chan_state_query(batch, i + 1,
+				&state->analog_states[i].state);
+		dlm_analog_chan_vdiv_query(batch, i + 1, &resp->vdivs[i]);
+		dlm_analog_chan_voffs_query(batch, i + 1,
+				&state->analog_states[i].vertical_offset);
+		dlm_analog_chan_coupl_query(batch, i + 1, &resp->couplings[i]);
+	}
+}
+
+/**
+ * Updates the internal state information of all analog channels from
+ * the query responses, and obtains the waveform parameters, which can't
+ * be part of a batch.
  *
  * @param sdi The device instance.
  * @param config The device's device configuration.
  * @param state The device's state information.
+ * @param resp The responses to the batched queries.
  *
  * @return SR_ERR on error, SR_OK otherwise.
  */
-static int analog_channel_state_get(const struct sr_dev_inst *sdi,
+static int analog_channel_state_update(const struct sr_dev_inst *sdi,
 		const struct scope_config *config,
-		struct scope_state *state)
+		struct scope_state *state,
+		const struct scope_state_responses *resp)
 {
 	struct sr_scpi_dev_inst *scpi;
 	int i, j;
 	GSList *l;
 	struct sr_channel *ch;
-	gchar *response;
 
 	scpi = sdi->conn;
 
 	for (i = 0; i < config->analog_channels; i++) {
-
-		if (dlm_analog_chan_state_get(scpi, i + 1,
-				&state->analog_states[i].state) != SR_OK)
-			return SR_ERR;
-
 		for (l = sdi->channels; l; l = l->next) {
 			ch = l->data;
 			if (ch->index == i) {
@@ -447,22 +480,12 @@ static int analog_channel_state_get(const struct sr_dev_inst *sdi,
 			}
 		}
 
-		if (dlm_analog_chan_vdiv_get(scpi, i + 1, &response) != SR_OK)
-			return SR_ERR;
-
-		if (array_float_get(response, dlm_vdivs, ARRAY_SIZE(dlm_vdivs),
-				&j) != SR_OK) {
-			g_free(response);
+		if (array_float_get(resp->vdivs[i], dlm_vdivs,
+				ARRAY_SIZE(dlm_vdivs), &j) != SR_OK)
 			return SR_ERR;
-		}
 
-		g_free(response);
 		state->analog_states[i].vdiv = j;
 
-		if (dlm_analog_chan_voffs_get(scpi, i + 1,
-				&state->analog_states[i].vertical_offset) != SR_OK)
-			return SR_ERR;
-
 		if (dlm_analog_chan_wrange_get(scpi, i + 1,
 				&state->analog_states[i].waveform_range) != SR_OK)
 			return SR_ERR;
@@ -471,55 +494,64 @@ static int analog_channel_state_get(const struct sr_dev_inst *sdi,
 				&state->analog_states[i].waveform_offset) != SR_OK)
 			return SR_ERR;
 
-		if (dlm_analog_chan_coupl_get(scpi, i + 1, &response) != SR_OK) {
-			g_free(response);
+		if (array_option_get(resp->couplings[i], config->coupling_options,
+				&state->analog_states[i].coupling) != SR_OK)
 			return SR_ERR;
-		}
-
-		if (array_option_get(response, config->coupling_options,
-				&state->analog_states[i].coupling) != SR_OK) {
-			g_free(response);
-			return SR_ERR;
-		}
-		g_free(response);
 	}
 
 	return SR_OK;
 }
 
 /**
- * Obtains information about all digital channels from the oscilloscope.
- * The internal state information is updated accordingly.
+ * Adds the queries about all digital channels to a batch.
  *
- * @param sdi The device instance.
+ * @param batch The batch to add the queries to.
  * @param config The device's device configuration.
  * @param state The device's state information.
- *
- * @return SR_ERR on error, SR_OK otherwise.
  */
-static int digital_channel_state_get(const struct sr_dev_inst *sdi,
+static void digital_channel_state_query(struct sr_scpi_batch *batch,
 		const struct scope_config *config,
 		struct scope_state *state)
 {
-	struct sr_scpi_dev_inst *scpi;
 	int i;
-	GSList *l;
-	struct sr_channel *ch;
-
-	scpi = sdi->conn;
 
 	if (!config->digital_channels) {
 		sr_warn("Tried obtaining digital channel states on a " \
 				"model without digital inputs.");
-		return SR_OK;
+		return;
 	}
 
-	for (i = 0; i < config->digital_channels; i++) {
-		if (dlm_digital_chan_state_get(scpi, i + 1,
-				&state->digital_states[i]) != SR_OK) {
-			return SR_ERR;
-		}
+	for (i = 0; i < config->digital_channels; i++)
+		dlm_digital_chan_state_query(batch, i + 1,
+				&state->digital_states[i]);
+
+	if (!config->pods) {
+		sr_warn("Tried obtaining pod states on a model without pods.");
+		return;
+	}
+
+	for (i = 0; i < config->pods; i++)
+		dlm_digital_pod_state_query(batch, i + 'A',
+				&state->pod_states[i]);
+}
+
+/**
+ * Updates the channels of the device instance from the digital channel
+ * states.
+ *
+ * @param sdi The device instance.
+ * @param config The device's device configuration.
+ * @param state The device's state information.
+ */
+static void digital_channel_state_update(const struct sr_dev_inst *sdi,
+		const struct scope_config *config,
+		struct scope_state *state)
+{
+	int i;
+	GSList *l;
+	struct sr_channel *ch;
 
+	for (i = 0; i < config->digital_channels; i++) {
 		for (l = sdi->channels; l; l = l->next) {
 			ch = l->data;
 			if (ch->index == i + DLM_DIG_CHAN_INDEX_OFFS) {
@@ -528,19 +560,6 @@ static int digital_channel_state_get(const struct sr_dev_inst *sdi,
 			}
 		}
 	}
-
-	if (!config->pods) {
-		sr_warn("Tried obtaining pod states on a model without pods.");
-		return SR_OK;
-	}
-
-	for (i = 0; i < config->pods; i++) {
-		if (dlm_digital_pod_state_get(scpi, i + 'A',
-				&state->pod_states[i]) != SR_OK)
-			return SR_ERR;
-	}
-
-	return SR_OK;
 }
 
 SR_PRIV int dlm_channel_state_set(const struct sr_dev_inst *sdi,
@@ -658,78 +677,115 @@ SR_PRIV int dlm_sample_rate_query(const struct sr_dev_inst *sdi)
 }
 
 /**
- * Obtains information about the current device state from the oscilloscope,
- * including all analog and digital channel configurations.
- * The internal state information is updated accordingly.
+ * Updates the internal state information from the responses to the
+ * state queries.
  *
  * @param sdi The device instance.
+ * @param config The device's device configuration.
+ * @param state The device's state information.
+ * @param resp The responses to the batched queries.
  *
  * @return SR_ERR on error, SR_OK otherwise.
  */
-SR_PRIV int dlm_scope_state_query(struct sr_dev_inst *sdi)
+static int scope_state_update(const struct sr_dev_inst *sdi,
+		const struct scope_config *config,
+		struct scope_state *state,
+		const struct scope_state_responses *resp)
 {
-	struct dev_context *devc;
-	struct scope_state *state;
-	const struct scope_config *config;
-	float tmp_float;
-	gchar *response;
 	int i;
 
-	devc = sdi->priv;
-	config = devc->model_config;
-	state = devc->model_state;
-
-	if (analog_channel_state_get(sdi, config, state) != SR_OK)
-		return SR_ERR;
-
-	if (digital_channel_state_get(sdi, config, state) != SR_OK)
+	if (analog_channel_state_update(sdi, config, state, resp) != SR_OK)
 		return SR_ERR;
 
-	if (dlm_timebase_get(sdi->conn, &response) != SR_OK)
-		return SR_ERR;
+	digital_channel_state_update(sdi, config, state);
 
-	if (array_float_get(response, dlm_timebases,
-			ARRAY_SIZE(dlm_timebases), &i) != SR_OK) {
-		g_free(response);
+	if (array_float_get(resp->timebase, dlm_timebases,
+			ARRAY_SIZE(dlm_timebases), &i) != SR_OK)
 		return SR_ERR;
-	}
 
-	g_free(response);
 	state->timebase = i;
 
-	if (dlm_horiz_trigger_pos_get(sdi->conn, &tmp_float) != SR_OK)
-		return SR_ERR;
-
 	/* TODO: Check if the calculation makes sense for the DLM. */
-	state->horiz_triggerpos = tmp_float /
+	state->horiz_triggerpos = resp->horiz_triggerpos /
 			(((double)dlm_timebases[state->timebase][0] /
 			dlm_timebases[state->timebase][1]) * config->num_xdivs);
 	state->horiz_triggerpos -= 0.5;
 	state->horiz_triggerpos *= -1;
 
-	if (dlm_trigger_source_get(sdi->conn, &response) != SR_OK) {
-		g_free(response);
-		return SR_ERR;
-	}
-
-	if (array_option_get(response, config->trigger_sources,
-			&state->trigger_source) != SR_OK) {
-		g_free(response);
+	if (array_option_get(resp->trigger_source, config->trigger_sources,
+			&state->trigger_source) != SR_OK)
 		return SR_ERR;
-	}
-
-	g_free(response);
 
-	if (dlm_trigger_slope_get(sdi->conn, &i) != SR_OK)
+	if (dlm_trigger_slope_parse(resp->trigger_slope, &i) != SR_OK)
 		return SR_ERR;
 
 	state->trigger_slope = i;
 
-	if (dlm_acq_length_get(sdi->conn, &state->samples_per_frame) != SR_OK) {
+	if (resp->acq_length < 0) {
 		sr_err("Failed to query acquisition length.");
 		return SR_ERR;
 	}
 
+	state->samples_per_frame = resp->acq_length;
+
+	return SR_OK;
+}
+
+/**
+ * Obtains information about the current device state from the oscilloscope,
+ * including all analog and digital channel configurations.
+ * The internal state information is updated accordingly.
+ *
+ * @param sdi The device instance.
+ *
+ * @return SR_ERR on error, SR_OK otherwise.
+ */
+SR_PRIV int dlm_scope_state_query(struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	struct scope_state *state;
+	const struct scope_config *config;
+	struct scope_state_responses resp;
+	struct sr_scpi_batch *batch;
+	int i, ret;
+
+	devc = sdi->priv;
+	config = devc->model_config;
+	state = devc->model_state;
+
+	/* Query everything in as few round trips as possible. */
+	memset(&resp, 0, sizeof(resp));
+	resp.vdivs = g_malloc0_n(config->analog_channels, sizeof(gchar *));
+	resp.couplings = g_malloc0_n(config->analog_channels, sizeof(gchar *));
+
+	batch = sr_scpi_batch_new();
+	analog_channel_state_query(batch, config, state, &resp);
+	digital_channel_state_query(batch, config, state);
+	dlm_timebase_query(batch, &resp.timebase);
+	dlm_horiz_trigger_pos_query(batch, &resp.horiz_triggerpos);
+	dlm_trigger_source_query(batch, &resp.trigger_source);
+	dlm_trigger_slope_query(batch, &resp.trigger_slope);
+	dlm_acq_length_query(batch, &resp.acq_length);
+
+	ret = sr_scpi_batch_run(sdi->conn, batch);
+	sr_scpi_batch_free(batch);
+
+	if (ret == SR_OK)
+		ret = scope_state_update(sdi, config, state, &resp);
+
+	for (i = 0; i < config->analog_channels; i++) {
+		g_free(resp.vdivs[i]);
+		g_free(resp.couplings[i]);
+	}
+	g_free(resp.vdivs);
+	g_free(resp.couplings);
+	g_free(resp.timebase);
+	g_free(resp.trigger_source);
+	g_free(resp.trigger_slope);
+
+	if (ret != SR_OK)
+		return SR_ERR;
+
 	dlm_sample_rate_query(sdi);
 
 	scope_state_dump(config, state);
@@ -27,10 +27,10 @@
  * https://www.yokogawa.com/pdf/provide/E/GW/IM/0000022842/0/IM710105-17E.pdf
  */
 
-int dlm_timebase_get(struct sr_scpi_dev_inst *scpi,
+void dlm_timebase_query(struct sr_scpi_batch *batch,
 		gchar **response)
 {
-	return sr_scpi_get_string(scpi, ":TIMEBASE:TDIV?", response);
+	sr_scpi_batch_add_string(batch, response, ":TIMEBASE:TDIV?");
 }
 
 int dlm_timebase_set(struct sr_scpi_dev_inst *scpi,
@@ -41,10 +41,10 @@ int dlm_timebase_set(struct sr_scpi_dev_inst *scpi,
 	return sr_scpi_send(scpi, cmd);
 }
 
-int dlm_horiz_trigger_pos_get(struct sr_scpi_dev_inst *scpi,
+void dlm_horiz_trigger_pos_query(struct sr_scpi_batch *batch,
 		float *response)
 {
-	return sr_scpi_get_float(scpi, ":TRIGGER:DELAY:TIME?", response);
+	sr_scpi_batch_add_float(batch, response, ":TRIGGER:DELAY:TIME?");
 }
 
 int dlm_horiz_trigger_pos_set(struct sr_scpi_dev_inst *scpi,
@@ -55,10 +55,10 @@ int dlm_horiz_trigger_pos_set(struct sr_scpi_dev_inst *scpi,
 	return sr_scpi_send(scpi, cmd);
 }
 
-int dlm_trigger_source_get(struct sr_scpi_dev_inst *scpi,
+void dlm_trigger_source_query(struct sr_scpi_batch *batch,
 		gchar **response)
 {
-	return sr_scpi_get_string(scpi, ":TRIGGER:ATRIGGER:SIMPLE:SOURCE?", response);
+	sr_scpi_batch_add_string(batch, response, ":TRIGGER:ATRIGGER:SIMPLE:SOURCE?");
 }
 
 int dlm_trigger_source_set(struct sr_scpi_dev_inst *scpi,
@@ -69,32 +69,25 @@ int dlm_trigger_source_set(struct sr_scpi_dev_inst *scpi,
 	return sr_scpi_send(scpi, cmd);
 }
 
-int dlm_trigger_slope_get(struct sr_scpi_dev_inst *scpi,
-		int *response)
+void dlm_trigger_slope_query(struct sr_scpi_batch *batch,
+		gchar **response)
 {
-	gchar *resp;
-	int result;
-
-	result = SR_ERR;
-
-	if (sr_scpi_get_string(scpi, ":TRIGGER:ATRIGGER:SIMPLE:SLOPE?", &resp) != SR_OK) {
-		g_free(resp);
-		return SR_ERR;
-	}
+	sr_scpi_batch_add_string(batch, response, ":TRIGGER:ATRIGGER:SIMPLE:SLOPE?");
+}
 
-	if (strcmp("RISE", resp) == 0) {
-		*response = SLOPE_POSITIVE;
-		result = SR_OK;
+int dlm_trigger_slope_parse(const gchar *value, int *slope)
+{
+	if (!g_strcmp0("RISE", value)) {
+		*slope = SLOPE_POSITIVE;
+		return SR_OK;
 	}
 
-	if (strcmp("FALL", resp) == 0) {
-		*response = SLOPE_NEGATIVE;
-		result = SR_OK;
+	if (!g_strcmp0("FALL", value)) {
+		*slope = SLOPE_NEGATIVE;
+		return SR_OK;
 	}
 
-	g_free(resp);
-
-	return result;
+	return SR_ERR;
 }
 
 int dlm_trigger_slope_set(struct sr_scpi_dev_inst *scpi,
@@ -109,12 +102,10 @@ int dlm_trigger_slope_set(struct sr_scpi_dev_inst *scpi,
 	return SR_ERR_ARG;
 }
 
-int dlm_analog_chan_state_get(struct sr_scpi_dev_inst *scpi, int channel,
+void dlm_analog_chan_state_query(struct sr_scpi_batch *batch, int channel,
 		gboolean *response)
 {
-	gchar cmd[MAX_COMMAND_SIZE];
-	g_snprintf(cmd, sizeof(cmd), ":CHANNEL%d:DISPLAY?", channel);
-	return sr_scpi_get_bool(scpi, cmd, response);
+	sr_scpi_batch_add_bool(batch, response, ":CHANNEL%d:DISPLAY?", channel);
 }
 
 int dlm_analog_chan_state_set(struct sr_scpi_dev_inst *scpi, int channel,
@@ -130,12 +121,10 @@ int dlm_analog_chan_state_set(struct sr_scpi_dev_inst *scpi, int channel,
 	return sr_scpi_send(scpi, cmd);
 }
 
-int dlm_analog_chan_vdiv_get(struct sr_scpi_dev_inst *scpi, int channel,
+void dlm_analog_chan_vdiv_query(struct sr_scpi_batch *batch, int channel,
 		gchar **response)
 {
-	gchar cmd[MAX_COMMAND_SIZE];
-	g_snprintf(cmd, sizeof(cmd), ":CHANNEL%d:VDIV?", channel);
-	return sr_scpi_get_string(scpi, cmd, response);
+	sr_scpi_batch_add_string(batch, response, ":CHANNEL%d:VDIV?", channel);
 }
 
 int dlm_analog_chan_vdiv_set(struct sr_scpi_dev_inst *scpi, int channel,
@@ -146,12 +135,10 @@ int dlm_analog_chan_vdiv_set(struct sr_scpi_dev_inst *scpi, int channel,
 	return sr_scpi_send(scpi, cmd);
 }
 
-int dlm_analog_chan_voffs_get(struct sr_scpi_dev_inst *scpi, int channel,
+void dlm_analog_chan_voffs_query(struct sr_scpi_batch *batch, int channel,
 		float *response)
 {
-	gchar cmd[MAX_COMMAND_SIZE];
-	g_snprintf(cmd, sizeof(cmd), ":CHANNEL%d:POSITION?", channel);
-	return sr_scpi_get_float(scpi, cmd, response);
+	sr_scpi_batch_add_float(batch, response, ":CHANNEL%d:POSITION?", channel);
 }
 
 int dlm_analog_chan_srate_get(struct sr_scpi_dev_inst *scpi, int channel,
@@ -170,12 +157,10 @@ int dlm_analog_chan_srate_get(struct sr_scpi_dev_inst *scpi, int channel,
 	return sr_scpi_get_float(scpi, ":WAVEFORM:SRATE?", response);
 }
 
-int dlm_analog_chan_coupl_get(struct sr_scpi_dev_inst *scpi, int channel,
+void dlm_analog_chan_coupl_query(struct sr_scpi_batch *batch, int channel,
 		gchar **response)
 {
-	gchar cmd[MAX_COMMAND_SIZE];
-	g_snprintf(cmd, sizeof(cmd), ":CHANNEL%d:COUPLING?", channel);
-	return sr_scpi_get_string(scpi, cmd, response);
+	sr_scpi_batch_add_string(batch, response, ":CHANNEL%d:COUPLING?", channel);
 }
 
 int dlm_analog_chan_coupl_set(struct sr_scpi_dev_inst *scpi, int channel,
@@ -210,12 +195,10 @@ int dlm_analog_chan_woffs_get(struct sr_scpi_dev_inst *scpi, int channel,
 	return result;
 }
 
-int dlm_digital_chan_state_get(struct sr_scpi_dev_inst *scpi, int channel,
+void dlm_digital_chan_state_query(struct sr_scpi_batch *batch, int channel,
 		gboolean *response)
 {
-	gchar cmd[MAX_COMMAND_SIZE];
-	g_snprintf(cmd, sizeof(cmd), ":LOGIC:PODA:BIT%d:DISPLAY?", channel);
-	return sr_scpi_get_bool(scpi, cmd, response);
+	sr_scpi_batch_add_bool(batch, response, ":LOGIC:PODA:BIT%d:DISPLAY?", channel);
 }
 
 int dlm_digital_chan_state_set(struct sr_scpi_dev_inst *scpi, int channel,
@@ -231,16 +214,13 @@ int dlm_digital_chan_state_set(struct sr_scpi_dev_inst *scpi, int channel,
 	return sr_scpi_send(scpi, cmd);
 }
 
-int dlm_digital_pod_state_get(struct sr_scpi_dev_inst *scpi, int pod,
+void dlm_digital_pod_state_query(struct sr_scpi_batch *batch, int pod,
 		gboolean *response)
 {
-	gchar cmd[MAX_COMMAND_SIZE];
-
 	/* TODO: pod currently ignored as DLM2000 only has pod A. */
 	(void)pod;
 
-	g_snprintf(cmd, sizeof(cmd), ":LOGIC:MODE?");
-	return sr_scpi_get_bool(scpi, cmd, response);
+	sr_scpi_batch_add_bool(batch, response, ":LOGIC:MODE?");
 }
 
 int dlm_digital_pod_state_set(struct sr_scpi_dev_inst *scpi, int pod,
@@ -269,26 +249,10 @@ int dlm_acquisition_stop(struct sr_scpi_dev_inst *scpi)
 	return sr_scpi_send(scpi, ":STOP");
 }
 
-int dlm_acq_length_get(struct sr_scpi_dev_inst *scpi,
-		uint32_t *response)
+void dlm_acq_length_query(struct sr_scpi_batch *batch,
+		int *response)
 {
-	int ret;
-	char *s;
-	long tmp;
-
-	if (sr_scpi_get_string(scpi, ":WAVEFORM:LENGTH?", &s) != SR_OK)
-		if (!s)
-			return SR_ERR;
-
-	if (sr_atol(s, &tmp) == SR_OK)
-		ret = SR_OK;
-	else
-		ret = SR_ERR;
-
-	g_free(s);
-	*response = tmp;
-
-	return ret;
+	sr_scpi_batch_add_int(batch, response, ":WAVEFORM:LENGTH?");
 }
 
 int dlm_chunks_per_acq_get(struct sr_scpi_dev_inst *scpi, int *response)
@@ -171,6 +171,8 @@ static struct sr_key_info sr_key_info_config[] = {
 		"Equivalent circuit model", NULL},
 	{SR_CONF_OVER_TEMPERATURE_PROTECTION_ACTIVE, SR_T_BOOL, "otp_active",
 		"Over-temperature protection active", NULL},
+	{SR_CONF_NUM_DEVICES, SR_T_INT32, "devices",
+		"Number of devices", NULL},
 
 	/* Special stuff */
 	{SR_CONF_SCAN_OPTIONS, SR_T_STRING, "scan_options",
@@ -189,6 +191,10 @@ static struct sr_key_info sr_key_info_config[] = {
 		"Data source", NULL},
 	{SR_CONF_PROBE_FACTOR, SR_T_UINT64, "probe_factor",
 		"Probe factor", NULL},
+	{SR_CONF_BUFFER_OVERRUNS, SR_T_UINT64, "buffer_overruns",
+		"Buffer overruns", NULL},
+	{SR_CONF_BUFFER_UNDERRUNS, SR_T_UINT64, "buffer_underruns",
+		"Buffer underruns", NULL},
 
 	/* Acquisition modes, sample limiting */
 	{SR_CONF_LIMIT_MSEC, SR_T_UINT64, "limit_time",
@@ -205,6 +211,8 @@ static struct sr_key_info sr_key_info_config[] = {
 		"Device mode", NULL},
 	{SR_CONF_TEST_MODE, SR_T_STRING, "test_mode",
 		"Test mode", NULL},
+	{SR_CONF_UNTHROTTLED, SR_T_BOOL, "unthrottled",
+		"Unthrottled acquisition", NULL},
 
 	ALL_ZERO
 };
@@ -542,6 +550,147 @@ SR_PRIV void sr_config_free(struct sr_config *src)
 
 }
 
+struct config_cache_entry {
+	const struct sr_channel_group *cg;
+	uint32_t key;
+	GVariant *data;
+	int64_t timestamp;
+};
+
+struct sr_config_cache {
+	GMutex mutex;
+	/* Keys whose values only change through sr_config_set(). */
+	uint32_t *keys;
+	unsigned int num_keys;
+	/* Maximum age of a cached value, 0 for no limit. */
+	uint64_t ttl_us;
+	/* Array of struct config_cache_entry. */
+	GArray *entries;
+	struct sr_config_cache_stats stats;
+};
+
+/**
+ * Enable caching of config_get() results for a device instance.
+ *
+ * Values of the given keys are kept until the next sr_config_set() or
+ * sr_config_commit() on the device, until it's opened, closed or a
+ * channel is enabled or disabled, until an acquisition is started, or
+ * until they are older than the given time to live. Keys whose values
+ * can change by themselves, like measurements, must not be included.
+ *
+ * @param sdi The device instance.
+ * @param keys The cacheable keys.
+ * @param num_keys The number of keys.
+ * @param ttl_us The maximum age of a cached value in microseconds, or 0
+ *               if values are only changed through this library.
+ */
+SR_PRIV void sr_config_cache_enable(struct sr_dev_inst *sdi,
+		const uint32_t *keys, unsigned int num_keys, uint64_t ttl_us)
+{
+	struct sr_config_cache *cache;
+
+	sr_config_cache_free(sdi->config_cache);
+
+	cache = g_malloc0(sizeof(struct sr_config_cache));
+	g_mutex_init(&cache->mutex);
+	cache->keys = g_memdup(keys, num_keys * sizeof(uint32_t));
+	cache->num_keys = num_keys;
+	cache->ttl_us = ttl_us;
+	cache->entries = g_array_new(FALSE, FALSE,
+			sizeof(struct config_cache_entry));
+
+	sdi->config_cache = cache;
+}
+
+static void config_cache_clear(struct sr_config_cache *cache)
+{
+	unsigned int i;
+
+	g_mutex_lock(&cache->mutex);
+	for (i = 0; i < cache->entries->len; i++)
+		g_variant_unref(g_array_index(cache->entries,
+				struct config_cache_entry, i).data);
+	g_array_set_size(cache->entries, 0);
+	cache->stats.invalidations++;
+	g_mutex_unlock(&cache->mutex);
+}
+
+SR_PRIV void sr_config_cache_free(struct sr_config_cache *cache)
+{
+	if (!cache)
+		return;
+
+	config_cache_clear(cache);
+	g_array_free(cache->entries, TRUE);
+	g_free(cache->keys);
+	g_mutex_clear(&cache->mutex);
+	g_free(cache);
+}
+
+static struct sr_config_cache *config_cache_get(const struct sr_dev_inst *sdi,
+		uint32_t key)
+{
+	struct sr_config_cache *cache;
+	unsigned int i;
+
+	if (!sdi || !(cache = sdi->config_cache))
+		return NULL;
+
+	for (i = 0; i < cache->num_keys; i++)
+		if (cache->keys[i] == key)
+			return cache;
+
+	return NULL;
+}
+
+static int config_cache_lookup(struct sr_config_cache *cache,
+		const struct sr_channel_group *cg, uint32_t key, GVariant **data)
+{
+	struct config_cache_entry *entry;
+	unsigned int i;
+	int ret;
+
+	ret = SR_ERR_NA;
+
+	g_mutex_lock(&cache->mutex);
+	for (i = 0; i < cache->entries->len; i++) {
+		entry = &g_array_index(cache->entries, struct config_cache_entry, i);
+		if (entry->key != key || entry->cg != cg)
+			continue;
+		if (cache->ttl_us && g_get_monotonic_time() - entry->timestamp >=
+				(int64_t)cache->ttl_us) {
+			g_variant_unref(entry->data);
+			g_array_remove_index_fast(cache->entries, i);
+		} else {
+			*data = g_variant_ref(entry->data);
+			ret = SR_OK;
+		}
+		break;
+	}
+	if (ret == SR_OK)
+		cache->stats.hits++;
+	else
+		cache->stats.misses++;
+	g_mutex_unlock(&cache->mutex);
+
+	return ret;
+}
+
+static void config_cache_store(struct sr_config_cache *cache,
+		const struct sr_channel_group *cg, uint32_t key, GVariant *data)
+{
+	struct config_cache_entry entry;
+
+	entry.cg = cg;
+	entry.key = key;
+	entry.data = g_variant_ref(data);
+	entry.timestamp = g_get_monotonic_time();
+
+	g_mutex_lock(&cache->mutex);
+	g_array_append_val(cache->entries, entry);
+	g_mutex_unlock(&cache->mutex);
+}
+
 static void log_key(const struct sr_dev_inst *sdi,
 	const struct sr_channel_group *cg, uint32_t key, int op, GVariant *data)
 {
@@ -655,6 +804,7 @@ SR_API int sr_config_get(const struct sr_dev_driver *driver,
 		const struct sr_channel_group *cg,
 		uint32_t key, GVariant **data)
 {
+	struct sr_config_cache *cache;
 	int ret;
 
 	if (!driver || !data)
@@ -666,11 +816,19 @@ SR_API int sr_config_get(const struct sr_dev_driver *driver,
 	if (check_key(driver, sdi, cg, key, SR_CONF_GET, NULL) != SR_OK)
 		return SR_ERR_ARG;
 
+	cache = config_cache_get(sdi, key);
+	if (cache && config_cache_lookup(cache, cg, key, data) == SR_OK) {
+		log_key(sdi, cg, key, SR_CONF_GET, *data);
+		return SR_OK;
+	}
+
 	if ((ret = driver->config_get(key, data, sdi, cg)) == SR_OK) {
 		log_key(sdi, cg, key, SR_CONF_GET, *data);
 		/* Got a floating reference from the driver. Sink it here,
 		 * caller will need to unref when done with it. */
 		g_variant_ref_sink(*data);
+		if (cache)
+			config_cache_store(cache, cg, key, *data);
 	}
 
 	return ret;
@@ -712,6 +870,8 @@ SR_API int sr_config_set(const struct sr_dev_inst *sdi,
 	else if ((ret = sr_variant_type_check(key, data)) == SR_OK) {
 		log_key(sdi, cg, key, SR_CONF_SET, data);
 		ret = sdi->driver->config_set(key, data, sdi, cg);
+		/* Setting one key can change others, e.g. the samplerate. */
+		sr_config_cache_clear(sdi);
 	}
 
 	g_variant_unref(data);
@@ -733,8 +893,12 @@ SR_API int sr_config_commit(const struct sr_dev_inst *sdi)
 	int ret;
 
 	if (!sdi || !sdi->driver)
-		ret = SR_ERR;
-	else if (!sdi->driver->config_commit)
+		return SR_ERR;
+
+	/* Committing can change any setting on the device. */
+	sr_config_cache_clear(sdi);
+
+	if (!sdi->driver->config_commit)
 		ret = SR_OK;
 	else
 		ret = sdi->driver->config_commit(sdi);
@@ -742,6 +906,63 @@ SR_API int sr_config_commit(const struct sr_dev_inst *sdi)
 	return ret;
 }
 
+/**
+ * Clear the config cache of a device instance.
+ *
+ * Drivers can cache the values of settings which only change when set
+ * through this library. The cache is cleared automatically whenever
+ * that happens, and after a driver-specific time to live. This forces
+ * all values to be read from the device again, e.g. after they were
+ * changed on its front panel.
+ *
+ * @param sdi The device instance.
+ *
+ * @retval SR_OK Success, also if the driver doesn't use a cache.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_config_cache_clear(const struct sr_dev_inst *sdi)
+{
+	if (!sdi)
+		return SR_ERR_ARG;
+
+	if (sdi->config_cache)
+		config_cache_clear(sdi->config_cache);
+
+	return SR_OK;
+}
+
+/**
+ * Get the counters of the config cache of a device instance.
+ *
+ * @param sdi The device instance.
+ * @param stats Pointer where to store the counters.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ * @retval SR_ERR_NA The driver doesn't use a cache for this device.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_config_cache_stats_get(const struct sr_dev_inst *sdi,
+		struct sr_config_cache_stats *stats)
+{
+	struct sr_config_cache *cache;
+
+	if (!sdi || !stats)
+		return SR_ERR_ARG;
+
+	if (!(cache = sdi->config_cache))
+		return SR_ERR_NA;
+
+	g_mutex_lock(&cache->mutex);
+	*stats = cache->stats;
+	g_mutex_unlock(&cache->mutex);
+
+	return SR_OK;
+}
+
 /**
  * List all possible values for a configuration key.
  *
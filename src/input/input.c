@@ -27,6 +27,9 @@
 
 /** @cond PRIVATE */
 #define LOG_PREFIX "input"
+
+/* Number of threads sr_input_scan_files() uses by default. */
+#define SCAN_DEFAULT_THREADS 4
 /** @endcond */
 
 /**
@@ -326,36 +329,33 @@ static gboolean check_required_metadata(const uint8_t *metadata, uint8_t *avail)
 	return TRUE;
 }
 
-/**
- * Try to find an input module that can parse the given buffer.
- *
- * The buffer must contain enough of the beginning of the file for
- * the input modules to find a match. This is format-dependent, but
- * 128 bytes is normally enough.
- *
- * If an input module is found, an instance is created into *in.
- * Otherwise, *in contains NULL.
- *
- * If an instance is created, it has the given buffer used for scanning
- * already submitted to it, to be processed before more data is sent.
- * This allows a frontend to submit an initial chunk of a non-seekable
- * stream, such as stdin, without having to keep it around and submit
- * it again later.
- *
+/* Returns TRUE if the header starts with all of the given magic sequences. */
+static gboolean check_magic(const struct sr_input_magic *magic,
+		const GString *header)
+{
+	for (; magic->bytes; magic++) {
+		if (header->len < magic->offset + magic->len)
+			return FALSE;
+		if (memcmp(header->str + magic->offset, magic->bytes, magic->len))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Run all input modules' format_match() against the given metadata, and
+ * store the first matching module in *imod_out. Modules that declare
+ * magic sequences are only tried if the header matches them.
  */
-SR_API int sr_input_scan_buffer(GString *buf, const struct sr_input **in)
+static int match_modules(GHashTable *meta, uint8_t *avail_metadata,
+		const GString *header, const struct sr_input_module **imod_out)
 {
 	const struct sr_input_module *imod;
-	GHashTable *meta;
-	unsigned int m, i;
+	unsigned int i;
 	int ret;
-	uint8_t mitem, avail_metadata[8];
 
-	/* No more metadata to be had from a buffer. */
-	avail_metadata[0] = SR_INPUT_META_HEADER;
-	avail_metadata[1] = 0;
-
-	*in = NULL;
+	*imod_out = NULL;
 	ret = SR_ERR;
 	for (i = 0; input_module_list[i]; i++) {
 		imod = input_module_list[i];
@@ -367,36 +367,23 @@ SR_API int sr_input_scan_buffer(GString *buf, const struct sr_input **in)
 		if (!check_required_metadata(imod->metadata, avail_metadata))
 			/* Cannot satisfy this module's requirements. */
 			continue;
-
-		meta = g_hash_table_new(NULL, NULL);
-		for (m = 0; m < sizeof(imod->metadata); m++) {
-			mitem = imod->metadata[m] & ~SR_INPUT_META_REQUIRED;
-			if (mitem == SR_INPUT_META_HEADER)
-				g_hash_table_insert(meta, GINT_TO_POINTER(mitem), buf);
-		}
-		if (g_hash_table_size(meta) == 0) {
-			/* No metadata for this module, so nothing to match. */
-			g_hash_table_destroy(meta);
+		if (imod->magic && !check_magic(imod->magic, header))
+			/* Doesn't carry this format's magic. */
 			continue;
-		}
+
 		sr_spew("Trying module %s.", imod->id);
 		ret = imod->format_match(meta);
-		g_hash_table_destroy(meta);
-		if (ret == SR_ERR_DATA) {
-			/* Module recognized this buffer, but cannot handle it. */
-			break;
-		} else if (ret == SR_ERR) {
+		if (ret == SR_ERR) {
 			/* Module didn't recognize this buffer. */
 			continue;
 		} else if (ret != SR_OK) {
-			/* Can be SR_ERR_NA. */
-			return ret;
+			/* Module recognized this buffer, but cannot handle it. */
+			break;
 		}
 
 		/* Found a matching module. */
 		sr_spew("Module %s matched.", imod->id);
-		*in = sr_input_new(imod, NULL);
-		g_string_insert_len((*in)->buf, 0, buf->str, buf->len);
+		*imod_out = imod;
 		break;
 	}
 
@@ -404,25 +391,68 @@ SR_API int sr_input_scan_buffer(GString *buf, const struct sr_input **in)
 }
 
 /**
- * Try to find an input module that can parse the given file.
+ * Try to find an input module that can parse the given buffer.
+ *
+ * The buffer must contain enough of the beginning of the file for
+ * the input modules to find a match. This is format-dependent, but
+ * 128 bytes is normally enough.
  *
  * If an input module is found, an instance is created into *in.
  * Otherwise, *in contains NULL.
  *
+ * If an instance is created, it has the given buffer used for scanning
+ * already submitted to it, to be processed before more data is sent.
+ * This allows a frontend to submit an initial chunk of a non-seekable
+ * stream, such as stdin, without having to keep it around and submit
+ * it again later.
+ *
  */
-SR_API int sr_input_scan_file(const char *filename, const struct sr_input **in)
+SR_API int sr_input_scan_buffer(GString *buf, const struct sr_input **in)
+{
+	const struct sr_input_module *imod;
+	GHashTable *meta;
+	int ret;
+	uint8_t avail_metadata[8];
+
+	/* No more metadata to be had from a buffer. */
+	avail_metadata[0] = SR_INPUT_META_HEADER;
+	avail_metadata[1] = 0;
+
+	*in = NULL;
+	meta = g_hash_table_new(NULL, NULL);
+	g_hash_table_insert(meta, GINT_TO_POINTER(SR_INPUT_META_HEADER), buf);
+	ret = match_modules(meta, avail_metadata, buf, &imod);
+	g_hash_table_destroy(meta);
+
+	if (imod) {
+		*in = sr_input_new(imod, NULL);
+		if (*in)
+			g_string_insert_len((*in)->buf, 0, buf->str, buf->len);
+	}
+
+	return ret;
+}
+
+/*
+ * Identify the format of the given file. If stream_out is not NULL, the
+ * file is kept open and returned there along with the header that was
+ * read from it, so the caller can continue reading where detection
+ * stopped.
+ */
+static int scan_file(const char *filename,
+		const struct sr_input_module **imod_out,
+		FILE **stream_out, GString **header_out)
 {
 	int64_t filesize;
 	FILE *stream;
-	const struct sr_input_module *imod;
 	GHashTable *meta;
 	GString *header;
 	size_t count;
-	unsigned int midx, i;
+	unsigned int midx;
 	int ret;
 	uint8_t avail_metadata[8];
 
-	*in = NULL;
+	*imod_out = NULL;
 
 	if (!filename || !filename[0]) {
 		sr_err("Invalid filename.");
@@ -450,7 +480,6 @@ SR_API int sr_input_scan_file(const char *filename, const struct sr_input **in)
 		g_string_free(header, TRUE);
 		return SR_ERR;
 	}
-	fclose(stream);
 	g_string_set_size(header, count);
 
 	meta = g_hash_table_new(NULL, NULL);
@@ -467,41 +496,172 @@ SR_API int sr_input_scan_file(const char *filename, const struct sr_input **in)
 	avail_metadata[midx] = 0;
 	/* TODO: MIME type */
 
-	ret = SR_ERR;
+	ret = match_modules(meta, avail_metadata, header, imod_out);
+	g_hash_table_destroy(meta);
 
-	for (i = 0; input_module_list[i]; i++) {
-		imod = input_module_list[i];
-		if (!imod->metadata[0]) {
-			/* Module has no metadata for matching so will take
-			 * any input. No point in letting it try to match. */
-			continue;
-		}
-		if (!check_required_metadata(imod->metadata, avail_metadata))
-			/* Cannot satisfy this module's requirements. */
-			continue;
+	if (*imod_out && stream_out) {
+		*stream_out = stream;
+		*header_out = header;
+	} else {
+		fclose(stream);
+		g_string_free(header, TRUE);
+	}
 
-		sr_dbg("Trying module %s.", imod->id);
+	return ret;
+}
 
-		ret = imod->format_match(meta);
-		if (ret == SR_ERR) {
-			/* Module didn't recognize this buffer. */
-			continue;
-		} else if (ret != SR_OK) {
-			/* Module recognized this buffer, but cannot handle it. */
-			break;
-		}
-		/* Found a matching module. */
-		sr_dbg("Module %s matched.", imod->id);
+/**
+ * Try to find an input module that can parse the given file.
+ *
+ * If an input module is found, an instance is created into *in.
+ * Otherwise, *in contains NULL.
+ *
+ */
+SR_API int sr_input_scan_file(const char *filename, const struct sr_input **in)
+{
+	const struct sr_input_module *imod;
+	int ret;
 
+	*in = NULL;
+	ret = scan_file(filename, &imod, NULL, NULL);
+	if (imod)
 		*in = sr_input_new(imod, NULL);
-		break;
+
+	return ret;
+}
+
+/**
+ * Try to find an input module that can parse the given file, and keep
+ * the file open for feeding its data to the module.
+ *
+ * This works like sr_input_scan_file(), but avoids opening the file a
+ * second time and reading its beginning again. If an input module is
+ * found, an instance is created into *in, with the part of the file
+ * that was used for identifying it already submitted to it, and *stream
+ * is left open and positioned right after that part. The caller should
+ * continue with sr_input_send() from there, and close the stream when
+ * done.
+ *
+ * Otherwise, *in and *stream contain NULL.
+ *
+ * @param filename The file to scan. Must not be NULL.
+ * @param in Pointer to store the new input instance in. Must not be NULL.
+ * @param stream Pointer to store the open file in. Must not be NULL.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ * @retval SR_ERR_DATA The format was recognized, but cannot be handled.
+ * @retval other The file could not be read or identified.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_input_scan_file_stream(const char *filename,
+		const struct sr_input **in, FILE **stream)
+{
+	const struct sr_input_module *imod;
+	GString *header;
+	int ret;
+
+	if (!in || !stream)
+		return SR_ERR_ARG;
+
+	*in = NULL;
+	*stream = NULL;
+	ret = scan_file(filename, &imod, stream, &header);
+	if (!imod)
+		return ret;
+
+	*in = sr_input_new(imod, NULL);
+	if (!*in) {
+		fclose(*stream);
+		*stream = NULL;
+	} else {
+		g_string_insert_len((*in)->buf, 0, header->str, header->len);
 	}
-	g_hash_table_destroy(meta);
 	g_string_free(header, TRUE);
 
 	return ret;
 }
 
+/** @cond PRIVATE */
+struct scan_job {
+	const char *filename;
+	const struct sr_input_module **imod;
+};
+/** @endcond */
+
+static void scan_file_job(gpointer data, gpointer user_data)
+{
+	struct scan_job *job;
+
+	(void)user_data;
+
+	job = data;
+	scan_file(job->filename, job->imod, NULL, NULL);
+}
+
+/**
+ * Identify the input format of a list of files.
+ *
+ * The files are scanned in parallel by a pool of worker threads. No
+ * input instances are created; use sr_input_new() with the resulting
+ * modules for the files that are to be loaded.
+ *
+ * @param filenames NULL-terminated list of files to scan. Must not be NULL.
+ * @param modules Array with room for one entry per file, which receives
+ *                the input module matching that file, or NULL if the
+ *                file could not be read or identified. Must not be NULL.
+ * @param num_threads Maximum number of threads to use. Values of zero or
+ *                    less select a default.
+ *
+ * @retval SR_OK Success. Unidentified files are not considered an error.
+ * @retval SR_ERR_ARG Invalid argument.
+ * @retval SR_ERR Failed to start the worker threads.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_input_scan_files(const char **filenames,
+		const struct sr_input_module **modules, int num_threads)
+{
+	GThreadPool *pool;
+	GError *error;
+	struct scan_job *jobs;
+	unsigned int num_files, i;
+
+	if (!filenames || !modules)
+		return SR_ERR_ARG;
+
+	for (num_files = 0; filenames[num_files]; num_files++)
+		modules[num_files] = NULL;
+	if (num_files == 0)
+		return SR_OK;
+
+	if (num_threads <= 0)
+		num_threads = SCAN_DEFAULT_THREADS;
+
+	error = NULL;
+	pool = g_thread_pool_new(scan_file_job, NULL,
+			MIN((unsigned int)num_threads, num_files), TRUE, &error);
+	if (!pool) {
+		sr_err("Failed to create scan threads: %s.", error->message);
+		g_error_free(error);
+		return SR_ERR;
+	}
+
+	jobs = g_malloc(num_files * sizeof(struct scan_job));
+	for (i = 0; i < num_files; i++) {
+		jobs[i].filename = filenames[i];
+		jobs[i].imod = &modules[i];
+		g_thread_pool_push(pool, &jobs[i], NULL);
+	}
+
+	/* Wait for all queued jobs to finish. */
+	g_thread_pool_free(pool, FALSE, TRUE);
+	g_free(jobs);
+
+	return SR_OK;
+}
+
 /**
  * Return the input instance's (virtual) device instance. This can be
  * used to find out the number of channels and other information.
@@ -31,7 +31,7 @@
 #define LOG_PREFIX "input/wav"
 
 /* How many bytes at a time to process and send to the session bus. */
-#define CHUNK_SIZE 4096
+#define CHUNK_SIZE (1024 * 1024)
 
 /* Minimum size of header + 1 8-bit mono PCM sample. */
 #define MIN_DATA_CHUNK_OFFSET    45
@@ -51,6 +51,8 @@ struct context {
 	int num_channels;
 	int unitsize;
 	gboolean found_data;
+	gboolean native;
+	float *fdata;
 };
 
 static int parse_wav_header(GString *buf, struct context *inc)
@@ -69,8 +71,8 @@ static int parse_wav_header(GString *buf, struct context *inc)
 	if (num_channels == 0)
 		return SR_ERR;
 	unitsize = samplesize / num_channels;
-	if (unitsize != 1 && unitsize != 2 && unitsize != 4) {
-		sr_err("Only 8, 16 or 32 bits per sample supported.");
+	if (unitsize < 1 || unitsize > 4) {
+		sr_err("Only 8, 16, 24 or 32 bits per sample supported.");
 		return SR_ERR_DATA;
 	}
 
@@ -148,10 +150,11 @@ static int format_match(GHashTable *metadata)
 
 static int init(struct sr_input *in, GHashTable *options)
 {
-	(void)options;
+	struct context *inc;
 
 	in->sdi = g_malloc0(sizeof(struct sr_dev_inst));
-	in->priv = g_malloc0(sizeof(struct context));
+	in->priv = inc = g_malloc0(sizeof(struct context));
+	inc->native = g_variant_get_boolean(g_hash_table_lookup(options, "native"));
 
 	return SR_OK;
 }
@@ -181,56 +184,125 @@ static int find_data_chunk(GString *buf, int initial_offset)
 	return offset;
 }
 
+/*
+ * Sample decoders, one per WAV sample format. Each one converts 'count'
+ * interleaved little endian samples to floats in a single tight loop,
+ * which the compiler can vectorize.
+ */
+static void decode_u8(float *out, const uint8_t *s, unsigned int count)
+{
+	unsigned int i;
+
+	/* 8-bit PCM samples are unsigned. */
+	for (i = 0; i < count; i++)
+		out[i] = s[i] / (float)255;
+}
+
+static void decode_s16(float *out, const uint8_t *s, unsigned int count)
+{
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		out[i] = RL16S(s + i * 2) / (float)INT16_MAX;
+}
+
+static void decode_s24(float *out, const uint8_t *s, unsigned int count)
+{
+	unsigned int i;
+	int32_t v;
+
+	for (i = 0; i < count; i++) {
+		/* Shift into the top bits and back for the sign extension. */
+		v = (int32_t)(((uint32_t)s[i * 3 + 2] << 24)
+				| ((uint32_t)s[i * 3 + 1] << 16)
+				| ((uint32_t)s[i * 3] << 8)) >> 8;
+		out[i] = v / (float)0x7fffff;
+	}
+}
+
+static void decode_s32(float *out, const uint8_t *s, unsigned int count)
+{
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		out[i] = RL32S(s + i * 4) / (float)INT32_MAX;
+}
+
+static void decode_float(float *out, const uint8_t *s, unsigned int count)
+{
+	unsigned int i;
+
+	/* BINARY32 float */
+	for (i = 0; i < count; i++)
+		out[i] = RLFL(s + i * 4);
+}
+
+/* Full-scale value of a PCM sample, used as the native encoding's scale. */
+static uint64_t pcm_full_scale(int unitsize)
+{
+	switch (unitsize) {
+	case 1:
+		return 255;
+	case 2:
+		return INT16_MAX;
+	default:
+		return INT32_MAX;
+	}
+}
+
 static void send_chunk(const struct sr_input *in, int offset, int num_samples)
 {
 	struct sr_datafeed_packet packet;
-	struct sr_datafeed_analog_old analog;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
 	struct context *inc;
-	float fdata[CHUNK_SIZE];
-	int total_samples, samplenum;
-	char *s, *d;
+	const uint8_t *s;
+	unsigned int count;
 
 	inc = in->priv;
 
-	s = in->buf->str + offset;
-	d = (char *)fdata;
-	memset(fdata, 0, CHUNK_SIZE);
-	total_samples = num_samples * inc->num_channels;
-	for (samplenum = 0; samplenum < total_samples; samplenum++) {
-		if (inc->fmt_code == WAVE_FORMAT_PCM_) {
-			switch (inc->unitsize) {
-			case 1:
-				/* 8-bit PCM samples are unsigned. */
-				fdata[samplenum] = *(uint8_t*)(s) / (float)255;
-				break;
-			case 2:
-				fdata[samplenum] = RL16S(s) / (float)INT16_MAX;
-				break;
-			case 4:
-				fdata[samplenum] = RL32S(s) / (float)INT32_MAX;
-				break;
-			}
-		} else {
-			/* BINARY32 float */
-#ifdef WORDS_BIGENDIAN
-			int i;
-			for (i = 0; i < inc->unitsize; i++)
-				d[i] = s[inc->unitsize - 1 - i];
-#else
-			memcpy(d, s, inc->unitsize);
+	s = (const uint8_t *)in->buf->str + offset;
+	count = num_samples * inc->num_channels;
+
+	sr_analog_init(&analog, &encoding, &meaning, &spec, 0);
+	analog.num_samples = num_samples;
+	meaning.channels = in->sdi->channels;
+	encoding.is_signed = TRUE;
+
+	if (inc->fmt_code == WAVE_FORMAT_PCM_ && inc->native
+			&& inc->unitsize != 3) {
+		/* Pass the samples on as they are, and let the consumer scale. */
+		encoding.unitsize = inc->unitsize;
+		encoding.is_float = FALSE;
+		/* 8-bit PCM samples are unsigned. */
+		encoding.is_signed = inc->unitsize != 1;
+		encoding.is_bigendian = FALSE;
+		encoding.scale.q = pcm_full_scale(inc->unitsize);
+		analog.data = (void *)s;
+#ifndef WORDS_BIGENDIAN
+	} else if (inc->fmt_code == WAVE_FORMAT_IEEE_FLOAT_
+			&& ((uintptr_t)s % sizeof(float)) == 0) {
+		/* Already in host float format, no need to copy. */
+		analog.data = (void *)s;
 #endif
-		}
-		s += inc->unitsize;
-		d += inc->unitsize;
+	} else {
+		if (inc->fmt_code == WAVE_FORMAT_IEEE_FLOAT_)
+			decode_float(inc->fdata, s, count);
+		else if (inc->unitsize == 1)
+			decode_u8(inc->fdata, s, count);
+		else if (inc->unitsize == 2)
+			decode_s16(inc->fdata, s, count);
+		else if (inc->unitsize == 3)
+			decode_s24(inc->fdata, s, count);
+		else
+			decode_s32(inc->fdata, s, count);
+		analog.data = inc->fdata;
 	}
-	packet.type = SR_DF_ANALOG_OLD;
+
+	packet.type = SR_DF_ANALOG;
 	packet.payload = &analog;
-	analog.channels = in->sdi->channels;
-	analog.num_samples = num_samples;
-	analog.mq = 0;
-	analog.mqflags = 0;
-	analog.unit = 0;
-	analog.data = fdata;
 	sr_session_send(in->sdi, &packet);
 }
 
@@ -261,6 +333,7 @@ static int process_buffer(struct sr_input *in)
 		g_slist_free(meta.config);
 		sr_config_free(src);
 
+		inc->fdata = g_malloc(CHUNK_SIZE / inc->unitsize * sizeof(float));
 		inc->started = TRUE;
 	}
 
@@ -359,14 +432,44 @@ static int end(struct sr_input *in)
 	return ret;
 }
 
+static void cleanup(struct sr_input *in)
+{
+	struct context *inc;
+
+	inc = in->priv;
+	g_free(inc->fdata);
+	inc->fdata = NULL;
+}
+
+static struct sr_option options[] = {
+	{ "native", "Native encoding", "Pass PCM samples on in their native integer encoding", NULL, NULL },
+	ALL_ZERO
+};
+
+static const struct sr_option *get_options(void)
+{
+	if (!options[0].def)
+		options[0].def = g_variant_ref_sink(g_variant_new_boolean(FALSE));
+
+	return options;
+}
+
 SR_PRIV struct sr_input_module input_wav = {
 	.id = "wav",
 	.name = "WAV",
 	.desc = "WAV file",
 	.exts = (const char*[]){"wav", NULL},
 	.metadata = { SR_INPUT_META_HEADER | SR_INPUT_META_REQUIRED },
+	.magic = (const struct sr_input_magic[]){
+		{ 0, 4, "RIFF" },
+		{ 8, 4, "WAVE" },
+		{ 12, 4, "fmt " },
+		ALL_ZERO
+	},
+	.options = get_options,
 	.format_match = format_match,
 	.init = init,
 	.receive = receive,
 	.end = end,
+	.cleanup = cleanup,
 };
@@ -27,80 +27,6 @@
 
 #define LOG_PREFIX "es51919"
 
-struct dev_buffer {
-	/** Total size of the buffer. */
-	size_t size;
-	/** Amount of data currently in the buffer. */
-	size_t len;
-	/** Offset where the data starts in the buffer. */
-	size_t offset;
-	/** Space for the data. */
-	uint8_t data[];
-};
-
-static struct dev_buffer *dev_buffer_new(size_t size)
-{
-	struct dev_buffer *dbuf;
-
-	dbuf = g_malloc0(sizeof(struct dev_buffer) + size);
-	dbuf->size = size;
-	dbuf->len = 0;
-	dbuf->offset = 0;
-
-	return dbuf;
-}
-
-static void dev_buffer_destroy(struct dev_buffer *dbuf)
-{
-	g_free(dbuf);
-}
-
-static int dev_buffer_fill_serial(struct dev_buffer *dbuf,
-				  struct sr_dev_inst *sdi)
-{
-	struct sr_serial_dev_inst *serial;
-	int len;
-
-	serial = sdi->conn;
-
-	/* If we already have data, move it to the beginning of the buffer. */
-	if (dbuf->len > 0 && dbuf->offset > 0)
-		memmove(dbuf->data, dbuf->data + dbuf->offset, dbuf->len);
-
-	dbuf->offset = 0;
-
-	len = dbuf->size - dbuf->len;
-	len = serial_read_nonblocking(serial, dbuf->data + dbuf->len, len);
-	if (len < 0) {
-		sr_err("Serial port read error: %d.", len);
-		return len;
-	}
-
-	dbuf->len += len;
-
-	return SR_OK;
-}
-
-static uint8_t *dev_buffer_packet_find(struct dev_buffer *dbuf,
-				gboolean (*packet_valid)(const uint8_t *),
-				size_t packet_size)
-{
-	size_t offset;
-
-	while (dbuf->len >= packet_size) {
-		if (packet_valid(dbuf->data + dbuf->offset)) {
-			offset = dbuf->offset;
-			dbuf->offset += packet_size;
-			dbuf->len -= packet_size;
-			return dbuf->data + offset;
-		}
-		dbuf->offset++;
-		dbuf->len--;
-	}
-
-	return NULL;
-}
-
 struct dev_limit_counter {
 	/** The current number of received samples/frames/etc. */
 	uint64_t count;
@@ -424,9 +350,6 @@ struct dev_context {
 	/** The time limit counter. */
 	struct dev_time_counter time_count;
 
-	/** Data buffer. */
-	struct dev_buffer *buf;
-
 	/** The frequency of the test signal (index to frequencies[]). */
 	unsigned int freq;
 
@@ -592,6 +515,15 @@ static gboolean packet_valid(const uint8_t *pkt)
 	return FALSE;
 }
 
+static const struct sr_framing framing = {
+	.type = SR_FRAMING_FIXED,
+	.size = PACKET_SIZE,
+	.has_sync = TRUE,
+	.sync = 0xd,
+	.sync_offset = 15,
+	.is_valid = packet_valid,
+};
+
 static int do_config_update(struct sr_dev_inst *sdi, uint32_t key,
 			    GVariant *var)
 {
@@ -692,18 +624,19 @@ static void handle_packet(struct sr_dev_inst *sdi, const uint8_t *pkt)
 
 static int handle_new_data(struct sr_dev_inst *sdi)
 {
-	struct dev_context *devc;
-	uint8_t *pkt;
+	struct sr_serial_dev_inst *serial;
+	const uint8_t *pkt;
 	int ret;
 
-	devc = sdi->priv;
+	serial = sdi->conn;
 
-	ret = dev_buffer_fill_serial(devc->buf, sdi);
-	if (ret < 0)
+	ret = serial_rx_fill(serial, 0);
+	if (ret < 0) {
+		sr_err("Serial port read error: %d.", ret);
 		return ret;
+	}
 
-	while ((pkt = dev_buffer_packet_find(devc->buf, packet_valid,
-					     PACKET_SIZE)))
+	while (serial_rx_frame(serial, &framing, &pkt) > 0)
 		handle_packet(sdi, pkt);
 
 	return SR_OK;
@@ -756,7 +689,6 @@ SR_PRIV void es51919_serial_clean(void *priv)
 	if (!(devc = priv))
 		return;
 
-	dev_buffer_destroy(devc->buf);
 	g_free(devc);
 }
 
@@ -788,7 +720,6 @@ SR_PRIV struct sr_dev_inst *es51919_serial_scan(GSList *options,
 	sdi->vendor = g_strdup(vendor);
 	sdi->model = g_strdup(model);
 	devc = g_malloc0(sizeof(struct dev_context));
-	devc->buf = dev_buffer_new(PACKET_SIZE * 8);
 	sdi->inst_type = SR_INST_SERIAL;
 	sdi->conn = serial;
 	sdi->priv = devc;
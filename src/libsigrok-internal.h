@@ -240,6 +240,16 @@ struct sr_input {
 	void *priv;
 };
 
+/** Magic byte sequence identifying an input format. */
+struct sr_input_magic {
+	/** Offset of the sequence from the start of the stream. */
+	size_t offset;
+	/** Length of the sequence in bytes. */
+	size_t len;
+	/** The bytes to match, or NULL to terminate a list. */
+	const char *bytes;
+};
+
 /** Input (file) module driver. */
 struct sr_input_module {
 	/**
@@ -284,6 +294,16 @@ struct sr_input_module {
 	 */
 	const uint8_t metadata[8];
 
+	/**
+	 * List of byte sequences at fixed offsets that every stream in this
+	 * format starts with, terminated by an entry with NULL bytes. Can be
+	 * NULL if the format has no such magic.
+	 *
+	 * When scanning a stream header, format_match() is only called if
+	 * all sequences match, so formats with magic are rejected cheaply.
+	 */
+	const struct sr_input_magic *magic;
+
 	/**
 	 * Returns a NULL-terminated list of options this module can take.
 	 * Can be NULL, if the module has no options.
@@ -468,6 +488,27 @@ struct sr_output_module {
 	int (*cleanup) (struct sr_output *o);
 };
 
+/** Element-wise operations, which transforms can be fused into. */
+enum sr_transform_op_type {
+	/** The values are passed on unchanged. */
+	SR_TRANSFORM_OP_NONE,
+	/** All bits of each logic sample are inverted. */
+	SR_TRANSFORM_OP_INVERT,
+	/** Each analog value x becomes x * mul + add. */
+	SR_TRANSFORM_OP_AFFINE,
+	/** Each analog value x becomes 1 / x. */
+	SR_TRANSFORM_OP_RECIPROCAL,
+};
+
+/** What a transform does to each sample of one data packet type. */
+struct sr_transform_op {
+	enum sr_transform_op_type type;
+	/** Factor, for SR_TRANSFORM_OP_AFFINE. */
+	float mul;
+	/** Term added after the factor, for SR_TRANSFORM_OP_AFFINE. */
+	float add;
+};
+
 /** Transform module instance. */
 struct sr_transform {
 	/** A pointer to this transform's module.  */
@@ -544,6 +585,25 @@ struct sr_transform_module {
 			struct sr_datafeed_packet *packet_in,
 			struct sr_datafeed_packet **packet_out);
 
+	/**
+	 * This function describes what receive() does to the samples of
+	 * one data packet type, if that is an element-wise operation.
+	 * Sequences of such transforms are then applied in a single pass
+	 * over the data, without calling receive(). Can be NULL.
+	 *
+	 * Transform modules which have this function must pass all other
+	 * packet types on unmodified.
+	 *
+	 * @param t Pointer to the respective 'struct sr_transform'.
+	 * @param packet_type SR_DF_LOGIC, SR_DF_ANALOG_OLD or SR_DF_ANALOG.
+	 * @param op The operation, filled in by this function.
+	 *
+	 * @retval SR_OK Success
+	 * @retval SR_ERR_NA Packets of this type have to go to receive().
+	 */
+	int (*fuse) (const struct sr_transform *t, int packet_type,
+			struct sr_transform_op *op);
+
 	/**
 	 * This function is called after the caller is finished using
 	 * the transform module, and can be used to free any internal
@@ -568,6 +628,9 @@ struct sr_usb_dev_inst {
 #endif
 
 #ifdef HAVE_LIBSERIALPORT
+/** Size of the receive buffer of a serial port. */
+#define SERIAL_RX_BUFSIZE 4096
+
 struct sr_serial_dev_inst {
 	/** Port name, e.g. '/dev/tty42'. */
 	char *port;
@@ -575,6 +638,12 @@ struct sr_serial_dev_inst {
 	char *serialcomm;
 	/** libserialport port handle */
 	struct sp_port *data;
+	/** Received bytes not consumed yet, see serial_rx_fill(). */
+	uint8_t rx_buf[SERIAL_RX_BUFSIZE];
+	/** Offset of the first unconsumed byte in rx_buf. */
+	size_t rx_start;
+	/** Number of unconsumed bytes in rx_buf. */
+	size_t rx_len;
 };
 #endif
 
@@ -603,12 +672,27 @@ SR_PRIV int sr_log(int loglevel, const char *format, ...)
 SR_PRIV int sr_log(int loglevel, const char *format, ...) G_GNUC_PRINTF(2, 3);
 #endif
 
-/* Message logging helpers with subsystem-specific prefix string. */
-#define sr_spew(...)	sr_log(SR_LOG_SPEW, LOG_PREFIX ": " __VA_ARGS__)
-#define sr_dbg(...)	sr_log(SR_LOG_DBG,  LOG_PREFIX ": " __VA_ARGS__)
-#define sr_info(...)	sr_log(SR_LOG_INFO, LOG_PREFIX ": " __VA_ARGS__)
-#define sr_warn(...)	sr_log(SR_LOG_WARN, LOG_PREFIX ": " __VA_ARGS__)
-#define sr_err(...)	sr_log(SR_LOG_ERR,  LOG_PREFIX ": " __VA_ARGS__)
+/* Currently selected loglevel, only to be read by the macros below. */
+SR_PRIV extern int sr_log_loglevel;
+
+/*
+ * Message logging helpers with subsystem-specific prefix string.
+ *
+ * Messages above the current loglevel cost a single comparison: the
+ * arguments are not evaluated and sr_log() is not called.
+ */
+#define sr_log_if(cond, level, ...) \
+	((cond) ? sr_log(level, LOG_PREFIX ": " __VA_ARGS__) : SR_OK)
+#define sr_spew(...)	sr_log_if(G_UNLIKELY(SR_LOG_SPEW <= sr_log_loglevel), \
+				SR_LOG_SPEW, __VA_ARGS__)
+#define sr_dbg(...)	sr_log_if(G_UNLIKELY(SR_LOG_DBG <= sr_log_loglevel), \
+				SR_LOG_DBG, __VA_ARGS__)
+#define sr_info(...)	sr_log_if(SR_LOG_INFO <= sr_log_loglevel, \
+				SR_LOG_INFO, __VA_ARGS__)
+#define sr_warn(...)	sr_log_if(SR_LOG_WARN <= sr_log_loglevel, \
+				SR_LOG_WARN, __VA_ARGS__)
+#define sr_err(...)	sr_log_if(SR_LOG_ERR <= sr_log_loglevel, \
+				SR_LOG_ERR, __VA_ARGS__)
 
 /*--- device.c --------------------------------------------------------------*/
 
@@ -651,6 +735,8 @@ struct sr_dev_inst {
 	void *priv;
 	/** Session to which this device is currently assigned. */
 	struct sr_session *session;
+	/** Cache of config_get() results, NULL unless enabled by the driver. */
+	struct sr_config_cache *config_cache;
 };
 
 /* Generic device instances */
@@ -683,6 +769,9 @@ SR_PRIV int sr_variant_type_check(uint32_t key, GVariant *data);
 SR_PRIV void sr_hw_cleanup_all(const struct sr_context *ctx);
 SR_PRIV struct sr_config *sr_config_new(uint32_t key, GVariant *data);
 SR_PRIV void sr_config_free(struct sr_config *src);
+SR_PRIV void sr_config_cache_enable(struct sr_dev_inst *sdi,
+		const uint32_t *keys, unsigned int num_keys, uint64_t ttl_us);
+SR_PRIV void sr_config_cache_free(struct sr_config_cache *cache);
 
 /*--- session.c -------------------------------------------------------------*/
 
@@ -696,6 +785,8 @@ struct sr_session {
 	/** List of struct datafeed_callback pointers. */
 	GSList *datafeed_callbacks;
 	GSList *transforms;
+	/** The transforms fused for single pass processing, or NULL. */
+	struct sr_transform_chain *transform_chain;
 	struct sr_trigger *trigger;
 
 	/** Callback to invoke on session stop. */
@@ -703,7 +794,10 @@ struct sr_session {
 	/** User data to be passed to the session stop callback. */
 	void *stopped_cb_data;
 
-	/** Mutex protecting the main context pointer. */
+	/**
+	 * Mutex protecting the main context pointer, the event sources
+	 * and the stop check, which device threads access too.
+	 */
 	GMutex main_mutex;
 	/** Context of the session main loop. */
 	GMainContext *main_context;
@@ -716,6 +810,24 @@ struct sr_session {
 	unsigned int stop_check_id;
 	/** Whether the session has been started. */
 	gboolean running;
+
+	/**
+	 * Pipeline statistics, struct sr_session_stats pointers. NULL
+	 * unless enabled with sr_session_stats_enable().
+	 */
+	GPtrArray *stats;
+	/** Mutex protecting the statistics. */
+	GMutex stats_mutex;
+
+	/** Threading policy, enum sr_session_threading. */
+	int threading;
+	/** Device threads, while running with SR_SESSION_THREADING_PER_DEVICE. */
+	struct session_threads *threads;
+
+	/** Sample clocks of the devices, struct sr_dev_clock by device. */
+	GHashTable *clocks;
+	/** Start of the session timeline, g_get_monotonic_time(). */
+	int64_t timeline_zero_us;
 };
 
 SR_PRIV int sr_session_source_add_internal(struct sr_session *session,
@@ -728,6 +840,13 @@ SR_PRIV int sr_session_fd_source_add(struct sr_session *session,
 		void *key, gintptr fd, int events, int timeout,
 		sr_receive_data_callback cb, void *cb_data);
 
+SR_PRIV uint64_t sr_session_stats_time(void);
+SR_PRIV void sr_session_stats_add(struct sr_session *session,
+		const struct sr_dev_inst *sdi, int stage, int index,
+		uint64_t bytes, uint64_t start_ns);
+SR_PRIV void sr_session_stats_add_source(struct sr_session *session,
+		void *cb_data, uint64_t start_ns);
+
 SR_PRIV int sr_session_source_add(struct sr_session *session, int fd,
 		int events, int timeout, sr_receive_data_callback cb, void *cb_data);
 SR_PRIV int sr_session_source_add_pollfd(struct sr_session *session,
@@ -760,6 +879,20 @@ SR_PRIV void sr_zip_discard(struct zip *archive);
 SR_PRIV GKeyFile *sr_sessionfile_read_metadata(struct zip *archive,
 			const struct zip_stat *entry);
 
+/*--- timeline.c ------------------------------------------------------------*/
+
+/** Sample clock of a device, mapping it onto the session timeline. */
+struct sr_dev_clock;
+
+SR_PRIV struct sr_dev_clock *sr_dev_clock_new(uint64_t samplerate,
+		int64_t zero_us);
+SR_PRIV void sr_dev_clock_free(struct sr_dev_clock *clock);
+SR_PRIV void sr_dev_clock_stamp(struct sr_dev_clock *clock,
+		const struct sr_datafeed_packet *packet,
+		struct sr_datafeed_time *time);
+SR_PRIV void sr_dev_clock_info(const struct sr_dev_clock *clock,
+		struct sr_session_clock *info);
+
 /*--- analog.c --------------------------------------------------------------*/
 
 SR_PRIV int sr_analog_init(struct sr_datafeed_analog *analog,
@@ -810,6 +943,7 @@ SR_PRIV int sr_atoi(const char *str, int *ret);
 SR_PRIV int sr_atod(const char *str, double *ret);
 SR_PRIV int sr_atof(const char *str, float *ret);
 SR_PRIV int sr_atof_ascii(const char *str, float *ret);
+SR_PRIV int sr_atof_ascii_list(const char *str, GArray *result);
 
 /*--- soft-trigger.c --------------------------------------------------------*/
 
@@ -833,6 +967,72 @@ SR_PRIV void soft_trigger_logic_free(struct soft_trigger_logic *st);
 SR_PRIV int soft_trigger_logic_check(struct soft_trigger_logic *st, uint8_t *buf,
 		int len, int *pre_trigger_samples);
 
+/*--- framing.c -------------------------------------------------------------*/
+
+typedef gboolean (*packet_valid_callback)(const uint8_t *buf);
+
+/**
+ * Callback that gets the size of a packet from its header.
+ *
+ * @param buf The start of the packet.
+ * @param len The number of bytes available at buf.
+ *
+ * @return The size of the packet, 0 if len bytes are not enough to tell,
+ *         or a negative value if buf is not the start of a packet.
+ */
+typedef int (*packet_length_callback)(const uint8_t *buf, size_t len);
+
+/** How packets are delimited in a byte stream. */
+enum sr_framing_type {
+	/** Packets of a fixed size. */
+	SR_FRAMING_FIXED,
+	/** Packets that start and end with given bytes. */
+	SR_FRAMING_DELIMITED,
+	/** Packets that give their size in their header. */
+	SR_FRAMING_LENGTH,
+};
+
+/** Description of the packets of a protocol, see sr_framing_find(). */
+struct sr_framing {
+	enum sr_framing_type type;
+	/** Packet size for fixed framing, maximum packet size otherwise. */
+	size_t size;
+	/**
+	 * Whether all packets have the byte sync at sync_offset. If so,
+	 * candidate packets are located with memchr() rather than by
+	 * trying every offset. Delimited framing always syncs on start.
+	 */
+	gboolean has_sync;
+	uint8_t sync;
+	size_t sync_offset;
+	/** First and last byte of a packet, for delimited framing. */
+	uint8_t start;
+	uint8_t end;
+	/** Packet size callback, for length framing. */
+	packet_length_callback packet_length;
+	/** Callback that checks a complete packet, or NULL. */
+	packet_valid_callback is_valid;
+};
+
+SR_PRIV int sr_framing_find(const struct sr_framing *framing,
+		const uint8_t *data, size_t len, size_t *offset);
+
+/*--- transform/kernel.c ----------------------------------------------------*/
+
+SR_PRIV void sr_transform_float_affine(float *data, size_t len,
+		float mul, float add);
+SR_PRIV void sr_transform_float_reciprocal(float *data, size_t len);
+SR_PRIV void sr_transform_bytes_invert(uint8_t *data, size_t len);
+
+/*--- transform/chain.c -----------------------------------------------------*/
+
+struct sr_transform_chain;
+
+SR_PRIV struct sr_transform_chain *sr_transform_chain_new(GSList *transforms);
+SR_PRIV int sr_transform_chain_run(const struct sr_transform_chain *chain,
+		struct sr_datafeed_packet *packet);
+SR_PRIV void sr_transform_chain_free(struct sr_transform_chain *chain);
+
 /*--- hardware/serial.c -----------------------------------------------------*/
 
 #ifdef HAVE_LIBSERIALPORT
@@ -841,8 +1041,6 @@ enum {
 	SERIAL_RDONLY = 2,
 };
 
-typedef gboolean (*packet_valid_callback)(const uint8_t *buf);
-
 SR_PRIV int serial_open(struct sr_serial_dev_inst *serial, int flags);
 SR_PRIV int serial_close(struct sr_serial_dev_inst *serial);
 SR_PRIV int serial_flush(struct sr_serial_dev_inst *serial);
@@ -859,6 +1057,17 @@ SR_PRIV int serial_set_params(struct sr_serial_dev_inst *serial, int baudrate,
 		int bits, int parity, int stopbits, int flowcontrol, int rts, int dtr);
 SR_PRIV int serial_set_paramstr(struct sr_serial_dev_inst *serial,
 		const char *paramstr);
+SR_PRIV int serial_rx_fill(struct sr_serial_dev_inst *serial,
+		unsigned int timeout_ms);
+SR_PRIV size_t serial_rx_available(const struct sr_serial_dev_inst *serial);
+SR_PRIV const uint8_t *serial_rx_peek(const struct sr_serial_dev_inst *serial);
+SR_PRIV void serial_rx_consume(struct sr_serial_dev_inst *serial, size_t count);
+SR_PRIV int serial_rx_line(struct sr_serial_dev_inst *serial, char *buf,
+		size_t maxlen);
+SR_PRIV int serial_rx_frame(struct sr_serial_dev_inst *serial,
+		const struct sr_framing *framing, const uint8_t **pkt);
+SR_PRIV int serial_rx_frame_detect(struct sr_serial_dev_inst *serial,
+		const struct sr_framing *framing, unsigned int timeout_ms);
 SR_PRIV int serial_readline(struct sr_serial_dev_inst *serial, char **buf,
 		int *buflen, gint64 timeout_ms);
 SR_PRIV int serial_stream_detect(struct sr_serial_dev_inst *serial,
@@ -20,7 +20,10 @@
 
 #include <config.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <glib/gprintf.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
@@ -42,7 +45,7 @@
  */
 
 /* Currently selected libsigrok loglevel. Default: SR_LOG_WARN. */
-static int cur_loglevel = SR_LOG_WARN; /* Show errors+warnings per default. */
+SR_PRIV int sr_log_loglevel = SR_LOG_WARN; /* Show errors+warnings per default. */
 
 /* Function prototype. */
 static int sr_logv(void *cb_data, int loglevel, const char *format,
@@ -62,6 +65,100 @@ static void *sr_log_cb_data = NULL;
 /** @endcond */
 static int64_t sr_log_start_time = 0;
 
+/** @cond PRIVATE */
+/* Number of records in the asynchronous log ring, a power of two. */
+#define LOG_RING_SIZE		4096
+/* Maximum number of arguments captured per record. */
+#define LOG_MAX_ARGS		8
+/* Space for the contents of string arguments per record. */
+#define LOG_STR_SIZE		96
+/* Polling interval of the drain thread while the ring is empty. */
+#define LOG_DRAIN_INTERVAL_US	2000
+/* Wrapping arithmetic on ring sequence numbers. */
+#define LOG_SEQ_ADD(a, b)	((gint)((guint)(a) + (guint)(b)))
+#define LOG_SEQ_DIFF(a, b)	((gint)((guint)(a) - (guint)(b)))
+/** @endcond */
+
+union log_arg {
+	intmax_t i;
+	uintmax_t u;
+	double d;
+	long double ld;
+	const void *p;
+	/* Offset of a string argument in log_record.str. */
+	size_t str;
+};
+
+/*
+ * A message in the asynchronous log ring. Only the format pointer and
+ * the arguments are stored; formatting happens on the drain thread.
+ * Messages that can't be captured that way are formatted right away
+ * into 'message' instead.
+ */
+struct log_record {
+	/* Sequence number, owned by the ring (see log_ring_push()). */
+	gint seq;
+	int loglevel;
+	int64_t timestamp;
+	const char *format;
+	char *message;
+	union log_arg args[LOG_MAX_ARGS];
+	char str[LOG_STR_SIZE];
+};
+
+enum log_arg_type {
+	LOG_ARG_INT,
+	LOG_ARG_UINT,
+	LOG_ARG_DOUBLE,
+	LOG_ARG_LONG_DOUBLE,
+	LOG_ARG_POINTER,
+	LOG_ARG_STRING,
+};
+
+/* A conversion specification, parsed from a printf format string. */
+struct log_spec {
+	char flags[6];
+	gboolean width_arg;
+	int width;
+	gboolean precision_arg;
+	int precision;
+	enum log_arg_type type;
+	/* Length modifier, one of the LENGTH_* values. */
+	int length;
+	char conversion;
+};
+
+enum {
+	LENGTH_NONE,
+	LENGTH_HH,
+	LENGTH_H,
+	LENGTH_L,
+	LENGTH_LL,
+	LENGTH_J,
+	LENGTH_Z,
+	LENGTH_T,
+	LENGTH_LONG_DOUBLE,
+};
+
+/*
+ * Bounded multi-producer ring, after Dmitry Vyukov's MPMC queue. A
+ * producer claims a slot by advancing 'log_head', and publishes it by
+ * setting the slot's sequence number. Records are consumed in order
+ * by whoever holds 'log_drain_mutex'.
+ */
+static struct log_record *log_ring = NULL;
+static gint log_head = 0;
+static gint log_tail = 0;
+static gint log_dropped = 0;
+static gint log_async = FALSE;
+static GMutex log_drain_mutex;
+static GMutex log_async_mutex;
+static GThread *log_drain_thread = NULL;
+static gint log_drain_stop = FALSE;
+
+/* Time stamp of the record being delivered, for sr_logv(). */
+static GPrivate log_timestamp;
+
 /**
  * Set the libsigrok loglevel.
  *
@@ -89,7 +186,7 @@ SR_API int sr_log_loglevel_set(int loglevel)
 	if (loglevel >= LOGLEVEL_TIMESTAMP && sr_log_start_time == 0)
 		sr_log_start_time = g_get_monotonic_time();
 
-	cur_loglevel = loglevel;
+	sr_log_loglevel = loglevel;
 
 	sr_dbg("libsigrok loglevel set to %d.", loglevel);
 
@@ -105,7 +202,7 @@ SR_API int sr_log_loglevel_set(int loglevel)
  */
 SR_API int sr_log_loglevel_get(void)
 {
-	return cur_loglevel;
+	return sr_log_loglevel;
 }
 
 /**
@@ -119,6 +216,9 @@ SR_API int sr_log_loglevel_get(void)
  *                never used or interpreted in any way. The pointer is allowed
  *                to be NULL if the caller doesn't need/want to pass any data.
  *
+ * With asynchronous logging enabled, the callback can be called from
+ * another thread than the one logging; see sr_log_async_set().
+ *
  * @return SR_OK upon success, SR_ERR_ARG upon invalid arguments.
  *
  * @since 0.3.0
@@ -161,6 +261,7 @@ SR_API int sr_log_callback_set_default(void)
 
 static int sr_logv(void *cb_data, int loglevel, const char *format, va_list args)
 {
+	const int64_t *timestamp;
 	uint64_t elapsed_us, minutes;
 	unsigned int rest_us, seconds, microseconds;
 	int ret;
@@ -169,11 +270,13 @@ static int sr_logv(void *cb_data, int loglevel, const char *format, va_list args
 	(void)cb_data;
 
 	/* Only output messages of at least the selected loglevel(s). */
-	if (loglevel > cur_loglevel)
+	if (loglevel > sr_log_loglevel)
 		return SR_OK;
 
-	if (cur_loglevel >= LOGLEVEL_TIMESTAMP) {
-		elapsed_us = g_get_monotonic_time() - sr_log_start_time;
+	if (sr_log_loglevel >= LOGLEVEL_TIMESTAMP) {
+		timestamp = g_private_get(&log_timestamp);
+		elapsed_us = (timestamp ? *timestamp : g_get_monotonic_time())
+				- sr_log_start_time;
 
 		minutes = elapsed_us / G_TIME_SPAN_MINUTE;
 		rest_us = elapsed_us % G_TIME_SPAN_MINUTE;
@@ -193,6 +296,508 @@ static int sr_logv(void *cb_data, int loglevel, const char *format, va_list args
 	return SR_OK;
 }
 
+/*
+ * Parse the conversion specification following a '%'. Returns the
+ * position after it, or NULL for anything that can't be captured.
+ */
+static const char *log_spec_parse(const char *p, struct log_spec *spec)
+{
+	size_t num_flags;
+
+	memset(spec, 0, sizeof(*spec));
+	spec->width = -1;
+	spec->precision = -1;
+
+	for (num_flags = 0; *p && strchr("-+ #0", *p); p++) {
+		if (num_flags == sizeof(spec->flags) - 1)
+			return NULL;
+		spec->flags[num_flags++] = *p;
+	}
+
+	if (*p == '*') {
+		spec->width_arg = TRUE;
+		p++;
+	} else if (g_ascii_isdigit(*p)) {
+		for (spec->width = 0; g_ascii_isdigit(*p); p++)
+			spec->width = spec->width * 10 + (*p - '0');
+	}
+
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			spec->precision_arg = TRUE;
+			p++;
+		} else {
+			for (spec->precision = 0; g_ascii_isdigit(*p); p++)
+				spec->precision = spec->precision * 10 + (*p - '0');
+		}
+	}
+
+	switch (*p) {
+	case 'h':
+		if (*++p == 'h') {
+			spec->length = LENGTH_HH;
+			p++;
+		} else {
+			spec->length = LENGTH_H;
+		}
+		break;
+	case 'l':
+		if (*++p == 'l') {
+			spec->length = LENGTH_LL;
+			p++;
+		} else {
+			spec->length = LENGTH_L;
+		}
+		break;
+	case 'j':
+		spec->length = LENGTH_J;
+		p++;
+		break;
+	case 'z':
+		spec->length = LENGTH_Z;
+		p++;
+		break;
+	case 't':
+		spec->length = LENGTH_T;
+		p++;
+		break;
+	case 'L':
+		spec->length = LENGTH_LONG_DOUBLE;
+		p++;
+		break;
+	}
+
+	spec->conversion = *p;
+	switch (*p) {
+	case 'd':
+	case 'i':
+		spec->type = LOG_ARG_INT;
+		break;
+	case 'u':
+	case 'o':
+	case 'x':
+	case 'X':
+		spec->type = LOG_ARG_UINT;
+		break;
+	case 'c':
+		if (spec->length != LENGTH_NONE)
+			return NULL;
+		spec->type = LOG_ARG_INT;
+		break;
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'F':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		spec->type = (spec->length == LENGTH_LONG_DOUBLE) ?
+				LOG_ARG_LONG_DOUBLE : LOG_ARG_DOUBLE;
+		if (spec->length != LENGTH_NONE
+				&& spec->length != LENGTH_LONG_DOUBLE
+				&& spec->length != LENGTH_L)
+			return NULL;
+		break;
+	case 'p':
+		if (spec->length != LENGTH_NONE)
+			return NULL;
+		spec->type = LOG_ARG_POINTER;
+		break;
+	case 's':
+		if (spec->length != LENGTH_NONE)
+			return NULL;
+		spec->type = LOG_ARG_STRING;
+		break;
+	default:
+		return NULL;
+	}
+	if (spec->type < LOG_ARG_DOUBLE && spec->length == LENGTH_LONG_DOUBLE)
+		return NULL;
+
+	return p + 1;
+}
+
+static intmax_t log_arg_int(int length, va_list *args)
+{
+	switch (length) {
+	case LENGTH_HH:
+		return (signed char)va_arg(*args, int);
+	case LENGTH_H:
+		return (short)va_arg(*args, int);
+	case LENGTH_L:
+		return va_arg(*args, long);
+	case LENGTH_LL:
+		return va_arg(*args, long long);
+	case LENGTH_J:
+		return va_arg(*args, intmax_t);
+	case LENGTH_Z:
+		return va_arg(*args, ssize_t);
+	case LENGTH_T:
+		return va_arg(*args, ptrdiff_t);
+	default:
+		return va_arg(*args, int);
+	}
+}
+
+static uintmax_t log_arg_uint(int length, va_list *args)
+{
+	switch (length) {
+	case LENGTH_HH:
+		return (unsigned char)va_arg(*args, unsigned int);
+	case LENGTH_H:
+		return (unsigned short)va_arg(*args, unsigned int);
+	case LENGTH_L:
+		return va_arg(*args, unsigned long);
+	case LENGTH_LL:
+		return va_arg(*args, unsigned long long);
+	case LENGTH_J:
+		return va_arg(*args, uintmax_t);
+	case LENGTH_Z:
+		return va_arg(*args, size_t);
+	case LENGTH_T:
+		return va_arg(*args, ptrdiff_t);
+	default:
+		return va_arg(*args, unsigned int);
+	}
+}
+
+/*
+ * Capture the arguments of a message into a record, without formatting
+ * anything. Returns FALSE if the format or the arguments don't fit.
+ */
+static gboolean log_record_capture(struct log_record *rec,
+		const char *format, va_list *args)
+{
+	struct log_spec spec;
+	const char *p, *str;
+	size_t str_len, str_used;
+	int n, precision;
+
+	rec->format = format;
+	rec->message = NULL;
+	str_used = n = 0;
+
+	for (p = format; *p; ) {
+		if (*p++ != '%')
+			continue;
+		if (*p == '%') {
+			p++;
+			continue;
+		}
+		if (!(p = log_spec_parse(p, &spec)))
+			return FALSE;
+		if (n + spec.width_arg + spec.precision_arg >= LOG_MAX_ARGS)
+			return FALSE;
+
+		if (spec.width_arg)
+			rec->args[n++].i = va_arg(*args, int);
+		precision = spec.precision;
+		if (spec.precision_arg)
+			precision = rec->args[n++].i = va_arg(*args, int);
+
+		switch (spec.type) {
+		case LOG_ARG_INT:
+			rec->args[n].i = log_arg_int(spec.length, args);
+			break;
+		case LOG_ARG_UINT:
+			rec->args[n].u = log_arg_uint(spec.length, args);
+			break;
+		case LOG_ARG_DOUBLE:
+			rec->args[n].d = va_arg(*args, double);
+			break;
+		case LOG_ARG_LONG_DOUBLE:
+			rec->args[n].ld = va_arg(*args, long double);
+			break;
+		case LOG_ARG_POINTER:
+			rec->args[n].p = va_arg(*args, void *);
+			break;
+		case LOG_ARG_STRING:
+			/* The string may be gone by the time it's formatted. */
+			if (!(str = va_arg(*args, const char *)))
+				str = "(null)";
+			/* With a precision, it needn't be NUL terminated. */
+			if (precision >= 0)
+				str_len = strnlen(str, precision);
+			else
+				str_len = strlen(str);
+			if (str_used + str_len + 1 > sizeof(rec->str))
+				return FALSE;
+			memcpy(rec->str + str_used, str, str_len);
+			rec->str[str_used + str_len] = '\0';
+			rec->args[n].str = str_used;
+			str_used += str_len + 1;
+			break;
+		}
+		n++;
+	}
+
+	return TRUE;
+}
+
+/* Format a captured record, one conversion at a time. */
+static char *log_record_format(const struct log_record *rec)
+{
+	struct log_spec spec;
+	GString *s;
+	const char *p, *start;
+	char conv[32];
+	int n, len;
+
+	s = g_string_sized_new(128);
+
+	for (p = rec->format, n = 0; *p; ) {
+		for (start = p; *p && *p != '%'; p++);
+		g_string_append_len(s, start, p - start);
+		if (!*p++)
+			break;
+		if (*p == '%') {
+			g_string_append_c(s, '%');
+			p++;
+			continue;
+		}
+		p = log_spec_parse(p, &spec);
+
+		len = g_snprintf(conv, sizeof(conv), "%%%s", spec.flags);
+		if (spec.width_arg)
+			spec.width = rec->args[n++].i;
+		if (spec.width_arg || spec.width >= 0)
+			len += g_snprintf(conv + len, sizeof(conv) - len,
+					"%d", spec.width);
+		if (spec.precision_arg)
+			spec.precision = rec->args[n++].i;
+		if (spec.precision >= 0)
+			len += g_snprintf(conv + len, sizeof(conv) - len,
+					".%d", spec.precision);
+		/* Integers were widened when captured. */
+		if (spec.type == LOG_ARG_INT && spec.conversion != 'c')
+			conv[len++] = 'j';
+		else if (spec.type == LOG_ARG_UINT)
+			conv[len++] = 'j';
+		else if (spec.type == LOG_ARG_LONG_DOUBLE)
+			conv[len++] = 'L';
+		conv[len++] = spec.conversion;
+		conv[len] = '\0';
+
+		switch (spec.type) {
+		case LOG_ARG_INT:
+			if (spec.conversion == 'c')
+				g_string_append_printf(s, conv, (int)rec->args[n].i);
+			else
+				g_string_append_printf(s, conv, rec->args[n].i);
+			break;
+		case LOG_ARG_UINT:
+			g_string_append_printf(s, conv, rec->args[n].u);
+			break;
+		case LOG_ARG_DOUBLE:
+			g_string_append_printf(s, conv, rec->args[n].d);
+			break;
+		case LOG_ARG_LONG_DOUBLE:
+			g_string_append_printf(s, conv, rec->args[n].ld);
+			break;
+		case LOG_ARG_POINTER:
+			g_string_append_printf(s, conv, rec->args[n].p);
+			break;
+		case LOG_ARG_STRING:
+			g_string_append_printf(s, conv,
+					rec->str + rec->args[n].str);
+			break;
+		}
+		n++;
+	}
+
+	return g_string_free(s, FALSE);
+}
+
+static int log_deliver(int loglevel, const char *format, ...)
+{
+	int ret;
+	va_list args;
+
+	va_start(args, format);
+	ret = sr_log_cb(sr_log_cb_data, loglevel, format, args);
+	va_end(args);
+
+	return ret;
+}
+
+/* Queue a message, without blocking. Returns FALSE if the ring is full. */
+static gboolean log_ring_push(int loglevel, const char *format, va_list args)
+{
+	struct log_record *rec;
+	va_list args_copy;
+	gint pos, seq, diff;
+
+	pos = g_atomic_int_get(&log_head);
+	for (;;) {
+		rec = &log_ring[pos & (LOG_RING_SIZE - 1)];
+		seq = g_atomic_int_get(&rec->seq);
+		diff = LOG_SEQ_DIFF(seq, pos);
+		if (diff == 0) {
+			if (g_atomic_int_compare_and_exchange(&log_head,
+					pos, LOG_SEQ_ADD(pos, 1)))
+				break;
+		} else if (diff < 0) {
+			g_atomic_int_inc(&log_dropped);
+			return FALSE;
+		}
+		pos = g_atomic_int_get(&log_head);
+	}
+
+	rec->loglevel = loglevel;
+	rec->timestamp = g_get_monotonic_time();
+	va_copy(args_copy, args);
+	if (!log_record_capture(rec, format, &args_copy))
+		rec->message = g_strdup_vprintf(format, args);
+	va_end(args_copy);
+
+	g_atomic_int_set(&rec->seq, LOG_SEQ_ADD(pos, 1));
+
+	return TRUE;
+}
+
+/* Deliver all queued messages. Returns the number of messages. */
+static int log_ring_drain(void)
+{
+	struct log_record *rec;
+	char *message;
+	gint pos, seq, dropped;
+	int count;
+
+	g_mutex_lock(&log_drain_mutex);
+
+	for (count = 0; ; count++) {
+		pos = log_tail;
+		rec = &log_ring[pos & (LOG_RING_SIZE - 1)];
+		seq = g_atomic_int_get(&rec->seq);
+		if (LOG_SEQ_DIFF(seq, LOG_SEQ_ADD(pos, 1)) < 0)
+			break;
+
+		if (rec->message) {
+			message = rec->message;
+			rec->message = NULL;
+		} else {
+			message = log_record_format(rec);
+		}
+		g_private_set(&log_timestamp, &rec->timestamp);
+		log_deliver(rec->loglevel, "%s", message);
+		g_private_set(&log_timestamp, NULL);
+		g_free(message);
+
+		log_tail = LOG_SEQ_ADD(pos, 1);
+		g_atomic_int_set(&rec->seq, LOG_SEQ_ADD(pos, LOG_RING_SIZE));
+	}
+
+	if ((dropped = g_atomic_int_get(&log_dropped))) {
+		g_atomic_int_add(&log_dropped, -dropped);
+		log_deliver(SR_LOG_WARN, LOG_PREFIX ": Dropped %d log "
+				"messages, ring buffer full.", dropped);
+	}
+
+	g_mutex_unlock(&log_drain_mutex);
+
+	return count;
+}
+
+static gpointer log_drain_thread_func(gpointer data)
+{
+	(void)data;
+
+	while (!g_atomic_int_get(&log_drain_stop)) {
+		if (!log_ring_drain())
+			g_usleep(LOG_DRAIN_INTERVAL_US);
+	}
+	log_ring_drain();
+
+	return NULL;
+}
+
+/**
+ * Enable or disable asynchronous logging.
+ *
+ * In asynchronous mode, messages are not formatted by the thread that
+ * emits them. The format string and the arguments are stored in a
+ * lock-free ring buffer instead, and a background thread formats the
+ * messages and passes them on to the log callback, with the time stamp
+ * of when they were emitted. This keeps the cost of debug output in
+ * the acquisition and datafeed paths low.
+ *
+ * The log callback is then called with a format string of "%s", from
+ * the background thread, or from the thread calling sr_log_flush() or
+ * disabling asynchronous mode. If the ring buffer fills up, messages
+ * are dropped, and a warning with the number of dropped messages is
+ * logged.
+ *
+ * Disabling asynchronous mode delivers all queued messages first.
+ *
+ * @param async TRUE to enable asynchronous logging, FALSE to disable it.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR Failed to start the background thread.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_log_async_set(gboolean async)
+{
+	GError *error = NULL;
+	GThread *thread;
+	int i, ret;
+
+	ret = SR_OK;
+	g_mutex_lock(&log_async_mutex);
+
+	if (async && !log_drain_thread) {
+		if (!log_ring) {
+			/* Never freed: a producer may still be looking at it. */
+			log_ring = g_malloc0(LOG_RING_SIZE * sizeof(*log_ring));
+			for (i = 0; i < LOG_RING_SIZE; i++)
+				log_ring[i].seq = i;
+		}
+		g_atomic_int_set(&log_drain_stop, FALSE);
+		log_drain_thread = g_thread_try_new("sr-log",
+				log_drain_thread_func, NULL, &error);
+		if (log_drain_thread) {
+			g_atomic_int_set(&log_async, TRUE);
+		} else {
+			sr_err("Failed to start log thread: %s.",
+					error->message);
+			g_error_free(error);
+			ret = SR_ERR;
+		}
+	} else if (!async && log_drain_thread) {
+		g_atomic_int_set(&log_async, FALSE);
+		g_atomic_int_set(&log_drain_stop, TRUE);
+		thread = log_drain_thread;
+		log_drain_thread = NULL;
+		g_thread_join(thread);
+		/* Catch messages queued while the thread was exiting. */
+		log_ring_drain();
+	}
+
+	g_mutex_unlock(&log_async_mutex);
+
+	return ret;
+}
+
+/**
+ * Deliver all queued messages to the log callback.
+ *
+ * Messages are delivered from the calling thread. This does nothing
+ * unless asynchronous logging is enabled.
+ *
+ * @return SR_OK upon success, a negative error code otherwise.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_log_flush(void)
+{
+	if (log_ring)
+		log_ring_drain();
+
+	return SR_OK;
+}
+
 /** @private */
 SR_PRIV int sr_log(int loglevel, const char *format, ...)
 {
@@ -200,7 +805,10 @@ SR_PRIV int sr_log(int loglevel, const char *format, ...)
 	va_list args;
 
 	va_start(args, format);
-	ret = sr_log_cb(sr_log_cb_data, loglevel, format, args);
+	if (G_UNLIKELY(g_atomic_int_get(&log_async)))
+		ret = log_ring_push(loglevel, format, args) ? SR_OK : SR_ERR;
+	else
+		ret = sr_log_cb(sr_log_cb_data, loglevel, format, args);
 	va_end(args);
 
 	return ret;
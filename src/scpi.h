@@ -70,6 +70,23 @@ struct sr_scpi_hw_info {
 	char *firmware_version;
 };
 
+struct sr_scpi_batch;
+struct scpi_async;
+struct sr_scpi_dev_inst;
+
+/**
+ * Completion callback of an asynchronous SCPI request.
+ *
+ * @param scpi The SCPI device the request was sent to.
+ * @param result SR_OK, or the error code of the request.
+ * @param response The response to a query, without the trailing
+ *                 linefeed. NULL for commands and on errors. Only
+ *                 valid until the callback returns.
+ * @param cb_data The callback data passed with the request.
+ */
+typedef void (*sr_scpi_async_callback)(struct sr_scpi_dev_inst *scpi,
+		int result, const char *response, void *cb_data);
+
 struct sr_scpi_dev_inst {
 	const char *name;
 	const char *prefix;
@@ -84,6 +101,13 @@ struct sr_scpi_dev_inst {
 	int (*send)(void *priv, const char *command);
 	int (*read_begin)(void *priv);
 	int (*read_data)(void *priv, char *buf, int maxlen);
+	/* Optional: like read_data, but returns 0 instead of waiting. */
+	int (*read_data_nowait)(void *priv, char *buf, int maxlen);
+	/*
+	 * Optional, for transports whose read_data blocks: wait for up to
+	 * timeout_ms for data to read. Returns 0 if there is none.
+	 */
+	int (*read_wait)(void *priv, unsigned int timeout_ms);
 	int (*read_complete)(void *priv);
 	int (*close)(struct sr_scpi_dev_inst *scpi);
 	void (*free)(void *priv);
@@ -91,6 +115,10 @@ struct sr_scpi_dev_inst {
 	void *priv;
 	/* Only used for quirk workarounds, notably the Rigol DS1000 series. */
 	uint64_t firmware_version;
+	/* Set once the device failed to answer a compound query. */
+	gboolean no_batch;
+	/* Queue of asynchronous requests, NULL until the first one. */
+	struct scpi_async *async;
 };
 
 SR_PRIV GSList *sr_scpi_scan(struct drv_context *drvc, GSList *options,
@@ -128,10 +156,36 @@ SR_PRIV int sr_scpi_get_floatv(struct sr_scpi_dev_inst *scpi,
 			const char *command, GArray **scpi_response);
 SR_PRIV int sr_scpi_get_uint8v(struct sr_scpi_dev_inst *scpi,
 			const char *command, GArray **scpi_response);
+SR_PRIV int sr_scpi_get_block(struct sr_scpi_dev_inst *scpi,
+			const char *command, GByteArray **scpi_response);
 SR_PRIV int sr_scpi_get_hw_id(struct sr_scpi_dev_inst *scpi,
 			struct sr_scpi_hw_info **scpi_response);
 SR_PRIV void sr_scpi_hw_info_free(struct sr_scpi_hw_info *hw_info);
 
+SR_PRIV struct sr_scpi_batch *sr_scpi_batch_new(void);
+SR_PRIV void sr_scpi_batch_add_string(struct sr_scpi_batch *batch,
+			char **result, const char *format, ...);
+SR_PRIV void sr_scpi_batch_add_bool(struct sr_scpi_batch *batch,
+			gboolean *result, const char *format, ...);
+SR_PRIV void sr_scpi_batch_add_int(struct sr_scpi_batch *batch,
+			int *result, const char *format, ...);
+SR_PRIV void sr_scpi_batch_add_float(struct sr_scpi_batch *batch,
+			float *result, const char *format, ...);
+SR_PRIV void sr_scpi_batch_add_double(struct sr_scpi_batch *batch,
+			double *result, const char *format, ...);
+SR_PRIV int sr_scpi_batch_run(struct sr_scpi_dev_inst *scpi,
+			struct sr_scpi_batch *batch);
+SR_PRIV void sr_scpi_batch_free(struct sr_scpi_batch *batch);
+
+SR_PRIV int sr_scpi_send_async(struct sr_session *session,
+			struct sr_scpi_dev_inst *scpi, sr_scpi_async_callback cb,
+			void *cb_data, const char *format, ...);
+SR_PRIV int sr_scpi_get_string_async(struct sr_session *session,
+			struct sr_scpi_dev_inst *scpi, sr_scpi_async_callback cb,
+			void *cb_data, const char *format, ...);
+SR_PRIV int sr_scpi_async_pending(struct sr_scpi_dev_inst *scpi);
+SR_PRIV void sr_scpi_async_cancel(struct sr_scpi_dev_inst *scpi);
+
 SR_PRIV const char *sr_vendor_alias(const char *raw_vendor);
 SR_PRIV const char *scpi_cmd_get(const struct scpi_command *cmdtable, int command);
 SR_PRIV int scpi_cmd(const struct sr_dev_inst *sdi,
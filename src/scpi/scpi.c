@@ -29,6 +29,66 @@
 #define SCPI_READ_RETRIES 100
 #define SCPI_READ_RETRY_TIMEOUT_US (10 * 1000)
 
+/*
+ * Limits of a compound query sent by sr_scpi_batch_run(). Instruments
+ * have input and output buffers of a few hundred bytes at least.
+ */
+#define SCPI_BATCH_MAX_LEN 240
+#define SCPI_BATCH_MAX_QUERIES 16
+
+/*
+ * Largest block accepted by sr_scpi_get_block(), and how much its data
+ * array grows by at first.
+ */
+#define SCPI_BLOCK_MAX_LEN (256 * 1024 * 1024)
+#define SCPI_BLOCK_CHUNK_LEN (64 * 1024)
+
+enum scpi_batch_type {
+	SCPI_BATCH_STRING,
+	SCPI_BATCH_BOOL,
+	SCPI_BATCH_INT,
+	SCPI_BATCH_FLOAT,
+	SCPI_BATCH_DOUBLE,
+};
+
+struct scpi_batch_query {
+	enum scpi_batch_type type;
+	char *command;
+	void *result;
+};
+
+struct sr_scpi_batch {
+	/* Array of struct scpi_batch_query. */
+	GArray *queries;
+};
+
+/*
+ * Asynchronous requests are driven by the event source of the device,
+ * which also fires this often to check for timeouts.
+ */
+#define SCPI_ASYNC_POLL_MS 10
+
+struct scpi_async_request {
+	char *command;
+	gboolean query;
+	sr_scpi_async_callback cb;
+	void *cb_data;
+};
+
+struct scpi_async {
+	struct sr_session *session;
+	gboolean source_added;
+	/* Requests in order of submission. */
+	GQueue requests;
+	/* Whether the first request has been sent, and the result. */
+	gboolean sent;
+	int send_ret;
+	/* Set while completed requests are handled. */
+	gboolean running;
+	GString *response;
+	gint64 laststart;
+};
+
 /**
  * Parse a string representation of a boolean-like value into a gboolean.
  * Similar to sr_parse_boolstring but rejects strings which do not represent
@@ -217,6 +277,8 @@ SR_PRIV int sr_scpi_open(struct sr_scpi_dev_inst *scpi)
 	return scpi->open(scpi);
 }
 
+static void scpi_async_free(struct scpi_async *async);
+
 /**
  * Add an event source for an SCPI device.
  *
@@ -368,11 +430,32 @@ SR_PRIV int sr_scpi_close(struct sr_scpi_dev_inst *scpi)
  */
 SR_PRIV void sr_scpi_free(struct sr_scpi_dev_inst *scpi)
 {
+	scpi_async_free(scpi->async);
 	scpi->free(scpi->priv);
 	g_free(scpi->priv);
 	g_free(scpi);
 }
 
+/*
+ * On transports whose read_data blocks, wait for the next data of a
+ * response for what is left of the read timeout, counted from laststart.
+ * Returns SR_ERR_TIMEOUT if none arrived in time.
+ */
+static int scpi_read_wait(struct sr_scpi_dev_inst *scpi, gint64 laststart)
+{
+	unsigned int elapsed_ms;
+
+	if (!scpi->read_wait)
+		return SR_OK;
+
+	elapsed_ms = (g_get_monotonic_time() - laststart) / 1000;
+	if (elapsed_ms >= scpi->read_timeout_ms || !scpi->read_wait(scpi->priv,
+			scpi->read_timeout_ms - elapsed_ms))
+		return SR_ERR_TIMEOUT;
+
+	return SR_OK;
+}
+
 /**
  * Send a SCPI command, receive the reply and store the reply in scpi_response.
  *
@@ -380,7 +463,8 @@ SR_PRIV void sr_scpi_free(struct sr_scpi_dev_inst *scpi)
  * @param command The SCPI command to send to the device (can be NULL).
  * @param scpi_response Pointer where to store the SCPI response.
  *
- * @return SR_OK on success, SR_ERR* on failure.
+ * @return SR_OK on success, SR_ERR_TIMEOUT if the device didn't answer
+ *         in time, SR_ERR* on other failures.
  */
 SR_PRIV int sr_scpi_get_string(struct sr_scpi_dev_inst *scpi,
 			       const char *command, char **scpi_response)
@@ -405,6 +489,11 @@ SR_PRIV int sr_scpi_get_string(struct sr_scpi_dev_inst *scpi,
 	*scpi_response = NULL;
 
 	while (!sr_scpi_read_complete(scpi)) {
+		if (scpi_read_wait(scpi, laststart) != SR_OK) {
+			sr_err("Timed out waiting for SCPI response.");
+			g_string_free(response, TRUE);
+			return SR_ERR_TIMEOUT;
+		}
 		len = sr_scpi_read_data(scpi, buf, sizeof(buf));
 		if (len < 0) {
 			sr_err("Incompletely read SCPI response.");
@@ -418,7 +507,7 @@ SR_PRIV int sr_scpi_get_string(struct sr_scpi_dev_inst *scpi,
 		if (elapsed_ms >= scpi->read_timeout_ms) {
 			sr_err("Timed out waiting for SCPI response.");
 			g_string_free(response, TRUE);
-			return SR_ERR;
+			return SR_ERR_TIMEOUT;
 		}
 	}
 
@@ -438,6 +527,229 @@ SR_PRIV int sr_scpi_get_string(struct sr_scpi_dev_inst *scpi,
 	return SR_OK;
 }
 
+/*
+ * Read exactly 'len' bytes of a response. Unlike sr_scpi_get_string(),
+ * this doesn't rely on sr_scpi_read_complete(), which is only a guess
+ * on some transports.
+ */
+static int scpi_read_exact(struct sr_scpi_dev_inst *scpi, char *buf,
+		size_t len)
+{
+	size_t pos;
+	int ret;
+	gint64 laststart;
+	unsigned int elapsed_ms;
+
+	laststart = g_get_monotonic_time();
+
+	for (pos = 0; pos < len; pos += ret) {
+		if (scpi_read_wait(scpi, laststart) != SR_OK) {
+			sr_err("Timed out waiting for SCPI response.");
+			return SR_ERR_TIMEOUT;
+		}
+		ret = sr_scpi_read_data(scpi, buf + pos, MIN(len - pos, G_MAXINT));
+		if (ret < 0) {
+			sr_err("Incompletely read SCPI response.");
+			return SR_ERR;
+		} else if (ret > 0) {
+			laststart = g_get_monotonic_time();
+		}
+		elapsed_ms = (g_get_monotonic_time() - laststart) / 1000;
+		if (elapsed_ms >= scpi->read_timeout_ms) {
+			sr_err("Timed out waiting for SCPI response.");
+			return SR_ERR_TIMEOUT;
+		}
+	}
+
+	return SR_OK;
+}
+
+/* Read and discard the rest of a response, usually just its terminator. */
+static int scpi_read_discard(struct sr_scpi_dev_inst *scpi)
+{
+	char buf[16];
+	int len;
+	gint64 laststart;
+	unsigned int elapsed_ms;
+
+	laststart = g_get_monotonic_time();
+
+	while (!sr_scpi_read_complete(scpi)) {
+		if (scpi_read_wait(scpi, laststart) != SR_OK) {
+			sr_err("Timed out waiting for SCPI response.");
+			return SR_ERR_TIMEOUT;
+		}
+		len = sr_scpi_read_data(scpi, buf, sizeof(buf));
+		if (len < 0) {
+			sr_err("Incompletely read SCPI response.");
+			return SR_ERR;
+		} else if (len > 0) {
+			laststart = g_get_monotonic_time();
+		}
+		elapsed_ms = (g_get_monotonic_time() - laststart) / 1000;
+		if (elapsed_ms >= scpi->read_timeout_ms) {
+			sr_err("Timed out waiting for SCPI response.");
+			return SR_ERR_TIMEOUT;
+		}
+	}
+
+	return SR_OK;
+}
+
+/* Read an indefinite length block ("#0"), which ends with the response. */
+static int scpi_read_indefinite_block(struct sr_scpi_dev_inst *scpi,
+		GByteArray *response)
+{
+	int len;
+	guint pos;
+	gint64 laststart;
+	unsigned int elapsed_ms;
+
+	laststart = g_get_monotonic_time();
+
+	for (pos = 0; !sr_scpi_read_complete(scpi); pos += len) {
+		if (scpi_read_wait(scpi, laststart) != SR_OK) {
+			sr_err("Timed out waiting for SCPI response.");
+			return SR_ERR_TIMEOUT;
+		}
+		if (pos + 4096 > SCPI_BLOCK_MAX_LEN) {
+			sr_err("Block longer than %d bytes.", SCPI_BLOCK_MAX_LEN);
+			return SR_ERR_DATA;
+		}
+		g_byte_array_set_size(response, pos + 4096);
+		len = sr_scpi_read_data(scpi, (char *)response->data + pos, 4096);
+		if (len < 0) {
+			sr_err("Incompletely read SCPI response.");
+			return SR_ERR;
+		} else if (len > 0) {
+			laststart = g_get_monotonic_time();
+		}
+		elapsed_ms = (g_get_monotonic_time() - laststart) / 1000;
+		if (elapsed_ms >= scpi->read_timeout_ms) {
+			sr_err("Timed out waiting for SCPI response.");
+			return SR_ERR_TIMEOUT;
+		}
+	}
+
+	/* The block ends with the response terminator. */
+	if (pos > 0 && response->data[pos - 1] == '\n')
+		pos--;
+	g_byte_array_set_size(response, pos);
+
+	return SR_OK;
+}
+
+/*
+ * Read a definite length block of datalen bytes. The array grows as the
+ * data arrives, so that a bogus length in the header doesn't allocate
+ * memory which is never filled.
+ */
+static int scpi_read_definite_block(struct sr_scpi_dev_inst *scpi,
+		GByteArray *response, size_t datalen)
+{
+	size_t pos, len;
+	int ret;
+
+	for (pos = 0; pos < datalen; pos += len) {
+		len = MIN(datalen - pos, MAX(pos, SCPI_BLOCK_CHUNK_LEN));
+		g_byte_array_set_size(response, pos + len);
+		ret = scpi_read_exact(scpi, (char *)response->data + pos, len);
+		if (ret != SR_OK)
+			return ret;
+	}
+
+	return SR_OK;
+}
+
+/**
+ * Send a SCPI command, receive a reply in IEEE 488.2 arbitrary block
+ * format and store the data of the block in scpi_response.
+ *
+ * A definite length block ("#<n><length><data>") is read straight into
+ * the result, which grows as the data arrives. Indefinite length blocks
+ * ("#0<data>") are supported as well. Blocks longer than 256 MiB are
+ * rejected.
+ *
+ * @param scpi Previously initialised SCPI device structure.
+ * @param command The SCPI command to send to the device (can be NULL).
+ * @param scpi_response Pointer where to store the data of the block. If it
+ *                      points to an existing array, that array is resized
+ *                      and reused, so one buffer can serve many reads.
+ *                      Otherwise a new array is allocated, which must be
+ *                      freed by the caller.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_DATA The response is not a valid block, or too long.
+ * @retval SR_ERR_TIMEOUT The device stopped sending before the end.
+ * @retval SR_ERR Other error.
+ */
+SR_PRIV int sr_scpi_get_block(struct sr_scpi_dev_inst *scpi,
+			      const char *command, GByteArray **scpi_response)
+{
+	char buf[10], *end;
+	int num_digits, ret, i;
+	unsigned long datalen;
+	GByteArray *response;
+
+	if (command)
+		if (sr_scpi_send(scpi, command) != SR_OK)
+			return SR_ERR;
+
+	if (sr_scpi_read_begin(scpi) != SR_OK)
+		return SR_ERR;
+
+	/* Skip any whitespace in front of the block. */
+	do {
+		if (scpi_read_exact(scpi, buf, 1) != SR_OK)
+			return SR_ERR;
+	} while (g_ascii_isspace(buf[0]));
+
+	if (buf[0] != '#' || scpi_read_exact(scpi, buf + 1, 1) != SR_OK
+			|| !g_ascii_isdigit(buf[1])) {
+		sr_err("Response is not a block.");
+		return SR_ERR_DATA;
+	}
+	num_digits = buf[1] - '0';
+
+	response = *scpi_response ? *scpi_response : g_byte_array_new();
+
+	if (num_digits == 0) {
+		ret = scpi_read_indefinite_block(scpi, response);
+	} else {
+		ret = scpi_read_exact(scpi, buf, num_digits);
+		if (ret == SR_OK) {
+			buf[num_digits] = '\0';
+			for (i = 0; i < num_digits; i++)
+				if (!g_ascii_isdigit(buf[i]))
+					break;
+			datalen = strtoul(buf, &end, 10);
+			if (i < num_digits || *end
+					|| datalen > SCPI_BLOCK_MAX_LEN) {
+				sr_err("Invalid block length '%s'.", buf);
+				ret = SR_ERR_DATA;
+			}
+		}
+		if (ret == SR_OK) {
+			sr_spew("Block of %lu bytes.", datalen);
+			ret = scpi_read_definite_block(scpi, response, datalen);
+		}
+		if (ret == SR_OK)
+			ret = scpi_read_discard(scpi);
+	}
+
+	if (ret != SR_OK) {
+		if (!*scpi_response)
+			g_byte_array_free(response, TRUE);
+		else
+			g_byte_array_set_size(response, 0);
+		return ret;
+	}
+
+	*scpi_response = response;
+
+	return SR_OK;
+}
+
 /**
  * Send a SCPI command, read the reply, parse it as a bool value and store the
  * result in scpi_response.
@@ -606,33 +918,26 @@ SR_PRIV int sr_scpi_get_floatv(struct sr_scpi_dev_inst *scpi,
 			       const char *command, GArray **scpi_response)
 {
 	int ret;
-	float tmp;
 	char *response;
-	gchar **ptr, **tokens;
+	const char *p;
+	guint num_values;
 	GArray *response_array;
 
 	response = NULL;
-	tokens = NULL;
 
 	ret = sr_scpi_get_string(scpi, command, &response);
 	if (ret != SR_OK && !response)
 		return ret;
 
-	tokens = g_strsplit(response, ",", 0);
-	ptr = tokens;
-
-	response_array = g_array_sized_new(TRUE, FALSE, sizeof(float), 256);
-
-	while (*ptr) {
-		if (sr_atof_ascii(*ptr, &tmp) == SR_OK)
-			response_array = g_array_append_val(response_array,
-							    tmp);
-		else
-			ret = SR_ERR_DATA;
+	/* Size the array for the whole list up front. */
+	for (p = response, num_values = 1; *p; p++)
+		if (*p == ',')
+			num_values++;
+	response_array = g_array_sized_new(TRUE, FALSE, sizeof(float),
+			num_values);
 
-		ptr++;
-	}
-	g_strfreev(tokens);
+	if (sr_atof_ascii_list(response, response_array) != SR_OK)
+		ret = SR_ERR_DATA;
 	g_free(response);
 
 	if (ret != SR_OK && response_array->len == 0) {
@@ -777,3 +1082,667 @@ SR_PRIV void sr_scpi_hw_info_free(struct sr_scpi_hw_info *hw_info)
 		g_free(hw_info);
 	}
 }
+
+/**
+ * Create an empty batch of queries.
+ *
+ * Queries are added with the sr_scpi_batch_add_*() functions, and sent
+ * with sr_scpi_batch_run(). Queries answered with arbitrary block data,
+ * such as waveforms, must not be part of a batch.
+ *
+ * @return The new batch, to be freed with sr_scpi_batch_free().
+ */
+SR_PRIV struct sr_scpi_batch *sr_scpi_batch_new(void)
+{
+	struct sr_scpi_batch *batch;
+
+	batch = g_malloc0(sizeof(struct sr_scpi_batch));
+	batch->queries = g_array_new(FALSE, FALSE,
+			sizeof(struct scpi_batch_query));
+
+	return batch;
+}
+
+static void scpi_batch_add(struct sr_scpi_batch *batch,
+		enum scpi_batch_type type, void *result,
+		const char *format, va_list args)
+{
+	struct scpi_batch_query query;
+
+	query.type = type;
+	query.command = g_strdup_vprintf(format, args);
+	query.result = result;
+	g_array_append_val(batch->queries, query);
+}
+
+/**
+ * Add a query to a batch, storing the reply as a string.
+ *
+ * The string must be freed by the caller with g_free(). It is set to
+ * NULL if sr_scpi_batch_run() fails.
+ *
+ * @param batch The batch to add the query to.
+ * @param result Pointer where to store the reply.
+ * @param format Format string of the query, followed by its arguments.
+ */
+SR_PRIV void sr_scpi_batch_add_string(struct sr_scpi_batch *batch,
+			char **result, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	scpi_batch_add(batch, SCPI_BATCH_STRING, result, format, args);
+	va_end(args);
+}
+
+/**
+ * Add a query to a batch, parsing the reply as a boolean.
+ *
+ * @param batch The batch to add the query to.
+ * @param result Pointer where to store the parsed result.
+ * @param format Format string of the query, followed by its arguments.
+ */
+SR_PRIV void sr_scpi_batch_add_bool(struct sr_scpi_batch *batch,
+			gboolean *result, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	scpi_batch_add(batch, SCPI_BATCH_BOOL, result, format, args);
+	va_end(args);
+}
+
+/**
+ * Add a query to a batch, parsing the reply as an integer.
+ *
+ * @param batch The batch to add the query to.
+ * @param result Pointer where to store the parsed result.
+ * @param format Format string of the query, followed by its arguments.
+ */
+SR_PRIV void sr_scpi_batch_add_int(struct sr_scpi_batch *batch,
+			int *result, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	scpi_batch_add(batch, SCPI_BATCH_INT, result, format, args);
+	va_end(args);
+}
+
+/**
+ * Add a query to a batch, parsing the reply as a float.
+ *
+ * @param batch The batch to add the query to.
+ * @param result Pointer where to store the parsed result.
+ * @param format Format string of the query, followed by its arguments.
+ */
+SR_PRIV void sr_scpi_batch_add_float(struct sr_scpi_batch *batch,
+			float *result, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	scpi_batch_add(batch, SCPI_BATCH_FLOAT, result, format, args);
+	va_end(args);
+}
+
+/**
+ * Add a query to a batch, parsing the reply as a double.
+ *
+ * @param batch The batch to add the query to.
+ * @param result Pointer where to store the parsed result.
+ * @param format Format string of the query, followed by its arguments.
+ */
+SR_PRIV void sr_scpi_batch_add_double(struct sr_scpi_batch *batch,
+			double *result, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	scpi_batch_add(batch, SCPI_BATCH_DOUBLE, result, format, args);
+	va_end(args);
+}
+
+static int scpi_batch_parse(struct scpi_batch_query *query,
+		const char *response)
+{
+	int ret;
+
+	switch (query->type) {
+	case SCPI_BATCH_STRING:
+		*(char **)query->result = g_strdup(response);
+		return SR_OK;
+	case SCPI_BATCH_BOOL:
+		ret = parse_strict_bool(response, query->result);
+		break;
+	case SCPI_BATCH_INT:
+		ret = sr_atoi(response, query->result);
+		break;
+	case SCPI_BATCH_FLOAT:
+		ret = sr_atof_ascii(response, query->result);
+		break;
+	case SCPI_BATCH_DOUBLE:
+		ret = sr_atod(response, query->result);
+		break;
+	default:
+		return SR_ERR_BUG;
+	}
+
+	if (ret != SR_OK) {
+		sr_dbg("Invalid response to '%s': '%.70s'.",
+			query->command, response);
+		return SR_ERR_DATA;
+	}
+
+	return SR_OK;
+}
+
+/*
+ * Split the response to a compound query into the responses to the
+ * individual queries. These are separated by semicolons, or by line
+ * breaks on some instruments. Separators within quoted strings don't
+ * count. The response is modified in place.
+ */
+static GPtrArray *scpi_batch_split(char *response)
+{
+	GPtrArray *fields;
+	char *p, *start, quote;
+
+	fields = g_ptr_array_new();
+	quote = '\0';
+
+	for (p = start = response; *p; p++) {
+		if (quote) {
+			if (*p == quote)
+				quote = '\0';
+		} else if (*p == '"' || *p == '\'') {
+			quote = *p;
+		} else if (*p == ';' || *p == '\n') {
+			*p = '\0';
+			g_ptr_array_add(fields, g_strstrip(start));
+			start = p + 1;
+		}
+	}
+	g_ptr_array_add(fields, g_strstrip(start));
+
+	return fields;
+}
+
+/*
+ * Read and discard what a device sends separately in response to the
+ * remaining queries of a compound query, so that it doesn't end up in
+ * the responses to later queries.
+ */
+static void scpi_batch_drain(struct sr_scpi_dev_inst *scpi,
+		unsigned int missing)
+{
+	GPtrArray *fields;
+	char *response;
+
+	while (missing > 0) {
+		response = NULL;
+		if (sr_scpi_get_string(scpi, NULL, &response) != SR_OK) {
+			g_free(response);
+			break;
+		}
+		fields = scpi_batch_split(response);
+		missing -= MIN(missing, fields->len);
+		g_ptr_array_free(fields, TRUE);
+		g_free(response);
+	}
+}
+
+/*
+ * Send num_queries queries, joined into the given message, and parse
+ * the responses. Returns SR_ERR_NA if the device didn't answer every
+ * query, in which case nothing was stored.
+ */
+static int scpi_batch_run_compound(struct sr_scpi_dev_inst *scpi,
+		struct scpi_batch_query *queries, unsigned int num_queries,
+		const char *message)
+{
+	GPtrArray *fields;
+	char *response;
+	unsigned int i;
+	int ret;
+
+	if (sr_scpi_send(scpi, "%s", message) != SR_OK)
+		return SR_ERR;
+
+	/* Devices which reject compound queries mostly don't answer. */
+	response = NULL;
+	ret = sr_scpi_get_string(scpi, NULL, &response);
+	if (ret == SR_ERR_TIMEOUT || (ret == SR_OK && !*response)) {
+		sr_dbg("No response to %u queries, disabling batching.",
+			num_queries);
+		scpi->no_batch = TRUE;
+		g_free(response);
+		return SR_ERR_NA;
+	} else if (ret != SR_OK) {
+		g_free(response);
+		return SR_ERR;
+	}
+
+	fields = scpi_batch_split(response);
+
+	if (fields->len != num_queries) {
+		sr_dbg("Got %u responses to %u queries, disabling batching.",
+			fields->len, num_queries);
+		scpi->no_batch = TRUE;
+		if (fields->len < num_queries)
+			scpi_batch_drain(scpi, num_queries - fields->len);
+		ret = SR_ERR_NA;
+	} else {
+		for (i = 0, ret = SR_OK; i < num_queries && ret == SR_OK; i++)
+			ret = scpi_batch_parse(&queries[i], fields->pdata[i]);
+	}
+
+	g_ptr_array_free(fields, TRUE);
+	g_free(response);
+
+	return ret;
+}
+
+static int scpi_batch_run_single(struct sr_scpi_dev_inst *scpi,
+		struct scpi_batch_query *query)
+{
+	char *response;
+	int ret;
+
+	response = NULL;
+	ret = sr_scpi_get_string(scpi, query->command, &response);
+	if (ret == SR_OK)
+		ret = scpi_batch_parse(query, response);
+	g_free(response);
+
+	return ret;
+}
+
+/**
+ * Send the queries of a batch and store the parsed replies.
+ *
+ * As many queries as fit are joined with semicolons into compound
+ * queries, each answered in one round trip. Queries which don't start
+ * at the root of the command tree are sent with a leading colon. If the
+ * device doesn't answer a compound query in time, or not with the
+ * expected number of responses, this and all further queries on that
+ * device are sent one at a time. Responses it sends separately are
+ * read and discarded first, which takes up to the read timeout.
+ *
+ * The batch can be run again, e.g. to refresh the same state.
+ *
+ * @param scpi Previously initialised SCPI device structure.
+ * @param batch The batch to run.
+ *
+ * @return SR_OK on success, SR_ERR* on failure, after which the results
+ *         are undefined and string results are NULL.
+ */
+SR_PRIV int sr_scpi_batch_run(struct sr_scpi_dev_inst *scpi,
+			struct sr_scpi_batch *batch)
+{
+	struct scpi_batch_query *queries, *query;
+	GString *message;
+	unsigned int i, j, n, num_queries;
+	int ret;
+
+	queries = (struct scpi_batch_query *)batch->queries->data;
+	num_queries = batch->queries->len;
+
+	for (i = 0; i < num_queries; i++)
+		if (queries[i].type == SCPI_BATCH_STRING)
+			*(char **)queries[i].result = NULL;
+
+	message = g_string_sized_new(SCPI_BATCH_MAX_LEN);
+	ret = SR_OK;
+
+	for (i = 0; i < num_queries && ret == SR_OK; i += n) {
+		g_string_assign(message, queries[i].command);
+		for (n = 1; !scpi->no_batch && n < SCPI_BATCH_MAX_QUERIES &&
+				i + n < num_queries; n++) {
+			query = &queries[i + n];
+			if (message->len + strlen(query->command) + 2 >
+					SCPI_BATCH_MAX_LEN)
+				break;
+			g_string_append_c(message, ';');
+			if (query->command[0] != ':' && query->command[0] != '*')
+				g_string_append_c(message, ':');
+			g_string_append(message, query->command);
+		}
+
+		ret = SR_ERR_NA;
+		if (n > 1)
+			ret = scpi_batch_run_compound(scpi, &queries[i], n,
+					message->str);
+		if (ret == SR_ERR_NA)
+			for (j = 0, ret = SR_OK; j < n && ret == SR_OK; j++)
+				ret = scpi_batch_run_single(scpi, &queries[i + j]);
+	}
+
+	g_string_free(message, TRUE);
+
+	if (ret != SR_OK) {
+		for (i = 0; i < num_queries; i++) {
+			if (queries[i].type != SCPI_BATCH_STRING)
+				continue;
+			g_free(*(char **)queries[i].result);
+			*(char **)queries[i].result = NULL;
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Free a batch of queries.
+ *
+ * @param batch The batch to free. Can be NULL.
+ */
+SR_PRIV void sr_scpi_batch_free(struct sr_scpi_batch *batch)
+{
+	unsigned int i;
+
+	if (!batch)
+		return;
+
+	for (i = 0; i < batch->queries->len; i++)
+		g_free(g_array_index(batch->queries,
+				struct scpi_batch_query, i).command);
+	g_array_free(batch->queries, TRUE);
+	g_free(batch);
+}
+
+static void scpi_async_request_free(struct scpi_async_request *req)
+{
+	g_free(req->command);
+	g_free(req);
+}
+
+static void scpi_async_free(struct scpi_async *async)
+{
+	struct scpi_async_request *req;
+
+	if (!async)
+		return;
+
+	while ((req = g_queue_pop_head(&async->requests)))
+		scpi_async_request_free(req);
+	g_string_free(async->response, TRUE);
+	g_free(async);
+}
+
+/* Send the first request. */
+static void scpi_async_send(struct sr_scpi_dev_inst *scpi)
+{
+	struct scpi_async *async;
+	struct scpi_async_request *req;
+
+	async = scpi->async;
+	req = g_queue_peek_head(&async->requests);
+
+	async->send_ret = scpi->send(scpi->priv, req->command);
+	if (async->send_ret == SR_OK && req->query) {
+		async->send_ret = scpi->read_begin(scpi->priv);
+		g_string_truncate(async->response, 0);
+		async->laststart = g_get_monotonic_time();
+	}
+	async->sent = TRUE;
+}
+
+/*
+ * Read what is available of the response to the first request.
+ * Returns SR_ERR_NA if the response is still incomplete.
+ */
+static int scpi_async_read(struct sr_scpi_dev_inst *scpi)
+{
+	struct scpi_async *async;
+	GString *response;
+	char buf[256];
+	int len;
+	unsigned int elapsed_ms;
+
+	async = scpi->async;
+	response = async->response;
+
+	while (!scpi->read_complete(scpi->priv)) {
+		/* Transports without it block, like sr_scpi_get_string(). */
+		if (scpi->read_data_nowait)
+			len = scpi->read_data_nowait(scpi->priv, buf, sizeof(buf));
+		else
+			len = scpi->read_data(scpi->priv, buf, sizeof(buf));
+		if (len < 0) {
+			sr_err("Incompletely read SCPI response.");
+			return SR_ERR;
+		} else if (len > 0) {
+			async->laststart = g_get_monotonic_time();
+			g_string_append_len(response, buf, len);
+			continue;
+		}
+		elapsed_ms = (g_get_monotonic_time() - async->laststart) / 1000;
+		if (elapsed_ms >= scpi->read_timeout_ms) {
+			sr_err("Timed out waiting for SCPI response.");
+			return SR_ERR_TIMEOUT;
+		}
+		if (scpi->read_data_nowait)
+			return SR_ERR_NA;
+	}
+
+	/* Get rid of trailing linefeed and carriage return if present. */
+	if (response->len >= 1 && response->str[response->len - 1] == '\n')
+		g_string_truncate(response, response->len - 1);
+	if (response->len >= 1 && response->str[response->len - 1] == '\r')
+		g_string_truncate(response, response->len - 1);
+
+	sr_spew("Got response: '%.70s', length %" G_GSIZE_FORMAT ".",
+		response->str, response->len);
+
+	return SR_OK;
+}
+
+/* Complete as many requests as possible, in order. */
+static void scpi_async_run(struct sr_scpi_dev_inst *scpi)
+{
+	struct scpi_async *async;
+	struct scpi_async_request *req;
+	int ret;
+
+	async = scpi->async;
+	async->running = TRUE;
+
+	while ((req = g_queue_peek_head(&async->requests))) {
+		if (!async->sent)
+			scpi_async_send(scpi);
+		ret = async->send_ret;
+		if (ret == SR_OK && req->query)
+			if ((ret = scpi_async_read(scpi)) == SR_ERR_NA)
+				break;
+
+		g_queue_pop_head(&async->requests);
+		async->sent = FALSE;
+		if (req->cb)
+			req->cb(scpi, ret, (ret == SR_OK && req->query) ?
+				async->response->str : NULL, req->cb_data);
+		scpi_async_request_free(req);
+	}
+
+	async->running = FALSE;
+}
+
+static int scpi_async_receive(int fd, int revents, void *cb_data)
+{
+	(void)fd;
+	(void)revents;
+
+	scpi_async_run(cb_data);
+
+	return TRUE;
+}
+
+static int scpi_async_submit(struct sr_session *session,
+		struct sr_scpi_dev_inst *scpi, gboolean query,
+		sr_scpi_async_callback cb, void *cb_data,
+		const char *format, va_list args)
+{
+	struct scpi_async *async;
+	struct scpi_async_request *req;
+	int ret;
+
+	if (!session || !scpi)
+		return SR_ERR_ARG;
+
+	if (!(async = scpi->async)) {
+		async = g_malloc0(sizeof(struct scpi_async));
+		g_queue_init(&async->requests);
+		async->response = g_string_new("");
+		scpi->async = async;
+	}
+
+	if (async->source_added && async->session != session) {
+		sr_err("Asynchronous requests pending in another session.");
+		return SR_ERR_ARG;
+	}
+
+	if (!async->source_added) {
+		ret = scpi->source_add(session, scpi->priv, G_IO_IN,
+				SCPI_ASYNC_POLL_MS, scpi_async_receive, scpi);
+		if (ret != SR_OK)
+			return ret;
+		async->session = session;
+		async->source_added = TRUE;
+	}
+
+	req = g_malloc0(sizeof(struct scpi_async_request));
+	req->command = g_strdup_vprintf(format, args);
+	req->query = query;
+	req->cb = cb;
+	req->cb_data = cb_data;
+	g_queue_push_tail(&async->requests, req);
+
+	/* Don't wait for the event source if the device is idle. */
+	if (!async->running && g_queue_get_length(&async->requests) == 1)
+		scpi_async_send(scpi);
+
+	return SR_OK;
+}
+
+/**
+ * Send a SCPI command without waiting for it to be sent.
+ *
+ * The command is queued behind all pending asynchronous requests of
+ * the device. Requests are handled by an event source of the device in
+ * the given session, which stays installed until
+ * sr_scpi_async_cancel() is called. Drivers must not add their own
+ * event source for the device meanwhile.
+ *
+ * @param session The session whose main loop handles the request.
+ * @param scpi Previously initialised SCPI device structure.
+ * @param cb Function called once the command was sent. Can be NULL.
+ * @param cb_data Data for the callback function.
+ * @param format Format string, to be followed by any necessary arguments.
+ *
+ * @return SR_OK if the command was queued, SR_ERR* on failure.
+ */
+SR_PRIV int sr_scpi_send_async(struct sr_session *session,
+			struct sr_scpi_dev_inst *scpi, sr_scpi_async_callback cb,
+			void *cb_data, const char *format, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, format);
+	ret = scpi_async_submit(session, scpi, FALSE, cb, cb_data,
+			format, args);
+	va_end(args);
+
+	return ret;
+}
+
+/**
+ * Send a SCPI query without waiting for the response.
+ *
+ * Like sr_scpi_send_async(), but the callback is called with the
+ * response once it has been received, or with an error if it didn't
+ * arrive within the read timeout of the device. With the TCP, serial
+ * and VXI transports, the main loop of the session is never blocked
+ * while waiting for the response, so one session can query many
+ * devices concurrently. Other transports block like
+ * sr_scpi_get_string() once the event source fires.
+ *
+ * @param session The session whose main loop handles the request.
+ * @param scpi Previously initialised SCPI device structure.
+ * @param cb Function called with the response. Can be NULL.
+ * @param cb_data Data for the callback function.
+ * @param format Format string, to be followed by any necessary arguments.
+ *
+ * @return SR_OK if the query was queued, SR_ERR* on failure.
+ */
+SR_PRIV int sr_scpi_get_string_async(struct sr_session *session,
+			struct sr_scpi_dev_inst *scpi, sr_scpi_async_callback cb,
+			void *cb_data, const char *format, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, format);
+	ret = scpi_async_submit(session, scpi, TRUE, cb, cb_data,
+			format, args);
+	va_end(args);
+
+	return ret;
+}
+
+/**
+ * Get the number of pending asynchronous requests of a device.
+ *
+ * @param scpi Previously initialised SCPI device structure.
+ *
+ * @return The number of requests which haven't completed yet.
+ */
+SR_PRIV int sr_scpi_async_pending(struct sr_scpi_dev_inst *scpi)
+{
+	if (!scpi->async)
+		return 0;
+
+	return g_queue_get_length(&scpi->async->requests);
+}
+
+/**
+ * Cancel all pending asynchronous requests of a device.
+ *
+ * The callbacks of cancelled requests are not called. If a query was
+ * already sent, its response is read and discarded first, so that the
+ * device is ready for the next command. This blocks until the response
+ * is complete, or for at most the read timeout of the device after the
+ * last data received from it. The event source of the device is
+ * removed.
+ *
+ * @param scpi Previously initialised SCPI device structure.
+ */
+SR_PRIV void sr_scpi_async_cancel(struct sr_scpi_dev_inst *scpi)
+{
+	struct scpi_async *async;
+	struct scpi_async_request *req;
+
+	if (!(async = scpi->async))
+		return;
+
+	req = g_queue_peek_head(&async->requests);
+	if (req && req->query && async->sent && async->send_ret == SR_OK) {
+		while (scpi_async_read(scpi) == SR_ERR_NA) {
+			/* Sleep until there's data, where the transport can. */
+			if (scpi->read_wait)
+				scpi_read_wait(scpi, async->laststart);
+			else
+				g_usleep(SCPI_ASYNC_POLL_MS * 1000);
+		}
+	}
+
+	while ((req = g_queue_pop_head(&async->requests)))
+		scpi_async_request_free(req);
+	async->sent = FALSE;
+
+	if (async->source_added) {
+		scpi->source_remove(async->session, scpi->priv);
+		async->source_added = FALSE;
+		async->session = NULL;
+	}
+}
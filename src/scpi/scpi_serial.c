@@ -235,6 +235,8 @@ SR_PRIV const struct sr_scpi_dev_inst scpi_serial_dev = {
 	.send          = scpi_serial_send,
 	.read_begin    = scpi_serial_read_begin,
 	.read_data     = scpi_serial_read_data,
+	/* Never waits for data anyway. */
+	.read_data_nowait = scpi_serial_read_data,
 	.read_complete = scpi_serial_read_complete,
 	.close         = scpi_serial_close,
 	.free          = scpi_serial_free,
@@ -27,6 +27,7 @@
 #include <string.h>
 #include <unistd.h>
 #ifndef _WIN32
+#include <sys/select.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -222,6 +223,40 @@ static int scpi_tcp_rigol_read_data(void *priv, char *buf, int maxlen)
 	return len;
 }
 
+/*
+ * Wait for up to timeout_ms for a recv() on the socket to return without
+ * waiting. Returns whether it would.
+ */
+static int scpi_tcp_read_wait(void *priv, unsigned int timeout_ms)
+{
+	struct scpi_tcp *tcp = priv;
+	fd_set fds;
+	struct timeval tv;
+
+	FD_ZERO(&fds);
+	FD_SET(tcp->socket, &fds);
+	tv.tv_sec = timeout_ms / 1000;
+	tv.tv_usec = (timeout_ms % 1000) * 1000;
+
+	return select(tcp->socket + 1, &fds, NULL, NULL, &tv) > 0;
+}
+
+static int scpi_tcp_raw_read_data_nowait(void *priv, char *buf, int maxlen)
+{
+	if (!scpi_tcp_read_wait(priv, 0))
+		return 0;
+
+	return scpi_tcp_raw_read_data(priv, buf, maxlen);
+}
+
+static int scpi_tcp_rigol_read_data_nowait(void *priv, char *buf, int maxlen)
+{
+	if (!scpi_tcp_read_wait(priv, 0))
+		return 0;
+
+	return scpi_tcp_rigol_read_data(priv, buf, maxlen);
+}
+
 static int scpi_tcp_read_complete(void *priv)
 {
 	struct scpi_tcp *tcp = priv;
@@ -259,6 +294,8 @@ SR_PRIV const struct sr_scpi_dev_inst scpi_tcp_raw_dev = {
 	.send          = scpi_tcp_send,
 	.read_begin    = scpi_tcp_read_begin,
 	.read_data     = scpi_tcp_raw_read_data,
+	.read_data_nowait = scpi_tcp_raw_read_data_nowait,
+	.read_wait     = scpi_tcp_read_wait,
 	.read_complete = scpi_tcp_read_complete,
 	.close         = scpi_tcp_close,
 	.free          = scpi_tcp_free,
@@ -275,6 +312,8 @@ SR_PRIV const struct sr_scpi_dev_inst scpi_tcp_rigol_dev = {
 	.send          = scpi_tcp_send,
 	.read_begin    = scpi_tcp_read_begin,
 	.read_data     = scpi_tcp_rigol_read_data,
+	.read_data_nowait = scpi_tcp_rigol_read_data_nowait,
+	.read_wait     = scpi_tcp_read_wait,
 	.read_complete = scpi_tcp_read_complete,
 	.close         = scpi_tcp_close,
 	.free          = scpi_tcp_free,
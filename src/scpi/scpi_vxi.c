@@ -95,17 +95,17 @@ static int scpi_vxi_open(struct sr_scpi_dev_inst *scpi)
 static int scpi_vxi_source_add(struct sr_session *session, void *priv,
 		int events, int timeout, sr_receive_data_callback cb, void *cb_data)
 {
-	(void)priv;
-
-	/* Hook up a dummy handler to receive data from the device. */
-	return sr_session_source_add(session, -1, events, timeout, cb, cb_data);
+	/*
+	 * Hook up a dummy handler to receive data from the device. Keyed
+	 * by the device, so that several devices can have one.
+	 */
+	return sr_session_fd_source_add(session, priv, -1, events, timeout,
+			cb, cb_data);
 }
 
 static int scpi_vxi_source_remove(struct sr_session *session, void *priv)
 {
-	(void)priv;
-
-	return sr_session_source_remove(session, -1);
+	return sr_session_source_remove_internal(session, priv);
 }
 
 /* Operation Flags */
@@ -163,21 +163,25 @@ static int scpi_vxi_read_begin(void *priv)
 #define RRR_TERM  0x02  /* a termination char has been read */
 #define RRR_END   0x04  /* an END indicator has been read */
 
-static int scpi_vxi_read_data(void *priv, char *buf, int maxlen)
+/* Error codes */
+#define ERR_IO_TIMEOUT 15
+
+static int scpi_vxi_read(struct scpi_vxi *vxi, char *buf, int maxlen,
+		unsigned long io_timeout)
 {
-	struct scpi_vxi *vxi = priv;
 	Device_ReadParms read_parms;
 	Device_ReadResp *read_resp;
 
 	read_parms.lid          = vxi->link;
-	read_parms.io_timeout   = VXI_DEFAULT_TIMEOUT_MS;
+	read_parms.io_timeout   = io_timeout;
 	read_parms.lock_timeout = VXI_DEFAULT_TIMEOUT_MS;
 	read_parms.flags        = 0;
 	read_parms.termChar     = 0;
 	read_parms.requestSize  = maxlen;
 
 	if (!(read_resp = device_read_1(&read_parms, vxi->client))
-	    || read_resp->error) {
+	    || (read_resp->error
+		&& !(io_timeout == 0 && read_resp->error == ERR_IO_TIMEOUT))) {
 		sr_err("Device read failed for %s with error %ld",
 		       vxi->address, read_resp ? read_resp->error : 0);
 		return SR_ERR;
@@ -188,6 +192,17 @@ static int scpi_vxi_read_data(void *priv, char *buf, int maxlen)
 	return read_resp->data.data_len;  /* actual number of bytes received */
 }
 
+static int scpi_vxi_read_data(void *priv, char *buf, int maxlen)
+{
+	return scpi_vxi_read(priv, buf, maxlen, VXI_DEFAULT_TIMEOUT_MS);
+}
+
+/* Returns what the device has right now, or nothing at all. */
+static int scpi_vxi_read_data_nowait(void *priv, char *buf, int maxlen)
+{
+	return scpi_vxi_read(priv, buf, maxlen, 0);
+}
+
 static int scpi_vxi_read_complete(void *priv)
 {
 	struct scpi_vxi *vxi = priv;
@@ -233,6 +248,7 @@ SR_PRIV const struct sr_scpi_dev_inst scpi_vxi_dev = {
 	.send          = scpi_vxi_send,
 	.read_begin    = scpi_vxi_read_begin,
 	.read_data     = scpi_vxi_read_data,
+	.read_data_nowait = scpi_vxi_read_data_nowait,
 	.read_complete = scpi_vxi_read_complete,
 	.close         = scpi_vxi_close,
 	.free          = scpi_vxi_free,
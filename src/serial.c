@@ -99,6 +99,8 @@ SR_PRIV int serial_open(struct sr_serial_dev_inst *serial, int flags)
 		return SR_ERR;
 	}
 
+	serial->rx_start = serial->rx_len = 0;
+
 	if (serial->serialcomm)
 		return serial_set_paramstr(serial, serial->serialcomm);
 	else
@@ -148,6 +150,7 @@ SR_PRIV int serial_close(struct sr_serial_dev_inst *serial)
 
 	sp_free_port(serial->data);
 	serial->data = NULL;
+	serial->rx_start = serial->rx_len = 0;
 
 	return SR_OK;
 }
@@ -179,6 +182,7 @@ SR_PRIV int serial_flush(struct sr_serial_dev_inst *serial)
 
 	sr_spew("Flushing serial port %s.", serial->port);
 
+	serial->rx_start = serial->rx_len = 0;
 	ret = sp_flush(serial->data, SP_BUF_BOTH);
 
 	switch (ret) {
@@ -313,11 +317,42 @@ SR_PRIV int serial_write_nonblocking(struct sr_serial_dev_inst *serial,
 	return _serial_write(serial, buf, count, 1, 0);
 }
 
+/* Translate the result of a libserialport read. */
+static int serial_read_result(enum sp_return ret)
+{
+	char *error;
+
+	switch (ret) {
+	case SP_ERR_ARG:
+		sr_err("Attempted serial port read with invalid arguments.");
+		return SR_ERR_ARG;
+	case SP_ERR_FAIL:
+		error = sp_last_error_message();
+		sr_err("Read error (%d): %s.", sp_last_error_code(), error);
+		sp_free_error_message(error);
+		return SR_ERR;
+	default:
+		return ret;
+	}
+}
+
+/* Read from the port itself, bypassing the receive buffer. */
+static int serial_port_read(struct sr_serial_dev_inst *serial, void *buf,
+		size_t count, int nonblocking, unsigned int timeout_ms)
+{
+	if (nonblocking)
+		return serial_read_result(sp_nonblocking_read(serial->data,
+				buf, count));
+	else
+		return serial_read_result(sp_blocking_read(serial->data,
+				buf, count, timeout_ms));
+}
+
 static int _serial_read(struct sr_serial_dev_inst *serial, void *buf,
 		size_t count, int nonblocking, unsigned int timeout_ms)
 {
-	ssize_t ret;
-	char *error;
+	size_t buffered;
+	int ret;
 
 	if (!serial) {
 		sr_dbg("Invalid serial port.");
@@ -329,24 +364,23 @@ static int _serial_read(struct sr_serial_dev_inst *serial, void *buf,
 		return SR_ERR;
 	}
 
-	if (nonblocking)
-		ret = sp_nonblocking_read(serial->data, buf, count);
-	else
-		ret = sp_blocking_read(serial->data, buf, count, timeout_ms);
-
-	switch (ret) {
-	case SP_ERR_ARG:
-		sr_err("Attempted serial port read with invalid arguments.");
-		return SR_ERR_ARG;
-	case SP_ERR_FAIL:
-		error = sp_last_error_message();
-		sr_err("Read error (%d): %s.", sp_last_error_code(), error);
-		sp_free_error_message(error);
-		return SR_ERR;
+	/* Bytes in the receive buffer arrived first, hand them out first. */
+	buffered = MIN(count, serial->rx_len);
+	if (buffered) {
+		memcpy(buf, serial_rx_peek(serial), buffered);
+		serial_rx_consume(serial, buffered);
+		if (buffered == count)
+			return buffered;
 	}
 
+	ret = serial_port_read(serial, (uint8_t *)buf + buffered,
+			count - buffered, nonblocking, timeout_ms);
+	if (ret < 0)
+		return buffered ? (int)buffered : ret;
+	ret += buffered;
+
 	if (ret > 0)
-		sr_spew("Read %zd/%zu bytes.", ret, count);
+		sr_spew("Read %d/%zu bytes.", ret, count);
 
 	return ret;
 }
@@ -392,6 +426,241 @@ SR_PRIV int serial_read_nonblocking(struct sr_serial_dev_inst *serial, void *buf
 	return _serial_read(serial, buf, count, 1, 0);
 }
 
+/**
+ * Read what the specified serial port has into its receive buffer.
+ *
+ * All available bytes are read at once, up to the free space in the
+ * buffer. Call this when the event source of the port reports G_IO_IN,
+ * then take complete lines or packets from the buffer with
+ * serial_rx_line() or serial_rx_frame(). The buffered bytes are also
+ * returned first by serial_read_blocking() and serial_read_nonblocking().
+ *
+ * @param serial Previously initialized serial port structure.
+ * @param[in] timeout_ms How long to wait for the first byte, or 0 to
+ *                       return immediately if there is none.
+ *
+ * @retval SR_ERR_ARG Invalid argument.
+ * @retval SR_ERR     Other error.
+ * @retval other      The number of bytes added to the buffer. 0 if none
+ *                    arrived within the timeout, or the buffer is full.
+ *
+ * @private
+ */
+SR_PRIV int serial_rx_fill(struct sr_serial_dev_inst *serial,
+		unsigned int timeout_ms)
+{
+	size_t space;
+	int ret;
+
+	if (!serial) {
+		sr_dbg("Invalid serial port.");
+		return SR_ERR;
+	}
+
+	if (!serial->data) {
+		sr_dbg("Cannot use unopened serial port %s.", serial->port);
+		return SR_ERR;
+	}
+
+	/* Keep the buffered bytes contiguous, for packet_valid(). */
+	if (serial->rx_start) {
+		memmove(serial->rx_buf, serial->rx_buf + serial->rx_start,
+				serial->rx_len);
+		serial->rx_start = 0;
+	}
+
+	space = SERIAL_RX_BUFSIZE - serial->rx_len;
+	if (!space)
+		return 0;
+
+	/* Returns as soon as there is anything, unlike sp_blocking_read(). */
+	if (timeout_ms)
+		ret = serial_read_result(sp_blocking_read_next(serial->data,
+				serial->rx_buf + serial->rx_len, space, timeout_ms));
+	else
+		ret = serial_port_read(serial, serial->rx_buf + serial->rx_len,
+				space, 1, 0);
+	if (ret < 0)
+		return ret;
+
+	if (ret > 0) {
+		serial->rx_len += ret;
+		sr_spew("Buffered %d bytes, %zu available.", ret,
+				serial->rx_len);
+	}
+
+	return ret;
+}
+
+/**
+ * Get the number of bytes in the receive buffer of a serial port.
+ *
+ * @param serial Previously initialized serial port structure.
+ *
+ * @private
+ */
+SR_PRIV size_t serial_rx_available(const struct sr_serial_dev_inst *serial)
+{
+	return serial->rx_len;
+}
+
+/**
+ * Get the bytes in the receive buffer of a serial port.
+ *
+ * @param serial Previously initialized serial port structure.
+ *
+ * @return The first of serial_rx_available() contiguous bytes. Only valid
+ *         until the next call to any of the serial port functions.
+ *
+ * @private
+ */
+SR_PRIV const uint8_t *serial_rx_peek(const struct sr_serial_dev_inst *serial)
+{
+	return serial->rx_buf + serial->rx_start;
+}
+
+/**
+ * Remove bytes from the receive buffer of a serial port.
+ *
+ * @param serial Previously initialized serial port structure.
+ * @param[in] count The number of bytes to remove. Must not be larger than
+ *                  serial_rx_available().
+ *
+ * @private
+ */
+SR_PRIV void serial_rx_consume(struct sr_serial_dev_inst *serial, size_t count)
+{
+	count = MIN(count, serial->rx_len);
+	serial->rx_start += count;
+	serial->rx_len -= count;
+	if (!serial->rx_len)
+		serial->rx_start = 0;
+}
+
+/**
+ * Take a line from the receive buffer of a serial port.
+ *
+ * Lines end with CR or LF, which is stripped. A line which doesn't fit
+ * into the buffer is returned in pieces.
+ *
+ * @param serial Previously initialized serial port structure.
+ * @param buf Buffer where to store the NUL terminated line.
+ * @param[in] maxlen Size of the buffer.
+ *
+ * @retval SR_ERR_NA No complete line has been received yet.
+ * @retval other     The length of the line.
+ *
+ * @private
+ */
+SR_PRIV int serial_rx_line(struct sr_serial_dev_inst *serial, char *buf,
+		size_t maxlen)
+{
+	const uint8_t *data;
+	size_t len, i;
+
+	if (maxlen < 1)
+		return SR_ERR_ARG;
+
+	data = serial_rx_peek(serial);
+	len = MIN(serial->rx_len, maxlen - 1);
+	for (i = 0; i < len; i++)
+		if (data[i] == '\r' || data[i] == '\n')
+			break;
+
+	/* Incomplete, unless it fills the buffer or the receive buffer. */
+	if (i == len && len < maxlen - 1 && len < SERIAL_RX_BUFSIZE)
+		return SR_ERR_NA;
+
+	memcpy(buf, data, i);
+	buf[i] = '\0';
+	serial_rx_consume(serial, i < len ? i + 1 : i);
+
+	return i;
+}
+
+/**
+ * Take a packet from the receive buffer of a serial port.
+ *
+ * Bytes before the first packet are discarded. The packet is not copied.
+ *
+ * @param serial Previously initialized serial port structure.
+ * @param framing Description of the packets.
+ * @param[out] pkt The packet. Only valid until the next call to any of the
+ *                 serial port functions.
+ *
+ * @retval SR_ERR_NA No complete packet has been received yet.
+ * @retval other     The size of the packet.
+ *
+ * @private
+ */
+SR_PRIV int serial_rx_frame(struct sr_serial_dev_inst *serial,
+		const struct sr_framing *framing, const uint8_t **pkt)
+{
+	const uint8_t *data;
+	size_t offset;
+	int ret;
+
+	data = serial_rx_peek(serial);
+	ret = sr_framing_find(framing, data, serial->rx_len, &offset);
+	if (ret < 0) {
+		serial_rx_consume(serial, offset);
+		return ret;
+	}
+
+	*pkt = data + offset;
+	serial_rx_consume(serial, offset + ret);
+
+	return ret;
+}
+
+/**
+ * Wait for a packet on a serial port.
+ *
+ * The packet is left in the receive buffer.
+ *
+ * @param serial Previously initialized serial port structure.
+ * @param framing Description of the packets.
+ * @param[in] timeout_ms The maximum time to wait.
+ *
+ * @retval SR_OK          A packet was received.
+ * @retval SR_ERR_TIMEOUT No packet within the timeout.
+ * @retval other          Error reading from the port.
+ *
+ * @private
+ */
+SR_PRIV int serial_rx_frame_detect(struct sr_serial_dev_inst *serial,
+		const struct sr_framing *framing, unsigned int timeout_ms)
+{
+	int64_t start, elapsed;
+	size_t offset;
+	int ret;
+
+	sr_dbg("Detecting packets on %s (timeout = %ums).",
+			serial->port, timeout_ms);
+
+	start = g_get_monotonic_time();
+	while (1) {
+		ret = sr_framing_find(framing, serial_rx_peek(serial),
+				serial->rx_len, &offset);
+		if (ret > 0) {
+			serial_rx_consume(serial, offset);
+			sr_spew("Found valid %d-byte packet.", ret);
+			return SR_OK;
+		}
+		serial_rx_consume(serial, offset);
+
+		elapsed = (g_get_monotonic_time() - start) / 1000;
+		if (elapsed >= timeout_ms)
+			break;
+		if ((ret = serial_rx_fill(serial, timeout_ms - elapsed)) < 0)
+			return ret;
+	}
+
+	sr_dbg("Detection timed out after %ums.", timeout_ms);
+
+	return SR_ERR_TIMEOUT;
+}
+
 /**
  * Set serial parameters for the specified serial port.
  *
@@ -624,33 +893,28 @@ SR_PRIV int serial_readline(struct sr_serial_dev_inst *serial, char **buf,
 	}
 
 	start = g_get_monotonic_time();
-	remaining = timeout_ms;
 
 	maxlen = *buflen;
-	*buflen = len = 0;
-	while (1) {
-		len = maxlen - *buflen - 1;
-		if (len < 1)
-			break;
-		len = sp_blocking_read(serial->data, *buf + *buflen, 1, remaining);
-		if (len > 0) {
-			*buflen += len;
-			*(*buf + *buflen) = '\0';
-			if (*buflen > 0 && (*(*buf + *buflen - 1) == '\r'
-					|| *(*buf + *buflen - 1) == '\n')) {
-				/* Strip CR/LF and terminate. */
-				*(*buf + --*buflen) = '\0';
-				break;
-			}
-		}
+	*buflen = 0;
+	if (maxlen < 1)
+		return SR_OK;
+	**buf = '\0';
+	while ((len = serial_rx_line(serial, *buf, maxlen)) == SR_ERR_NA) {
 		/* Reduce timeout by time elapsed. */
 		remaining = timeout_ms - ((g_get_monotonic_time() - start) / 1000);
-		if (remaining <= 0)
-			/* Timeout */
+		if (remaining <= 0) {
+			/* Timeout, return what we have. */
+			len = MIN(serial->rx_len, (size_t)maxlen - 1);
+			memcpy(*buf, serial_rx_peek(serial), len);
+			*(*buf + len) = '\0';
+			serial_rx_consume(serial, len);
 			break;
-		if (len < 1)
-			g_usleep(2000);
+		}
+		/* Wait for the next bytes, rather than polling. */
+		if (serial_rx_fill(serial, remaining) < 0)
+			return SR_ERR;
 	}
+	*buflen = len;
 	if (*buflen)
 		sr_dbg("Received %d: '%s'.", *buflen, *buf);
 
@@ -682,9 +946,9 @@ SR_PRIV int serial_stream_detect(struct sr_serial_dev_inst *serial,
 				 packet_valid_callback is_valid,
 				 uint64_t timeout_ms, int baudrate)
 {
-	uint64_t start, time, byte_delay_us;
+	uint64_t start, time;
 	size_t ibuf, i, maxlen;
-	ssize_t len;
+	const uint8_t *data;
 
 	maxlen = *buflen;
 
@@ -696,47 +960,46 @@ SR_PRIV int serial_stream_detect(struct sr_serial_dev_inst *serial,
 		return SR_ERR;
 	}
 
-	/* Assume 8n1 transmission. That is 10 bits for every byte. */
-	byte_delay_us = 10 * ((1000 * 1000) / baudrate);
+	/* Only used to tune polling, which is no longer done. */
+	(void)baudrate;
+
 	start = g_get_monotonic_time();
 
-	i = ibuf = len = 0;
-	while (ibuf < maxlen) {
-		len = serial_read_nonblocking(serial, &buf[ibuf], 1);
-		if (len > 0) {
-			ibuf += len;
-		} else if (len == 0) {
-			/* No logging, already done in serial_read(). */
-		} else {
-			/* Error reading byte, but continuing anyway. */
-		}
+	i = ibuf = 0;
+	while (1) {
+		data = serial_rx_peek(serial);
+		ibuf = MIN(serial_rx_available(serial), maxlen);
 
 		time = g_get_monotonic_time() - start;
 		time /= 1000;
 
-		if ((ibuf - i) >= packet_size) {
+		for (; ibuf - i >= packet_size; i++) {
 			/* We have at least a packet's worth of data. */
-			if (is_valid(&buf[i])) {
+			if (is_valid(&data[i])) {
 				sr_spew("Found valid %zu-byte packet after "
-					"%" PRIu64 "ms.", (ibuf - i), time);
+					"%" PRIu64 "ms.", packet_size, time);
+				/* Leave bytes after the packet for later reads. */
+				ibuf = i + packet_size;
+				memcpy(buf, data, ibuf);
+				serial_rx_consume(serial, ibuf);
 				*buflen = ibuf;
 				return SR_OK;
-			} else {
-				sr_spew("Got %zu bytes, but not a valid "
-					"packet.", (ibuf - i));
 			}
 			/* Not a valid packet. Continue searching. */
-			i++;
 		}
+		if (ibuf >= maxlen)
+			break;
 		if (time >= timeout_ms) {
 			/* Timeout */
 			sr_dbg("Detection timed out after %" PRIu64 "ms.", time);
 			break;
 		}
-		if (len < 1)
-			g_usleep(byte_delay_us);
+		/* Error reading, but continuing anyway. */
+		serial_rx_fill(serial, timeout_ms - time);
 	}
 
+	memcpy(buf, data, ibuf);
+	serial_rx_consume(serial, ibuf);
 	*buflen = ibuf;
 
 	sr_err("Didn't find a valid packet (read %zu bytes).", *buflen);
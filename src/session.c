@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
 #include <glib.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
@@ -68,6 +69,69 @@ struct fd_source {
 	GPollFD pollfd;
 };
 
+/* Queued packet data above which device threads wait for the session thread. */
+#define QUEUE_MAX_BYTES (64 * 1024 * 1024)
+
+/** A device running on a thread of its own.
+ * @internal
+ */
+struct dev_thread {
+	struct sr_session *session;
+	struct sr_dev_inst *sdi;
+	GMainContext *context;
+	GMainLoop *loop;
+	GThread *thread;
+	/* Set when a call from threads_call() returned. */
+	gboolean done;
+	int ret;
+	/* Whether the acquisition was started. */
+	gboolean started;
+};
+
+/** A packet sent on a device thread, to be sent on the session thread.
+ * @internal
+ */
+struct queued_packet {
+	const struct sr_dev_inst *sdi;
+	struct sr_datafeed_packet *packet;
+	struct sr_datafeed_time time;
+	uint64_t bytes;
+};
+
+/** The device threads of a running session, and their packet queue.
+ * @internal
+ */
+struct session_threads {
+	struct sr_session *session;
+	/* struct dev_thread pointers, in the order of the devices. */
+	GSList *threads;
+	/* Protects the fields below. */
+	GMutex mutex;
+	/* Queued packets, in the order they were sent. */
+	GQueue queue;
+	uint64_t queue_bytes;
+	/* Once set, device threads no longer wait for queue space. */
+	gboolean draining;
+	/* Signalled when a packet is queued, or a call returned. */
+	GCond queue_cond;
+	/* Signalled when packets are taken from the queue. */
+	GCond space_cond;
+	/* Sends the queued packets on the session thread. */
+	GSource *source;
+	GMainContext *main_context;
+};
+
+/** Event source for sending the packets queued by device threads.
+ * @internal
+ */
+struct queue_source {
+	GSource base;
+	struct session_threads *st;
+};
+
+/* The device thread, when running on one. */
+static GPrivate current_dev_thread;
+
 /** FD event source prepare() method.
  * This is called immediately before poll().
  */
@@ -118,6 +182,7 @@ static gboolean fd_source_dispatch(GSource *source,
 {
 	struct fd_source *fsource;
 	unsigned int revents;
+	uint64_t start_ns;
 	gboolean keep;
 
 	fsource = (struct fd_source *)source;
@@ -127,8 +192,16 @@ static gboolean fd_source_dispatch(GSource *source,
 		sr_err("Callback not set, cannot dispatch event.");
 		return G_SOURCE_REMOVE;
 	}
-	keep = (*(sr_receive_data_callback)callback)
-			(fsource->pollfd.fd, revents, user_data);
+	if (G_UNLIKELY(fsource->session->stats)) {
+		start_ns = sr_session_stats_time();
+		keep = (*(sr_receive_data_callback)callback)
+				(fsource->pollfd.fd, revents, user_data);
+		sr_session_stats_add_source(fsource->session, user_data,
+				start_ns);
+	} else {
+		keep = (*(sr_receive_data_callback)callback)
+				(fsource->pollfd.fd, revents, user_data);
+	}
 
 	if (fsource->timeout_us >= 0 && G_LIKELY(keep)
 			&& G_LIKELY(!g_source_is_destroyed(source)))
@@ -224,12 +297,16 @@ SR_API int sr_session_new(struct sr_context *ctx,
 	session->ctx = ctx;
 
 	g_mutex_init(&session->main_mutex);
+	g_mutex_init(&session->stats_mutex);
 
 	/* To maintain API compatibility, we need a lookup table
 	 * which maps poll_object IDs to GSource* pointers.
 	 */
 	session->event_sources = g_hash_table_new(NULL, NULL);
 
+	session->clocks = g_hash_table_new_full(NULL, NULL, NULL,
+			(GDestroyNotify)sr_dev_clock_free);
+
 	*new_session = session;
 
 	return SR_OK;
@@ -259,9 +336,15 @@ SR_API int sr_session_destroy(struct sr_session *session)
 	sr_session_datafeed_callback_remove_all(session);
 
 	g_hash_table_unref(session->event_sources);
+	g_hash_table_unref(session->clocks);
+	sr_transform_chain_free(session->transform_chain);
 
 	g_mutex_clear(&session->main_mutex);
 
+	if (session->stats)
+		g_ptr_array_free(session->stats, TRUE);
+	g_mutex_clear(&session->stats_mutex);
+
 	g_free(session);
 
 	return SR_OK;
@@ -297,6 +380,7 @@ SR_API int sr_session_dev_remove_all(struct sr_session *session)
 
 	g_slist_free(session->devs);
 	session->devs = NULL;
+	g_hash_table_remove_all(session->clocks);
 
 	return SR_OK;
 }
@@ -365,8 +449,10 @@ SR_API int sr_session_dev_add(struct sr_session *session,
 			       sr_strerror(ret));
 			return ret;
 		}
-		if ((ret = sdi->driver->dev_acquisition_start(sdi,
-					sdi)) != SR_OK) {
+		ret = sdi->driver->dev_acquisition_start(sdi, sdi);
+		/* Drivers may reconfigure the device when starting. */
+		sr_config_cache_clear(sdi);
+		if (ret != SR_OK) {
 			sr_err("Failed to start acquisition of device in "
 			       "running session (%s)", sr_strerror(ret));
 			return ret;
@@ -440,6 +526,7 @@ SR_API int sr_session_dev_remove(struct sr_session *session,
 
 	session->devs = g_slist_remove(session->devs, sdi);
 	sdi->session = NULL;
+	g_hash_table_remove(session->clocks, sdi);
 
 	return SR_OK;
 }
@@ -657,11 +744,16 @@ static int unset_main_context(struct sr_session *session)
 static unsigned int session_source_attach(struct sr_session *session,
 		GSource *source)
 {
+	struct dev_thread *dt;
 	unsigned int id = 0;
 
 	g_mutex_lock(&session->main_mutex);
 
-	if (session->main_context)
+	/* Sources added on a device thread are handled there. */
+	dt = g_private_get(&current_dev_thread);
+	if (dt && dt->session == session)
+		id = g_source_attach(source, dt->context);
+	else if (session->main_context)
 		id = g_source_attach(source, session->main_context);
 	else
 		sr_err("Cannot add event source without main context.");
@@ -671,6 +763,19 @@ static unsigned int session_source_attach(struct sr_session *session,
 	return id;
 }
 
+static unsigned int session_source_count(struct sr_session *session)
+{
+	unsigned int count;
+
+	g_mutex_lock(&session->main_mutex);
+	count = g_hash_table_size(session->event_sources);
+	g_mutex_unlock(&session->main_mutex);
+
+	return count;
+}
+
+static void session_threads_free(struct sr_session *session);
+
 /* Idle handler; invoked when the number of registered event sources
  * for a running session drops to zero.
  */
@@ -679,16 +784,23 @@ static gboolean delayed_stop_check(void *data)
 	struct sr_session *session;
 
 	session = data;
+
+	g_mutex_lock(&session->main_mutex);
 	session->stop_check_id = 0;
+	g_mutex_unlock(&session->main_mutex);
 
 	/* Session already ended? */
 	if (!session->running)
 		return G_SOURCE_REMOVE;
 
 	/* New event sources may have been installed in the meantime. */
-	if (g_hash_table_size(session->event_sources) != 0)
+	if (session_source_count(session) != 0)
 		return G_SOURCE_REMOVE;
 
+	/* Also sends what the device threads sent last. */
+	if (session->threads)
+		session_threads_free(session);
+
 	session->running = FALSE;
 	unset_main_context(session);
 
@@ -715,20 +827,400 @@ static int stop_check_later(struct sr_session *session)
 	GSource *source;
 	unsigned int source_id;
 
-	if (session->stop_check_id != 0)
+	/* May be called on a device thread. The check runs on the session's. */
+	g_mutex_lock(&session->main_mutex);
+
+	if (session->stop_check_id != 0) {
+		g_mutex_unlock(&session->main_mutex);
 		return SR_OK; /* idle handler already installed */
+	}
+	if (!session->main_context) {
+		sr_err("Cannot add event source without main context.");
+		g_mutex_unlock(&session->main_mutex);
+		return SR_ERR;
+	}
 
 	source = g_idle_source_new();
 	g_source_set_callback(source, &delayed_stop_check, session, NULL);
 
-	source_id = session_source_attach(session, source);
+	source_id = g_source_attach(source, session->main_context);
 	session->stop_check_id = source_id;
 
+	g_mutex_unlock(&session->main_mutex);
+
 	g_source_unref(source);
 
 	return (source_id != 0) ? SR_OK : SR_ERR;
 }
 
+static int session_send(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		struct sr_datafeed_time *time);
+static uint64_t packet_data_bytes(const struct sr_datafeed_packet *packet);
+
+/* Send the queued packets, on the session thread. */
+static void queue_flush(struct session_threads *st)
+{
+	struct queued_packet *qp;
+
+	g_mutex_lock(&st->mutex);
+	while ((qp = g_queue_pop_head(&st->queue))) {
+		st->queue_bytes -= qp->bytes;
+		g_cond_broadcast(&st->space_cond);
+		g_mutex_unlock(&st->mutex);
+
+		session_send(qp->sdi, qp->packet, &qp->time);
+		sr_packet_free(qp->packet);
+		g_free(qp);
+
+		g_mutex_lock(&st->mutex);
+	}
+	g_mutex_unlock(&st->mutex);
+}
+
+/* Queue a packet sent on a device thread. */
+static int queue_push(struct session_threads *st,
+		const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		const struct sr_datafeed_time *time)
+{
+	struct queued_packet *qp;
+	int ret;
+
+	qp = g_malloc(sizeof(struct queued_packet));
+	qp->sdi = sdi;
+	qp->time = *time;
+	qp->bytes = packet_data_bytes(packet);
+	if ((ret = sr_packet_copy(packet, &qp->packet)) != SR_OK) {
+		g_free(qp);
+		return ret;
+	}
+
+	g_mutex_lock(&st->mutex);
+	/* Don't let a fast device outrun the session thread unboundedly. */
+	while (st->queue_bytes > QUEUE_MAX_BYTES && !st->draining)
+		g_cond_wait(&st->space_cond, &st->mutex);
+	g_queue_push_tail(&st->queue, qp);
+	st->queue_bytes += qp->bytes;
+	g_cond_broadcast(&st->queue_cond);
+	g_mutex_unlock(&st->mutex);
+
+	g_main_context_wakeup(st->main_context);
+
+	return SR_OK;
+}
+
+static gboolean queue_pending(struct session_threads *st)
+{
+	gboolean pending;
+
+	g_mutex_lock(&st->mutex);
+	pending = !g_queue_is_empty(&st->queue);
+	g_mutex_unlock(&st->mutex);
+
+	return pending;
+}
+
+static gboolean queue_source_prepare(GSource *source, int *timeout)
+{
+	*timeout = -1;
+
+	return queue_pending(((struct queue_source *)source)->st);
+}
+
+static gboolean queue_source_check(GSource *source)
+{
+	return queue_pending(((struct queue_source *)source)->st);
+}
+
+static gboolean queue_source_dispatch(GSource *source,
+		GSourceFunc callback, void *user_data)
+{
+	(void)callback;
+	(void)user_data;
+
+	queue_flush(((struct queue_source *)source)->st);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gpointer dev_thread_run(gpointer data)
+{
+	struct dev_thread *dt;
+
+	dt = data;
+	g_private_set(&current_dev_thread, dt);
+	g_main_context_push_thread_default(dt->context);
+
+	g_main_loop_run(dt->loop);
+
+	g_main_context_pop_thread_default(dt->context);
+	g_private_set(&current_dev_thread, NULL);
+
+	return NULL;
+}
+
+static void dev_thread_done(struct dev_thread *dt, int ret)
+{
+	struct session_threads *st;
+
+	st = dt->session->threads;
+
+	g_mutex_lock(&st->mutex);
+	dt->ret = ret;
+	dt->done = TRUE;
+	g_cond_broadcast(&st->queue_cond);
+	g_mutex_unlock(&st->mutex);
+}
+
+static gboolean dev_thread_start(void *data)
+{
+	struct dev_thread *dt;
+	struct sr_dev_inst *sdi;
+	int ret;
+
+	dt = data;
+	sdi = dt->sdi;
+
+	ret = sdi->driver->dev_acquisition_start(sdi, sdi);
+	/* Drivers may reconfigure the device when starting. */
+	sr_config_cache_clear(sdi);
+	dt->started = (ret == SR_OK);
+	dev_thread_done(dt, ret);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean dev_thread_stop(void *data)
+{
+	struct dev_thread *dt;
+	struct sr_dev_inst *sdi;
+
+	dt = data;
+	sdi = dt->sdi;
+
+	if (sdi->driver && sdi->driver->dev_acquisition_stop)
+		sdi->driver->dev_acquisition_stop(sdi, sdi);
+	dev_thread_done(dt, SR_OK);
+
+	return G_SOURCE_REMOVE;
+}
+
+/*
+ * Run func on the device threads, all of them or just those whose
+ * acquisition was started, and wait until it returned on all of them.
+ * Meanwhile the packets they send are passed on.
+ */
+static void threads_call(struct session_threads *st, GSourceFunc func,
+		gboolean started_only)
+{
+	struct dev_thread *dt;
+	GSList *l;
+
+	g_mutex_lock(&st->mutex);
+	for (l = st->threads; l; l = l->next) {
+		dt = l->data;
+		dt->done = started_only && !dt->started;
+	}
+	g_mutex_unlock(&st->mutex);
+
+	for (l = st->threads; l; l = l->next) {
+		dt = l->data;
+		if (!started_only || dt->started)
+			g_main_context_invoke(dt->context, func, dt);
+	}
+
+	g_mutex_lock(&st->mutex);
+	for (l = st->threads; l; l = l->next) {
+		dt = l->data;
+		while (!dt->done) {
+			if (!g_queue_is_empty(&st->queue)) {
+				g_mutex_unlock(&st->mutex);
+				queue_flush(st);
+				g_mutex_lock(&st->mutex);
+				continue;
+			}
+			g_cond_wait(&st->queue_cond, &st->mutex);
+		}
+	}
+	g_mutex_unlock(&st->mutex);
+}
+
+/* Start a thread with its own main context for every device. */
+static void session_threads_new(struct sr_session *session)
+{
+	static GSourceFuncs queue_source_funcs = {
+		.prepare  = &queue_source_prepare,
+		.check    = &queue_source_check,
+		.dispatch = &queue_source_dispatch,
+	};
+	struct session_threads *st;
+	struct dev_thread *dt;
+	GSList *l;
+
+	st = g_malloc0(sizeof(struct session_threads));
+	st->session = session;
+	g_mutex_init(&st->mutex);
+	g_queue_init(&st->queue);
+	g_cond_init(&st->queue_cond);
+	g_cond_init(&st->space_cond);
+	st->main_context = g_main_context_ref(session->main_context);
+
+	st->source = g_source_new(&queue_source_funcs,
+			sizeof(struct queue_source));
+	((struct queue_source *)st->source)->st = st;
+	g_source_set_name(st->source, "packet queue");
+	g_source_attach(st->source, st->main_context);
+
+	session->threads = st;
+
+	for (l = session->devs; l; l = l->next) {
+		dt = g_malloc0(sizeof(struct dev_thread));
+		dt->session = session;
+		dt->sdi = l->data;
+		dt->context = g_main_context_new();
+		dt->loop = g_main_loop_new(dt->context, FALSE);
+		dt->thread = g_thread_new(dt->sdi->driver->name,
+				dev_thread_run, dt);
+		st->threads = g_slist_append(st->threads, dt);
+	}
+}
+
+/* End the device threads, and send what they queued. */
+static void session_threads_free(struct sr_session *session)
+{
+	struct session_threads *st;
+	struct dev_thread *dt;
+	GSList *l;
+
+	st = session->threads;
+
+	g_mutex_lock(&st->mutex);
+	st->draining = TRUE;
+	g_cond_broadcast(&st->space_cond);
+	g_mutex_unlock(&st->mutex);
+
+	for (l = st->threads; l; l = l->next) {
+		dt = l->data;
+		g_main_loop_quit(dt->loop);
+		g_thread_join(dt->thread);
+	}
+
+	queue_flush(st);
+
+	for (l = st->threads; l; l = l->next) {
+		dt = l->data;
+		g_main_loop_unref(dt->loop);
+		g_main_context_unref(dt->context);
+		g_free(dt);
+	}
+	g_slist_free(st->threads);
+
+	g_source_destroy(st->source);
+	g_source_unref(st->source);
+	g_main_context_unref(st->main_context);
+
+	g_cond_clear(&st->space_cond);
+	g_cond_clear(&st->queue_cond);
+	g_mutex_clear(&st->mutex);
+	g_free(st);
+
+	session->threads = NULL;
+}
+
+/* Start a new timeline, with the nominal samplerates of the devices. */
+static void session_clocks_reset(struct sr_session *session)
+{
+	struct sr_dev_inst *sdi;
+	struct sr_dev_clock *clock;
+	GVariant *gvar;
+	uint64_t samplerate;
+	GSList *l;
+
+	session->timeline_zero_us = g_get_monotonic_time();
+	g_hash_table_remove_all(session->clocks);
+
+	for (l = session->devs; l; l = l->next) {
+		sdi = l->data;
+		samplerate = 0;
+		if (sr_dev_has_option(sdi, SR_CONF_SAMPLERATE)
+				&& sr_config_get(sdi->driver, sdi, NULL,
+					SR_CONF_SAMPLERATE, &gvar) == SR_OK) {
+			samplerate = g_variant_get_uint64(gvar);
+			g_variant_unref(gvar);
+		}
+		clock = sr_dev_clock_new(samplerate, session->timeline_zero_us);
+		g_hash_table_insert(session->clocks, sdi, clock);
+	}
+}
+
+/* Have all devices start acquisition, each on its own thread. */
+static int session_threads_start(struct sr_session *session)
+{
+	struct dev_thread *dt;
+	GSList *l;
+	int ret;
+
+	session_threads_new(session);
+
+	threads_call(session->threads, dev_thread_start, FALSE);
+
+	ret = SR_OK;
+	for (l = session->threads->threads; l; l = l->next) {
+		dt = l->data;
+		if (dt->started)
+			continue;
+		sr_err("Could not start %s device %s acquisition.",
+			dt->sdi->driver->name, dt->sdi->connection_id);
+		if (ret == SR_OK)
+			ret = dt->ret;
+	}
+
+	if (ret != SR_OK) {
+		/* Stop the devices which did start. */
+		threads_call(session->threads, dev_thread_stop, TRUE);
+		session_threads_free(session);
+	}
+
+	return ret;
+}
+
+/* Have all devices start acquisition, on the session thread. */
+static int session_devs_start(struct sr_session *session)
+{
+	struct sr_dev_inst *sdi;
+	GSList *l, *lend;
+	int ret;
+
+	ret = SR_OK;
+	for (l = session->devs; l; l = l->next) {
+		sdi = l->data;
+		ret = sdi->driver->dev_acquisition_start(sdi, sdi);
+		/* Drivers may reconfigure the device when starting. */
+		sr_config_cache_clear(sdi);
+		if (ret != SR_OK) {
+			sr_err("Could not start %s device %s acquisition.",
+				sdi->driver->name, sdi->connection_id);
+			break;
+		}
+	}
+
+	if (ret != SR_OK) {
+		/* If there are multiple devices, some of them may already have
+		 * started successfully. Stop them now before returning. */
+		lend = l->next;
+		for (l = session->devs; l != lend; l = l->next) {
+			sdi = l->data;
+			if (sdi->driver->dev_acquisition_stop)
+				sdi->driver->dev_acquisition_stop(sdi, sdi);
+		}
+		/* TODO: Handle delayed stops. Need to iterate the event
+		 * sources... */
+	}
+
+	return ret;
+}
+
 /**
  * Start a session.
  *
@@ -754,7 +1246,7 @@ SR_API int sr_session_start(struct sr_session *session)
 {
 	struct sr_dev_inst *sdi;
 	struct sr_channel *ch;
-	GSList *l, *c, *lend;
+	GSList *l, *c;
 	int ret;
 
 	if (!session) {
@@ -808,37 +1300,22 @@ SR_API int sr_session_start(struct sr_session *session)
 
 	sr_info("Starting.");
 
+	session_clocks_reset(session);
 	session->running = TRUE;
 
-	/* Have all devices start acquisition. */
-	for (l = session->devs; l; l = l->next) {
-		sdi = l->data;
-		ret = sdi->driver->dev_acquisition_start(sdi, sdi);
-		if (ret != SR_OK) {
-			sr_err("Could not start %s device %s acquisition.",
-				sdi->driver->name, sdi->connection_id);
-			break;
-		}
-	}
+	if (session->threading == SR_SESSION_THREADING_PER_DEVICE)
+		ret = session_threads_start(session);
+	else
+		ret = session_devs_start(session);
 
 	if (ret != SR_OK) {
-		/* If there are multiple devices, some of them may already have
-		 * started successfully. Stop them now before returning. */
-		lend = l->next;
-		for (l = session->devs; l != lend; l = l->next) {
-			sdi = l->data;
-			if (sdi->driver->dev_acquisition_stop)
-				sdi->driver->dev_acquisition_stop(sdi, sdi);
-		}
-		/* TODO: Handle delayed stops. Need to iterate the event
-		 * sources... */
 		session->running = FALSE;
 
 		unset_main_context(session);
 		return ret;
 	}
 
-	if (g_hash_table_size(session->event_sources) == 0)
+	if (session_source_count(session) == 0)
 		stop_check_later(session);
 
 	return SR_OK;
@@ -900,6 +1377,7 @@ static gboolean session_stop_sync(void *user_data)
 {
 	struct sr_session *session;
 	struct sr_dev_inst *sdi;
+	struct dev_thread *dt;
 	GSList *node;
 
 	session = user_data;
@@ -909,6 +1387,15 @@ static gboolean session_stop_sync(void *user_data)
 
 	sr_info("Stopping.");
 
+	/* Devices with threads of their own are stopped there. */
+	if (session->threads) {
+		for (node = session->threads->threads; node; node = node->next) {
+			dt = node->data;
+			g_main_context_invoke(dt->context, dev_thread_stop, dt);
+		}
+		return G_SOURCE_REMOVE;
+	}
+
 	for (node = session->devs; node; node = node->next) {
 		sdi = node->data;
 		if (sdi->driver && sdi->driver->dev_acquisition_stop)
@@ -1024,6 +1511,280 @@ SR_API int sr_session_stopped_callback_set(struct sr_session *session,
 	return SR_OK;
 }
 
+/**
+ * Enable or disable the pipeline statistics of a session.
+ *
+ * While enabled, the packets passing through each stage of the datafeed
+ * pipeline are counted and timed, per device. See struct sr_session_stats
+ * for what is recorded. Disabling the statistics discards them. When
+ * disabled, the cost to the pipeline is one test per packet and per
+ * event source dispatch.
+ *
+ * This should be called before the session is started.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param enable TRUE to enable the statistics, FALSE to disable them.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid session passed.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_session_stats_enable(struct sr_session *session,
+		gboolean enable)
+{
+	if (!session) {
+		sr_err("%s: session was NULL", __func__);
+		return SR_ERR_ARG;
+	}
+
+	g_mutex_lock(&session->stats_mutex);
+	if (enable && !session->stats) {
+		session->stats = g_ptr_array_new_with_free_func(g_free);
+	} else if (!enable && session->stats) {
+		g_ptr_array_free(session->stats, TRUE);
+		session->stats = NULL;
+	}
+	g_mutex_unlock(&session->stats_mutex);
+
+	return SR_OK;
+}
+
+/**
+ * Set the threading policy of a session.
+ *
+ * With SR_SESSION_THREADING_PER_DEVICE, starting the session starts a
+ * thread with a main context of its own for every device, on which the
+ * device's acquisition is started and stopped, and its event sources are
+ * dispatched. A slow device then doesn't hold up the others. The packets
+ * the devices send are still passed through the transforms to the
+ * datafeed callbacks on the thread running the session, in the order
+ * each device sent them.
+ *
+ * Changing the configuration of a device while the session is running
+ * is not synchronized with its thread.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param threading The policy, enum sr_session_threading.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ * @retval SR_ERR The session is running.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_session_threading_set(struct sr_session *session,
+		int threading)
+{
+	if (!session) {
+		sr_err("%s: session was NULL", __func__);
+		return SR_ERR_ARG;
+	}
+
+	if (threading != SR_SESSION_THREADING_SINGLE
+			&& threading != SR_SESSION_THREADING_PER_DEVICE) {
+		sr_err("Invalid threading policy %d.", threading);
+		return SR_ERR_ARG;
+	}
+
+	if (session->running) {
+		sr_err("Cannot change the threading of a running session.");
+		return SR_ERR;
+	}
+
+	session->threading = threading;
+
+	return SR_OK;
+}
+
+/**
+ * Get the threading policy of a session.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param threading Pointer where to store the policy,
+ *                  enum sr_session_threading. Must not be NULL.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @see sr_session_threading_set()
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_session_threading_get(struct sr_session *session,
+		int *threading)
+{
+	if (!session || !threading)
+		return SR_ERR_ARG;
+
+	*threading = session->threading;
+
+	return SR_OK;
+}
+
+/**
+ * Get the pipeline statistics of a session.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param stats Pointer where to store the list of statistics, as
+ *              struct sr_session_stats pointers. The list and its
+ *              entries are copies, to be freed by the caller with
+ *              g_slist_free_full(stats, g_free). Must not be NULL.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ * @retval SR_ERR_NA The statistics are not enabled.
+ *
+ * @see sr_session_stats_enable()
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_session_stats_get(struct sr_session *session, GSList **stats)
+{
+	GSList *list;
+	unsigned int i;
+	int ret;
+
+	if (!session || !stats) {
+		sr_err("%s: Invalid arguments.", __func__);
+		return SR_ERR_ARG;
+	}
+
+	list = NULL;
+	ret = SR_OK;
+	g_mutex_lock(&session->stats_mutex);
+	if (session->stats) {
+		for (i = session->stats->len; i > 0; i--)
+			list = g_slist_prepend(list, g_memdup(
+				g_ptr_array_index(session->stats, i - 1),
+				sizeof(struct sr_session_stats)));
+	} else {
+		ret = SR_ERR_NA;
+	}
+	g_mutex_unlock(&session->stats_mutex);
+
+	*stats = list;
+
+	return ret;
+}
+
+/**
+ * Reset the pipeline statistics of a session to zero.
+ *
+ * @param session The session to use. Must not be NULL.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid session passed.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_session_stats_reset(struct sr_session *session)
+{
+	if (!session) {
+		sr_err("%s: session was NULL", __func__);
+		return SR_ERR_ARG;
+	}
+
+	g_mutex_lock(&session->stats_mutex);
+	if (session->stats)
+		g_ptr_array_set_size(session->stats, 0);
+	g_mutex_unlock(&session->stats_mutex);
+
+	return SR_OK;
+}
+
+/** @private
+ *  Current time for the pipeline statistics, in nanoseconds.
+ */
+SR_PRIV uint64_t sr_session_stats_time(void)
+{
+#ifdef G_OS_WIN32
+	return g_get_monotonic_time() * 1000;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/** @private
+ *  Record one run of a pipeline stage, which started at start_ns.
+ *  Only to be called while the statistics are enabled.
+ */
+SR_PRIV void sr_session_stats_add(struct sr_session *session,
+		const struct sr_dev_inst *sdi, int stage, int index,
+		uint64_t bytes, uint64_t start_ns)
+{
+	struct sr_session_stats *st;
+	uint64_t elapsed;
+	unsigned int i, bucket;
+
+	elapsed = sr_session_stats_time() - start_ns;
+	bucket = MIN(g_bit_storage(elapsed) - 1,
+			SR_STATS_HISTOGRAM_BUCKETS - 1);
+
+	g_mutex_lock(&session->stats_mutex);
+	if (!session->stats) {
+		/* Disabled in the meantime. */
+		g_mutex_unlock(&session->stats_mutex);
+		return;
+	}
+	/* There are only a handful of entries per device. */
+	for (i = 0, st = NULL; i < session->stats->len; i++) {
+		st = g_ptr_array_index(session->stats, i);
+		if (st->sdi == sdi && st->stage == stage && st->index == index)
+			break;
+		st = NULL;
+	}
+	if (!st) {
+		st = g_malloc0(sizeof(struct sr_session_stats));
+		st->sdi = sdi;
+		st->stage = stage;
+		st->index = index;
+		g_ptr_array_add(session->stats, st);
+	}
+	st->count++;
+	st->bytes += bytes;
+	st->total_ns += elapsed;
+	st->max_ns = MAX(st->max_ns, elapsed);
+	st->histogram[bucket]++;
+	g_mutex_unlock(&session->stats_mutex);
+}
+
+/** @private
+ *  Record one event source dispatch. Most drivers pass their device
+ *  instance as callback data; the run is attributed to that device.
+ */
+SR_PRIV void sr_session_stats_add_source(struct sr_session *session,
+		void *cb_data, uint64_t start_ns)
+{
+	const struct sr_dev_inst *sdi;
+
+	sdi = g_slist_find(session->devs, cb_data) ? cb_data : NULL;
+	sr_session_stats_add(session, sdi, SR_STAGE_SOURCE, 0, 0, start_ns);
+}
+
+/* Sample data bytes in a packet, for the statistics. */
+static uint64_t packet_data_bytes(const struct sr_datafeed_packet *packet)
+{
+	const struct sr_datafeed_logic *logic;
+	const struct sr_datafeed_analog *analog;
+
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		return logic->length;
+	case SR_DF_ANALOG:
+		analog = packet->payload;
+		return (uint64_t)analog->num_samples * analog->encoding->unitsize
+			* g_slist_length(analog->meaning->channels);
+	default:
+		return 0;
+	}
+}
+
 /**
  * Debug helper.
  *
@@ -1092,11 +1853,9 @@ static void datafeed_dump(const struct sr_datafeed_packet *packet)
 SR_PRIV int sr_session_send(const struct sr_dev_inst *sdi,
 		const struct sr_datafeed_packet *packet)
 {
-	GSList *l;
-	struct datafeed_callback *cb_struct;
-	struct sr_datafeed_packet *packet_in, *packet_out;
-	struct sr_transform *t;
-	int ret;
+	struct dev_thread *dt;
+	struct sr_datafeed_packet unstamped;
+	struct sr_datafeed_time time;
 
 	if (!sdi) {
 		sr_err("%s: sdi was NULL", __func__);
@@ -1150,13 +1909,70 @@ SR_PRIV int sr_session_send(const struct sr_dev_inst *sdi,
 		return sr_session_send(sdi, &new_packet);
 	}
 
+	/* Drivers don't set the time, it's stamped here. */
+	time.monotonic_us = g_get_monotonic_time();
+	unstamped.type = packet->type;
+	unstamped.payload = packet->payload;
+	unstamped.time = NULL;
+
+	/* Packets sent on a device thread are passed on by the session's. */
+	dt = g_private_get(&current_dev_thread);
+	if (dt && dt->session == sdi->session)
+		return queue_push(sdi->session->threads, sdi, &unstamped, &time);
+
+	return session_send(sdi, &unstamped, &time);
+}
+
+/* Pass a packet through the transforms to the datafeed callbacks. */
+static int session_send(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		struct sr_datafeed_time *time)
+{
+	GSList *l;
+	struct sr_session *session;
+	struct sr_dev_clock *clock;
+	struct datafeed_callback *cb_struct;
+	struct sr_datafeed_packet stamped, *packet_in, *packet_out;
+	struct sr_transform *t;
+	uint64_t bytes, out_bytes, send_ns, stage_ns;
+	gboolean stats;
+	int ret, i;
+
+	session = sdi->session;
+
+	/* Devices not started by the session, like inputs, start their
+	 * clock with their first packet. */
+	if (!(clock = g_hash_table_lookup(session->clocks, sdi))) {
+		if (g_hash_table_size(session->clocks) == 0)
+			session->timeline_zero_us = time->monotonic_us;
+		clock = sr_dev_clock_new(0, session->timeline_zero_us);
+		g_hash_table_insert(session->clocks, (void *)sdi, clock);
+	}
+	sr_dev_clock_stamp(clock, packet, time);
+	stamped.type = packet->type;
+	stamped.payload = packet->payload;
+	stamped.time = time;
+	packet = &stamped;
+
+	stats = session->stats != NULL;
+	bytes = out_bytes = send_ns = stage_ns = 0;
+	if (G_UNLIKELY(stats)) {
+		bytes = out_bytes = packet_data_bytes(packet);
+		send_ns = stage_ns = sr_session_stats_time();
+	}
+
 	/*
-	 * Pass the packet to the first transform module. If that returns
-	 * another packet (instead of NULL), pass that packet to the next
-	 * transform module in the list, and so on.
+	 * If the transforms are fused for this type of packet, that does
+	 * all of them in one go. Otherwise pass the packet to the first
+	 * transform module. If that returns another packet (instead of
+	 * NULL), pass that packet to the next transform module in the
+	 * list, and so on.
 	 */
 	packet_in = (struct sr_datafeed_packet *)packet;
-	for (l = sdi->session->transforms; l; l = l->next) {
+	ret = SR_ERR_NA;
+	if (session->transform_chain)
+		ret = sr_transform_chain_run(session->transform_chain, packet_in);
+	for (l = ret == SR_OK ? NULL : session->transforms; l; l = l->next) {
 		t = l->data;
 		sr_spew("Running transform module '%s'.", t->module->id);
 		ret = t->module->receive(t, packet_in, &packet_out);
@@ -1170,6 +1986,12 @@ SR_PRIV int sr_session_send(const struct sr_dev_inst *sdi,
 			 * packet, abort.
 			 */
 			sr_spew("Transform module didn't return a packet, aborting.");
+			if (G_UNLIKELY(stats)) {
+				sr_session_stats_add(session, sdi,
+					SR_STAGE_TRANSFORM, 0, bytes, stage_ns);
+				sr_session_stats_add(session, sdi,
+					SR_STAGE_SEND, 0, bytes, send_ns);
+			}
 			return SR_OK;
 		} else {
 			/*
@@ -1181,17 +2003,34 @@ SR_PRIV int sr_session_send(const struct sr_dev_inst *sdi,
 	}
 	packet = packet_in;
 
+	if (G_UNLIKELY(stats) && session->transforms) {
+		sr_session_stats_add(session, sdi, SR_STAGE_TRANSFORM,
+				0, bytes, stage_ns);
+		out_bytes = packet_data_bytes(packet);
+	}
+
 	/*
 	 * If the last transform did output a packet, pass it to all datafeed
 	 * callbacks.
 	 */
-	for (l = sdi->session->datafeed_callbacks; l; l = l->next) {
+	for (l = session->datafeed_callbacks, i = 0; l; l = l->next, i++) {
 		if (sr_log_loglevel_get() >= SR_LOG_DBG)
 			datafeed_dump(packet);
 		cb_struct = l->data;
-		cb_struct->cb(sdi, packet, cb_struct->cb_data);
+		if (G_UNLIKELY(stats)) {
+			stage_ns = sr_session_stats_time();
+			cb_struct->cb(sdi, packet, cb_struct->cb_data);
+			sr_session_stats_add(session, sdi, SR_STAGE_CALLBACK,
+					i, out_bytes, stage_ns);
+		} else {
+			cb_struct->cb(sdi, packet, cb_struct->cb_data);
+		}
 	}
 
+	if (G_UNLIKELY(stats))
+		sr_session_stats_add(session, sdi, SR_STAGE_SEND, 0,
+				bytes, send_ns);
+
 	return SR_OK;
 }
 
@@ -1218,11 +2057,14 @@ SR_PRIV int sr_session_source_add_internal(struct sr_session *session,
 	 * already installed source. (Well it would, if we did not have
 	 * another sanity check there.)
 	 */
+	g_mutex_lock(&session->main_mutex);
 	if (g_hash_table_contains(session->event_sources, key)) {
+		g_mutex_unlock(&session->main_mutex);
 		sr_err("Event source with key %p already exists.", key);
 		return SR_ERR_BUG;
 	}
 	g_hash_table_insert(session->event_sources, key, source);
+	g_mutex_unlock(&session->main_mutex);
 
 	if (session_source_attach(session, source) == 0)
 		return SR_ERR;
@@ -1361,16 +2203,23 @@ SR_PRIV int sr_session_source_remove_internal(struct sr_session *session,
 {
 	GSource *source;
 
+	g_mutex_lock(&session->main_mutex);
 	source = g_hash_table_lookup(session->event_sources, key);
 	/*
 	 * Trying to remove an already removed event source is problematic
 	 * since the poll_object handle may have been reused in the meantime.
 	 */
 	if (!source) {
+		g_mutex_unlock(&session->main_mutex);
 		sr_warn("Cannot remove non-existing event source %p.", key);
 		return SR_ERR_BUG;
 	}
+	/* Destroying it unregisters it, which takes the lock again. */
+	g_source_ref(source);
+	g_mutex_unlock(&session->main_mutex);
+
 	g_source_destroy(source);
+	g_source_unref(source);
 
 	return SR_OK;
 }
@@ -1457,24 +2306,30 @@ SR_PRIV int sr_session_source_destroyed(struct sr_session *session,
 		void *key, GSource *source)
 {
 	GSource *registered_source;
+	unsigned int count;
 
+	g_mutex_lock(&session->main_mutex);
 	registered_source = g_hash_table_lookup(session->event_sources, key);
 	/*
 	 * Trying to remove an already removed event source is problematic
 	 * since the poll_object handle may have been reused in the meantime.
 	 */
 	if (!registered_source) {
+		g_mutex_unlock(&session->main_mutex);
 		sr_err("No event source for key %p found.", key);
 		return SR_ERR_BUG;
 	}
 	if (registered_source != source) {
+		g_mutex_unlock(&session->main_mutex);
 		sr_err("Event source for key %p does not match"
 			" destroyed source.", key);
 		return SR_ERR_BUG;
 	}
 	g_hash_table_remove(session->event_sources, key);
+	count = g_hash_table_size(session->event_sources);
+	g_mutex_unlock(&session->main_mutex);
 
-	if (g_hash_table_size(session->event_sources) > 0)
+	if (count > 0)
 		return SR_OK;
 
 	/* If no event sources are left, consider the acquisition finished.
@@ -1503,13 +2358,19 @@ SR_PRIV int sr_packet_copy(const struct sr_datafeed_packet *packet,
 	const struct sr_datafeed_analog *analog;
 	struct sr_datafeed_analog *analog_copy;
 	uint8_t *payload;
+	size_t size;
 
 	*copy = g_malloc0(sizeof(struct sr_datafeed_packet));
 	(*copy)->type = packet->type;
+	if (packet->time)
+		(*copy)->time = g_memdup(packet->time,
+				sizeof(struct sr_datafeed_time));
 
 	switch (packet->type) {
 	case SR_DF_TRIGGER:
 	case SR_DF_END:
+	case SR_DF_FRAME_BEGIN:
+	case SR_DF_FRAME_END:
 		/* No payload. */
 		break;
 	case SR_DF_HEADER:
@@ -1520,37 +2381,36 @@ SR_PRIV int sr_packet_copy(const struct sr_datafeed_packet *packet,
 	case SR_DF_META:
 		meta = packet->payload;
 		meta_copy = g_malloc0(sizeof(struct sr_datafeed_meta));
-		g_slist_foreach(meta->config, (GFunc)copy_src, meta_copy->config);
+		g_slist_foreach(meta->config, (GFunc)copy_src, meta_copy);
 		(*copy)->payload = meta_copy;
 		break;
 	case SR_DF_LOGIC:
 		logic = packet->payload;
-		logic_copy = g_malloc(sizeof(logic));
+		logic_copy = g_malloc(sizeof(*logic_copy));
 		logic_copy->length = logic->length;
 		logic_copy->unitsize = logic->unitsize;
-		memcpy(logic_copy->data, logic->data, logic->length * logic->unitsize);
+		logic_copy->data = g_memdup(logic->data, logic->length);
 		(*copy)->payload = logic_copy;
 		break;
 	case SR_DF_ANALOG_OLD:
 		analog_old = packet->payload;
-		analog_old_copy = g_malloc(sizeof(analog_old));
+		analog_old_copy = g_malloc(sizeof(*analog_old_copy));
 		analog_old_copy->channels = g_slist_copy(analog_old->channels);
 		analog_old_copy->num_samples = analog_old->num_samples;
 		analog_old_copy->mq = analog_old->mq;
 		analog_old_copy->unit = analog_old->unit;
 		analog_old_copy->mqflags = analog_old->mqflags;
-		analog_old_copy->data = g_malloc(analog_old->num_samples * sizeof(float));
-		memcpy(analog_old_copy->data, analog_old->data,
-				analog_old->num_samples * sizeof(float));
+		/* One value per channel for each sample. */
+		size = analog_old->num_samples * sizeof(float)
+				* g_slist_length(analog_old->channels);
+		analog_old_copy->data = g_memdup(analog_old->data, size);
 		(*copy)->payload = analog_old_copy;
 		break;
 	case SR_DF_ANALOG:
 		analog = packet->payload;
-		analog_copy = g_malloc(sizeof(analog));
-		analog_copy->data = g_malloc(
-				analog->encoding->unitsize * analog->num_samples);
-		memcpy(analog_copy->data, analog->data,
-				analog->encoding->unitsize * analog->num_samples);
+		analog_copy = g_malloc(sizeof(*analog_copy));
+		size = packet_data_bytes(packet);
+		analog_copy->data = g_memdup(analog->data, size);
 		analog_copy->num_samples = analog->num_samples;
 		analog_copy->encoding = g_memdup(analog->encoding,
 				sizeof(struct sr_analog_encoding));
@@ -1564,6 +2424,9 @@ SR_PRIV int sr_packet_copy(const struct sr_datafeed_packet *packet,
 		break;
 	default:
 		sr_err("Unknown packet type %d", packet->type);
+		g_free((void *)(*copy)->time);
+		g_free(*copy);
+		*copy = NULL;
 		return SR_ERR;
 	}
 
@@ -1582,6 +2445,8 @@ void sr_packet_free(struct sr_datafeed_packet *packet)
 	switch (packet->type) {
 	case SR_DF_TRIGGER:
 	case SR_DF_END:
+	case SR_DF_FRAME_BEGIN:
+	case SR_DF_FRAME_END:
 		/* No payload. */
 		break;
 	case SR_DF_HEADER:
@@ -1621,6 +2486,7 @@ void sr_packet_free(struct sr_datafeed_packet *packet)
 	default:
 		sr_err("Unknown packet type %d", packet->type);
 	}
+	g_free((void *)packet->time);
 	g_free(packet);
 
 }
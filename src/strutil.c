@@ -211,6 +211,154 @@ SR_PRIV int sr_atof_ascii(const char *str, float *ret)
 	return SR_OK;
 }
 
+/* Powers of ten that are exactly representable as a double. */
+static const double exact_powers_of_ten[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/*
+ * Parse the number at the start of str, like g_ascii_strtod(). Numbers
+ * with at most 15 significant digits and a small exponent, which covers
+ * what instruments send, are converted directly: both the mantissa and
+ * the power of ten are exact doubles then, so a single multiplication or
+ * division yields the correctly rounded result. Anything else is left
+ * to g_ascii_strtod().
+ *
+ * Returns a pointer to the first character after the number, or str if
+ * there was no number.
+ */
+static const char *parse_double_ascii(const char *str, double *ret)
+{
+	const char *p, *digits;
+	char *endptr;
+	uint64_t mantissa;
+	int num_digits, exponent, e, e_sign;
+	gboolean negative;
+
+	p = str;
+	negative = (*p == '-');
+	if (*p == '-' || *p == '+')
+		p++;
+
+	mantissa = 0;
+	num_digits = exponent = 0;
+	digits = p;
+	for (; g_ascii_isdigit(*p); p++) {
+		if (mantissa || *p != '0')
+			num_digits++;
+		mantissa = mantissa * 10 + (*p - '0');
+		if (num_digits > 15)
+			goto fallback;
+	}
+	if (*p == '.') {
+		for (p++; g_ascii_isdigit(*p); p++, exponent--) {
+			if (mantissa || *p != '0')
+				num_digits++;
+			mantissa = mantissa * 10 + (*p - '0');
+			if (num_digits > 15)
+				goto fallback;
+		}
+	}
+	if (p == digits || (p == digits + 1 && *digits == '.'))
+		goto fallback;
+
+	if (*p == 'e' || *p == 'E') {
+		e_sign = 1;
+		if (p[1] == '-' || p[1] == '+') {
+			e_sign = (p[1] == '-') ? -1 : 1;
+			if (!g_ascii_isdigit(p[2]))
+				goto fallback;
+			p += 2;
+		} else if (g_ascii_isdigit(p[1])) {
+			p++;
+		} else {
+			goto fallback;
+		}
+		for (e = 0; g_ascii_isdigit(*p); p++) {
+			e = e * 10 + (*p - '0');
+			if (e > 1000)
+				goto fallback;
+		}
+		exponent += e_sign * e;
+	}
+
+	if (exponent < -22 || exponent > 22)
+		goto fallback;
+
+	if (exponent < 0)
+		*ret = mantissa / exact_powers_of_ten[-exponent];
+	else
+		*ret = mantissa * exact_powers_of_ten[exponent];
+	if (negative)
+		*ret = -*ret;
+
+	return p;
+
+fallback:
+	errno = 0;
+	*ret = g_ascii_strtod(str, &endptr);
+	if (errno)
+		return str;
+
+	return endptr;
+}
+
+/**
+ * @private
+ *
+ * Parse a comma separated list of numeric values into floats, ignoring
+ * the locale. Whitespace around the values is ignored.
+ *
+ * Values that can't be parsed are skipped, the others are still appended
+ * to the result.
+ *
+ * @param str The string to parse.
+ * @param result Array of floats to append the values to.
+ *
+ * @retval SR_OK All values parsed successfully.
+ * @retval SR_ERR At least one value failed to parse.
+ */
+SR_PRIV int sr_atof_ascii_list(const char *str, GArray *result)
+{
+	const char *p, *end;
+	double value;
+	float tmp;
+	int ret;
+
+	ret = SR_OK;
+	p = str;
+
+	if (!*p)
+		return SR_OK;
+
+	for (;;) {
+		while (g_ascii_isspace(*p))
+			p++;
+		end = parse_double_ascii(p, &value);
+		if (end != p) {
+			for (p = end; g_ascii_isspace(*p); p++);
+			if (*p == ',' || !*p) {
+				tmp = value;
+				g_array_append_val(result, tmp);
+			} else {
+				ret = SR_ERR;
+			}
+		} else {
+			ret = SR_ERR;
+		}
+
+		/* Continue with the next value, if any. */
+		while (*p && *p != ',')
+			p++;
+		if (!*p)
+			break;
+		p++;
+	}
+
+	return ret;
+}
+
 /**
  * Convert a numeric value value to its "natural" string representation
  * in SI units.
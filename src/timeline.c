@@ -0,0 +1,542 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "timeline"
+/** @endcond */
+
+/**
+ * @file
+ *
+ * Packet timestamps and the alignment of devices on a common timeline.
+ */
+
+/**
+ * @defgroup grp_timeline Timeline
+ *
+ * Packet timestamps and the alignment of devices on a common timeline.
+ *
+ * Every packet passed to the datafeed callbacks carries a struct
+ * sr_datafeed_time, giving the position of its first sample in the
+ * device's sample stream and the time the device sent it. The session
+ * maps the sample positions of each device onto a timeline shared by
+ * all devices in the session, by a linear fit of the send times against
+ * the sample positions. The slope of the fit is the device's sample
+ * clock as measured by the host's clock, so drifting clocks don't
+ * make the devices diverge over long acquisitions.
+ *
+ * The send time of a packet includes the transfer latency of the
+ * device, which the fit can't tell from a clock offset. Devices with
+ * very different latencies are thus aligned only within those.
+ *
+ * @{
+ */
+
+/* Use the fitted slope only once there are this many observations. */
+#define MIN_FIT_OBSERVATIONS 8
+
+/* Key of the logic sample position, channel pointers for analog ones. */
+static const int logic_position;
+
+struct sr_dev_clock {
+	/* Nominal samplerate, 0 if unknown. */
+	uint64_t samplerate;
+	/* Start of the timeline, monotonic time in us. */
+	int64_t zero_us;
+	/* Sample positions by channel, uint64_t pointers. */
+	GHashTable *positions;
+	/* Position of the device, the highest of those. */
+	uint64_t position;
+	/*
+	 * Fit of the send time (y, in us) against the position (x), both
+	 * relative to the first observation. The means and the (co)variance
+	 * sums are kept running, for numerical stability.
+	 */
+	uint64_t n;
+	uint64_t x0;
+	int64_t t0_us;
+	double mean_x;
+	double mean_y;
+	double m2_x;
+	double c_xy;
+};
+
+/** @private */
+SR_PRIV struct sr_dev_clock *sr_dev_clock_new(uint64_t samplerate,
+		int64_t zero_us)
+{
+	struct sr_dev_clock *clock;
+
+	clock = g_malloc0(sizeof(struct sr_dev_clock));
+	clock->samplerate = samplerate;
+	clock->zero_us = zero_us;
+	clock->positions = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+
+	return clock;
+}
+
+/** @private */
+SR_PRIV void sr_dev_clock_free(struct sr_dev_clock *clock)
+{
+	if (!clock)
+		return;
+
+	g_hash_table_destroy(clock->positions);
+	g_free(clock);
+}
+
+static void clock_fit_reset(struct sr_dev_clock *clock)
+{
+	clock->n = 0;
+	clock->mean_x = clock->mean_y = 0;
+	clock->m2_x = clock->c_xy = 0;
+}
+
+static void clock_observe(struct sr_dev_clock *clock, uint64_t x,
+		int64_t t_us)
+{
+	double dx, dy;
+
+	if (clock->n == 0) {
+		clock->x0 = x;
+		clock->t0_us = t_us;
+	}
+
+	clock->n++;
+	dx = (double)(x - clock->x0) - clock->mean_x;
+	dy = (double)(t_us - clock->t0_us) - clock->mean_y;
+	clock->mean_x += dx / clock->n;
+	clock->mean_y += dy / clock->n;
+	clock->m2_x += dx * ((double)(x - clock->x0) - clock->mean_x);
+	clock->c_xy += dx * ((double)(t_us - clock->t0_us) - clock->mean_y);
+}
+
+/* The fitted duration of a sample in us, or 0 if there is none yet. */
+static double clock_slope(const struct sr_dev_clock *clock)
+{
+	if (clock->n >= MIN_FIT_OBSERVATIONS && clock->m2_x > 0
+			&& clock->c_xy > 0)
+		return clock->c_xy / clock->m2_x;
+
+	if (clock->samplerate)
+		return 1000000.0 / clock->samplerate;
+
+	return 0;
+}
+
+/* Map a position onto the timeline. FALSE if that can't be estimated yet. */
+static gboolean clock_map(const struct sr_dev_clock *clock, uint64_t x,
+		int64_t *t_ns)
+{
+	double slope, t;
+
+	if (clock->n == 0 || (slope = clock_slope(clock)) == 0)
+		return FALSE;
+
+	/* The fitted line passes through the means. */
+	t = clock->mean_y + slope * ((double)x - clock->x0 - clock->mean_x);
+	*t_ns = (int64_t)((t + (clock->t0_us - clock->zero_us)) * 1000);
+
+	return TRUE;
+}
+
+/* Number of samples in a packet, and the key of its sample position. */
+static uint64_t packet_samples(const struct sr_datafeed_packet *packet,
+		const void **key)
+{
+	const struct sr_datafeed_logic *logic;
+	const struct sr_datafeed_analog *analog;
+
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		*key = &logic_position;
+		return logic->unitsize ? logic->length / logic->unitsize : 0;
+	case SR_DF_ANALOG:
+		analog = packet->payload;
+		/* Packets for several channels may cover the same samples. */
+		*key = analog->meaning->channels ?
+			analog->meaning->channels->data : NULL;
+		return analog->num_samples;
+	default:
+		*key = NULL;
+		return 0;
+	}
+}
+
+static void clock_meta(struct sr_dev_clock *clock,
+		const struct sr_datafeed_meta *meta)
+{
+	struct sr_config *src;
+	GSList *l;
+
+	for (l = meta->config; l; l = l->next) {
+		src = l->data;
+		if (src->key != SR_CONF_SAMPLERATE)
+			continue;
+		clock->samplerate = g_variant_get_uint64(src->data);
+		/* The positions from here on are in a different unit. */
+		clock_fit_reset(clock);
+	}
+}
+
+/**
+ * Stamp a packet sent by a device.
+ *
+ * @param clock The device's clock.
+ * @param packet The packet, in the order the device sent it.
+ * @param time The time of the packet, with monotonic_us set to when it
+ *             was sent. The other fields are filled in.
+ *
+ * @private
+ */
+SR_PRIV void sr_dev_clock_stamp(struct sr_dev_clock *clock,
+		const struct sr_datafeed_packet *packet,
+		struct sr_datafeed_time *time)
+{
+	const void *key;
+	uint64_t samples, *position;
+
+	switch (packet->type) {
+	case SR_DF_HEADER:
+		/* A new acquisition, with a new sample stream. */
+		g_hash_table_remove_all(clock->positions);
+		clock->position = 0;
+		clock_fit_reset(clock);
+		break;
+	case SR_DF_META:
+		clock_meta(clock, packet->payload);
+		break;
+	case SR_DF_FRAME_BEGIN:
+		/* Frames need not follow each other without a gap. */
+		clock_fit_reset(clock);
+		break;
+	default:
+		break;
+	}
+
+	time->samplerate = clock->samplerate;
+	time->sample = clock->position;
+
+	samples = packet_samples(packet, &key);
+	if (samples) {
+		if (!(position = g_hash_table_lookup(clock->positions, key))) {
+			position = g_malloc0(sizeof(uint64_t));
+			g_hash_table_insert(clock->positions, (void *)key, position);
+		}
+		time->sample = *position;
+		*position += samples;
+		/*
+		 * The packet was sent once its last sample was known. Packets
+		 * of other channels for samples already sent tell nothing new.
+		 */
+		if (*position > clock->position) {
+			clock->position = *position;
+			clock_observe(clock, clock->position, time->monotonic_us);
+		}
+	}
+
+	if (!clock_map(clock, time->sample, &time->timeline_ns))
+		time->timeline_ns = (time->monotonic_us - clock->zero_us) * 1000;
+}
+
+/**
+ * Get the estimated relation of a device's clock to the session timeline.
+ *
+ * @private
+ */
+SR_PRIV void sr_dev_clock_info(const struct sr_dev_clock *clock,
+		struct sr_session_clock *info)
+{
+	double slope;
+
+	memset(info, 0, sizeof(*info));
+	info->samplerate = clock->samplerate;
+	info->observations = clock->n;
+	if (!clock_map(clock, 0, &info->offset_ns))
+		info->offset_ns = 0;
+
+	if (clock->n < MIN_FIT_OBSERVATIONS || clock->m2_x <= 0
+			|| clock->c_xy <= 0)
+		return;
+
+	slope = clock->c_xy / clock->m2_x;
+	info->measured_samplerate = 1000000.0 / slope;
+	if (clock->samplerate)
+		info->drift_ppm = (info->measured_samplerate
+			- clock->samplerate) * 1000000.0 / clock->samplerate;
+}
+
+/**
+ * Get the estimated relation of a device's sample clock to the timeline
+ * of a session.
+ *
+ * This should be called on the thread running the session, for example
+ * from a datafeed callback.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param sdi The device. Must not be NULL.
+ * @param clock Pointer where to store the estimate. Must not be NULL.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ * @retval SR_ERR_NA The device hasn't sent any packets yet.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_session_clock_get(struct sr_session *session,
+		const struct sr_dev_inst *sdi, struct sr_session_clock *clock)
+{
+	struct sr_dev_clock *dev_clock;
+
+	if (!session || !sdi || !clock)
+		return SR_ERR_ARG;
+
+	if (!(dev_clock = g_hash_table_lookup(session->clocks, sdi)))
+		return SR_ERR_NA;
+
+	sr_dev_clock_info(dev_clock, clock);
+
+	return SR_OK;
+}
+
+/* Packets of one device, waiting to be merged. */
+struct merge_stream {
+	const struct sr_dev_inst *sdi;
+	/* Copies of the packets, struct sr_datafeed_packet pointers. */
+	GQueue packets;
+	/* Whether the device sent SR_DF_END, and won't send more. */
+	gboolean ended;
+};
+
+struct sr_session_merge {
+	struct sr_session *session;
+	int64_t max_delay_ns;
+	sr_datafeed_callback cb;
+	void *cb_data;
+	/* struct merge_stream pointers. */
+	GSList *streams;
+	/* Latest timeline time of a packet pushed. */
+	int64_t latest_ns;
+};
+
+static struct merge_stream *merge_stream_get(struct sr_session_merge *merge,
+		const struct sr_dev_inst *sdi)
+{
+	struct merge_stream *stream;
+	GSList *l;
+
+	for (l = merge->streams; l; l = l->next) {
+		stream = l->data;
+		if (stream->sdi == sdi)
+			return stream;
+	}
+
+	stream = g_malloc0(sizeof(struct merge_stream));
+	stream->sdi = sdi;
+	g_queue_init(&stream->packets);
+	merge->streams = g_slist_append(merge->streams, stream);
+
+	return stream;
+}
+
+/*
+ * Pass on packets in timeline order. A packet is held until all devices
+ * still running have a packet queued, so none of them can send an
+ * earlier one, unless it's older than the maximum delay, or all is set.
+ */
+static void merge_release(struct sr_session_merge *merge, gboolean all)
+{
+	struct merge_stream *stream, *next;
+	struct sr_datafeed_packet *packet;
+	gboolean waiting;
+	int64_t next_ns;
+	GSList *l;
+
+	while (TRUE) {
+		next = NULL;
+		next_ns = 0;
+		waiting = FALSE;
+		for (l = merge->streams; l; l = l->next) {
+			stream = l->data;
+			if (!(packet = g_queue_peek_head(&stream->packets))) {
+				if (!stream->ended)
+					waiting = TRUE;
+				continue;
+			}
+			if (!next || packet->time->timeline_ns < next_ns) {
+				next = stream;
+				next_ns = packet->time->timeline_ns;
+			}
+		}
+
+		if (!next)
+			break;
+		if (waiting && !all
+				&& merge->latest_ns - next_ns < merge->max_delay_ns)
+			break;
+
+		packet = g_queue_pop_head(&next->packets);
+		merge->cb(next->sdi, packet, merge->cb_data);
+		sr_packet_free(packet);
+	}
+}
+
+/**
+ * Create a merger of the packet streams of the devices in a session.
+ *
+ * The packets pushed into the merger with sr_session_merge_push(),
+ * typically from a datafeed callback, are passed on to a callback in the
+ * order of their time on the session timeline, as a single stream. The
+ * order of the packets of each device is kept.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param max_delay_ns The longest time on the timeline a packet is held
+ *                     waiting for the other devices, which may send
+ *                     earlier packets. Devices which send nothing for
+ *                     longer, like slow multimeters, don't hold up the
+ *                     others. Use G_MAXINT64 to wait indefinitely.
+ * @param cb The callback to pass the merged packets to. Must not be NULL.
+ * @param cb_data Opaque pointer passed in by the caller.
+ *
+ * @return The merger, or NULL on invalid arguments. Free it with
+ *         sr_session_merge_free().
+ *
+ * @since 0.4.0
+ */
+SR_API struct sr_session_merge *sr_session_merge_new(
+		struct sr_session *session, int64_t max_delay_ns,
+		sr_datafeed_callback cb, void *cb_data)
+{
+	struct sr_session_merge *merge;
+	GSList *l;
+
+	if (!session || !cb || max_delay_ns < 0)
+		return NULL;
+
+	merge = g_malloc0(sizeof(struct sr_session_merge));
+	merge->session = session;
+	merge->max_delay_ns = max_delay_ns;
+	merge->cb = cb;
+	merge->cb_data = cb_data;
+
+	/* Wait for all devices of the session from the start. */
+	for (l = session->devs; l; l = l->next)
+		merge_stream_get(merge, l->data);
+
+	return merge;
+}
+
+/**
+ * Push a packet into a merger.
+ *
+ * @param merge The merger. Must not be NULL.
+ * @param sdi The device which sent the packet. Must not be NULL.
+ * @param packet The packet, as passed to a datafeed callback. It's copied.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument, or the packet has no time.
+ * @retval SR_ERR Other error.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_session_merge_push(struct sr_session_merge *merge,
+		const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet)
+{
+	struct merge_stream *stream;
+	struct sr_datafeed_packet *copy;
+	int ret;
+
+	if (!merge || !sdi || !packet)
+		return SR_ERR_ARG;
+
+	if (!packet->time) {
+		sr_err("Cannot merge packets without time.");
+		return SR_ERR_ARG;
+	}
+
+	if ((ret = sr_packet_copy(packet, &copy)) != SR_OK)
+		return ret;
+
+	stream = merge_stream_get(merge, sdi);
+	if (packet->type == SR_DF_HEADER)
+		stream->ended = FALSE;
+	else if (packet->type == SR_DF_END)
+		stream->ended = TRUE;
+	g_queue_push_tail(&stream->packets, copy);
+	merge->latest_ns = MAX(merge->latest_ns, packet->time->timeline_ns);
+
+	merge_release(merge, FALSE);
+
+	return SR_OK;
+}
+
+/**
+ * Pass on all packets held by a merger.
+ *
+ * @param merge The merger. Must not be NULL.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @since 0.4.0
+ */
+SR_API int sr_session_merge_flush(struct sr_session_merge *merge)
+{
+	if (!merge)
+		return SR_ERR_ARG;
+
+	merge_release(merge, TRUE);
+
+	return SR_OK;
+}
+
+/**
+ * Free a merger, discarding the packets it still holds.
+ *
+ * @param merge The merger. May be NULL.
+ *
+ * @since 0.4.0
+ */
+SR_API void sr_session_merge_free(struct sr_session_merge *merge)
+{
+	struct merge_stream *stream;
+	GSList *l;
+
+	if (!merge)
+		return;
+
+	for (l = merge->streams; l; l = l->next) {
+		stream = l->data;
+		while (!g_queue_is_empty(&stream->packets))
+			sr_packet_free(g_queue_pop_head(&stream->packets));
+		g_free(stream);
+	}
+	g_slist_free(merge->streams);
+	g_free(merge);
+}
+
+/** @} */
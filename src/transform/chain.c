@@ -0,0 +1,258 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Fusing of a session's transforms.
+ *
+ * When all transforms of a session describe themselves as element-wise
+ * operations, the operations are collected per data packet type, and
+ * merged where possible: consecutive factors and offsets become one,
+ * and inversions cancel out in pairs. The remaining operations are then
+ * applied block by block, so that each sample is read from and written
+ * to memory once, however many transforms there are.
+ *
+ * Packet types some transform can't be fused for still go through the
+ * transforms' receive() functions.
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "transform/chain"
+/** @endcond */
+
+/* Number of floats processed by all operations in turn, fits in L1. */
+#define CHAIN_BLOCK_SIZE	1024
+
+static const int data_packet_types[] = {
+	SR_DF_LOGIC,
+	SR_DF_ANALOG_OLD,
+	SR_DF_ANALOG,
+};
+
+struct sr_transform_chain {
+	/* Per data packet type, NULL if not all transforms could be fused. */
+	GArray *ops[G_N_ELEMENTS(data_packet_types)];
+};
+
+static int type_index(int packet_type)
+{
+	unsigned int i;
+
+	for (i = 0; i < G_N_ELEMENTS(data_packet_types); i++) {
+		if (data_packet_types[i] == packet_type)
+			return i;
+	}
+
+	return -1;
+}
+
+/* Whether the chain can apply this operation to this packet type. */
+static gboolean op_supported(int packet_type, const struct sr_transform_op *op)
+{
+	if (op->type == SR_TRANSFORM_OP_NONE)
+		return TRUE;
+
+	switch (packet_type) {
+	case SR_DF_LOGIC:
+		return op->type == SR_TRANSFORM_OP_INVERT;
+	case SR_DF_ANALOG_OLD:
+		return op->type == SR_TRANSFORM_OP_AFFINE
+			|| op->type == SR_TRANSFORM_OP_RECIPROCAL;
+	default:
+		return FALSE;
+	}
+}
+
+/* Append an operation, merging it with the previous one where possible. */
+static void ops_append(GArray *ops, const struct sr_transform_op *op)
+{
+	struct sr_transform_op *last;
+
+	last = ops->len ? &g_array_index(ops, struct sr_transform_op,
+			ops->len - 1) : NULL;
+
+	switch (op->type) {
+	case SR_TRANSFORM_OP_NONE:
+		return;
+	case SR_TRANSFORM_OP_INVERT:
+		if (last && last->type == SR_TRANSFORM_OP_INVERT) {
+			g_array_set_size(ops, ops->len - 1);
+			return;
+		}
+		break;
+	case SR_TRANSFORM_OP_AFFINE:
+		if (last && last->type == SR_TRANSFORM_OP_AFFINE) {
+			/* (x * m1 + a1) * m2 + a2 */
+			last->mul *= op->mul;
+			last->add = last->add * op->mul + op->add;
+			if (last->mul == 1 && last->add == 0)
+				g_array_set_size(ops, ops->len - 1);
+			return;
+		}
+		if (op->mul == 1 && op->add == 0)
+			return;
+		break;
+	default:
+		break;
+	}
+
+	g_array_append_val(ops, *op);
+}
+
+/**
+ * Fuse a list of transforms.
+ *
+ * @param transforms List of struct sr_transform pointers, in the order
+ *                   in which they are applied.
+ *
+ * @return The fused transforms, or NULL if they can't be fused for any
+ *         packet type, or there are none.
+ *
+ * @private
+ */
+SR_PRIV struct sr_transform_chain *sr_transform_chain_new(GSList *transforms)
+{
+	struct sr_transform_chain *chain;
+	struct sr_transform_op op;
+	const struct sr_transform *t;
+	GSList *l;
+	unsigned int i;
+	int ret;
+	gboolean fused;
+
+	if (!transforms)
+		return NULL;
+
+	for (l = transforms; l; l = l->next) {
+		t = l->data;
+		if (!t->module->fuse) {
+			sr_dbg("Transform module '%s' can't be fused.",
+				t->module->id);
+			return NULL;
+		}
+	}
+
+	chain = g_malloc0(sizeof(struct sr_transform_chain));
+	for (i = 0; i < G_N_ELEMENTS(data_packet_types); i++) {
+		chain->ops[i] = g_array_new(FALSE, FALSE,
+				sizeof(struct sr_transform_op));
+		fused = TRUE;
+		for (l = transforms; l && fused; l = l->next) {
+			t = l->data;
+			ret = t->module->fuse(t, data_packet_types[i], &op);
+			fused = ret == SR_OK && op_supported(data_packet_types[i], &op);
+			if (fused)
+				ops_append(chain->ops[i], &op);
+		}
+		if (!fused) {
+			g_array_free(chain->ops[i], TRUE);
+			chain->ops[i] = NULL;
+		}
+		sr_dbg("Packet type %d: %s, %u operations.", data_packet_types[i],
+			fused ? "fused" : "not fused",
+			fused ? chain->ops[i]->len : 0);
+	}
+
+	return chain;
+}
+
+static void run_floats(const GArray *ops, float *data, size_t count)
+{
+	const struct sr_transform_op *op;
+	size_t pos, len;
+	unsigned int i;
+
+	for (pos = 0; pos < count; pos += len) {
+		len = MIN(count - pos, CHAIN_BLOCK_SIZE);
+		for (i = 0; i < ops->len; i++) {
+			op = &g_array_index(ops, struct sr_transform_op, i);
+			if (op->type == SR_TRANSFORM_OP_AFFINE)
+				sr_transform_float_affine(data + pos, len,
+					op->mul, op->add);
+			else
+				sr_transform_float_reciprocal(data + pos, len);
+		}
+	}
+}
+
+/**
+ * Apply fused transforms to a packet, in place.
+ *
+ * @retval SR_OK The packet has been transformed, and is to be sent on.
+ * @retval SR_ERR_NA The transforms have to be run one by one on this
+ *                   packet, as they couldn't be fused for its type.
+ *
+ * @private
+ */
+SR_PRIV int sr_transform_chain_run(const struct sr_transform_chain *chain,
+		struct sr_datafeed_packet *packet)
+{
+	const struct sr_datafeed_logic *logic;
+	const struct sr_datafeed_analog_old *analog_old;
+	const GArray *ops;
+	int idx;
+
+	/* Fusable transforms pass everything else on as it is. */
+	if ((idx = type_index(packet->type)) < 0)
+		return SR_OK;
+	if (!(ops = chain->ops[idx]))
+		return SR_ERR_NA;
+	if (!ops->len)
+		return SR_OK;
+
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		/* Pairs cancel out, so this is a single inversion. */
+		logic = packet->payload;
+		if (logic->unitsize)
+			sr_transform_bytes_invert(logic->data,
+				logic->length / logic->unitsize * logic->unitsize);
+		break;
+	case SR_DF_ANALOG_OLD:
+		analog_old = packet->payload;
+		run_floats(ops, analog_old->data, analog_old->num_samples
+				* g_slist_length(analog_old->channels));
+		break;
+	}
+
+	return SR_OK;
+}
+
+/**
+ * Free fused transforms. NULL is ignored.
+ *
+ * @private
+ */
+SR_PRIV void sr_transform_chain_free(struct sr_transform_chain *chain)
+{
+	unsigned int i;
+
+	if (!chain)
+		return;
+
+	for (i = 0; i < G_N_ELEMENTS(data_packet_types); i++) {
+		if (chain->ops[i])
+			g_array_free(chain->ops[i], TRUE);
+	}
+	g_free(chain);
+}
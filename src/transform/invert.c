@@ -32,13 +32,8 @@ static int receive(const struct sr_transform *t,
 	const struct sr_datafeed_logic *logic;
 	const struct sr_datafeed_analog_old *analog_old;
 	const struct sr_datafeed_analog *analog;
-	struct sr_channel *ch;
-	GSList *l;
-	float *fdata, *f;
-	int si, num_channels, c;
-	uint8_t *b;
 	int64_t p;
-	uint64_t i, j, q;
+	uint64_t q;
 
 	if (!t || !t->sdi || !packet_in || !packet_out)
 		return SR_ERR_ARG;
@@ -46,27 +41,17 @@ static int receive(const struct sr_transform *t,
 	switch (packet_in->type) {
 	case SR_DF_LOGIC:
 		logic = packet_in->payload;
-		for (i = 0; i <= logic->length - logic->unitsize; i += logic->unitsize) {
-			for (j = 0; j < logic->unitsize; j++) {
-				/* For now invert every bit in every byte. */
-				b = (uint8_t *)logic->data + i + logic->unitsize - 1 - j;
-				*b = ~(*b);
-			}
-		}
+		/* For now invert every bit in every whole sample. */
+		if (logic->unitsize)
+			sr_transform_bytes_invert(logic->data,
+				logic->length / logic->unitsize * logic->unitsize);
 		break;
 	case SR_DF_ANALOG_OLD:
 		analog_old = packet_in->payload;
-		fdata = (float *)analog_old->data;
-		num_channels = g_slist_length(analog_old->channels);
-		for (si = 0; si < analog_old->num_samples; si++) {
-			/* For now invert all values in all channels. */
-			for (l = analog_old->channels, c = 0; l; l = l->next, c++) {
-				ch = l->data;
-				(void)ch;
-				f = &fdata[si * num_channels + c];
-				*f = 1.0 / *f;
-			}
-		}
+		/* For now invert all values in all channels. */
+		sr_transform_float_reciprocal(analog_old->data,
+			analog_old->num_samples
+				* g_slist_length(analog_old->channels));
 		break;
 	case SR_DF_ANALOG:
 		analog = packet_in->payload;
@@ -88,6 +73,26 @@ static int receive(const struct sr_transform *t,
 	return SR_OK;
 }
 
+static int fuse(const struct sr_transform *t, int packet_type,
+		struct sr_transform_op *op)
+{
+	(void)t;
+
+	switch (packet_type) {
+	case SR_DF_LOGIC:
+		op->type = SR_TRANSFORM_OP_INVERT;
+		break;
+	case SR_DF_ANALOG_OLD:
+		op->type = SR_TRANSFORM_OP_RECIPROCAL;
+		break;
+	default:
+		/* Inverted through the encoding, which needs receive(). */
+		return SR_ERR_NA;
+	}
+
+	return SR_OK;
+}
+
 SR_PRIV struct sr_transform_module transform_invert = {
 	.id = "invert",
 	.name = "Invert",
@@ -95,5 +100,6 @@ SR_PRIV struct sr_transform_module transform_invert = {
 	.options = NULL,
 	.init = NULL,
 	.receive = receive,
+	.fuse = fuse,
 	.cleanup = NULL,
 };
@@ -0,0 +1,156 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Element-wise kernels for the transform modules.
+ *
+ * Vector versions are used where the instruction set is available at
+ * compile time: SSE2 or AVX2 on x86 and NEON on ARM. Both SSE2 and NEON
+ * are always available on 64-bit targets, so no runtime detection is
+ * needed for those. The scalar loops handle the remaining elements, and
+ * everything on other targets.
+ *
+ * AVX2 is not part of the default x86-64 target, so the AVX2 versions
+ * are only built when the compiler is told the machine has it, e.g.
+ * with ./configure CFLAGS="-O2 -mavx2" (or -march=native). Such a
+ * library doesn't run on CPUs without AVX2.
+ */
+
+#include <config.h>
+#include <string.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "transform/kernel"
+/** @endcond */
+
+/**
+ * Apply data[i] = data[i] * mul + add to an array of floats.
+ *
+ * @private
+ */
+SR_PRIV void sr_transform_float_affine(float *data, size_t len,
+		float mul, float add)
+{
+	size_t i;
+#if defined(__AVX2__)
+	const __m256 vmul = _mm256_set1_ps(mul);
+	const __m256 vadd = _mm256_set1_ps(add);
+#elif defined(__SSE2__)
+	const __m128 vmul = _mm_set1_ps(mul);
+	const __m128 vadd = _mm_set1_ps(add);
+#elif defined(__ARM_NEON)
+	const float32x4_t vmul = vdupq_n_f32(mul);
+	const float32x4_t vadd = vdupq_n_f32(add);
+#endif
+
+	i = 0;
+#if defined(__AVX2__)
+	for (; i + 8 <= len; i += 8)
+		_mm256_storeu_ps(data + i, _mm256_add_ps(_mm256_mul_ps(
+			_mm256_loadu_ps(data + i), vmul), vadd));
+#elif defined(__SSE2__)
+	for (; i + 4 <= len; i += 4)
+		_mm_storeu_ps(data + i, _mm_add_ps(_mm_mul_ps(
+			_mm_loadu_ps(data + i), vmul), vadd));
+#elif defined(__ARM_NEON)
+	for (; i + 4 <= len; i += 4)
+		vst1q_f32(data + i, vaddq_f32(vmulq_f32(
+			vld1q_f32(data + i), vmul), vadd));
+#endif
+	for (; i < len; i++)
+		data[i] = data[i] * mul + add;
+}
+
+/**
+ * Apply data[i] = 1 / data[i] to an array of floats.
+ *
+ * @private
+ */
+SR_PRIV void sr_transform_float_reciprocal(float *data, size_t len)
+{
+	size_t i;
+#if defined(__AVX2__)
+	const __m256 one = _mm256_set1_ps(1.0f);
+#elif defined(__SSE2__)
+	const __m128 one = _mm_set1_ps(1.0f);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	const float32x4_t one = vdupq_n_f32(1.0f);
+#endif
+
+	i = 0;
+	/* A true division; the reciprocal estimates aren't exact enough. */
+#if defined(__AVX2__)
+	for (; i + 8 <= len; i += 8)
+		_mm256_storeu_ps(data + i,
+			_mm256_div_ps(one, _mm256_loadu_ps(data + i)));
+#elif defined(__SSE2__)
+	for (; i + 4 <= len; i += 4)
+		_mm_storeu_ps(data + i, _mm_div_ps(one, _mm_loadu_ps(data + i)));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	for (; i + 4 <= len; i += 4)
+		vst1q_f32(data + i, vdivq_f32(one, vld1q_f32(data + i)));
+#endif
+	for (; i < len; i++)
+		data[i] = 1.0f / data[i];
+}
+
+/**
+ * Invert all bits of a buffer.
+ *
+ * @private
+ */
+SR_PRIV void sr_transform_bytes_invert(uint8_t *data, size_t len)
+{
+	uint64_t word;
+	size_t i;
+#if defined(__AVX2__)
+	const __m256i ones = _mm256_set1_epi8(-1);
+#elif defined(__SSE2__)
+	const __m128i ones = _mm_set1_epi8(-1);
+#endif
+
+	i = 0;
+#if defined(__AVX2__)
+	for (; i + 32 <= len; i += 32)
+		_mm256_storeu_si256((__m256i *)(data + i), _mm256_xor_si256(
+			_mm256_loadu_si256((const __m256i *)(data + i)), ones));
+#elif defined(__SSE2__)
+	for (; i + 16 <= len; i += 16)
+		_mm_storeu_si128((__m128i *)(data + i), _mm_xor_si128(
+			_mm_loadu_si128((const __m128i *)(data + i)), ones));
+#elif defined(__ARM_NEON)
+	for (; i + 16 <= len; i += 16)
+		vst1q_u8(data + i, vmvnq_u8(vld1q_u8(data + i)));
+#endif
+	/* Whole words, where the compiler may still vectorize. */
+	for (; i + sizeof(word) <= len; i += sizeof(word)) {
+		memcpy(&word, data + i, sizeof(word));
+		word = ~word;
+		memcpy(data + i, &word, sizeof(word));
+	}
+	for (; i < len; i++)
+		data[i] = ~data[i];
+}
@@ -39,6 +39,17 @@ static int receive(const struct sr_transform *t,
 	return SR_OK;
 }
 
+static int fuse(const struct sr_transform *t, int packet_type,
+		struct sr_transform_op *op)
+{
+	(void)t;
+	(void)packet_type;
+
+	op->type = SR_TRANSFORM_OP_NONE;
+
+	return SR_OK;
+}
+
 SR_PRIV struct sr_transform_module transform_nop = {
 	.id = "nop",
 	.name = "NOP",
@@ -46,5 +57,6 @@ SR_PRIV struct sr_transform_module transform_nop = {
 	.options = NULL,
 	.init = NULL,
 	.receive = receive,
+	.fuse = fuse,
 	.cleanup = NULL,
 };
@@ -27,6 +27,7 @@
 
 struct context {
 	struct sr_rational factor;
+	float float_factor;
 };
 
 static int init(struct sr_transform *t, GHashTable *options)
@@ -40,6 +41,118 @@ static int init(struct sr_transform *t, GHashTable *options)
 
 	g_variant_get(g_hash_table_lookup(options, "factor"), "(xt)",
 			&ctx->factor.p, &ctx->factor.q);
+	if (!ctx->factor.q) {
+		sr_err("Invalid factor, denominator is 0.");
+		g_free(ctx);
+		t->priv = NULL;
+		return SR_ERR_ARG;
+	}
+	ctx->float_factor = (float)ctx->factor.p / ctx->factor.q;
+
+	return SR_OK;
+}
+
+static uint64_t gcd(uint64_t a, uint64_t b)
+{
+	uint64_t t;
+
+	while (b) {
+		t = a % b;
+		a = b;
+		b = t;
+	}
+
+	return a;
+}
+
+/* Multiply r by f. FALSE if the result doesn't fit, r is kept then. */
+static gboolean rational_mult(struct sr_rational *r,
+		const struct sr_rational *f)
+{
+	uint64_t rp, fp, rq, fq, g;
+	gboolean negative;
+
+	if (!r->q || !f->q)
+		return FALSE;
+
+	negative = (r->p < 0) != (f->p < 0);
+	rp = (r->p < 0) ? -(uint64_t)r->p : (uint64_t)r->p;
+	fp = (f->p < 0) ? -(uint64_t)f->p : (uint64_t)f->p;
+	if (!rp || !fp) {
+		r->p = 0;
+		r->q = 1;
+		return TRUE;
+	}
+
+	/* Cancel crosswise first, which keeps repeated scaling small. */
+	g = gcd(rp, f->q);
+	rp /= g;
+	fq = f->q / g;
+	g = gcd(fp, r->q);
+	fp /= g;
+	rq = r->q / g;
+
+	if (rp > INT64_MAX / fp || rq > UINT64_MAX / fq)
+		return FALSE;
+
+	r->p = negative ? -(int64_t)(rp * fp) : (int64_t)(rp * fp);
+	r->q = rq * fq;
+
+	return TRUE;
+}
+
+/* Whether the data are floats the kernels can work on directly. */
+static gboolean is_native_float(const struct sr_analog_encoding *encoding)
+{
+#ifdef WORDS_BIGENDIAN
+	const gboolean bigendian = TRUE;
+#else
+	const gboolean bigendian = FALSE;
+#endif
+
+	return encoding->is_float && encoding->unitsize == sizeof(float)
+		&& !encoding->is_bigendian == !bigendian;
+}
+
+static int scale_analog(const struct context *ctx,
+		const struct sr_datafeed_analog *analog)
+{
+	struct sr_analog_encoding *encoding;
+	struct sr_rational scale, offset;
+	float add;
+
+	encoding = analog->encoding;
+	scale = encoding->scale;
+	offset = encoding->offset;
+
+	/*
+	 * The values are raw * scale + offset, so scaling both rationals
+	 * scales the values without touching the data.
+	 */
+	if (rational_mult(&scale, &ctx->factor)
+			&& rational_mult(&offset, &ctx->factor)) {
+		encoding->scale = scale;
+		encoding->offset = offset;
+		return SR_OK;
+	}
+
+	/*
+	 * Otherwise scale the data in place, keeping the encoding. For
+	 * the values to be scaled by f, the raw values become
+	 * f * raw + (f - 1) * offset / scale.
+	 */
+	if (!is_native_float(encoding) || !encoding->scale.p
+			|| !encoding->scale.q || !encoding->offset.q) {
+		sr_err("Cannot scale this encoding by %" PRId64 "/%" PRIu64 ".",
+			ctx->factor.p, ctx->factor.q);
+		return SR_ERR;
+	}
+	add = (ctx->float_factor - 1)
+		* ((double)encoding->offset.p / encoding->offset.q)
+		/ ((double)encoding->scale.p / encoding->scale.q);
+	sr_transform_float_affine(analog->data, analog->num_samples
+			* g_slist_length(analog->meaning->channels),
+			ctx->float_factor, add);
 
 	return SR_OK;
 }
@@ -50,12 +163,7 @@ static int receive(const struct sr_transform *t,
 {
 	struct context *ctx;
 	const struct sr_datafeed_analog_old *analog_old;
-	const struct sr_datafeed_analog *analog;
-	struct sr_channel *ch;
-	GSList *l;
-	float *fdata;
-	float factor;
-	int i, num_channels, c;
+	int ret;
 
 	if (!t || !t->sdi || !packet_in || !packet_out)
 		return SR_ERR_ARG;
@@ -64,22 +172,15 @@ static int receive(const struct sr_transform *t,
 	switch (packet_in->type) {
 	case SR_DF_ANALOG_OLD:
 		analog_old = packet_in->payload;
-		fdata = (float *)analog_old->data;
-		num_channels = g_slist_length(analog_old->channels);
-		factor = (float) ctx->factor.p / ctx->factor.q;
-		for (i = 0; i < analog_old->num_samples; i++) {
-			/* For now scale all values in all channels. */
-			for (l = analog_old->channels, c = 0; l; l = l->next, c++) {
-				ch = l->data;
-				(void)ch;
-				fdata[i * num_channels + c] *= factor;
-			}
-		}
+		/* For now scale all values in all channels. */
+		sr_transform_float_affine(analog_old->data,
+			analog_old->num_samples
+				* g_slist_length(analog_old->channels),
+			ctx->float_factor, 0);
 		break;
 	case SR_DF_ANALOG:
-		analog = packet_in->payload;
-		analog->encoding->scale.p *= ctx->factor.p;
-		analog->encoding->scale.q *= ctx->factor.q;
+		if ((ret = scale_analog(ctx, packet_in->payload)) != SR_OK)
+			return ret;
 		break;
 	default:
 		sr_spew("Unsupported packet type %d, ignoring.", packet_in->type);
@@ -92,6 +193,30 @@ static int receive(const struct sr_transform *t,
 	return SR_OK;
 }
 
+static int fuse(const struct sr_transform *t, int packet_type,
+		struct sr_transform_op *op)
+{
+	struct context *ctx;
+
+	ctx = t->priv;
+
+	switch (packet_type) {
+	case SR_DF_ANALOG_OLD:
+		op->type = SR_TRANSFORM_OP_AFFINE;
+		op->mul = ctx->float_factor;
+		op->add = 0;
+		break;
+	case SR_DF_ANALOG:
+		/* Scaled through the encoding, which needs receive(). */
+		return SR_ERR_NA;
+	default:
+		op->type = SR_TRANSFORM_OP_NONE;
+		break;
+	}
+
+	return SR_OK;
+}
+
 static int cleanup(struct sr_transform *t)
 {
 	struct context *ctx;
@@ -130,5 +255,6 @@ SR_PRIV struct sr_transform_module transform_scale = {
 	.options = get_options,
 	.init = init,
 	.receive = receive,
+	.fuse = fuse,
 	.cleanup = cleanup,
 };
@@ -257,9 +257,14 @@ SR_API const struct sr_transform *sr_transform_new(const struct sr_transform_mod
 	}
 	if (new_opts)
 		g_hash_table_destroy(new_opts);
+	if (!t)
+		return NULL;
 
 	/* Add the transform to the session's list of transforms. */
 	sdi->session->transforms = g_slist_append(sdi->session->transforms, t);
+	sr_transform_chain_free(sdi->session->transform_chain);
+	sdi->session->transform_chain =
+		sr_transform_chain_new(sdi->session->transforms);
 
 	return t;
 }
@@ -267,15 +272,28 @@ SR_API const struct sr_transform *sr_transform_new(const struct sr_transform_mod
 /**
  * Free the specified transform instance and all associated resources.
  *
+ * If the device is still in a session, the transform is removed from
+ * that session's transforms. So this must be called before the device
+ * is freed.
+ *
  * @since 0.4.0
  */
 SR_API int sr_transform_free(const struct sr_transform *t)
 {
+	struct sr_session *session;
 	int ret;
 
 	if (!t)
 		return SR_ERR_ARG;
 
+	if (t->sdi && (session = t->sdi->session)
+			&& g_slist_find(session->transforms, t)) {
+		session->transforms = g_slist_remove(session->transforms, t);
+		sr_transform_chain_free(session->transform_chain);
+		session->transform_chain =
+			sr_transform_chain_new(session->transforms);
+	}
+
 	ret = SR_OK;
 	if (t->module->cleanup)
 		ret = t->module->cleanup((struct sr_transform *)t);
@@ -121,6 +121,7 @@ static gboolean usb_source_dispatch(GSource *source,
 	GPollFD *pollfd;
 	unsigned int revents;
 	unsigned int i;
+	uint64_t start_ns;
 	gboolean keep;
 
 	usource = (struct usb_source *)source;
@@ -139,7 +140,16 @@ static gboolean usb_source_dispatch(GSource *source,
 		sr_err("Callback not set, cannot dispatch event.");
 		return G_SOURCE_REMOVE;
 	}
-	keep = (*(sr_receive_data_callback)callback)(-1, revents, user_data);
+	if (G_UNLIKELY(usource->session->stats)) {
+		start_ns = sr_session_stats_time();
+		keep = (*(sr_receive_data_callback)callback)(-1, revents,
+				user_data);
+		sr_session_stats_add_source(usource->session, user_data,
+				start_ns);
+	} else {
+		keep = (*(sr_receive_data_callback)callback)(-1, revents,
+				user_data);
+	}
 
 	if (G_LIKELY(keep) && G_LIKELY(!g_source_is_destroyed(source))) {
 		if (usource->timeout_us >= 0)
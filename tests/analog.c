@@ -86,6 +86,62 @@ START_TEST(test_analog_to_float)
 }
 END_TEST
 
+START_TEST(test_analog_to_float_int)
+{
+	int ret;
+	unsigned int i;
+	float fout[4];
+	struct sr_channel ch;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	/* -2, 1000, 0x1234, -32768 as little endian 16-bit. */
+	const uint8_t s16le[] = {0xfe, 0xff, 0xe8, 0x03, 0x34, 0x12, 0x00, 0x80};
+	/* 1, 2, 0x80, 0xff as unsigned 8-bit. */
+	const uint8_t u8[] = {0x01, 0x02, 0x80, 0xff};
+	const float v16[] = {-0.002 + 1, 1.0 + 1, 4.66 + 1, -32.768 + 1};
+	const float v8[] = {2, 4, 256, 510};
+
+	sr_analog_init_(&analog, &encoding, &meaning, &spec, 3);
+	meaning.channels = g_slist_append(NULL, &ch);
+	analog.num_samples = 4;
+
+	encoding.is_float = FALSE;
+	encoding.is_signed = TRUE;
+	encoding.is_bigendian = FALSE;
+	encoding.unitsize = 2;
+	encoding.scale.p = 1;
+	encoding.scale.q = 1000;
+	encoding.offset.p = 1;
+	encoding.offset.q = 1;
+	analog.data = (void *)s16le;
+	ret = sr_analog_to_float(&analog, fout);
+	fail_unless(ret == SR_OK, "sr_analog_to_float() failed: %d.", ret);
+	for (i = 0; i < ARRAY_SIZE(v16); i++)
+		fail_unless(fabs(v16[i] - fout[i]) <= 0.001, "%f != %f",
+				v16[i], fout[i]);
+
+	encoding.is_signed = FALSE;
+	encoding.unitsize = 1;
+	encoding.scale.p = 2;
+	encoding.scale.q = 1;
+	encoding.offset.p = 0;
+	analog.data = (void *)u8;
+	ret = sr_analog_to_float(&analog, fout);
+	fail_unless(ret == SR_OK, "sr_analog_to_float() failed: %d.", ret);
+	for (i = 0; i < ARRAY_SIZE(v8); i++)
+		fail_unless(fabs(v8[i] - fout[i]) <= 0.001, "%f != %f",
+				v8[i], fout[i]);
+
+	encoding.unitsize = 3;
+	ret = sr_analog_to_float(&analog, fout);
+	fail_unless(ret == SR_ERR, "Unsupported unit size not rejected.");
+
+	g_slist_free(meaning.channels);
+}
+END_TEST
+
 START_TEST(test_analog_to_float_null)
 {
 	int ret;
@@ -205,6 +261,7 @@ Suite *suite_analog(void)
 
 	tc = tcase_create("analog_to_float");
 	tcase_add_test(tc, test_analog_to_float);
+	tcase_add_test(tc, test_analog_to_float_int);
 	tcase_add_test(tc, test_analog_to_float_null);
 	tcase_add_test(tc, test_analog_unit_to_string);
 	tcase_add_test(tc, test_analog_unit_to_string_null);
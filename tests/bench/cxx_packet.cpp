@@ -0,0 +1,141 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Measure the per-packet overhead of C++ datafeed callbacks, comparing
+ * the owning Packet wrappers against the non-owning PacketView API.
+ *
+ * Logic data is fed through the "binary" input module, which splits it
+ * into packets. Each run is timed as a whole; the run without any
+ * callback is the baseline that the others are compared to. All times
+ * are divided by the number of packets the callbacks received.
+ *
+ * Results are printed one per line as "<name> <value> <unit>".
+ */
+
+#include <libsigrokcxx/libsigrokcxx.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace sigrok;
+
+#define CHUNK_SIZE (1024 * 1024)
+#define DEFAULT_TOTAL_MB 1024
+
+enum mode {
+	MODE_NONE,
+	MODE_PACKET,
+	MODE_VIEW,
+};
+
+static const char *mode_names[] = { "none", "packet", "view" };
+
+static double run(shared_ptr<Context> context, enum mode mode,
+	size_t total_bytes, size_t &num_packets)
+{
+	auto session = context->create_session();
+	auto input = context->input_formats()["binary"]->create_input();
+	vector<uint8_t> chunk(CHUNK_SIZE, 0x55);
+	size_t packets = 0, bytes = 0;
+
+	session->add_device(input->device());
+
+	switch (mode) {
+	case MODE_NONE:
+		break;
+	case MODE_PACKET:
+		session->add_datafeed_callback(
+			[&](shared_ptr<Device>, shared_ptr<Packet> packet) {
+				if (packet->type() != PacketType::LOGIC)
+					return;
+				auto logic = dynamic_pointer_cast<Logic>(
+					packet->payload());
+				bytes += logic->data_length();
+				packets++;
+			});
+		break;
+	case MODE_VIEW:
+		session->add_datafeed_view_callback(
+			[&](Device *, const PacketView &packet) {
+				if (packet.type() != PacketType::LOGIC)
+					return;
+				bytes += packet.logic().data_length();
+				packets++;
+			});
+		break;
+	}
+
+	auto start = chrono::steady_clock::now();
+	for (size_t sent = 0; sent < total_bytes; sent += CHUNK_SIZE)
+		input->send(chunk.data(), chunk.size());
+	input->end();
+	auto end = chrono::steady_clock::now();
+
+	session->remove_datafeed_callbacks();
+
+	if (mode != MODE_NONE && bytes != total_bytes) {
+		cerr << "Received " << bytes << " of " << total_bytes
+			<< " bytes." << endl;
+		exit(1);
+	}
+
+	/* Without a callback, there's nothing to count. */
+	if (mode != MODE_NONE)
+		num_packets = packets;
+
+	return chrono::duration<double, nano>(end - start).count();
+}
+
+int main(int argc, char **argv)
+{
+	size_t total_mb = DEFAULT_TOTAL_MB;
+	double elapsed[3];
+	size_t num_packets = 0;
+
+	if (argc > 1)
+		total_mb = strtoul(argv[1], nullptr, 10);
+	if (!total_mb) {
+		cerr << "Usage: " << argv[0] << " [megabytes]" << endl;
+		return 1;
+	}
+
+	auto context = Context::create();
+
+	for (int m = MODE_NONE; m <= MODE_VIEW; m++)
+		elapsed[m] = run(context, static_cast<enum mode>(m),
+			total_mb * CHUNK_SIZE, num_packets);
+	if (!num_packets) {
+		cerr << "No packets received." << endl;
+		return 1;
+	}
+
+	for (int m = MODE_NONE; m <= MODE_VIEW; m++)
+		cout << "cxx_packet." << mode_names[m] << ".total "
+			<< elapsed[m] / num_packets << " ns/packet" << endl;
+
+	for (int m = MODE_PACKET; m <= MODE_VIEW; m++)
+		cout << "cxx_packet." << mode_names[m] << ".overhead "
+			<< (elapsed[m] - elapsed[MODE_NONE]) / num_packets
+			<< " ns/packet" << endl;
+
+	return 0;
+}
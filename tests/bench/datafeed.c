@@ -0,0 +1,740 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmarks of the core datafeed path.
+ *
+ *   datafeed [-t <milliseconds>] [<benchmark>...]
+ *
+ * Without arguments, all benchmarks are run:
+ *
+ *   session_send  sr_session_send() dispatch overhead per packet
+ *   trigger       soft trigger scan rate
+ *   analog        sr_analog_to_float() conversion rate, per encoding
+ *   output        rate of every output module
+ *   input         parse rate of every input module, fed with data
+ *                 written by the output module of the same name
+ *   sessionfile   srzip session file write and replay rates
+ *   demo          unthrottled demo driver acquisition rate
+ *
+ * Each measurement runs for about the given time (default 500 ms).
+ * The feed is 8 logic channels and one analog channel. libsigrok is
+ * linked statically, so that internal functions such as
+ * sr_session_send() and the soft trigger can be called directly.
+ *
+ * Results are printed one per line as "<name> <value> <unit>".
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+#define LOG_PREFIX "bench"
+
+#define NUM_LOGIC_CHANNELS	8
+#define PACKET_SAMPLES		4096
+#define SAMPLERATE		SR_MHZ(1)
+/* Samples written by an output module to make input module test data. */
+#define INPUT_SAMPLES		(256 * 1024)
+#define INPUT_CHUNK_SIZE	(64 * 1024)
+#define TRIGGER_CHUNK_SIZE	(64 * 1024)
+/* Iterations between looking at the clock, in the tightest loops. */
+#define CLOCK_INTERVAL		64
+
+struct feed {
+	struct sr_dev_inst *sdi;
+	struct sr_channel *analog_ch;
+	uint8_t logic_data[PACKET_SAMPLES];
+	float analog_data[PACKET_SAMPLES];
+	struct sr_datafeed_header header;
+	struct sr_datafeed_meta meta;
+	struct sr_datafeed_logic logic;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	struct sr_datafeed_packet header_packet;
+	struct sr_datafeed_packet meta_packet;
+	struct sr_datafeed_packet logic_packet;
+	struct sr_datafeed_packet analog_packet;
+	struct sr_datafeed_packet end_packet;
+};
+
+struct feed_counter {
+	uint64_t packets;
+	uint64_t logic_samples;
+	uint64_t analog_samples;
+	gboolean ended;
+};
+
+static struct sr_context *ctx;
+static int64_t duration_us = 500 * 1000;
+
+static void fill_random(uint8_t *buf, size_t len, uint32_t seed)
+{
+	uint32_t x;
+	size_t i;
+
+	x = seed ? seed : 1;
+	for (i = 0; i < len; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		buf[i] = x >> 24;
+	}
+}
+
+static void feed_init(struct feed *f)
+{
+	struct sr_config *src;
+	char name[16];
+	unsigned int i;
+
+	memset(f, 0, sizeof(*f));
+
+	f->sdi = sr_dev_inst_user_new("sigrok", "Benchmark", NULL);
+	for (i = 0; i < NUM_LOGIC_CHANNELS; i++) {
+		snprintf(name, sizeof(name), "D%u", i);
+		sr_dev_inst_channel_add(f->sdi, i, SR_CHANNEL_LOGIC, name);
+	}
+	sr_dev_inst_channel_add(f->sdi, i, SR_CHANNEL_ANALOG, "A0");
+	f->analog_ch = g_slist_last(f->sdi->channels)->data;
+
+	fill_random(f->logic_data, sizeof(f->logic_data), 0x5eed);
+	for (i = 0; i < PACKET_SAMPLES; i++)
+		f->analog_data[i] = sinf(2 * G_PI * i / 256) * 3.3f;
+
+	f->header.feed_version = 1;
+	f->header_packet.type = SR_DF_HEADER;
+	f->header_packet.payload = &f->header;
+
+	src = sr_config_new(SR_CONF_SAMPLERATE,
+			g_variant_new_uint64(SAMPLERATE));
+	f->meta.config = g_slist_append(NULL, src);
+	f->meta_packet.type = SR_DF_META;
+	f->meta_packet.payload = &f->meta;
+
+	f->logic.length = PACKET_SAMPLES;
+	f->logic.unitsize = 1;
+	f->logic.data = f->logic_data;
+	f->logic_packet.type = SR_DF_LOGIC;
+	f->logic_packet.payload = &f->logic;
+
+	sr_analog_init(&f->analog, &f->encoding, &f->meaning, &f->spec, 3);
+	f->analog.data = f->analog_data;
+	f->analog.num_samples = PACKET_SAMPLES;
+	f->meaning.mq = SR_MQ_VOLTAGE;
+	f->meaning.unit = SR_UNIT_VOLT;
+	f->meaning.channels = g_slist_append(NULL, f->analog_ch);
+	f->analog_packet.type = SR_DF_ANALOG;
+	f->analog_packet.payload = &f->analog;
+
+	f->end_packet.type = SR_DF_END;
+}
+
+static void feed_cleanup(struct feed *f)
+{
+	g_slist_free_full(f->meta.config, (GDestroyNotify)sr_config_free);
+	g_slist_free(f->meaning.channels);
+	sr_dev_inst_free(f->sdi);
+}
+
+static void datafeed_count(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	struct feed_counter *c;
+	const struct sr_datafeed_logic *logic;
+	const struct sr_datafeed_analog *analog;
+
+	(void)sdi;
+
+	c = cb_data;
+	c->packets++;
+
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		c->logic_samples += logic->length / logic->unitsize;
+		break;
+	case SR_DF_ANALOG:
+		analog = packet->payload;
+		c->analog_samples += analog->num_samples;
+		break;
+	case SR_DF_END:
+		c->ended = TRUE;
+		break;
+	}
+}
+
+static double rate(uint64_t count, int64_t elapsed_us)
+{
+	return (double)count / MAX(elapsed_us, 1);
+}
+
+static void bench_session_send_packet(struct feed *f, const char *name,
+		const struct sr_datafeed_packet *packet)
+{
+	struct sr_session *session;
+	struct feed_counter counter;
+	int64_t start, end, deadline;
+	uint64_t n;
+	int i;
+
+	memset(&counter, 0, sizeof(counter));
+	sr_session_new(ctx, &session);
+	sr_session_dev_add(session, f->sdi);
+	sr_session_datafeed_callback_add(session, datafeed_count, &counter);
+	sr_session_send(f->sdi, &f->header_packet);
+
+	n = 0;
+	start = g_get_monotonic_time();
+	deadline = start + duration_us;
+	do {
+		for (i = 0; i < CLOCK_INTERVAL; i++)
+			sr_session_send(f->sdi, packet);
+		n += CLOCK_INTERVAL;
+	} while ((end = g_get_monotonic_time()) < deadline);
+
+	sr_session_send(f->sdi, &f->end_packet);
+	sr_session_destroy(session);
+
+	printf("session_send.%s %.1f ns/packet\n", name,
+		(end - start) * 1000.0 / n);
+}
+
+static int bench_session_send(struct feed *f)
+{
+	bench_session_send_packet(f, "logic", &f->logic_packet);
+	bench_session_send_packet(f, "analog", &f->analog_packet);
+
+	return 0;
+}
+
+static void bench_trigger_match(struct feed *f, const char *name,
+		int match)
+{
+	struct sr_trigger *trigger;
+	struct sr_trigger_stage *stage;
+	struct soft_trigger_logic *stl;
+	uint8_t *data;
+	int64_t start, end, deadline;
+	uint64_t samples;
+	int pre_trigger_samples, i;
+
+	/* D0 is always low, so the trigger never fires. */
+	data = g_malloc(TRIGGER_CHUNK_SIZE);
+	fill_random(data, TRIGGER_CHUNK_SIZE, 0x7219);
+	for (i = 0; i < TRIGGER_CHUNK_SIZE; i++)
+		data[i] &= ~1;
+
+	trigger = sr_trigger_new(NULL);
+	stage = sr_trigger_stage_add(trigger);
+	sr_trigger_match_add(stage, f->sdi->channels->data, match, 0);
+	stl = soft_trigger_logic_new(f->sdi, trigger, 0);
+
+	samples = 0;
+	start = g_get_monotonic_time();
+	deadline = start + duration_us;
+	do {
+		soft_trigger_logic_check(stl, data, TRIGGER_CHUNK_SIZE,
+				&pre_trigger_samples);
+		samples += TRIGGER_CHUNK_SIZE / stl->unitsize;
+	} while ((end = g_get_monotonic_time()) < deadline);
+
+	soft_trigger_logic_free(stl);
+	sr_trigger_free(trigger);
+	g_free(data);
+
+	printf("trigger.%s %.1f MS/s\n", name, rate(samples, end - start));
+}
+
+static int bench_trigger(struct feed *f)
+{
+	bench_trigger_match(f, "level", SR_TRIGGER_ONE);
+	bench_trigger_match(f, "edge", SR_TRIGGER_RISING);
+
+	return 0;
+}
+
+static void bench_analog_encoding(struct feed *f, const char *name,
+		const void *data, int unitsize, gboolean is_float,
+		gboolean is_signed, int64_t scale_q, int64_t offset_p)
+{
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	float *out;
+	int64_t start, end, deadline;
+	uint64_t samples;
+	int i;
+
+	sr_analog_init(&analog, &encoding, &meaning, &spec, 3);
+	analog.data = (void *)data;
+	analog.num_samples = PACKET_SAMPLES;
+	meaning.channels = g_slist_append(NULL, f->analog_ch);
+	encoding.unitsize = unitsize;
+	encoding.is_float = is_float;
+	encoding.is_signed = is_signed;
+	encoding.scale.q = scale_q;
+	encoding.offset.p = offset_p;
+
+	out = g_malloc(PACKET_SAMPLES * sizeof(float));
+
+	samples = 0;
+	start = g_get_monotonic_time();
+	deadline = start + duration_us;
+	do {
+		for (i = 0; i < CLOCK_INTERVAL; i++)
+			sr_analog_to_float(&analog, out);
+		samples += CLOCK_INTERVAL * PACKET_SAMPLES;
+	} while ((end = g_get_monotonic_time()) < deadline);
+
+	g_free(out);
+	g_slist_free(meaning.channels);
+
+	printf("analog_to_float.%s %.1f MS/s\n", name,
+		rate(samples, end - start));
+}
+
+static int bench_analog(struct feed *f)
+{
+	uint8_t *raw;
+
+	raw = g_malloc(PACKET_SAMPLES * sizeof(uint32_t));
+	fill_random(raw, PACKET_SAMPLES * sizeof(uint32_t), 0xa1a1);
+
+	bench_analog_encoding(f, "float", f->analog_data, 4, TRUE, TRUE, 1, 0);
+	bench_analog_encoding(f, "float_scaled", f->analog_data, 4, TRUE, TRUE,
+			1000, 0);
+	bench_analog_encoding(f, "int16_scaled", raw, 2, FALSE, TRUE,
+			32768, 0);
+	bench_analog_encoding(f, "uint8_offset", raw, 1, FALSE, FALSE,
+			256, -1);
+	bench_analog_encoding(f, "int32_scaled", raw, 4, FALSE, TRUE,
+			1 << 24, 0);
+
+	g_free(raw);
+
+	return 0;
+}
+
+static void output_send(const struct sr_output *o,
+		const struct sr_datafeed_packet *packet, GString *dest)
+{
+	GString *out;
+
+	out = NULL;
+	sr_output_send(o, packet, &out);
+	if (!out)
+		return;
+	if (dest)
+		g_string_append_len(dest, out->str, out->len);
+	g_string_free(out, TRUE);
+}
+
+/*
+ * Run the feed through an output module, for the given number of
+ * samples or, if zero, for the benchmark duration. The output is
+ * collected in dest, unless that is NULL.
+ */
+static int output_run(struct feed *f, const struct sr_output_module *omod,
+		uint64_t num_samples, GString *dest, uint64_t *samples,
+		int64_t *elapsed)
+{
+	const struct sr_output *o;
+	int64_t start, end, deadline;
+	uint64_t n;
+
+	if (!(o = sr_output_new(omod, NULL, f->sdi, NULL)))
+		return SR_ERR;
+
+	n = 0;
+	start = g_get_monotonic_time();
+	deadline = start + duration_us;
+	output_send(o, &f->header_packet, dest);
+	output_send(o, &f->meta_packet, dest);
+	do {
+		output_send(o, &f->logic_packet, dest);
+		output_send(o, &f->analog_packet, dest);
+		n += PACKET_SAMPLES;
+		end = g_get_monotonic_time();
+	} while (num_samples ? n < num_samples : end < deadline);
+	output_send(o, &f->end_packet, dest);
+	end = g_get_monotonic_time();
+
+	sr_output_free(o);
+
+	if (samples)
+		*samples = n;
+	if (elapsed)
+		*elapsed = end - start;
+
+	return SR_OK;
+}
+
+static int bench_output(struct feed *f)
+{
+	const struct sr_output_module **omods;
+	const char *id;
+	uint64_t samples, bytes;
+	int64_t elapsed;
+	int i;
+
+	omods = sr_output_list();
+	for (i = 0; omods[i]; i++) {
+		id = sr_output_id_get(omods[i]);
+		/* These write files themselves; see the sessionfile benchmark. */
+		if (sr_output_test_flag(omods[i], SR_OUTPUT_INTERNAL_IO_HANDLING))
+			continue;
+		if (output_run(f, omods[i], 0, NULL, &samples, &elapsed) != SR_OK) {
+			fprintf(stderr, "Output module %s failed.\n", id);
+			continue;
+		}
+		bytes = samples * (f->logic.unitsize + sizeof(float));
+		printf("output.%s %.1f MB/s\n", id, rate(bytes, elapsed));
+		printf("output.%s.rate %.2f MS/s\n", id, rate(samples, elapsed));
+	}
+
+	return 0;
+}
+
+/* Feed data to a new instance of an input module, in chunks. */
+static int input_run(const struct sr_input_module *imod, const GString *data,
+		struct feed_counter *counter)
+{
+	const struct sr_input *in;
+	struct sr_session *session;
+	struct sr_dev_inst *sdi;
+	GString *chunk;
+	gsize pos, len;
+	int ret;
+
+	if (!(in = sr_input_new(imod, NULL)))
+		return SR_ERR;
+
+	sr_session_new(ctx, &session);
+	sr_session_datafeed_callback_add(session, datafeed_count, counter);
+
+	chunk = g_string_sized_new(INPUT_CHUNK_SIZE);
+	sdi = NULL;
+	ret = SR_OK;
+	for (pos = 0; pos < data->len && ret == SR_OK; pos += len) {
+		len = MIN(INPUT_CHUNK_SIZE, data->len - pos);
+		g_string_assign(chunk, "");
+		g_string_append_len(chunk, data->str + pos, len);
+		ret = sr_input_send(in, chunk);
+		/* As frontends do: add the device once it's known. */
+		if (!sdi && (sdi = sr_input_dev_inst_get(in)))
+			sr_session_dev_add(session, sdi);
+	}
+	if (ret == SR_OK)
+		ret = sr_input_end(in);
+	g_string_free(chunk, TRUE);
+
+	/* The session refers to the device, which goes with the input. */
+	sr_session_destroy(session);
+	sr_input_free(in);
+
+	return ret;
+}
+
+static int bench_input(struct feed *f)
+{
+	const struct sr_input_module **imods;
+	const struct sr_output_module *omod;
+	struct feed_counter counter;
+	GString *data;
+	char *id;
+	uint64_t bytes, samples;
+	int64_t start, end, deadline;
+	int i, ret;
+
+	imods = sr_input_list();
+	for (i = 0; imods[i]; i++) {
+		id = (char *)sr_input_id_get(imods[i]);
+		omod = sr_output_find(id);
+		if (!omod || sr_output_test_flag(omod,
+				SR_OUTPUT_INTERNAL_IO_HANDLING)) {
+			fprintf(stderr, "No test data for input module %s.\n", id);
+			continue;
+		}
+
+		data = g_string_new(NULL);
+		if (output_run(f, omod, INPUT_SAMPLES, data, NULL, NULL) != SR_OK
+				|| !data->len) {
+			fprintf(stderr, "No test data for input module %s.\n", id);
+			g_string_free(data, TRUE);
+			continue;
+		}
+
+		memset(&counter, 0, sizeof(counter));
+		bytes = 0;
+		ret = SR_OK;
+		start = g_get_monotonic_time();
+		deadline = start + duration_us;
+		do {
+			if ((ret = input_run(imods[i], data, &counter)) != SR_OK)
+				break;
+			bytes += data->len;
+		} while ((end = g_get_monotonic_time()) < deadline);
+		g_string_free(data, TRUE);
+
+		if (ret != SR_OK) {
+			fprintf(stderr, "Input module %s failed.\n", id);
+			continue;
+		}
+		samples = MAX(counter.logic_samples, counter.analog_samples);
+		printf("input.%s %.1f MB/s\n", id, rate(bytes, end - start));
+		printf("input.%s.rate %.2f MS/s\n", id, rate(samples, end - start));
+	}
+
+	return 0;
+}
+
+static int bench_sessionfile(struct feed *f)
+{
+	const struct sr_output_module *omod;
+	const struct sr_output *o;
+	struct sr_session *session;
+	struct feed_counter counter;
+	char *filename;
+	int64_t start, end, deadline;
+	uint64_t written;
+	int fd, ret;
+
+	if (!(omod = sr_output_find("srzip"))) {
+		fprintf(stderr, "No srzip output module.\n");
+		return 1;
+	}
+
+	filename = g_build_filename(g_get_tmp_dir(),
+			"sigrok-bench-XXXXXX.sr", NULL);
+	if ((fd = g_mkstemp(filename)) < 0) {
+		fprintf(stderr, "Failed to create %s.\n", filename);
+		g_free(filename);
+		return 1;
+	}
+	close(fd);
+	/* The module wants to create the file itself. */
+	g_unlink(filename);
+
+	if (!(o = sr_output_new(omod, NULL, f->sdi, filename))) {
+		fprintf(stderr, "Failed to create session file output.\n");
+		g_free(filename);
+		return 1;
+	}
+
+	written = 0;
+	start = g_get_monotonic_time();
+	deadline = start + duration_us;
+	output_send(o, &f->header_packet, NULL);
+	output_send(o, &f->meta_packet, NULL);
+	do {
+		output_send(o, &f->logic_packet, NULL);
+		written += f->logic.length;
+	} while (g_get_monotonic_time() < deadline);
+	output_send(o, &f->end_packet, NULL);
+	sr_output_free(o);
+	end = g_get_monotonic_time();
+
+	printf("sessionfile.write %.1f MB/s\n", rate(written, end - start));
+
+	ret = 1;
+	memset(&counter, 0, sizeof(counter));
+	start = g_get_monotonic_time();
+	if (sr_session_load(ctx, filename, &session) == SR_OK) {
+		sr_session_datafeed_callback_add(session, datafeed_count,
+				&counter);
+		if (sr_session_start(session) == SR_OK)
+			sr_session_run(session);
+		sr_session_destroy(session);
+	}
+	end = g_get_monotonic_time();
+
+	if (counter.ended && counter.logic_samples == written) {
+		printf("sessionfile.replay %.1f MB/s\n",
+			rate(written, end - start));
+		ret = 0;
+	} else {
+		fprintf(stderr, "Session file replay failed: %" PRIu64
+			" of %" PRIu64 " samples.\n", counter.logic_samples,
+			written);
+	}
+
+	g_unlink(filename);
+	g_free(filename);
+
+	return ret;
+}
+
+static void demo_run(struct sr_dev_inst *sdi, uint64_t packet_size)
+{
+	struct sr_session *session;
+	struct feed_counter counter;
+	int64_t start, end;
+
+	sr_config_set(sdi, NULL, SR_CONF_BUFFERSIZE,
+			g_variant_new_uint64(packet_size));
+	sr_config_set(sdi, NULL, SR_CONF_LIMIT_MSEC,
+			g_variant_new_uint64(duration_us / 1000));
+
+	memset(&counter, 0, sizeof(counter));
+	sr_session_new(ctx, &session);
+	sr_session_dev_add(session, sdi);
+	sr_session_datafeed_callback_add(session, datafeed_count, &counter);
+
+	start = g_get_monotonic_time();
+	if (sr_session_start(session) == SR_OK)
+		sr_session_run(session);
+	end = g_get_monotonic_time();
+
+	sr_session_destroy(session);
+
+	printf("demo.%" PRIu64 " %.1f MS/s\n", packet_size,
+		rate(counter.logic_samples, end - start));
+	printf("demo.%" PRIu64 ".packets %.0f packets/s\n", packet_size,
+		rate(counter.packets, end - start) * 1e6);
+}
+
+static int bench_demo(struct feed *f)
+{
+	struct sr_dev_driver **drivers, *driver;
+	struct sr_dev_inst *sdi;
+	GSList *options, *devices;
+	int i;
+
+	(void)f;
+
+	drivers = sr_driver_list(ctx);
+	for (driver = NULL, i = 0; drivers[i]; i++)
+		if (!strcmp(drivers[i]->name, "demo"))
+			driver = drivers[i];
+	if (!driver) {
+		fprintf(stderr, "The demo driver is not available.\n");
+		return 0;
+	}
+	if (sr_driver_init(ctx, driver) != SR_OK)
+		return 1;
+
+	options = g_slist_append(NULL, sr_config_new(SR_CONF_NUM_LOGIC_CHANNELS,
+			g_variant_new_int32(NUM_LOGIC_CHANNELS)));
+	options = g_slist_append(options, sr_config_new(
+			SR_CONF_NUM_ANALOG_CHANNELS, g_variant_new_int32(0)));
+	devices = sr_driver_scan(driver, options);
+	g_slist_free_full(options, (GDestroyNotify)sr_config_free);
+	if (!devices)
+		return 1;
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	if (sr_dev_open(sdi) != SR_OK)
+		return 1;
+	sr_config_set(sdi, NULL, SR_CONF_UNTHROTTLED,
+			g_variant_new_boolean(TRUE));
+
+	demo_run(sdi, 4096);
+	demo_run(sdi, 1024 * 1024);
+
+	sr_dev_close(sdi);
+
+	return 0;
+}
+
+static const struct {
+	const char *name;
+	int (*run)(struct feed *f);
+} benchmarks[] = {
+	{ "session_send", bench_session_send },
+	{ "trigger", bench_trigger },
+	{ "analog", bench_analog },
+	{ "output", bench_output },
+	{ "input", bench_input },
+	{ "sessionfile", bench_sessionfile },
+	{ "demo", bench_demo },
+};
+
+static void usage(const char *argv0)
+{
+	unsigned int i;
+
+	fprintf(stderr, "Usage: %s [-t <milliseconds>] [<benchmark>...]\n"
+		"Benchmarks:", argv0);
+	for (i = 0; i < ARRAY_SIZE(benchmarks); i++)
+		fprintf(stderr, " %s", benchmarks[i].name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+	struct feed f;
+	unsigned int i;
+	int opt, arg, found, ret;
+
+	while ((opt = getopt(argc, argv, "t:")) != -1) {
+		switch (opt) {
+		case 't':
+			duration_us = strtoll(optarg, NULL, 10) * 1000;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (duration_us <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	for (arg = optind; arg < argc; arg++) {
+		for (i = 0, found = 0; i < ARRAY_SIZE(benchmarks); i++)
+			found |= !strcmp(argv[arg], benchmarks[i].name);
+		if (!found) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (sr_init(&ctx) != SR_OK)
+		return 1;
+	sr_log_loglevel_set(SR_LOG_WARN);
+	feed_init(&f);
+
+	ret = 0;
+	for (i = 0; i < ARRAY_SIZE(benchmarks); i++) {
+		if (optind < argc) {
+			for (arg = optind, found = 0; arg < argc; arg++)
+				found |= !strcmp(argv[arg], benchmarks[i].name);
+			if (!found)
+				continue;
+		}
+		ret |= benchmarks[i].run(&f);
+	}
+
+	feed_cleanup(&f);
+	sr_exit(ctx);
+
+	return ret;
+}
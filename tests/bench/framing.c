@@ -0,0 +1,412 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmarks of the packet framing engine.
+ *
+ *   framing [-t <milliseconds>] [-f <file>] [<protocol>...]
+ *
+ * Without arguments, all protocols are run:
+ *
+ *   fixed       14 byte packets with sync nibbles, like FS9721 DMMs
+ *   fixed_sync  17 byte packets ending in CR LF, like ES51919 LCR meters
+ *   length      DLE STX framed packets with a length byte, like Brymen DMMs
+ *   delimited   LF ... CR groups, like Teleinfo meters
+ *
+ * Each protocol is fed a stream of packets mixed with bytes that can't
+ * start a packet, in chunks the size of a serial read, and the rate is
+ * measured for about the given time (default 500 ms). The framing
+ * engine itself is checked by the "framing" suite in tests/.
+ *
+ * With -f, the recorded byte stream in the given file is fed instead,
+ * and only the rate and packet count are reported.
+ *
+ * Results are printed one per line as "<name> <value> <unit>".
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+#define LOG_PREFIX "bench"
+
+/* Same as the serial receive buffer. */
+#define BUF_SIZE		4096
+#define MAX_CHUNK_SIZE		256
+#define NUM_PACKETS		4096
+#define STREAM_SEED		0x5eed
+
+#define DLE	0x10
+#define STX	0x02
+#define ETX	0x03
+#define LF	0x0a
+#define CR	0x0d
+
+/* Receive buffer, compacted before every chunk like the serial one. */
+struct rx {
+	uint8_t data[BUF_SIZE];
+	size_t start;
+	size_t len;
+};
+
+struct protocol {
+	const char *name;
+	const struct sr_framing *framing;
+	/* Write a valid packet, return its size. */
+	size_t (*make_packet)(uint8_t *buf, GRand *rand);
+	/* Whether a byte may appear between packets. */
+	gboolean (*is_filler)(uint8_t c);
+};
+
+static int64_t duration_us = 500 * 1000;
+static const char *stream_file;
+
+static double rate(uint64_t count, int64_t elapsed_us)
+{
+	return (double)count / MAX(elapsed_us, 1);
+}
+
+/* fixed: byte i carries i + 1 in its upper nibble. */
+
+static gboolean fixed_valid(const uint8_t *buf)
+{
+	int i;
+
+	for (i = 0; i < 14; i++)
+		if ((buf[i] >> 4) != i + 1)
+			return FALSE;
+
+	return TRUE;
+}
+
+static size_t fixed_make(uint8_t *buf, GRand *rand)
+{
+	int i;
+
+	for (i = 0; i < 14; i++)
+		buf[i] = ((i + 1) << 4) | g_rand_int_range(rand, 0, 16);
+
+	return 14;
+}
+
+static gboolean fixed_filler(uint8_t c)
+{
+	return (c >> 4) == 0;
+}
+
+static const struct sr_framing fixed_framing = {
+	.type = SR_FRAMING_FIXED,
+	.size = 14,
+	.is_valid = fixed_valid,
+};
+
+/* fixed_sync: 15 bytes of payload, then CR LF. */
+
+static gboolean fixed_sync_valid(const uint8_t *buf)
+{
+	return buf[15] == CR && buf[16] == LF;
+}
+
+static size_t fixed_sync_make(uint8_t *buf, GRand *rand)
+{
+	int i;
+
+	for (i = 0; i < 15; i++)
+		buf[i] = g_rand_int_range(rand, 0x20, 0x80);
+	buf[15] = CR;
+	buf[16] = LF;
+
+	return 17;
+}
+
+static gboolean fixed_sync_filler(uint8_t c)
+{
+	return c != CR;
+}
+
+static const struct sr_framing fixed_sync_framing = {
+	.type = SR_FRAMING_FIXED,
+	.size = 17,
+	.has_sync = TRUE,
+	.sync = CR,
+	.sync_offset = 15,
+	.is_valid = fixed_sync_valid,
+};
+
+/* length: DLE STX cmd len, payload, XOR checksum, DLE ETX. */
+
+static int length_length(const uint8_t *buf, size_t len)
+{
+	if (len < 4)
+		return 0;
+	if (buf[0] != DLE || buf[1] != STX)
+		return -1;
+
+	return 4 + buf[3] + 3;
+}
+
+static gboolean length_valid(const uint8_t *buf)
+{
+	uint8_t chksum;
+	int i;
+
+	chksum = 0;
+	for (i = 0; i < buf[3]; i++)
+		chksum ^= buf[4 + i];
+
+	return buf[4 + buf[3]] == chksum;
+}
+
+static size_t length_make(uint8_t *buf, GRand *rand)
+{
+	uint8_t chksum;
+	int i, len;
+
+	len = g_rand_int_range(rand, 1, 16);
+	buf[0] = DLE;
+	buf[1] = STX;
+	buf[2] = 0x00;
+	buf[3] = len;
+	chksum = 0;
+	for (i = 0; i < len; i++) {
+		buf[4 + i] = g_rand_int_range(rand, 0x20, 0x80);
+		chksum ^= buf[4 + i];
+	}
+	buf[4 + len] = chksum;
+	buf[5 + len] = DLE;
+	buf[6 + len] = ETX;
+
+	return len + 7;
+}
+
+static gboolean length_filler(uint8_t c)
+{
+	return c != DLE;
+}
+
+static const struct sr_framing length_framing = {
+	.type = SR_FRAMING_LENGTH,
+	.size = 22,
+	.has_sync = TRUE,
+	.sync = DLE,
+	.sync_offset = 0,
+	.packet_length = length_length,
+	.is_valid = length_valid,
+};
+
+/* delimited: LF, label, SP, value, SP, checksum, CR. */
+
+static size_t delimited_make(uint8_t *buf, GRand *rand)
+{
+	return sprintf((char *)buf, "\nPAPP %05u %c\r",
+			g_rand_int_range(rand, 0, 100000),
+			g_rand_int_range(rand, 0x20, 0x60));
+}
+
+static gboolean delimited_filler(uint8_t c)
+{
+	return c != LF;
+}
+
+static const struct sr_framing delimited_framing = {
+	.type = SR_FRAMING_DELIMITED,
+	.size = 25,
+	.start = LF,
+	.end = CR,
+};
+
+static const struct protocol protocols[] = {
+	{ "fixed", &fixed_framing, fixed_make, fixed_filler },
+	{ "fixed_sync", &fixed_sync_framing, fixed_sync_make,
+		fixed_sync_filler },
+	{ "length", &length_framing, length_make, length_filler },
+	{ "delimited", &delimited_framing, delimited_make, delimited_filler },
+};
+
+static void rx_feed(struct rx *rx, const uint8_t *data, size_t len)
+{
+	if (rx->start) {
+		memmove(rx->data, rx->data + rx->start, rx->len);
+		rx->start = 0;
+	}
+	memcpy(rx->data + rx->len, data, len);
+	rx->len += len;
+}
+
+/* Take a packet, like serial_rx_frame(). */
+static int rx_frame(struct rx *rx, const struct sr_framing *framing,
+		const uint8_t **pkt)
+{
+	size_t offset;
+	int ret;
+
+	ret = sr_framing_find(framing, rx->data + rx->start, rx->len, &offset);
+	if (ret > 0) {
+		*pkt = rx->data + rx->start + offset;
+		offset += ret;
+	}
+	rx->start += offset;
+	rx->len -= offset;
+
+	return ret;
+}
+
+/* Packets mixed with filler. */
+static GByteArray *make_stream(const struct protocol *p)
+{
+	GByteArray *stream;
+	GRand *rand;
+	uint8_t buf[64], c;
+	size_t size;
+	int i, j, filler;
+
+	rand = g_rand_new_with_seed(STREAM_SEED);
+	stream = g_byte_array_new();
+	for (i = 0; i < NUM_PACKETS; i++) {
+		filler = g_rand_int_range(rand, 0, 4) ? 0 :
+			g_rand_int_range(rand, 1, 32);
+		for (j = 0; j < filler; j++) {
+			do {
+				c = g_rand_int_range(rand, 0, 256);
+			} while (!p->is_filler(c));
+			g_byte_array_append(stream, &c, 1);
+		}
+		size = p->make_packet(buf, rand);
+		g_byte_array_append(stream, buf, size);
+	}
+	g_rand_free(rand);
+
+	return stream;
+}
+
+static void bench_stream(const char *name, const struct sr_framing *framing,
+		const GByteArray *stream)
+{
+	struct rx rx;
+	const uint8_t *pkt;
+	int64_t start, end;
+	uint64_t bytes, packets;
+	size_t pos, chunk;
+
+	memset(&rx, 0, sizeof(rx));
+	bytes = packets = 0;
+	start = g_get_monotonic_time();
+	do {
+		for (pos = 0; pos < stream->len; pos += chunk) {
+			chunk = MIN(MAX_CHUNK_SIZE, stream->len - pos);
+			rx_feed(&rx, stream->data + pos, chunk);
+			while (rx_frame(&rx, framing, &pkt) > 0)
+				packets++;
+		}
+		bytes += stream->len;
+		end = g_get_monotonic_time();
+	} while (end - start < duration_us);
+
+	printf("framing.%s %.1f MB/s\n", name, rate(bytes, end - start));
+	printf("framing.%s.packets %.2f Mpackets/s\n", name,
+		rate(packets, end - start));
+}
+
+static int run_protocol(const struct protocol *p)
+{
+	GByteArray *stream;
+	gchar *contents;
+	gsize len;
+	GError *error;
+
+	if (stream_file) {
+		error = NULL;
+		if (!g_file_get_contents(stream_file, &contents, &len, &error)) {
+			fprintf(stderr, "%s\n", error->message);
+			g_error_free(error);
+			return 1;
+		}
+		stream = g_byte_array_new_take((guint8 *)contents, len);
+		bench_stream(p->name, p->framing, stream);
+		g_byte_array_free(stream, TRUE);
+		return 0;
+	}
+
+	stream = make_stream(p);
+	bench_stream(p->name, p->framing, stream);
+	g_byte_array_free(stream, TRUE);
+
+	return 0;
+}
+
+static void usage(const char *argv0)
+{
+	unsigned int i;
+
+	fprintf(stderr, "Usage: %s [-t <milliseconds>] [-f <file>] "
+		"[<protocol>...]\nProtocols:", argv0);
+	for (i = 0; i < ARRAY_SIZE(protocols); i++)
+		fprintf(stderr, " %s", protocols[i].name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int i;
+	int opt, arg, found, ret;
+
+	while ((opt = getopt(argc, argv, "t:f:")) != -1) {
+		switch (opt) {
+		case 't':
+			duration_us = strtoll(optarg, NULL, 10) * 1000;
+			break;
+		case 'f':
+			stream_file = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (duration_us <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	for (arg = optind; arg < argc; arg++) {
+		for (i = 0, found = 0; i < ARRAY_SIZE(protocols); i++)
+			found |= !strcmp(argv[arg], protocols[i].name);
+		if (!found) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	ret = 0;
+	for (i = 0; i < ARRAY_SIZE(protocols); i++) {
+		if (optind < argc) {
+			for (arg = optind, found = 0; arg < argc; arg++)
+				found |= !strcmp(argv[arg], protocols[i].name);
+			if (!found)
+				continue;
+		}
+		ret |= run_protocol(&protocols[i]);
+	}
+
+	return ret;
+}
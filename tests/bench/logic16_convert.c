@@ -0,0 +1,273 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Test and benchmark harness for the Saleae Logic16 sample converter.
+ *
+ * Without arguments, pseudo-random FPGA data is converted for every
+ * channel count (using both the lowest and the highest channels), split
+ * into transfers of varying odd sizes, and compared bit for bit against
+ * a straightforward reference implementation. The conversion rate of
+ * both is then measured for 3 and 16 channels.
+ *
+ * Recorded transfer buffers can be checked as well:
+ *
+ *   logic16_convert -m <channel mask> <file>...
+ *
+ * Each file holds the raw data of consecutive bulk transfers.
+ *
+ * Results are printed one per line as "<name> <value> <unit>".
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "hardware/saleae-logic16/convert.h"
+
+#define TEST_WORDS	(16 * 1024 + 5)
+#define BENCH_BYTES	(64 * 1024 * 1024)
+#define TRANSFER_SIZE	(16 * 1024)
+
+struct reference {
+	int num_channels;
+	int cur_channel;
+	uint16_t channel_masks[16];
+	uint16_t channel_data[16];
+};
+
+/* The original bit by bit conversion, producing little endian samples. */
+static size_t reference_convert(struct reference *ref, uint8_t *dest,
+		const uint8_t *src, size_t srccnt)
+{
+	uint16_t sample, channel_mask;
+	size_t ret = 0;
+	int i;
+
+	for (srccnt /= 2; srccnt; srccnt--, src += 2) {
+		sample = src[0] | (src[1] << 8);
+		channel_mask = ref->channel_masks[ref->cur_channel];
+
+		for (i = 15; i >= 0; --i, sample >>= 1)
+			if (sample & 1)
+				ref->channel_data[i] |= channel_mask;
+
+		if (++ref->cur_channel == ref->num_channels) {
+			ref->cur_channel = 0;
+			for (i = 0; i < 16; i++) {
+				*dest++ = ref->channel_data[i] & 0xff;
+				*dest++ = ref->channel_data[i] >> 8;
+			}
+			memset(ref->channel_data, 0, sizeof(ref->channel_data));
+			ret += 16;
+		}
+	}
+
+	return ret;
+}
+
+static int masks_from_bits(uint16_t bits, uint16_t *masks)
+{
+	int i, n;
+
+	for (i = n = 0; i < 16; i++)
+		if (bits & (1 << i))
+			masks[n++] = 1 << i;
+
+	return n;
+}
+
+static void fill_random(uint8_t *buf, size_t len, uint32_t seed)
+{
+	uint32_t x;
+	size_t i;
+
+	x = seed ? seed : 1;
+	for (i = 0; i < len; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		buf[i] = x >> 24;
+	}
+}
+
+/*
+ * Convert the data with both implementations, in transfers of the
+ * given sizes (cycled through), and compare the results.
+ */
+static int compare(uint16_t bits, const uint8_t *data, size_t len,
+		const size_t *sizes, int num_sizes)
+{
+	struct logic16_converter conv;
+	struct reference ref;
+	uint8_t *out, *ref_out;
+	size_t pos, chunk, n, ref_n, total;
+	int i, ret;
+
+	memset(&ref, 0, sizeof(ref));
+	ref.num_channels = masks_from_bits(bits, ref.channel_masks);
+	logic16_converter_init(&conv, ref.channel_masks, ref.num_channels);
+
+	out = g_malloc(len * 16 + 32);
+	ref_out = g_malloc(len * 16 + 32);
+	ret = 0;
+
+	for (pos = total = 0, i = 0; pos < len; pos += chunk, i++) {
+		chunk = MIN(sizes[i % num_sizes], len - pos);
+		n = logic16_convert(&conv, out + total * 2, data + pos, chunk);
+		ref_n = reference_convert(&ref, ref_out + total * 2,
+				data + pos, chunk);
+		if (n != ref_n) {
+			printf("Sample count mismatch for mask 0x%04x at "
+				"offset %zu: %zu != %zu.\n", bits, pos, n, ref_n);
+			ret = 1;
+			break;
+		}
+		total += n;
+	}
+
+	if (!ret && memcmp(out, ref_out, total * 2)) {
+		printf("Sample data mismatch for mask 0x%04x.\n", bits);
+		ret = 1;
+	}
+
+	g_free(out);
+	g_free(ref_out);
+
+	return ret;
+}
+
+static int run_tests(void)
+{
+	static const size_t sizes[] = { 2, 30, 512, 6, 1022, 16384, 34 };
+	uint8_t *data;
+	size_t len;
+	int n, ret;
+
+	len = TEST_WORDS * 2;
+	data = g_malloc(len);
+	fill_random(data, len, 0x4c313621);
+	ret = 0;
+
+	for (n = 1; n <= 16; n++) {
+		/* Lowest n channels, and highest n channels. */
+		ret |= compare((1 << n) - 1, data, len,
+				sizes, G_N_ELEMENTS(sizes));
+		ret |= compare(((1 << n) - 1) << (16 - n), data, len,
+				sizes, G_N_ELEMENTS(sizes));
+	}
+	/* A sparse selection spanning both output bytes. */
+	ret |= compare(0x8421, data, len, sizes, G_N_ELEMENTS(sizes));
+
+	g_free(data);
+
+	printf("logic16_convert.test %s\n", ret ? "fail" : "pass");
+
+	return ret;
+}
+
+static void run_bench(uint16_t bits)
+{
+	struct logic16_converter conv;
+	struct reference ref;
+	uint8_t *data, *out;
+	size_t pos, samples;
+	gint64 start, conv_time, ref_time;
+
+	data = g_malloc(BENCH_BYTES);
+	out = g_malloc(TRANSFER_SIZE * 16 + 32);
+	fill_random(data, BENCH_BYTES, 0x1234);
+
+	memset(&ref, 0, sizeof(ref));
+	ref.num_channels = masks_from_bits(bits, ref.channel_masks);
+	logic16_converter_init(&conv, ref.channel_masks, ref.num_channels);
+
+	samples = 0;
+	start = g_get_monotonic_time();
+	for (pos = 0; pos < BENCH_BYTES; pos += TRANSFER_SIZE)
+		samples += logic16_convert(&conv, out, data + pos,
+				TRANSFER_SIZE);
+	conv_time = g_get_monotonic_time() - start;
+
+	start = g_get_monotonic_time();
+	for (pos = 0; pos < BENCH_BYTES; pos += TRANSFER_SIZE)
+		reference_convert(&ref, out, data + pos, TRANSFER_SIZE);
+	ref_time = g_get_monotonic_time() - start;
+
+	printf("logic16_convert.table.%dch %.1f MS/s\n", ref.num_channels,
+		(double)samples / MAX(conv_time, 1));
+	printf("logic16_convert.reference.%dch %.1f MS/s\n", ref.num_channels,
+		(double)samples / MAX(ref_time, 1));
+
+	g_free(data);
+	g_free(out);
+}
+
+static int check_file(uint16_t bits, const char *filename)
+{
+	static const size_t sizes[] = { TRANSFER_SIZE };
+	GError *error = NULL;
+	gchar *data;
+	gsize len;
+	int ret;
+
+	if (!g_file_get_contents(filename, &data, &len, &error)) {
+		printf("Failed to read %s: %s\n", filename, error->message);
+		g_error_free(error);
+		return 1;
+	}
+
+	ret = compare(bits, (const uint8_t *)data, len, sizes, 1);
+	printf("logic16_convert.file %s %s\n", filename,
+		ret ? "fail" : "pass");
+	g_free(data);
+
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long bits;
+	int i, ret;
+
+	if (argc > 1) {
+		if (argc < 4 || strcmp(argv[1], "-m")) {
+			fprintf(stderr, "Usage: %s [-m <channel mask> "
+				"<file>...]\n", argv[0]);
+			return 1;
+		}
+		bits = strtoul(argv[2], NULL, 0);
+		if (!bits || bits > 0xffff) {
+			fprintf(stderr, "Invalid channel mask.\n");
+			return 1;
+		}
+		for (i = 3, ret = 0; i < argc; i++)
+			ret |= check_file(bits, argv[i]);
+		return ret;
+	}
+
+	if ((ret = run_tests()))
+		return ret;
+
+	run_bench(0x0007);
+	run_bench(0xffff);
+
+	return 0;
+}
@@ -0,0 +1,298 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Test and benchmark harness for batched SCPI queries, against an
+ * emulated Hameg HMO2024 on a local TCP port.
+ *
+ *   scpi_batch [-t <milliseconds>] [-l <latency us>]
+ *   scpi_batch -p <port> [-l <latency us>]
+ *
+ * Without -p, the hameg-hmo state refresh is checked against the
+ * emulator, then timed with batching and with one query at a time.
+ * The latency (default 200 us) is added to every answer of the
+ * emulator, as a stand-in for the network and instrument turnaround.
+ *
+ * With -p, the emulator just serves the given port until interrupted,
+ * for use with e.g. "sigrok-cli -d hameg-hmo:conn=tcp-raw/127.0.0.1/<port>".
+ *
+ * Results are printed one per line as "<name> <value> <unit>".
+ */
+
+#include <config.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "scpi.h"
+#include "hardware/hameg-hmo/protocol.h"
+#include "../scpi_emulator.h"
+
+#define DEFAULT_LATENCY_US 200
+
+static const struct scpi_emulator_setting hmo2024[] = {
+	{ "*IDN", "HAMEG,HMO2024,012345678,05.886" },
+	{ ":CHAN1:STAT", "1" },
+	{ ":CHAN1:SCAL", "1.0E+00" },
+	{ ":CHAN1:POS", "0.0E+00" },
+	{ ":CHAN1:COUP", "DCL" },
+	{ ":CHAN2:STAT", "1" },
+	{ ":CHAN2:SCAL", "5.0E-01" },
+	{ ":CHAN2:POS", "-1.5E+00" },
+	{ ":CHAN2:COUP", "ACL" },
+	{ ":CHAN3:STAT", "0" },
+	{ ":CHAN3:SCAL", "2.0E-01" },
+	{ ":CHAN3:POS", "2.0E+00" },
+	{ ":CHAN3:COUP", "DC" },
+	{ ":CHAN4:STAT", "0" },
+	{ ":CHAN4:SCAL", "1.0E-02" },
+	{ ":CHAN4:POS", "0.0E+00" },
+	{ ":CHAN4:COUP", "GND" },
+	{ ":LOG0:STAT", "1" },
+	{ ":LOG1:STAT", "0" },
+	{ ":LOG2:STAT", "1" },
+	{ ":LOG3:STAT", "0" },
+	{ ":LOG4:STAT", "0" },
+	{ ":LOG5:STAT", "0" },
+	{ ":LOG6:STAT", "0" },
+	{ ":LOG7:STAT", "1" },
+	{ ":POD1:STAT", "1" },
+	{ ":TIM:SCAL", "1.0E-03" },
+	{ ":TIM:POS", "0.0E+00" },
+	{ ":TRIG:A:SOUR", "CH2" },
+	{ ":TRIG:A:EDGE:SLOP", "NEG" },
+	{ ":ACQ:SRAT", "1.0E+09" },
+	{ ":CHAN1:DATA:POINTS", "24000" },
+	{ NULL, NULL },
+};
+
+static struct sr_context *ctx;
+static gint64 duration_us = 500 * 1000;
+
+static struct sr_dev_inst *hmo_open(const char *resource)
+{
+	struct sr_dev_driver **drivers, *driver;
+	struct sr_dev_inst *sdi;
+	GSList *options, *devices;
+	int i;
+
+	drivers = sr_driver_list(ctx);
+	for (driver = NULL, i = 0; drivers[i]; i++)
+		if (!strcmp(drivers[i]->name, "hameg-hmo"))
+			driver = drivers[i];
+	if (!driver || sr_driver_init(ctx, driver) != SR_OK)
+		return NULL;
+
+	options = g_slist_append(NULL, sr_config_new(SR_CONF_CONN,
+			g_variant_new_string(resource)));
+	devices = sr_driver_scan(driver, options);
+	g_slist_free_full(options, (GDestroyNotify)sr_config_free);
+	if (!devices)
+		return NULL;
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	if (sr_dev_open(sdi) != SR_OK)
+		return NULL;
+
+	return sdi;
+}
+
+static int states_equal(const struct scope_config *config,
+		const struct scope_state *a, const struct scope_state *b)
+{
+	return !memcmp(a->analog_channels, b->analog_channels,
+			config->analog_channels * sizeof(*a->analog_channels)) &&
+		!memcmp(a->digital_channels, b->digital_channels,
+			config->digital_channels * sizeof(gboolean)) &&
+		!memcmp(a->digital_pods, b->digital_pods,
+			config->digital_pods * sizeof(gboolean)) &&
+		a->timebase == b->timebase &&
+		a->horiz_triggerpos == b->horiz_triggerpos &&
+		a->trigger_source == b->trigger_source &&
+		a->trigger_slope == b->trigger_slope &&
+		a->sample_rate == b->sample_rate;
+}
+
+static int test_hmo(struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	const struct scope_config *config;
+	struct scope_state *state, batched;
+	struct sr_scpi_dev_inst *scpi;
+	int ret;
+
+	devc = sdi->priv;
+	config = devc->model_config;
+	state = devc->model_state;
+	scpi = sdi->conn;
+
+	/* The state was fetched in batches when opening the device. */
+	batched = *state;
+	batched.analog_channels = g_memdup(state->analog_channels,
+			config->analog_channels * sizeof(*state->analog_channels));
+	batched.digital_channels = g_memdup(state->digital_channels,
+			config->digital_channels * sizeof(gboolean));
+	batched.digital_pods = g_memdup(state->digital_pods,
+			config->digital_pods * sizeof(gboolean));
+
+	memset(state->analog_channels, 0,
+			config->analog_channels * sizeof(*state->analog_channels));
+	scpi->no_batch = TRUE;
+	ret = hmo_scope_state_get(sdi) != SR_OK ||
+		!states_equal(config, state, &batched) ||
+		state->analog_channels[1].coupling != 1 ||
+		state->analog_channels[1].vertical_offset != -1.5 ||
+		!state->digital_channels[7] || state->trigger_source != 1 ||
+		state->trigger_slope != 1;
+	scpi->no_batch = FALSE;
+	if (ret)
+		printf("hameg-hmo state mismatch.\n");
+
+	g_free(batched.analog_channels);
+	g_free(batched.digital_channels);
+	g_free(batched.digital_pods);
+
+	return ret;
+}
+
+static void bench_hmo(struct scpi_emulator *emu, struct sr_dev_inst *sdi,
+		gboolean batch)
+{
+	struct sr_scpi_dev_inst *scpi;
+	struct scpi_emulator_stats stats;
+	gint64 start, elapsed;
+	uint64_t refreshes;
+
+	scpi = sdi->conn;
+	scpi->no_batch = !batch;
+	scpi_emulator_reset_stats(emu);
+
+	refreshes = 0;
+	start = g_get_monotonic_time();
+	do {
+		if (hmo_scope_state_get(sdi) != SR_OK)
+			break;
+		refreshes++;
+		elapsed = g_get_monotonic_time() - start;
+	} while (elapsed < duration_us);
+
+	scpi_emulator_get_stats(emu, &stats);
+	scpi->no_batch = FALSE;
+	if (!refreshes)
+		return;
+
+	printf("scpi_batch.hmo_state.%s %.2f ms\n",
+		batch ? "batched" : "sequential",
+		elapsed / 1000.0 / refreshes);
+	printf("scpi_batch.hmo_state.%s.messages %.1f messages\n",
+		batch ? "batched" : "sequential",
+		(double)stats.messages / refreshes);
+}
+
+static int run(unsigned int latency_us)
+{
+	struct scpi_emulator *emu;
+	struct sr_dev_inst *sdi;
+	char *resource;
+	int ret;
+
+	if (!(emu = scpi_emulator_start(0, hmo2024, latency_us)))
+		return 1;
+	resource = g_strdup_printf("tcp-raw/127.0.0.1/%d",
+			scpi_emulator_port(emu));
+
+	if (!(sdi = hmo_open(resource))) {
+		printf("Failed to open the emulated HMO2024.\n");
+		ret = 1;
+	} else {
+		ret = test_hmo(sdi);
+	}
+	printf("scpi_batch.test %s\n", ret ? "fail" : "pass");
+
+	if (!ret) {
+		bench_hmo(emu, sdi, FALSE);
+		bench_hmo(emu, sdi, TRUE);
+	}
+	if (sdi)
+		sr_dev_close(sdi);
+
+	g_free(resource);
+	scpi_emulator_stop(emu);
+
+	return ret;
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr, "Usage: %s [-t <milliseconds>] [-l <latency us>]\n"
+		"       %s -p <port> [-l <latency us>]\n", argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	struct scpi_emulator *emu;
+	unsigned int latency_us;
+	int opt, port, ret;
+
+	latency_us = DEFAULT_LATENCY_US;
+	port = 0;
+	while ((opt = getopt(argc, argv, "t:l:p:")) != -1) {
+		switch (opt) {
+		case 't':
+			duration_us = strtoll(optarg, NULL, 10) * 1000;
+			break;
+		case 'l':
+			latency_us = strtoul(optarg, NULL, 10);
+			break;
+		case 'p':
+			port = strtol(optarg, NULL, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (duration_us <= 0 || port < 0 || optind < argc) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (port) {
+		if (!(emu = scpi_emulator_start(port, hmo2024, latency_us)))
+			return 1;
+		printf("Emulating a HMO2024 on tcp-raw/127.0.0.1/%d.\n", port);
+		for (;;)
+			pause();
+	}
+
+	if (sr_init(&ctx) != SR_OK)
+		return 1;
+	sr_log_loglevel_set(SR_LOG_WARN);
+
+	ret = run(latency_us);
+
+	sr_exit(ctx);
+
+	return ret;
+}
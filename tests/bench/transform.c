@@ -0,0 +1,654 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks and benchmarks of the transform modules.
+ *
+ *   transform [-t <milliseconds>] [<benchmark>...]
+ *
+ * First the element-wise kernels are checked against plain loops, for
+ * all lengths and alignments around the vector width, and the scale
+ * transform against sr_analog_to_float(), both where it folds the
+ * factor into the encoding and where it has to scale the data, and
+ * fused transforms against running them one by one. Then, without
+ * arguments, all benchmarks are run:
+ *
+ *   nop     packet rate of the nop transform, for the call overhead
+ *   scale   scale transform on encoded (folded) and float (data) packets
+ *   invert  invert transform on logic and float packets
+ *   chain   three fused transforms on float packets
+ *
+ * The data rates are also measured for the per-sample loops the
+ * transforms used before, and for running the chained transforms one
+ * by one, as "<name>.reference". Each measurement runs
+ * for about the given time (default 500 ms).
+ *
+ * Results are printed one per line as "<name> <value> <unit>".
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <float.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+#define LOG_PREFIX "bench"
+
+#define PACKET_SAMPLES		4096
+#define LOGIC_UNITSIZE		2
+/* Lengths checked, covering several vector widths plus tails. */
+#define CHECK_MAX_LEN		80
+#define CHECK_MAX_ALIGN		4
+
+struct bench {
+	const char *name;
+	void (*run)(void);
+};
+
+static struct sr_context *ctx;
+static struct sr_session *session;
+static struct sr_dev_inst *sdi;
+static struct sr_channel *analog_ch;
+static int64_t duration_us = 500 * 1000;
+
+static double rate(uint64_t count, int64_t elapsed_us)
+{
+	return (double)count / MAX(elapsed_us, 1);
+}
+
+static void fill_random(uint8_t *buf, size_t len, uint32_t seed)
+{
+	uint32_t x;
+	size_t i;
+
+	x = seed ? seed : 1;
+	for (i = 0; i < len; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		buf[i] = x >> 24;
+	}
+}
+
+static void fill_floats(float *buf, size_t len)
+{
+	size_t i;
+
+	/* Away from zero, so reciprocals stay finite. */
+	for (i = 0; i < len; i++)
+		buf[i] = (i & 1 ? -1 : 1) * (1.5f + sinf(i * 0.1f));
+}
+
+static const struct sr_transform *transform_new(const char *id,
+		int64_t p, uint64_t q)
+{
+	const struct sr_transform *t;
+	GHashTable *options;
+
+	options = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+			(GDestroyNotify)g_variant_unref);
+	if (!strcmp(id, "scale"))
+		g_hash_table_insert(options, g_strdup("factor"),
+			g_variant_ref_sink(g_variant_new("(xt)", p, q)));
+	t = sr_transform_new(sr_transform_find(id), options, sdi);
+	g_hash_table_destroy(options);
+
+	return t;
+}
+
+/* The scale transform's loop before the kernels. */
+static void scale_reference(struct sr_datafeed_analog_old *analog_old,
+		float factor)
+{
+	float *fdata;
+	GSList *l;
+	int i, c, num_channels;
+
+	fdata = analog_old->data;
+	num_channels = g_slist_length(analog_old->channels);
+	for (i = 0; i < analog_old->num_samples; i++)
+		for (l = analog_old->channels, c = 0; l; l = l->next, c++)
+			fdata[i * num_channels + c] *= factor;
+}
+
+/* The invert transform's loop before the kernels. */
+static void invert_reference(struct sr_datafeed_logic *logic)
+{
+	uint64_t i, j;
+	uint8_t *b;
+
+	for (i = 0; i <= logic->length - logic->unitsize; i += logic->unitsize) {
+		for (j = 0; j < logic->unitsize; j++) {
+			b = (uint8_t *)logic->data + i + logic->unitsize - 1 - j;
+			*b = ~(*b);
+		}
+	}
+}
+
+static int check_kernels(void)
+{
+	float fin[CHECK_MAX_LEN + CHECK_MAX_ALIGN];
+	float fout[CHECK_MAX_LEN + CHECK_MAX_ALIGN];
+	uint8_t bin[CHECK_MAX_LEN + CHECK_MAX_ALIGN];
+	uint8_t bout[CHECK_MAX_LEN + CHECK_MAX_ALIGN];
+	size_t len, align, i;
+
+	fill_floats(fin, G_N_ELEMENTS(fin));
+	fill_random(bin, sizeof(bin), 1);
+
+	for (len = 0; len <= CHECK_MAX_LEN; len++) {
+		for (align = 0; align < CHECK_MAX_ALIGN; align++) {
+			memcpy(fout, fin, sizeof(fout));
+			sr_transform_float_affine(fout + align, len, -2.5f, 0.25f);
+			for (i = 0; i < G_N_ELEMENTS(fout); i++) {
+				if (i >= align && i < align + len ?
+						fabsf(fout[i] - (fin[i] * -2.5f + 0.25f))
+						> 1e-5f : fout[i] != fin[i]) {
+					fprintf(stderr, "affine: Wrong at %zu, "
+						"length %zu.\n", i, len);
+					return 1;
+				}
+			}
+
+			memcpy(fout, fin, sizeof(fout));
+			sr_transform_float_reciprocal(fout + align, len);
+			for (i = 0; i < G_N_ELEMENTS(fout); i++) {
+				if (i >= align && i < align + len ?
+						fout[i] != 1.0f / fin[i] :
+						fout[i] != fin[i]) {
+					fprintf(stderr, "reciprocal: Wrong at "
+						"%zu, length %zu.\n", i, len);
+					return 1;
+				}
+			}
+
+			memcpy(bout, bin, sizeof(bout));
+			sr_transform_bytes_invert(bout + align, len);
+			for (i = 0; i < sizeof(bout); i++) {
+				if (bout[i] != (i >= align && i < align + len ?
+						(uint8_t)~bin[i] : bin[i])) {
+					fprintf(stderr, "invert: Wrong at %zu, "
+						"length %zu.\n", i, len);
+					return 1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Scale a packet with the given encoding, and compare its values. */
+static int check_scale_encoding(const char *name, int64_t p, uint64_t q,
+		int unitsize, gboolean is_float, struct sr_rational scale,
+		struct sr_rational offset)
+{
+	const struct sr_transform *t;
+	struct sr_datafeed_packet packet, *out;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	union {
+		int16_t i[PACKET_SAMPLES];
+		float f[PACKET_SAMPLES];
+	} data;
+	float before[PACKET_SAMPLES], after[PACKET_SAMPLES], factor;
+	unsigned int i;
+	int ret;
+
+	sr_analog_init(&analog, &encoding, &meaning, &spec, 3);
+	encoding.unitsize = unitsize;
+	encoding.is_float = is_float;
+	encoding.is_signed = !is_float;
+	encoding.scale = scale;
+	encoding.offset = offset;
+	/* Two channels' worth of samples, all of which must be scaled. */
+	meaning.channels = g_slist_append(NULL, analog_ch);
+	meaning.channels = g_slist_append(meaning.channels, analog_ch);
+	analog.data = &data;
+	analog.num_samples = PACKET_SAMPLES / 2;
+	if (is_float)
+		fill_floats(data.f, PACKET_SAMPLES);
+	else
+		fill_random((uint8_t *)data.i, sizeof(data.i), 2);
+	packet.type = SR_DF_ANALOG;
+	packet.payload = &analog;
+	sr_analog_to_float(&analog, before);
+
+	t = transform_new("scale", p, q);
+	ret = t->module->receive(t, &packet, &out);
+	sr_transform_free(t);
+	if (ret == SR_OK)
+		ret = sr_analog_to_float(&analog, after);
+	g_slist_free(meaning.channels);
+	if (ret != SR_OK) {
+		fprintf(stderr, "scale: %s failed.\n", name);
+		return 1;
+	}
+
+	factor = (float)p / q;
+	for (i = 0; i < PACKET_SAMPLES; i++) {
+		if (fabsf(after[i] - before[i] * factor)
+				> 1e-4f * fabsf(before[i] * factor) + FLT_MIN) {
+			fprintf(stderr, "scale: %s: %g * %g is not %g.\n",
+				name, before[i], factor, after[i]);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int check_scale(void)
+{
+	const struct sr_rational one = { 1, 1 }, zero = { 0, 1 };
+	const struct sr_rational milli = { 1, 1000 }, offset = { -7, 2 };
+	/* The largest 64-bit prime, which no factor can be cancelled with. */
+	const struct sr_rational coarse = { 1, 18446744073709551557ULL };
+
+	return check_scale_encoding("int16", 3, 7, 2, FALSE, milli, zero)
+		|| check_scale_encoding("int16.offset", -5, 4, 2, FALSE,
+			milli, offset)
+		|| check_scale_encoding("float", 3, 7, 4, TRUE, one, zero)
+		|| check_scale_encoding("float.offset", 3, 7, 4, TRUE,
+			one, offset)
+		|| check_scale_encoding("float.data", 1, 3, 4, TRUE,
+			coarse, zero);
+}
+
+static int check_invert(void)
+{
+	const struct sr_transform *t;
+	struct sr_datafeed_packet packet, *out;
+	struct sr_datafeed_logic logic;
+	uint8_t data[2 * 64 + 1], expect[sizeof(data)];
+	size_t len;
+
+	t = transform_new("invert", 0, 0);
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &logic;
+	logic.unitsize = LOGIC_UNITSIZE;
+	/* Short packets, and partial samples, which are left alone. */
+	for (len = 0; len <= sizeof(data); len++) {
+		fill_random(expect, sizeof(expect), len + 3);
+		memcpy(data, expect, sizeof(data));
+		logic.data = expect;
+		logic.length = len;
+		if (len >= LOGIC_UNITSIZE)
+			invert_reference(&logic);
+		logic.data = data;
+		t->module->receive(t, &packet, &out);
+		if (memcmp(data, expect, sizeof(data))) {
+			fprintf(stderr, "invert: Wrong at length %zu.\n", len);
+			sr_transform_free(t);
+			return 1;
+		}
+	}
+	sr_transform_free(t);
+
+	return 0;
+}
+
+static void bench_nop(void)
+{
+	const struct sr_transform *t;
+	struct sr_datafeed_packet packet, *out;
+	int64_t start, end;
+	uint64_t packets;
+	unsigned int i;
+
+	t = transform_new("nop", 0, 0);
+	packet.type = SR_DF_TRIGGER;
+	packet.payload = NULL;
+	packets = 0;
+	start = g_get_monotonic_time();
+	do {
+		for (i = 0; i < 1024; i++)
+			t->module->receive(t, &packet, &out);
+		packets += i;
+		end = g_get_monotonic_time();
+	} while (end - start < duration_us);
+	sr_transform_free(t);
+
+	printf("transform.nop %.2f Mpackets/s\n", rate(packets, end - start));
+}
+
+static void bench_scale(void)
+{
+	const struct sr_transform *t;
+	struct sr_datafeed_packet packet, *out;
+	struct sr_datafeed_analog analog;
+	struct sr_datafeed_analog_old analog_old;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	static float data[PACKET_SAMPLES];
+	int64_t start, end;
+	uint64_t bytes;
+
+	/* 16 bit encoded samples, where the factor goes into the encoding. */
+	sr_analog_init(&analog, &encoding, &meaning, &spec, 3);
+	encoding.unitsize = 2;
+	encoding.is_float = FALSE;
+	analog.data = data;
+	analog.num_samples = PACKET_SAMPLES;
+	packet.type = SR_DF_ANALOG;
+	packet.payload = &analog;
+	t = transform_new("scale", 3, 7);
+	bytes = 0;
+	start = g_get_monotonic_time();
+	do {
+		/* As if every packet came with its own encoding. */
+		encoding.scale.p = encoding.scale.q = 1;
+		t->module->receive(t, &packet, &out);
+		bytes += PACKET_SAMPLES * 2;
+		end = g_get_monotonic_time();
+	} while (end - start < duration_us);
+	sr_transform_free(t);
+	printf("transform.scale.fold %.1f MB/s\n", rate(bytes, end - start));
+
+	/* Float samples, scaled in place. A factor of -1 keeps them sane. */
+	fill_floats(data, PACKET_SAMPLES);
+	analog_old.channels = g_slist_append(NULL, analog_ch);
+	analog_old.num_samples = PACKET_SAMPLES;
+	analog_old.data = data;
+	packet.type = SR_DF_ANALOG_OLD;
+	packet.payload = &analog_old;
+	t = transform_new("scale", -1, 1);
+	bytes = 0;
+	start = g_get_monotonic_time();
+	do {
+		t->module->receive(t, &packet, &out);
+		bytes += sizeof(data);
+		end = g_get_monotonic_time();
+	} while (end - start < duration_us);
+	sr_transform_free(t);
+	printf("transform.scale.data %.1f MB/s\n", rate(bytes, end - start));
+
+	bytes = 0;
+	start = g_get_monotonic_time();
+	do {
+		scale_reference(&analog_old, -1);
+		bytes += sizeof(data);
+		end = g_get_monotonic_time();
+	} while (end - start < duration_us);
+	g_slist_free(analog_old.channels);
+	printf("transform.scale.data.reference %.1f MB/s\n",
+		rate(bytes, end - start));
+}
+
+static void bench_invert(void)
+{
+	const struct sr_transform *t;
+	struct sr_datafeed_packet packet, *out;
+	struct sr_datafeed_logic logic;
+	struct sr_datafeed_analog_old analog_old;
+	static uint8_t data[PACKET_SAMPLES * LOGIC_UNITSIZE];
+	static float fdata[PACKET_SAMPLES];
+	int64_t start, end;
+	uint64_t bytes;
+
+	fill_random(data, sizeof(data), 4);
+	logic.length = sizeof(data);
+	logic.unitsize = LOGIC_UNITSIZE;
+	logic.data = data;
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &logic;
+	t = transform_new("invert", 0, 0);
+	bytes = 0;
+	start = g_get_monotonic_time();
+	do {
+		t->module->receive(t, &packet, &out);
+		bytes += sizeof(data);
+		end = g_get_monotonic_time();
+	} while (end - start < duration_us);
+	printf("transform.invert.logic %.1f MB/s\n", rate(bytes, end - start));
+
+	bytes = 0;
+	start = g_get_monotonic_time();
+	do {
+		invert_reference(&logic);
+		bytes += sizeof(data);
+		end = g_get_monotonic_time();
+	} while (end - start < duration_us);
+	printf("transform.invert.logic.reference %.1f MB/s\n",
+		rate(bytes, end - start));
+
+	fill_floats(fdata, PACKET_SAMPLES);
+	analog_old.channels = g_slist_append(NULL, analog_ch);
+	analog_old.num_samples = PACKET_SAMPLES;
+	analog_old.data = fdata;
+	packet.type = SR_DF_ANALOG_OLD;
+	packet.payload = &analog_old;
+	bytes = 0;
+	start = g_get_monotonic_time();
+	do {
+		t->module->receive(t, &packet, &out);
+		bytes += sizeof(fdata);
+		end = g_get_monotonic_time();
+	} while (end - start < duration_us);
+	sr_transform_free(t);
+	g_slist_free(analog_old.channels);
+	printf("transform.invert.float %.1f MB/s\n", rate(bytes, end - start));
+}
+
+/* Scale by 2, invert and scale by 1/2, which maps x to 1/(4x). */
+static GSList *chain_transforms(void)
+{
+	GSList *transforms;
+
+	transforms = g_slist_append(NULL, (void *)transform_new("scale", 2, 1));
+	transforms = g_slist_append(transforms,
+			(void *)transform_new("invert", 0, 0));
+	transforms = g_slist_append(transforms,
+			(void *)transform_new("scale", 1, 2));
+
+	return transforms;
+}
+
+static void chain_free(GSList *transforms)
+{
+	GSList *l;
+
+	for (l = transforms; l; l = l->next)
+		sr_transform_free(l->data);
+	g_slist_free(transforms);
+}
+
+/* Run the transforms one by one, as without fusing. */
+static void chain_run_modules(GSList *transforms,
+		struct sr_datafeed_packet *packet)
+{
+	const struct sr_transform *t;
+	struct sr_datafeed_packet *out;
+	GSList *l;
+
+	for (l = transforms; l; l = l->next) {
+		t = l->data;
+		t->module->receive(t, packet, &out);
+	}
+}
+
+static int check_chain(void)
+{
+	GSList *transforms;
+	struct sr_transform_chain *chain;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_analog_old analog_old;
+	float fused[PACKET_SAMPLES + 3], modules[PACKET_SAMPLES + 3];
+	unsigned int i;
+	int ret;
+
+	transforms = chain_transforms();
+	chain = sr_transform_chain_new(transforms);
+	analog_old.channels = g_slist_append(NULL, analog_ch);
+	packet.type = SR_DF_ANALOG_OLD;
+	packet.payload = &analog_old;
+
+	/* Not a multiple of the block size. */
+	analog_old.num_samples = G_N_ELEMENTS(fused);
+	fill_floats(fused, G_N_ELEMENTS(fused));
+	memcpy(modules, fused, sizeof(modules));
+	analog_old.data = fused;
+	ret = chain ? sr_transform_chain_run(chain, &packet) : SR_ERR;
+	analog_old.data = modules;
+	chain_run_modules(transforms, &packet);
+
+	sr_transform_chain_free(chain);
+	chain_free(transforms);
+	g_slist_free(analog_old.channels);
+
+	if (ret != SR_OK) {
+		fprintf(stderr, "chain: Not fused.\n");
+		return 1;
+	}
+	for (i = 0; i < G_N_ELEMENTS(fused); i++) {
+		if (fabsf(fused[i] - modules[i]) > 1e-5f * fabsf(modules[i])) {
+			fprintf(stderr, "chain: Wrong at %u, %g instead of %g.\n",
+				i, fused[i], modules[i]);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static void bench_chain(void)
+{
+	GSList *transforms;
+	struct sr_transform_chain *chain;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_analog_old analog_old;
+	/* Larger than the caches, where each extra pass costs most. */
+	static float data[PACKET_SAMPLES * 1024];
+	int64_t start, end;
+	uint64_t bytes;
+
+	transforms = chain_transforms();
+	chain = sr_transform_chain_new(transforms);
+	fill_floats(data, G_N_ELEMENTS(data));
+	analog_old.channels = g_slist_append(NULL, analog_ch);
+	analog_old.num_samples = G_N_ELEMENTS(data);
+	analog_old.data = data;
+	packet.type = SR_DF_ANALOG_OLD;
+	packet.payload = &analog_old;
+
+	bytes = 0;
+	start = g_get_monotonic_time();
+	do {
+		sr_transform_chain_run(chain, &packet);
+		bytes += sizeof(data);
+		end = g_get_monotonic_time();
+	} while (end - start < duration_us);
+	printf("transform.chain.float %.1f MB/s\n", rate(bytes, end - start));
+
+	bytes = 0;
+	start = g_get_monotonic_time();
+	do {
+		chain_run_modules(transforms, &packet);
+		bytes += sizeof(data);
+		end = g_get_monotonic_time();
+	} while (end - start < duration_us);
+	printf("transform.chain.float.reference %.1f MB/s\n",
+		rate(bytes, end - start));
+
+	sr_transform_chain_free(chain);
+	chain_free(transforms);
+	g_slist_free(analog_old.channels);
+}
+
+static const struct bench benches[] = {
+	{ "nop", bench_nop },
+	{ "scale", bench_scale },
+	{ "invert", bench_invert },
+	{ "chain", bench_chain },
+};
+
+static void usage(const char *argv0)
+{
+	unsigned int i;
+
+	fprintf(stderr, "Usage: %s [-t <milliseconds>] [<benchmark>...]\n"
+		"Benchmarks:", argv0);
+	for (i = 0; i < G_N_ELEMENTS(benches); i++)
+		fprintf(stderr, " %s", benches[i].name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int i;
+	int opt, arg, found, ret;
+
+	while ((opt = getopt(argc, argv, "t:")) != -1) {
+		switch (opt) {
+		case 't':
+			duration_us = strtoll(optarg, NULL, 10) * 1000;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (duration_us <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	for (arg = optind; arg < argc; arg++) {
+		for (i = 0, found = 0; i < G_N_ELEMENTS(benches); i++)
+			found |= !strcmp(argv[arg], benches[i].name);
+		if (!found) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (sr_init(&ctx) != SR_OK)
+		return 1;
+	sr_session_new(ctx, &session);
+	sdi = sr_dev_inst_user_new("sigrok", "Benchmark", NULL);
+	sr_dev_inst_channel_add(sdi, 0, SR_CHANNEL_ANALOG, "A0");
+	analog_ch = sdi->channels->data;
+	sr_session_dev_add(session, sdi);
+
+	ret = check_kernels() || check_scale() || check_invert()
+		|| check_chain();
+
+	for (i = 0; !ret && i < G_N_ELEMENTS(benches); i++) {
+		if (optind < argc) {
+			for (arg = optind, found = 0; arg < argc; arg++)
+				found |= !strcmp(argv[arg], benches[i].name);
+			if (!found)
+				continue;
+		}
+		benches[i].run();
+	}
+
+	sr_session_destroy(session);
+	sr_dev_inst_free(sdi);
+	sr_exit(ctx);
+
+	return ret;
+}
@@ -0,0 +1,250 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Preload module recording the USB traffic of any libusb program, for
+ * later replay with tests/bench/usb_replay:
+ *
+ *   SR_USB_RECORD=capture.rec \
+ *   LD_PRELOAD=tests/bench/.libs/usb_record.so sigrok-cli ...
+ *
+ * Control transfers, synchronous bulk/interrupt transfers and the
+ * completion of every asynchronous transfer are written to the file
+ * named by SR_USB_RECORD, in the format described in usb_replay.h.
+ * Without SR_USB_RECORD, all calls are passed through unchanged.
+ */
+
+#define _GNU_SOURCE
+#include <config.h>
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libusb.h>
+#include "usb_replay.h"
+
+struct pending_transfer {
+	libusb_transfer_cb_fn callback;
+};
+
+static GMutex lock;
+static FILE *out;
+static int64_t start_time;
+/* Original callbacks of the submitted transfers, by transfer. */
+static GHashTable *pending;
+
+static int (*real_control_transfer)(libusb_device_handle *dev_handle,
+		uint8_t request_type, uint8_t bRequest, uint16_t wValue,
+		uint16_t wIndex, unsigned char *data, uint16_t wLength,
+		unsigned int timeout);
+static int (*real_bulk_transfer)(libusb_device_handle *dev_handle,
+		unsigned char endpoint, unsigned char *data, int length,
+		int *actual_length, unsigned int timeout);
+static int (*real_interrupt_transfer)(libusb_device_handle *dev_handle,
+		unsigned char endpoint, unsigned char *data, int length,
+		int *actual_length, unsigned int timeout);
+static int (*real_submit_transfer)(struct libusb_transfer *transfer);
+
+static void recorder_init(void)
+{
+	static gsize initialized = 0;
+	const char *filename;
+
+	if (!g_once_init_enter(&initialized))
+		return;
+
+	real_control_transfer = dlsym(RTLD_NEXT, "libusb_control_transfer");
+	real_bulk_transfer = dlsym(RTLD_NEXT, "libusb_bulk_transfer");
+	real_interrupt_transfer = dlsym(RTLD_NEXT, "libusb_interrupt_transfer");
+	real_submit_transfer = dlsym(RTLD_NEXT, "libusb_submit_transfer");
+
+	if ((filename = getenv("SR_USB_RECORD"))) {
+		if (!(out = fopen(filename, "wb")))
+			fprintf(stderr, "usb_record: Failed to open %s.\n",
+				filename);
+		else
+			fwrite(USB_RECORD_MAGIC, 1, USB_RECORD_MAGIC_LEN, out);
+	}
+	pending = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+			NULL, g_free);
+
+	g_once_init_leave(&initialized, 1);
+}
+
+static void __attribute__((destructor)) recorder_exit(void)
+{
+	g_mutex_lock(&lock);
+	if (out) {
+		fclose(out);
+		out = NULL;
+	}
+	g_mutex_unlock(&lock);
+}
+
+static void write_record(struct usb_record *rec)
+{
+	uint8_t header[USB_RECORD_HEADER_LEN];
+	int64_t now;
+
+	g_mutex_lock(&lock);
+	if (out) {
+		now = g_get_monotonic_time();
+		if (!start_time)
+			start_time = now;
+		rec->timestamp = now - start_time;
+		usb_record_header_pack(header, rec);
+		fwrite(header, 1, sizeof(header), out);
+		if (rec->actual_length)
+			fwrite(rec->data, 1, rec->actual_length, out);
+	}
+	g_mutex_unlock(&lock);
+}
+
+int LIBUSB_CALL libusb_control_transfer(libusb_device_handle *dev_handle,
+		uint8_t request_type, uint8_t bRequest, uint16_t wValue,
+		uint16_t wIndex, unsigned char *data, uint16_t wLength,
+		unsigned int timeout)
+{
+	struct usb_record rec;
+	int ret;
+
+	recorder_init();
+
+	ret = real_control_transfer(dev_handle, request_type, bRequest,
+			wValue, wIndex, data, wLength, timeout);
+
+	memset(&rec, 0, sizeof(rec));
+	rec.type = USB_RECORD_CONTROL;
+	rec.endpoint = request_type & LIBUSB_ENDPOINT_DIR_MASK;
+	rec.request_type = request_type;
+	rec.request = bRequest;
+	rec.value = wValue;
+	rec.index = wIndex;
+	rec.status = ret;
+	rec.length = wLength;
+	rec.actual_length = ret > 0 ? ret : 0;
+	rec.data = data;
+	write_record(&rec);
+
+	return ret;
+}
+
+static void record_sync(unsigned char endpoint, const unsigned char *data,
+		int length, int actual_length, int ret)
+{
+	struct usb_record rec;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.type = USB_RECORD_SYNC;
+	rec.endpoint = endpoint;
+	rec.status = ret;
+	rec.length = length;
+	rec.actual_length = actual_length;
+	rec.data = data;
+	write_record(&rec);
+}
+
+int LIBUSB_CALL libusb_bulk_transfer(libusb_device_handle *dev_handle,
+		unsigned char endpoint, unsigned char *data, int length,
+		int *actual_length, unsigned int timeout)
+{
+	int ret, transferred;
+
+	recorder_init();
+
+	transferred = 0;
+	ret = real_bulk_transfer(dev_handle, endpoint, data, length,
+			&transferred, timeout);
+	record_sync(endpoint, data, length, transferred, ret);
+	if (actual_length)
+		*actual_length = transferred;
+
+	return ret;
+}
+
+int LIBUSB_CALL libusb_interrupt_transfer(libusb_device_handle *dev_handle,
+		unsigned char endpoint, unsigned char *data, int length,
+		int *actual_length, unsigned int timeout)
+{
+	int ret, transferred;
+
+	recorder_init();
+
+	transferred = 0;
+	ret = real_interrupt_transfer(dev_handle, endpoint, data, length,
+			&transferred, timeout);
+	record_sync(endpoint, data, length, transferred, ret);
+	if (actual_length)
+		*actual_length = transferred;
+
+	return ret;
+}
+
+static void LIBUSB_CALL record_transfer(struct libusb_transfer *transfer)
+{
+	struct pending_transfer *p;
+	struct usb_record rec;
+	libusb_transfer_cb_fn callback;
+
+	g_mutex_lock(&lock);
+	p = g_hash_table_lookup(pending, transfer);
+	callback = p->callback;
+	g_hash_table_remove(pending, transfer);
+	g_mutex_unlock(&lock);
+
+	memset(&rec, 0, sizeof(rec));
+	rec.type = USB_RECORD_TRANSFER;
+	rec.endpoint = transfer->endpoint;
+	rec.status = transfer->status;
+	rec.length = transfer->length;
+	rec.actual_length = transfer->actual_length;
+	rec.data = transfer->buffer;
+	write_record(&rec);
+
+	/* The callback may resubmit or free the transfer. */
+	transfer->callback = callback;
+	callback(transfer);
+}
+
+int LIBUSB_CALL libusb_submit_transfer(struct libusb_transfer *transfer)
+{
+	struct pending_transfer *p;
+	int ret;
+
+	recorder_init();
+
+	if (!out || transfer->type == LIBUSB_TRANSFER_TYPE_ISOCHRONOUS)
+		return real_submit_transfer(transfer);
+
+	p = g_malloc(sizeof(*p));
+	p->callback = transfer->callback;
+	g_mutex_lock(&lock);
+	g_hash_table_insert(pending, transfer, p);
+	g_mutex_unlock(&lock);
+
+	transfer->callback = record_transfer;
+	if ((ret = real_submit_transfer(transfer)) != 0) {
+		transfer->callback = p->callback;
+		g_mutex_lock(&lock);
+		g_hash_table_remove(pending, transfer);
+		g_mutex_unlock(&lock);
+	}
+
+	return ret;
+}
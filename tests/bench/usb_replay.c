@@ -0,0 +1,569 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replay of recorded USB traffic, in place of libusb.
+ *
+ * The usb_replay benchmark links libsigrok statically, so the functions
+ * below take the place of libusb's transfer and event handling for the
+ * drivers. Everything else (the context, device lists) still comes from
+ * the real libusb.
+ *
+ * Synchronous IN requests are answered from the next matching record;
+ * outgoing data is accepted as is. Asynchronous IN transfers are filled
+ * from the recorded completions on their endpoint, which are treated as
+ * one stream of data: the driver may pick other transfer sizes than it
+ * did while recording. A short recorded transfer ends the replayed one
+ * early, like a short packet would. Once the stream runs out, transfers
+ * complete with LIBUSB_TRANSFER_NO_DEVICE, as if the device was gone.
+ *
+ * Transfers complete whenever the driver handles libusb events. The
+ * poll fd handed out is readable while transfers are pending, so the
+ * session's USB event source keeps dispatching as fast as the driver can
+ * consume data. Otherwise it times out, which drivers that poll the
+ * device status, like sysclk-lwla, rely on.
+ */
+
+#include <config.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libusb.h>
+#include "usb_replay.h"
+
+#define LOG_PREFIX "usb-replay"
+
+struct replay_transfer {
+	gboolean submitted;
+	gboolean cancelled;
+	/* Must be last, the isochronous packet descriptors follow it. */
+	struct libusb_transfer transfer;
+};
+
+/* The recorded completions on one IN endpoint. */
+struct replay_stream {
+	uint8_t endpoint;
+	GPtrArray *records;
+	unsigned int next;
+	size_t offset;
+	unsigned int loops_left;
+};
+
+static struct {
+	gchar *data;
+	GArray *records;
+	unsigned int sync_next;
+	GSList *streams;
+	GQueue *queue;
+	int wake_fds[2];
+	gboolean readable;
+	struct libusb_pollfd pollfd;
+	struct usb_replay_stats stats;
+} replay = {
+	.wake_fds = { -1, -1 },
+};
+
+static struct replay_transfer *replay_transfer(struct libusb_transfer *t)
+{
+	return (struct replay_transfer *)((char *)t
+			- G_STRUCT_OFFSET(struct replay_transfer, transfer));
+}
+
+/* Make the poll fd readable or not. */
+static void set_readable(gboolean readable)
+{
+	char c;
+
+	if (readable == replay.readable)
+		return;
+
+	if (readable) {
+		if (write(replay.wake_fds[1], "", 1) != 1)
+			sr_err("Failed to wake up the replay poll fd.");
+	} else {
+		if (read(replay.wake_fds[0], &c, 1) != 1)
+			sr_err("Failed to drain the replay poll fd.");
+	}
+	replay.readable = readable;
+}
+
+static struct replay_stream *get_stream(uint8_t endpoint)
+{
+	struct replay_stream *stream;
+	GSList *l;
+
+	for (l = replay.streams; l; l = l->next) {
+		stream = l->data;
+		if (stream->endpoint == endpoint)
+			return stream;
+	}
+
+	return NULL;
+}
+
+static void free_stream(void *data)
+{
+	struct replay_stream *stream = data;
+
+	g_ptr_array_free(stream->records, TRUE);
+	g_free(stream);
+}
+
+int usb_replay_open(const char *filename, unsigned int loops)
+{
+	GError *error = NULL;
+	struct usb_record rec;
+	struct replay_stream *stream;
+	gsize len, pos;
+	unsigned int i;
+
+	if (!g_file_get_contents(filename, &replay.data, &len, &error)) {
+		sr_err("Failed to read %s: %s", filename, error->message);
+		g_error_free(error);
+		return SR_ERR;
+	}
+
+	if (len < USB_RECORD_MAGIC_LEN || memcmp(replay.data,
+			USB_RECORD_MAGIC, USB_RECORD_MAGIC_LEN)) {
+		sr_err("%s is not a USB recording.", filename);
+		g_free(replay.data);
+		replay.data = NULL;
+		return SR_ERR_DATA;
+	}
+
+	replay.records = g_array_new(FALSE, FALSE, sizeof(struct usb_record));
+	for (pos = USB_RECORD_MAGIC_LEN; pos + USB_RECORD_HEADER_LEN <= len;) {
+		usb_record_header_unpack(&rec,
+				(const uint8_t *)replay.data + pos);
+		pos += USB_RECORD_HEADER_LEN;
+		if (rec.actual_length > len - pos) {
+			sr_warn("Recording is truncated.");
+			break;
+		}
+		rec.data = (const uint8_t *)replay.data + pos;
+		pos += rec.actual_length;
+		g_array_append_val(replay.records, rec);
+	}
+
+	/* Only data that made it to the driver can be replayed. */
+	for (i = 0; i < replay.records->len; i++) {
+		struct usb_record *r;
+
+		r = &g_array_index(replay.records, struct usb_record, i);
+		if (r->type != USB_RECORD_TRANSFER
+				|| !(r->endpoint & LIBUSB_ENDPOINT_IN)
+				|| (r->status != LIBUSB_TRANSFER_COMPLETED
+				&& r->status != LIBUSB_TRANSFER_TIMED_OUT))
+			continue;
+		if (!(stream = get_stream(r->endpoint))) {
+			stream = g_malloc0(sizeof(*stream));
+			stream->endpoint = r->endpoint;
+			stream->records = g_ptr_array_new();
+			stream->loops_left = loops ? loops - 1 : 0;
+			replay.streams = g_slist_append(replay.streams, stream);
+		}
+		g_ptr_array_add(stream->records, r);
+	}
+
+	replay.sync_next = 0;
+	replay.queue = g_queue_new();
+	memset(&replay.stats, 0, sizeof(replay.stats));
+
+	replay.readable = FALSE;
+	if (pipe(replay.wake_fds) < 0) {
+		sr_err("Failed to create the replay poll fd.");
+		usb_replay_close();
+		return SR_ERR;
+	}
+	replay.pollfd.fd = replay.wake_fds[0];
+	replay.pollfd.events = POLLIN;
+
+	sr_info("Loaded %u records from %s.", replay.records->len, filename);
+
+	return SR_OK;
+}
+
+void usb_replay_close(void)
+{
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		if (replay.wake_fds[i] >= 0)
+			close(replay.wake_fds[i]);
+		replay.wake_fds[i] = -1;
+	}
+	if (replay.queue)
+		g_queue_free(replay.queue);
+	replay.queue = NULL;
+	g_slist_free_full(replay.streams, free_stream);
+	replay.streams = NULL;
+	if (replay.records)
+		g_array_free(replay.records, TRUE);
+	replay.records = NULL;
+	g_free(replay.data);
+	replay.data = NULL;
+}
+
+void usb_replay_get_stats(struct usb_replay_stats *stats)
+{
+	*stats = replay.stats;
+}
+
+/*
+ * Read up to length bytes from a stream. Returns the number of bytes
+ * read, or -1 if the stream has run out.
+ */
+static int stream_read(struct replay_stream *stream, uint8_t *buf, int length)
+{
+	const struct usb_record *rec;
+	int done, n;
+
+	for (done = 0; done < length;) {
+		if (stream->next == stream->records->len) {
+			if (!stream->loops_left)
+				return done ? done : -1;
+			stream->loops_left--;
+			stream->next = 0;
+			stream->offset = 0;
+		}
+		rec = g_ptr_array_index(stream->records, stream->next);
+		n = MIN(rec->actual_length - stream->offset,
+				(size_t)(length - done));
+		memcpy(buf + done, rec->data + stream->offset, n);
+		done += n;
+		stream->offset += n;
+		if (stream->offset == rec->actual_length) {
+			stream->next++;
+			stream->offset = 0;
+			/* A short transfer: the device had no more data. */
+			if (rec->actual_length < rec->length)
+				break;
+		}
+	}
+
+	return done;
+}
+
+static void complete_transfer(struct replay_transfer *rt)
+{
+	struct libusb_transfer *transfer;
+	struct replay_stream *stream;
+	uint8_t flags;
+	int ret;
+
+	transfer = &rt->transfer;
+	rt->submitted = FALSE;
+
+	if (rt->cancelled) {
+		transfer->status = LIBUSB_TRANSFER_CANCELLED;
+		transfer->actual_length = 0;
+	} else if (transfer->endpoint & LIBUSB_ENDPOINT_IN) {
+		stream = get_stream(transfer->endpoint);
+		ret = stream ? stream_read(stream, transfer->buffer,
+				transfer->length) : -1;
+		if (ret < 0) {
+			transfer->status = LIBUSB_TRANSFER_NO_DEVICE;
+			transfer->actual_length = 0;
+		} else {
+			transfer->status = LIBUSB_TRANSFER_COMPLETED;
+			transfer->actual_length = ret;
+			replay.stats.transfers++;
+			replay.stats.bytes += ret;
+		}
+	} else {
+		transfer->status = LIBUSB_TRANSFER_COMPLETED;
+		transfer->actual_length = transfer->length;
+	}
+
+	flags = transfer->flags;
+	transfer->callback(transfer);
+	if (flags & LIBUSB_TRANSFER_FREE_TRANSFER)
+		libusb_free_transfer(transfer);
+}
+
+/* Complete every transfer that was submitted before this call. */
+static void dispatch(int *completed)
+{
+	unsigned int n;
+
+	for (n = g_queue_get_length(replay.queue); n; n--) {
+		complete_transfer(g_queue_pop_head(replay.queue));
+		if (completed && *completed)
+			break;
+	}
+	set_readable(!g_queue_is_empty(replay.queue));
+}
+
+struct libusb_transfer * LIBUSB_CALL libusb_alloc_transfer(int iso_packets)
+{
+	struct replay_transfer *rt;
+
+	rt = g_malloc0(sizeof(*rt) + iso_packets
+			* sizeof(struct libusb_iso_packet_descriptor));
+	rt->transfer.num_iso_packets = iso_packets;
+
+	return &rt->transfer;
+}
+
+void LIBUSB_CALL libusb_free_transfer(struct libusb_transfer *transfer)
+{
+	if (!transfer)
+		return;
+
+	if (transfer->flags & LIBUSB_TRANSFER_FREE_BUFFER)
+		free(transfer->buffer);
+	g_free(replay_transfer(transfer));
+}
+
+int LIBUSB_CALL libusb_submit_transfer(struct libusb_transfer *transfer)
+{
+	struct replay_transfer *rt;
+
+	rt = replay_transfer(transfer);
+	if (rt->submitted)
+		return LIBUSB_ERROR_BUSY;
+
+	rt->submitted = TRUE;
+	rt->cancelled = FALSE;
+	g_queue_push_tail(replay.queue, rt);
+	set_readable(TRUE);
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_cancel_transfer(struct libusb_transfer *transfer)
+{
+	struct replay_transfer *rt;
+
+	rt = replay_transfer(transfer);
+	if (!rt->submitted || rt->cancelled)
+		return LIBUSB_ERROR_NOT_FOUND;
+
+	rt->cancelled = TRUE;
+
+	return LIBUSB_SUCCESS;
+}
+
+/*
+ * Find the next synchronous record matching a request. Records are
+ * consumed in order, skipping the ones that don't match.
+ */
+static const struct usb_record *find_sync(uint8_t type, uint8_t endpoint,
+		uint8_t request_type, uint8_t request, uint16_t value,
+		uint16_t index)
+{
+	const struct usb_record *rec;
+	unsigned int i;
+
+	for (i = replay.sync_next; i < replay.records->len; i++) {
+		rec = &g_array_index(replay.records, struct usb_record, i);
+		if (rec->type != type || rec->endpoint != endpoint)
+			continue;
+		if (type == USB_RECORD_CONTROL && (rec->request_type != request_type
+				|| rec->request != request || rec->value != value
+				|| rec->index != index))
+			continue;
+		replay.sync_next = i + 1;
+		return rec;
+	}
+
+	replay.stats.unmatched++;
+
+	return NULL;
+}
+
+int LIBUSB_CALL libusb_control_transfer(libusb_device_handle *dev_handle,
+		uint8_t request_type, uint8_t bRequest, uint16_t wValue,
+		uint16_t wIndex, unsigned char *data, uint16_t wLength,
+		unsigned int timeout)
+{
+	const struct usb_record *rec;
+
+	(void)dev_handle;
+	(void)timeout;
+
+	if (!(request_type & LIBUSB_ENDPOINT_IN))
+		return wLength;
+
+	rec = find_sync(USB_RECORD_CONTROL, LIBUSB_ENDPOINT_IN, request_type,
+			bRequest, wValue, wIndex);
+	if (!rec) {
+		memset(data, 0, wLength);
+		return wLength;
+	}
+
+	memcpy(data, rec->data, MIN(rec->actual_length, wLength));
+
+	return rec->status < 0 ? rec->status
+			: (int)MIN(rec->actual_length, wLength);
+}
+
+static int sync_transfer(unsigned char endpoint, unsigned char *data,
+		int length, int *actual_length)
+{
+	const struct usb_record *rec;
+	int n;
+
+	n = length;
+	if (endpoint & LIBUSB_ENDPOINT_IN) {
+		rec = find_sync(USB_RECORD_SYNC, endpoint, 0, 0, 0, 0);
+		if (!rec) {
+			memset(data, 0, length);
+		} else {
+			n = MIN(rec->actual_length, (unsigned int)length);
+			memcpy(data, rec->data, n);
+			if (rec->status < 0) {
+				if (actual_length)
+					*actual_length = n;
+				return rec->status;
+			}
+		}
+	}
+
+	if (actual_length)
+		*actual_length = n;
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_bulk_transfer(libusb_device_handle *dev_handle,
+		unsigned char endpoint, unsigned char *data, int length,
+		int *actual_length, unsigned int timeout)
+{
+	(void)dev_handle;
+	(void)timeout;
+
+	return sync_transfer(endpoint, data, length, actual_length);
+}
+
+int LIBUSB_CALL libusb_interrupt_transfer(libusb_device_handle *dev_handle,
+		unsigned char endpoint, unsigned char *data, int length,
+		int *actual_length, unsigned int timeout)
+{
+	(void)dev_handle;
+	(void)timeout;
+
+	return sync_transfer(endpoint, data, length, actual_length);
+}
+
+int LIBUSB_CALL libusb_handle_events(libusb_context *ctx)
+{
+	(void)ctx;
+
+	dispatch(NULL);
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_handle_events_completed(libusb_context *ctx,
+		int *completed)
+{
+	(void)ctx;
+
+	dispatch(completed);
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_handle_events_timeout(libusb_context *ctx,
+		struct timeval *tv)
+{
+	(void)ctx;
+	(void)tv;
+
+	dispatch(NULL);
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_handle_events_timeout_completed(libusb_context *ctx,
+		struct timeval *tv, int *completed)
+{
+	(void)ctx;
+	(void)tv;
+
+	dispatch(completed);
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_get_next_timeout(libusb_context *ctx,
+		struct timeval *tv)
+{
+	(void)ctx;
+	(void)tv;
+
+	return 0;
+}
+
+const struct libusb_pollfd ** LIBUSB_CALL libusb_get_pollfds(
+		libusb_context *ctx)
+{
+	const struct libusb_pollfd **pollfds;
+
+	(void)ctx;
+
+	pollfds = malloc(2 * sizeof(*pollfds));
+	if (!pollfds)
+		return NULL;
+	pollfds[0] = &replay.pollfd;
+	pollfds[1] = NULL;
+
+	return pollfds;
+}
+
+#if (LIBUSB_API_VERSION >= 0x01000104)
+void LIBUSB_CALL libusb_free_pollfds(const struct libusb_pollfd **pollfds)
+{
+	free(pollfds);
+}
+#endif
+
+void LIBUSB_CALL libusb_set_pollfd_notifiers(libusb_context *ctx,
+		libusb_pollfd_added_cb added_cb, libusb_pollfd_removed_cb removed_cb,
+		void *user_data)
+{
+	(void)ctx;
+	(void)added_cb;
+	(void)removed_cb;
+	(void)user_data;
+}
+
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+/* Have the drivers fall back to their own buffers. */
+unsigned char * LIBUSB_CALL libusb_dev_mem_alloc(
+		libusb_device_handle *dev_handle, size_t length)
+{
+	(void)dev_handle;
+	(void)length;
+
+	return NULL;
+}
+
+int LIBUSB_CALL libusb_dev_mem_free(libusb_device_handle *dev_handle,
+		unsigned char *buffer, size_t length)
+{
+	(void)dev_handle;
+	(void)buffer;
+	(void)length;
+
+	return LIBUSB_ERROR_NOT_SUPPORTED;
+}
+#endif
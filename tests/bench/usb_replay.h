@@ -0,0 +1,142 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBSIGROK_TESTS_BENCH_USB_REPLAY_H
+#define LIBSIGROK_TESTS_BENCH_USB_REPLAY_H
+
+#include <stdint.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+/*
+ * USB traffic recordings.
+ *
+ * A recording starts with the 16 byte magic, followed by any number of
+ * records. Each record is a 32 byte header, followed by actual_length
+ * bytes of data. All fields are little endian.
+ *
+ *   offset  size  field
+ *        0     1  type (enum usb_record_type)
+ *        1     1  endpoint address, including the direction bit
+ *        2     1  bmRequestType (control transfers only)
+ *        3     1  bRequest (control transfers only)
+ *        4     2  wValue (control transfers only)
+ *        6     2  wIndex (control transfers only)
+ *        8     4  status: libusb return code for synchronous calls,
+ *                 enum libusb_transfer_status for asynchronous ones
+ *       12     4  requested length
+ *       16     4  actual length
+ *       20     4  reserved, zero
+ *       24     8  timestamp in microseconds since the first record
+ */
+
+#define USB_RECORD_MAGIC	"sigrok-usb-rec1\n"
+#define USB_RECORD_MAGIC_LEN	16
+#define USB_RECORD_HEADER_LEN	32
+
+enum usb_record_type {
+	/** libusb_control_transfer(). */
+	USB_RECORD_CONTROL = 1,
+	/** libusb_bulk_transfer() or libusb_interrupt_transfer(). */
+	USB_RECORD_SYNC,
+	/** Completion of a transfer queued with libusb_submit_transfer(). */
+	USB_RECORD_TRANSFER,
+};
+
+struct usb_record {
+	uint8_t type;
+	uint8_t endpoint;
+	uint8_t request_type;
+	uint8_t request;
+	uint16_t value;
+	uint16_t index;
+	int32_t status;
+	uint32_t length;
+	uint32_t actual_length;
+	uint64_t timestamp;
+	const uint8_t *data;
+};
+
+struct usb_replay_stats {
+	/** Asynchronous transfers completed with data. */
+	uint64_t transfers;
+	/** Bytes handed to the driver in those transfers. */
+	uint64_t bytes;
+	/** Synchronous requests that had no matching record. */
+	uint64_t unmatched;
+};
+
+static inline void usb_record_header_pack(uint8_t *buf,
+		const struct usb_record *rec)
+{
+	buf[0] = rec->type;
+	buf[1] = rec->endpoint;
+	buf[2] = rec->request_type;
+	buf[3] = rec->request;
+	WL16(&buf[4], rec->value);
+	WL16(&buf[6], rec->index);
+	WL32(&buf[8], rec->status);
+	WL32(&buf[12], rec->length);
+	WL32(&buf[16], rec->actual_length);
+	WL32(&buf[20], 0);
+	WL32(&buf[24], rec->timestamp & 0xffffffff);
+	WL32(&buf[28], rec->timestamp >> 32);
+}
+
+static inline void usb_record_header_unpack(struct usb_record *rec,
+		const uint8_t *buf)
+{
+	rec->type = buf[0];
+	rec->endpoint = buf[1];
+	rec->request_type = buf[2];
+	rec->request = buf[3];
+	rec->value = RL16(&buf[4]);
+	rec->index = RL16(&buf[6]);
+	rec->status = RL32S(&buf[8]);
+	rec->length = RL32(&buf[12]);
+	rec->actual_length = RL32(&buf[16]);
+	rec->timestamp = RL32(&buf[24]) | ((uint64_t)RL32(&buf[28]) << 32);
+	rec->data = NULL;
+}
+
+int usb_replay_open(const char *filename, unsigned int loops);
+void usb_replay_close(void);
+void usb_replay_get_stats(struct usb_replay_stats *stats);
+
+/* Per-driver setup of a device instance for replay. */
+struct usb_replay_driver {
+	const char *name;
+	/* The libsigrok driver, if it isn't the same as the name. */
+	const char *driver;
+	uint64_t default_samplerate;
+	int default_channels;
+	int max_channels;
+	int (*setup)(struct sr_dev_inst *sdi, uint64_t samplerate,
+			int num_channels);
+	void (*cleanup)(struct sr_dev_inst *sdi);
+};
+
+extern const struct usb_replay_driver usb_replay_fx2lafw;
+extern const struct usb_replay_driver usb_replay_dslogic;
+extern const struct usb_replay_driver usb_replay_logic16;
+extern const struct usb_replay_driver usb_replay_lwla1016;
+extern const struct usb_replay_driver usb_replay_lwla1034;
+
+#endif
@@ -0,0 +1,316 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replay recorded USB traffic through a logic analyzer driver, without
+ * the hardware, and measure how fast the driver consumes it.
+ *
+ *   usb_replay -d <driver> [-r <samplerate>] [-c <channels>]
+ *              [-l <limit samples>] [-n <loops>] <recording>
+ *
+ * Recordings are made with the usb_record preload module (see
+ * usb_record.c) while running the real device at the same settings.
+ * The driver is set up with its regular acquisition code; only libusb
+ * is replaced (see usb_replay.c). Data is fed as fast as the driver
+ * and the session take it, so the rate reported is that of the host
+ * side alone. Use -n to play a short recording several times over.
+ *
+ * Results are printed one per line as "<name> <value> <unit>".
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "usb_replay.h"
+
+#define LOG_PREFIX "usb-replay"
+
+static const struct usb_replay_driver *replay_drivers[] = {
+#ifdef HAVE_HW_FX2LAFW
+	&usb_replay_fx2lafw,
+	&usb_replay_dslogic,
+#endif
+#ifdef HAVE_HW_SALEAE_LOGIC16
+	&usb_replay_logic16,
+#endif
+#ifdef HAVE_HW_SYSCLK_LWLA
+	&usb_replay_lwla1016,
+	&usb_replay_lwla1034,
+#endif
+	NULL,
+};
+
+struct feed_stats {
+	uint64_t samples;
+	uint64_t packets;
+	gboolean ended;
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	struct feed_stats *stats = cb_data;
+	const struct sr_datafeed_logic *logic;
+
+	(void)sdi;
+
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		stats->samples += logic->length / logic->unitsize;
+		stats->packets++;
+		break;
+	case SR_DF_END:
+		stats->ended = TRUE;
+		break;
+	default:
+		break;
+	}
+}
+
+/* The replayed device ignores uploaded firmware, so any will do. */
+static int resource_open(struct sr_resource *res, const char *name,
+		void *cb_data)
+{
+	(void)name;
+	(void)cb_data;
+
+	res->size = 0;
+	res->handle = NULL;
+
+	return SR_OK;
+}
+
+static int resource_close(struct sr_resource *res, void *cb_data)
+{
+	(void)res;
+	(void)cb_data;
+
+	return SR_OK;
+}
+
+static ssize_t resource_read(const struct sr_resource *res, void *buf,
+		size_t count, void *cb_data)
+{
+	(void)res;
+	(void)buf;
+	(void)count;
+	(void)cb_data;
+
+	return 0;
+}
+
+static struct sr_dev_driver *find_driver(struct sr_context *ctx,
+		const char *name)
+{
+	struct sr_dev_driver **drivers;
+	int i;
+
+	drivers = sr_driver_list(ctx);
+	for (i = 0; drivers[i]; i++)
+		if (!strcmp(drivers[i]->name, name))
+			return drivers[i];
+
+	return NULL;
+}
+
+static struct sr_dev_inst *create_device(struct sr_dev_driver *driver,
+		int num_channels)
+{
+	struct sr_dev_inst *sdi;
+	char name[8];
+	int i;
+
+	sdi = g_malloc0(sizeof(struct sr_dev_inst));
+	sdi->driver = driver;
+	sdi->status = SR_ST_ACTIVE;
+	sdi->inst_type = SR_INST_USB;
+	sdi->model = g_strdup("Replay");
+	sdi->connection_id = g_strdup("replay");
+	sdi->conn = sr_usb_dev_inst_new(0, 0, NULL);
+
+	for (i = 0; i < num_channels; i++) {
+		snprintf(name, sizeof(name), "%d", i);
+		sr_channel_new(sdi, i, SR_CHANNEL_LOGIC, TRUE, name);
+	}
+
+	return sdi;
+}
+
+static double cpu_seconds(void)
+{
+	struct rusage usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+		+ (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static void usage(const char *argv0)
+{
+	int i;
+
+	fprintf(stderr, "Usage: %s -d <driver> [-r <samplerate>] "
+		"[-c <channels>] [-l <limit samples>] [-n <loops>] "
+		"<recording>\nDrivers:", argv0);
+	for (i = 0; replay_drivers[i]; i++)
+		fprintf(stderr, " %s", replay_drivers[i]->name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+	const struct usb_replay_driver *rdrv;
+	struct usb_replay_stats replay_stats;
+	struct feed_stats stats;
+	struct sr_context *ctx;
+	struct sr_session *session;
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	const char *driver_name;
+	uint64_t samplerate, limit_samples;
+	unsigned int loops;
+	int num_channels, opt, i, ret;
+	int64_t start, elapsed;
+	double cpu;
+
+	driver_name = NULL;
+	samplerate = limit_samples = 0;
+	num_channels = 0;
+	loops = 1;
+	while ((opt = getopt(argc, argv, "d:r:c:l:n:")) != -1) {
+		switch (opt) {
+		case 'd':
+			driver_name = optarg;
+			break;
+		case 'r':
+			if (sr_parse_sizestring(optarg, &samplerate) != SR_OK) {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 'c':
+			num_channels = strtol(optarg, NULL, 10);
+			break;
+		case 'l':
+			limit_samples = strtoull(optarg, NULL, 10);
+			break;
+		case 'n':
+			loops = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (!driver_name || optind != argc - 1 || num_channels < 0 || !loops) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	for (rdrv = NULL, i = 0; replay_drivers[i]; i++)
+		if (!strcmp(replay_drivers[i]->name, driver_name))
+			rdrv = replay_drivers[i];
+	if (!rdrv || num_channels > rdrv->max_channels) {
+		usage(argv[0]);
+		return 1;
+	}
+	if (!samplerate)
+		samplerate = rdrv->default_samplerate;
+	if (!num_channels)
+		num_channels = rdrv->default_channels;
+
+	if (sr_init(&ctx) != SR_OK)
+		return 1;
+	sr_resource_set_hooks(ctx, resource_open, resource_close,
+			resource_read, NULL);
+
+	ret = 1;
+	if (!(driver = find_driver(ctx, rdrv->driver ? rdrv->driver
+			: rdrv->name))) {
+		fprintf(stderr, "Driver %s is not available.\n", rdrv->name);
+		goto done;
+	}
+	if (sr_driver_init(ctx, driver) != SR_OK)
+		goto done;
+	if (usb_replay_open(argv[optind], loops) != SR_OK)
+		goto done;
+
+	sdi = create_device(driver, num_channels);
+	if (rdrv->setup(sdi, samplerate, num_channels) != SR_OK) {
+		fprintf(stderr, "Device setup failed.\n");
+		goto free_device;
+	}
+	if (limit_samples && sr_config_set(sdi, NULL, SR_CONF_LIMIT_SAMPLES,
+			g_variant_new_uint64(limit_samples)) != SR_OK)
+		goto cleanup_device;
+
+	memset(&stats, 0, sizeof(stats));
+	sr_session_new(ctx, &session);
+	sr_session_dev_add(session, sdi);
+	sr_session_datafeed_callback_add(session, datafeed_in, &stats);
+
+	cpu = cpu_seconds();
+	start = g_get_monotonic_time();
+	if (sr_session_start(session) == SR_OK)
+		sr_session_run(session);
+	elapsed = g_get_monotonic_time() - start;
+	cpu = cpu_seconds() - cpu;
+
+	sr_session_destroy(session);
+
+	usb_replay_get_stats(&replay_stats);
+	if (replay_stats.unmatched)
+		fprintf(stderr, "%" PRIu64 " requests had no recorded reply.\n",
+			replay_stats.unmatched);
+	if (!stats.ended || !stats.samples) {
+		fprintf(stderr, "Acquisition failed.\n");
+		goto cleanup_device;
+	}
+
+	elapsed = MAX(elapsed, 1);
+	printf("usb_replay.%s.rate %.1f MS/s\n", rdrv->name,
+		(double)stats.samples / elapsed);
+	printf("usb_replay.%s.usb %.1f MB/s\n", rdrv->name,
+		(double)replay_stats.bytes / elapsed);
+	printf("usb_replay.%s.cpu %.2f ns/sample\n", rdrv->name,
+		cpu * 1e9 / stats.samples);
+	printf("usb_replay.%s.load %.0f %%\n", rdrv->name,
+		cpu * 1e8 / elapsed);
+	printf("usb_replay.%s.packet %.0f bytes\n", rdrv->name,
+		(double)replay_stats.bytes / MAX(stats.packets, 1));
+	ret = 0;
+
+cleanup_device:
+	rdrv->cleanup(sdi);
+free_device:
+	sr_usb_dev_inst_free(sdi->conn);
+	sdi->conn = NULL;
+	sdi->priv = NULL;
+	sr_dev_inst_free(sdi);
+	usb_replay_close();
+done:
+	sr_exit(ctx);
+
+	return ret;
+}
@@ -0,0 +1,79 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include "hardware/fx2lafw/protocol.h"
+#include "usb_replay.h"
+
+static int setup(struct sr_dev_inst *sdi, uint64_t samplerate,
+		int num_channels)
+{
+	struct dev_context *devc;
+
+	devc = fx2lafw_dev_new();
+	devc->cur_samplerate = samplerate;
+	devc->sample_wide = num_channels > 8;
+	sdi->priv = devc;
+
+	return SR_OK;
+}
+
+static void cleanup(struct sr_dev_inst *sdi)
+{
+	fx2lafw_pool_free(sdi);
+	g_free(sdi->priv);
+	sdi->priv = NULL;
+}
+
+/* DSLogic devices are handled by the fx2lafw driver. */
+static int setup_dslogic(struct sr_dev_inst *sdi, uint64_t samplerate,
+		int num_channels)
+{
+	struct dev_context *devc;
+
+	setup(sdi, samplerate, num_channels);
+	devc = sdi->priv;
+	devc->dslogic = TRUE;
+
+	return SR_OK;
+}
+
+const struct usb_replay_driver usb_replay_fx2lafw = {
+	.name = "fx2lafw",
+	.default_samplerate = SR_MHZ(24),
+	.default_channels = 8,
+	.max_channels = 16,
+	.setup = setup,
+	.cleanup = cleanup,
+};
+
+/*
+ * The FPGA configuration is sent at the start of every acquisition, and
+ * the trigger position is the first transfer recorded on the data
+ * endpoint, so the recording must start before the acquisition does.
+ */
+const struct usb_replay_driver usb_replay_dslogic = {
+	.name = "dslogic",
+	.driver = "fx2lafw",
+	.default_samplerate = SR_MHZ(100),
+	.default_channels = 16,
+	.max_channels = 16,
+	.setup = setup_dslogic,
+	.cleanup = cleanup,
+};
@@ -0,0 +1,56 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include "hardware/saleae-logic16/protocol.h"
+#include "usb_replay.h"
+
+static int setup(struct sr_dev_inst *sdi, uint64_t samplerate,
+		int num_channels)
+{
+	struct dev_context *devc;
+
+	(void)num_channels;
+
+	devc = g_malloc0(sizeof(struct dev_context));
+	devc->selected_voltage_range = VOLTAGE_RANGE_18_33_V;
+	devc->cur_samplerate = samplerate;
+	sdi->priv = devc;
+
+	/*
+	 * Runs the recorded initialization, which also picks the FPGA
+	 * register mapping for the acquisition setup.
+	 */
+	return logic16_init_device(sdi);
+}
+
+static void cleanup(struct sr_dev_inst *sdi)
+{
+	g_free(sdi->priv);
+	sdi->priv = NULL;
+}
+
+const struct usb_replay_driver usb_replay_logic16 = {
+	.name = "saleae-logic16",
+	.default_samplerate = SR_MHZ(16),
+	.default_channels = 16,
+	.max_channels = 16,
+	.setup = setup,
+	.cleanup = cleanup,
+};
@@ -0,0 +1,84 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The LWLA captures to its own memory, polling the capture status every
+ * 100 ms, and reads the samples out afterwards. The status polls of the
+ * recording are replayed at that pace, so only the cpu and load results
+ * describe the readout; the rate includes the capture time.
+ */
+
+#include <config.h>
+#include "hardware/sysclk-lwla/protocol.h"
+#include "usb_replay.h"
+
+static int setup(struct sr_dev_inst *sdi, const struct model_info *model,
+		uint64_t samplerate, int num_channels)
+{
+	struct dev_context *devc;
+
+	devc = g_malloc0(sizeof(struct dev_context));
+	devc->model = model;
+	devc->samplerate = samplerate;
+	devc->channel_mask = (UINT64_C(1) << num_channels) - 1;
+	devc->cfg_rle = TRUE;
+	devc->state = STATE_IDLE;
+	devc->active_fpga_config = FPGA_NOCONF;
+	sdi->priv = devc;
+
+	return SR_OK;
+}
+
+static int setup_lwla1016(struct sr_dev_inst *sdi, uint64_t samplerate,
+		int num_channels)
+{
+	return setup(sdi, &lwla1016_info, samplerate, num_channels);
+}
+
+static int setup_lwla1034(struct sr_dev_inst *sdi, uint64_t samplerate,
+		int num_channels)
+{
+	return setup(sdi, &lwla1034_info, samplerate, num_channels);
+}
+
+static void cleanup(struct sr_dev_inst *sdi)
+{
+	g_free(sdi->priv);
+	sdi->priv = NULL;
+}
+
+const struct usb_replay_driver usb_replay_lwla1016 = {
+	.name = "lwla1016",
+	.driver = "sysclk-lwla",
+	.default_samplerate = SR_MHZ(100),
+	.default_channels = 16,
+	.max_channels = 16,
+	.setup = setup_lwla1016,
+	.cleanup = cleanup,
+};
+
+const struct usb_replay_driver usb_replay_lwla1034 = {
+	.name = "lwla1034",
+	.driver = "sysclk-lwla",
+	.default_samplerate = SR_MHZ(125),
+	.default_channels = 34,
+	.max_channels = 34,
+	.setup = setup_lwla1034,
+	.cleanup = cleanup,
+};
@@ -20,8 +20,14 @@
 
 #include <config.h>
 #include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include <check.h>
 #include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
 #include "lib.h"
 
 /*
@@ -163,6 +169,156 @@ START_TEST(test_exit_null)
 }
 END_TEST
 
+static GMutex log_mutex;
+static GSList *log_messages;
+static GThread *log_thread;
+
+static int collect_log(void *cb_data, int loglevel, const char *format,
+		va_list args)
+{
+	(void)cb_data;
+	(void)loglevel;
+
+	g_mutex_lock(&log_mutex);
+	log_messages = g_slist_append(log_messages,
+			g_strdup_vprintf(format, args));
+	log_thread = g_thread_self();
+	g_mutex_unlock(&log_mutex);
+
+	return SR_OK;
+}
+
+static void log_setup(void)
+{
+	log_messages = NULL;
+	log_thread = NULL;
+	sr_log_callback_set(collect_log, NULL);
+}
+
+static void log_teardown(void)
+{
+	sr_log_async_set(FALSE);
+	sr_log_callback_set_default();
+	sr_log_loglevel_set(SR_LOG_WARN);
+	g_slist_free_full(log_messages, g_free);
+}
+
+/* Check that messages above the loglevel don't reach the callback. */
+START_TEST(test_log_level)
+{
+	sr_log_loglevel_set(SR_LOG_WARN);
+	sr_log_loglevel_set(SR_LOG_NONE);
+	sr_log_callback_set(NULL, NULL);
+	fail_unless(log_messages == NULL, "Message above loglevel logged.");
+
+	sr_log_loglevel_set(SR_LOG_ERR);
+	sr_log_callback_set(NULL, NULL);
+	fail_unless(g_slist_length(log_messages) == 1,
+			"Expected one message, got %d.",
+			g_slist_length(log_messages));
+}
+END_TEST
+
+/*
+ * Check that asynchronously logged messages are delivered in order,
+ * formatted from the arguments as they were at the time of the call,
+ * and from the log thread, unless flushed.
+ */
+START_TEST(test_log_async)
+{
+	GSList *l;
+	int ret, i;
+
+	ret = sr_log_async_set(TRUE);
+	fail_unless(ret == SR_OK, "sr_log_async_set() failed: %d.", ret);
+
+	sr_log_loglevel_set(SR_LOG_DBG);
+	sr_log_callback_set(NULL, NULL);
+
+	/* Wait for the log thread to deliver them, for up to a second. */
+	for (i = 0; i < 1000; i++) {
+		g_mutex_lock(&log_mutex);
+		ret = g_slist_length(log_messages);
+		g_mutex_unlock(&log_mutex);
+		if (ret >= 2)
+			break;
+		g_usleep(1000);
+	}
+
+	g_mutex_lock(&log_mutex);
+	fail_unless(g_slist_length(log_messages) == 2,
+			"Expected two messages, got %d.",
+			g_slist_length(log_messages));
+	fail_unless(log_thread != NULL && log_thread != g_thread_self(),
+			"Message not delivered from the log thread.");
+	l = log_messages;
+	fail_unless(!strcmp(l->data, "log: libsigrok loglevel set to 4."),
+			"Unexpected message '%s'.", (char *)l->data);
+	l = l->next;
+	fail_unless(!strcmp(l->data, "log: sr_log_callback_set: cb was NULL"),
+			"Unexpected message '%s'.", (char *)l->data);
+	g_mutex_unlock(&log_mutex);
+
+	/* A flush delivers what is queued before it returns. */
+	sr_log_callback_set(NULL, NULL);
+	sr_log_flush();
+	g_mutex_lock(&log_mutex);
+	fail_unless(g_slist_length(log_messages) == 3,
+			"Flushed message not delivered.");
+	g_mutex_unlock(&log_mutex);
+
+	ret = sr_log_async_set(FALSE);
+	fail_unless(ret == SR_OK, "sr_log_async_set() failed: %d.", ret);
+
+	/* Back to synchronous delivery. */
+	log_thread = NULL;
+	sr_log_callback_set(NULL, NULL);
+	fail_unless(g_slist_length(log_messages) == 4,
+			"Synchronous message not delivered.");
+	fail_unless(log_thread == g_thread_self(),
+			"Synchronous message delivered from another thread.");
+}
+END_TEST
+
+#ifndef _WIN32
+/*
+ * Check that strings with a precision are captured only up to it, as
+ * drivers log buffers which aren't NUL terminated that way. The buffer
+ * ends right before an inaccessible page, so reading past it crashes.
+ */
+START_TEST(test_log_async_precision)
+{
+	char *map, *buf;
+	long page;
+	int ret;
+
+	page = sysconf(_SC_PAGESIZE);
+	map = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	fail_unless(map != MAP_FAILED, "mmap() failed.");
+	ret = mprotect(map + page, page, PROT_NONE);
+	fail_unless(ret == 0, "mprotect() failed.");
+	buf = map + page - 4;
+	memcpy(buf, "abcd", 4);
+
+	ret = sr_log_async_set(TRUE);
+	fail_unless(ret == SR_OK, "sr_log_async_set() failed: %d.", ret);
+	sr_log_loglevel_set(SR_LOG_ERR);
+	sr_log(SR_LOG_ERR, "%.*s|%.3s|%.*s", 4, buf, buf + 1, -1, "end");
+	sr_log_flush();
+
+	g_mutex_lock(&log_mutex);
+	fail_unless(log_messages != NULL, "Message not delivered.");
+	fail_unless(!strcmp(g_slist_last(log_messages)->data, "abcd|bcd|end"),
+			"Unexpected message '%s'.",
+			(char *)g_slist_last(log_messages)->data);
+	g_mutex_unlock(&log_mutex);
+
+	munmap(map, 2 * page);
+}
+END_TEST
+#endif
+
 Suite *suite_core(void)
 {
 	Suite *s;
@@ -180,5 +336,14 @@ Suite *suite_core(void)
 	tcase_add_test(tc, test_exit_null);
 	suite_add_tcase(s, tc);
 
+	tc = tcase_create("log");
+	tcase_add_checked_fixture(tc, log_setup, log_teardown);
+	tcase_add_test(tc, test_log_level);
+	tcase_add_test(tc, test_log_async);
+#ifndef _WIN32
+	tcase_add_test(tc, test_log_async_precision);
+#endif
+	suite_add_tcase(s, tc);
+
 	return s;
 }
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
 #include "lib.h"
 
 START_TEST(test_user_new)
@@ -62,6 +63,199 @@ START_TEST(test_channel_add)
 }
 END_TEST
 
+/* An open demo device, with its samplerate and sample limit cached. */
+static struct sr_dev_inst *cached_demo_new(uint64_t ttl_us)
+{
+	const uint32_t keys[] = { SR_CONF_SAMPLERATE, SR_CONF_LIMIT_SAMPLES };
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct sr_config_cache_stats stats;
+	GSList *options, *devs;
+
+	driver = srtest_driver_get("demo");
+	srtest_driver_init(srtest_ctx, driver);
+	options = g_slist_append(NULL, sr_config_new(
+			SR_CONF_NUM_ANALOG_CHANNELS, g_variant_new_int32(0)));
+	devs = sr_driver_scan(driver, options);
+	g_slist_free_full(options, (GDestroyNotify)sr_config_free);
+	fail_unless(devs != NULL);
+	sdi = devs->data;
+	g_slist_free(devs);
+	fail_unless(sr_dev_open(sdi) == SR_OK);
+
+	/* The demo driver doesn't use the cache by itself. */
+	fail_unless(sr_config_cache_stats_get(sdi, &stats) == SR_ERR_NA);
+	sr_config_cache_enable(sdi, keys, G_N_ELEMENTS(keys), ttl_us);
+	fail_unless(sr_config_cache_stats_get(sdi, &stats) == SR_OK);
+	fail_unless(stats.hits == 0 && stats.misses == 0);
+	fail_unless(stats.invalidations == 0);
+
+	return sdi;
+}
+
+static uint64_t samplerate_get(const struct sr_dev_inst *sdi)
+{
+	GVariant *gvar;
+	uint64_t samplerate;
+	int ret;
+
+	ret = sr_config_get(sdi->driver, sdi, NULL, SR_CONF_SAMPLERATE, &gvar);
+	fail_unless(ret == SR_OK);
+	samplerate = g_variant_get_uint64(gvar);
+	g_variant_unref(gvar);
+
+	return samplerate;
+}
+
+/* Change the samplerate behind the library's back, like a front panel. */
+static void samplerate_set_directly(const struct sr_dev_inst *sdi,
+		uint64_t samplerate)
+{
+	GVariant *gvar;
+
+	gvar = g_variant_ref_sink(g_variant_new_uint64(samplerate));
+	fail_unless(sdi->driver->config_set(SR_CONF_SAMPLERATE, gvar,
+			sdi, NULL) == SR_OK);
+	g_variant_unref(gvar);
+}
+
+static void cache_stats_check(const struct sr_dev_inst *sdi, uint64_t hits,
+		uint64_t misses, uint64_t invalidations)
+{
+	struct sr_config_cache_stats stats;
+
+	fail_unless(sr_config_cache_stats_get(sdi, &stats) == SR_OK);
+	fail_unless(stats.hits == hits && stats.misses == misses
+			&& stats.invalidations == invalidations,
+		"%" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64
+		" invalidations.", stats.hits, stats.misses,
+		stats.invalidations);
+}
+
+/* Cached values are served until the cache is cleared. */
+START_TEST(test_config_cache_hits)
+{
+	struct sr_dev_inst *sdi;
+	struct sr_config_cache_stats stats;
+	GVariant *gvar;
+	uint64_t samplerate;
+
+	sdi = cached_demo_new(0);
+	samplerate = samplerate_get(sdi);
+	cache_stats_check(sdi, 0, 1, 0);
+	fail_unless(samplerate_get(sdi) == samplerate);
+	cache_stats_check(sdi, 1, 1, 0);
+
+	/* Keys not cached aren't counted. */
+	fail_unless(sr_config_get(sdi->driver, sdi, NULL,
+			SR_CONF_LIMIT_MSEC, &gvar) == SR_OK);
+	g_variant_unref(gvar);
+	cache_stats_check(sdi, 1, 1, 0);
+
+	samplerate_set_directly(sdi, samplerate * 2);
+	fail_unless(samplerate_get(sdi) == samplerate);
+	cache_stats_check(sdi, 2, 1, 0);
+	fail_unless(sr_config_cache_clear(sdi) == SR_OK);
+	fail_unless(samplerate_get(sdi) == samplerate * 2);
+	cache_stats_check(sdi, 2, 2, 1);
+
+	fail_unless(sr_config_cache_clear(NULL) == SR_ERR_ARG);
+	fail_unless(sr_config_cache_stats_get(NULL, &stats) == SR_ERR_ARG);
+	fail_unless(sr_config_cache_stats_get(sdi, NULL) == SR_ERR_ARG);
+}
+END_TEST
+
+/*
+ * Cached values expire after the time to live. It is long enough for
+ * the hit not to expire on a loaded machine, the expiry itself only
+ * needs the sleep.
+ */
+START_TEST(test_config_cache_ttl)
+{
+	const uint64_t ttl_us = G_USEC_PER_SEC;
+	struct sr_dev_inst *sdi;
+	uint64_t samplerate;
+
+	sdi = cached_demo_new(ttl_us);
+	samplerate = samplerate_get(sdi);
+	samplerate_set_directly(sdi, samplerate * 2);
+	fail_unless(samplerate_get(sdi) == samplerate);
+	cache_stats_check(sdi, 1, 1, 0);
+
+	g_usleep(ttl_us);
+	fail_unless(samplerate_get(sdi) == samplerate * 2);
+	cache_stats_check(sdi, 1, 2, 0);
+	fail_unless(samplerate_get(sdi) == samplerate * 2);
+	cache_stats_check(sdi, 2, 2, 0);
+}
+END_TEST
+
+/*
+ * The cache is cleared by settings, commits, opening and closing the
+ * device, changes of the enabled channels and acquisition starts.
+ */
+START_TEST(test_config_cache_invalidation)
+{
+	struct sr_dev_inst *sdi;
+	struct sr_channel *ch;
+	struct sr_session *sess;
+	struct sr_config_cache_stats stats;
+	uint64_t samplerate, invalidations;
+	int ret;
+
+	sdi = cached_demo_new(0);
+	ch = sdi->channels->data;
+	samplerate_get(sdi);
+	cache_stats_check(sdi, 0, 1, 0);
+
+	ret = sr_config_set(sdi, NULL, SR_CONF_LIMIT_SAMPLES,
+			g_variant_new_uint64(1000));
+	fail_unless(ret == SR_OK);
+	cache_stats_check(sdi, 0, 1, 1);
+	samplerate_get(sdi);
+	cache_stats_check(sdi, 0, 2, 1);
+
+	fail_unless(sr_config_commit(sdi) == SR_OK);
+	samplerate_get(sdi);
+	cache_stats_check(sdi, 0, 3, 2);
+
+	fail_unless(sr_dev_close(sdi) == SR_OK);
+	fail_unless(sr_dev_open(sdi) == SR_OK);
+	samplerate_get(sdi);
+	cache_stats_check(sdi, 0, 4, 4);
+
+	/* Only actual changes of the enabled channels count. */
+	fail_unless(ch->enabled);
+	fail_unless(sr_dev_channel_enable(ch, TRUE) == SR_OK);
+	samplerate_get(sdi);
+	cache_stats_check(sdi, 1, 4, 4);
+	fail_unless(sr_dev_channel_enable(ch, FALSE) == SR_OK);
+	samplerate_get(sdi);
+	cache_stats_check(sdi, 1, 5, 5);
+	fail_unless(sr_dev_channel_enable(ch, TRUE) == SR_OK);
+	samplerate_get(sdi);
+	cache_stats_check(sdi, 1, 6, 6);
+
+	/*
+	 * Nothing cached before a start is served after it, whatever else
+	 * reads settings while starting.
+	 */
+	samplerate = samplerate_get(sdi);
+	samplerate_set_directly(sdi, samplerate * 2);
+	fail_unless(samplerate_get(sdi) == samplerate);
+	fail_unless(sr_config_cache_stats_get(sdi, &stats) == SR_OK);
+	invalidations = stats.invalidations;
+	sr_session_new(srtest_ctx, &sess);
+	sr_session_dev_add(sess, sdi);
+	fail_unless(sr_session_start(sess) == SR_OK);
+	fail_unless(sr_config_cache_stats_get(sdi, &stats) == SR_OK);
+	fail_unless(stats.invalidations > invalidations);
+	sr_session_run(sess);
+	sr_session_destroy(sess);
+	fail_unless(samplerate_get(sdi) == samplerate * 2);
+}
+END_TEST
+
 Suite *suite_device(void)
 {
 	Suite *s;
@@ -77,5 +271,12 @@ Suite *suite_device(void)
 	tcase_add_test(tc, test_channel_add);
 	suite_add_tcase(s, tc);
 
+	tc = tcase_create("config_cache");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_config_cache_hits);
+	tcase_add_test(tc, test_config_cache_ttl);
+	tcase_add_test(tc, test_config_cache_invalidation);
+	suite_add_tcase(s, tc);
+
 	return s;
 }
@@ -0,0 +1,477 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "lib.h"
+
+/* Same as the serial receive buffer. */
+#define BUF_SIZE		4096
+#define MAX_CHUNK_SIZE		256
+#define NUM_PACKETS		1024
+#define FUZZ_SIZE		(64 * 1024)
+#define STREAM_SEED		0x5eed
+
+#define DLE	0x10
+#define STX	0x02
+#define ETX	0x03
+#define LF	0x0a
+#define CR	0x0d
+
+/* Receive buffer, compacted before every chunk like the serial one. */
+struct rx {
+	uint8_t data[BUF_SIZE];
+	size_t start;
+	size_t len;
+};
+
+struct protocol {
+	const char *name;
+	const struct sr_framing *framing;
+	/* Write a valid packet, return its size. */
+	size_t (*make_packet)(uint8_t *buf, GRand *rand);
+	/* Whether a byte may appear between packets. */
+	gboolean (*is_filler)(uint8_t c);
+};
+
+/* fixed: 14 bytes, byte i carries i + 1 in its upper nibble (FS9721). */
+
+static gboolean fixed_valid(const uint8_t *buf)
+{
+	int i;
+
+	for (i = 0; i < 14; i++)
+		if ((buf[i] >> 4) != i + 1)
+			return FALSE;
+
+	return TRUE;
+}
+
+static size_t fixed_make(uint8_t *buf, GRand *rand)
+{
+	int i;
+
+	for (i = 0; i < 14; i++)
+		buf[i] = ((i + 1) << 4) | g_rand_int_range(rand, 0, 16);
+
+	return 14;
+}
+
+static gboolean fixed_filler(uint8_t c)
+{
+	return (c >> 4) == 0;
+}
+
+static const struct sr_framing fixed_framing = {
+	.type = SR_FRAMING_FIXED,
+	.size = 14,
+	.is_valid = fixed_valid,
+};
+
+/* fixed_sync: 15 bytes of payload, then CR LF (ES51919). */
+
+static gboolean fixed_sync_valid(const uint8_t *buf)
+{
+	return buf[15] == CR && buf[16] == LF;
+}
+
+static size_t fixed_sync_make(uint8_t *buf, GRand *rand)
+{
+	int i;
+
+	for (i = 0; i < 15; i++)
+		buf[i] = g_rand_int_range(rand, 0x20, 0x80);
+	buf[15] = CR;
+	buf[16] = LF;
+
+	return 17;
+}
+
+static gboolean fixed_sync_filler(uint8_t c)
+{
+	return c != CR;
+}
+
+static const struct sr_framing fixed_sync_framing = {
+	.type = SR_FRAMING_FIXED,
+	.size = 17,
+	.has_sync = TRUE,
+	.sync = CR,
+	.sync_offset = 15,
+	.is_valid = fixed_sync_valid,
+};
+
+/* length: DLE STX cmd len, payload, XOR checksum, DLE ETX (Brymen). */
+
+static int length_length(const uint8_t *buf, size_t len)
+{
+	if (len < 4)
+		return 0;
+	if (buf[0] != DLE || buf[1] != STX)
+		return -1;
+
+	return 4 + buf[3] + 3;
+}
+
+static gboolean length_valid(const uint8_t *buf)
+{
+	uint8_t chksum;
+	int i;
+
+	chksum = 0;
+	for (i = 0; i < buf[3]; i++)
+		chksum ^= buf[4 + i];
+
+	return buf[4 + buf[3]] == chksum;
+}
+
+static size_t length_make(uint8_t *buf, GRand *rand)
+{
+	uint8_t chksum;
+	int i, len;
+
+	len = g_rand_int_range(rand, 1, 16);
+	buf[0] = DLE;
+	buf[1] = STX;
+	buf[2] = 0x00;
+	buf[3] = len;
+	chksum = 0;
+	for (i = 0; i < len; i++) {
+		buf[4 + i] = g_rand_int_range(rand, 0x20, 0x80);
+		chksum ^= buf[4 + i];
+	}
+	buf[4 + len] = chksum;
+	buf[5 + len] = DLE;
+	buf[6 + len] = ETX;
+
+	return len + 7;
+}
+
+static gboolean length_filler(uint8_t c)
+{
+	return c != DLE;
+}
+
+static const struct sr_framing length_framing = {
+	.type = SR_FRAMING_LENGTH,
+	.size = 22,
+	.has_sync = TRUE,
+	.sync = DLE,
+	.sync_offset = 0,
+	.packet_length = length_length,
+	.is_valid = length_valid,
+};
+
+/* delimited: LF, label, SP, value, SP, checksum, CR (Teleinfo). */
+
+static size_t delimited_make(uint8_t *buf, GRand *rand)
+{
+	return sprintf((char *)buf, "\nPAPP %05u %c\r",
+			g_rand_int_range(rand, 0, 100000),
+			g_rand_int_range(rand, 0x20, 0x60));
+}
+
+static gboolean delimited_filler(uint8_t c)
+{
+	return c != LF;
+}
+
+static const struct sr_framing delimited_framing = {
+	.type = SR_FRAMING_DELIMITED,
+	.size = 25,
+	.start = LF,
+	.end = CR,
+};
+
+static const struct protocol protocols[] = {
+	{ "fixed", &fixed_framing, fixed_make, fixed_filler },
+	{ "fixed_sync", &fixed_sync_framing, fixed_sync_make,
+		fixed_sync_filler },
+	{ "length", &length_framing, length_make, length_filler },
+	{ "delimited", &delimited_framing, delimited_make, delimited_filler },
+};
+
+static void rx_feed(struct rx *rx, const uint8_t *data, size_t len)
+{
+	if (rx->start) {
+		memmove(rx->data, rx->data + rx->start, rx->len);
+		rx->start = 0;
+	}
+	fail_unless(rx->len + len <= BUF_SIZE, "Receive buffer overflow.");
+	memcpy(rx->data + rx->len, data, len);
+	rx->len += len;
+}
+
+/* Take a packet, like serial_rx_frame(). */
+static int rx_frame(struct rx *rx, const struct sr_framing *framing,
+		const uint8_t **pkt)
+{
+	size_t offset;
+	int ret;
+
+	ret = sr_framing_find(framing, rx->data + rx->start, rx->len, &offset);
+	fail_unless(offset <= rx->len, "Offset %zu beyond %zu bytes.",
+			offset, rx->len);
+	if (ret > 0) {
+		*pkt = rx->data + rx->start + offset;
+		offset += ret;
+	}
+	rx->start += offset;
+	rx->len -= offset;
+
+	return ret;
+}
+
+/* A false sync byte ahead of the packet must not hide it. */
+START_TEST(test_sync_offset)
+{
+	uint8_t buf[64];
+	size_t offset;
+	int ret;
+
+	/* A CR without LF, then a packet. */
+	memset(buf, 'a', sizeof(buf));
+	buf[20] = CR;
+	memcpy(buf + 25, "0123456789abcde\r\n", 17);
+	ret = sr_framing_find(&fixed_sync_framing, buf, 42, &offset);
+	fail_unless(ret == 17, "Packet not found: %d.", ret);
+	fail_unless(offset == 25, "Packet found at %zu.", offset);
+
+	/* The packet isn't complete yet, its start must be kept. */
+	ret = sr_framing_find(&fixed_sync_framing, buf, 41, &offset);
+	fail_unless(ret == SR_ERR_NA, "Incomplete packet found.");
+	fail_unless(offset == 25, "Discarded up to %zu.", offset);
+
+	/* No sync at all: keep what may still become a packet's head. */
+	ret = sr_framing_find(&fixed_sync_framing, buf, 20, &offset);
+	fail_unless(ret == SR_ERR_NA, "Packet found without sync.");
+	fail_unless(offset == 20 - 15, "Discarded up to %zu.", offset);
+
+	/* Less than a packet's head. */
+	ret = sr_framing_find(&fixed_sync_framing, buf, 10, &offset);
+	fail_unless(ret == SR_ERR_NA && offset == 0,
+			"Discarded %zu bytes of a short buffer.", offset);
+}
+END_TEST
+
+/* A start byte without an end within the maximum size is skipped. */
+START_TEST(test_delimited_too_long)
+{
+	static const char packet[] = "\nPAPP 01234 A\r";
+	uint8_t buf[64];
+	size_t offset;
+	int ret;
+
+	memset(buf, 'x', sizeof(buf));
+	buf[0] = LF;
+	memcpy(buf + 30, packet, strlen(packet));
+	ret = sr_framing_find(&delimited_framing, buf,
+			30 + strlen(packet), &offset);
+	fail_unless(ret == (int)strlen(packet), "Packet not found: %d.", ret);
+	fail_unless(offset == 30, "Packet found at %zu.", offset);
+
+	/* Shorter than the maximum, the end may still arrive. */
+	ret = sr_framing_find(&delimited_framing, buf, 10, &offset);
+	fail_unless(ret == SR_ERR_NA, "Packet found without end.");
+	fail_unless(offset == 0, "Discarded up to %zu.", offset);
+
+	/* At the maximum, it can't, and nothing else starts a packet. */
+	ret = sr_framing_find(&delimited_framing, buf,
+			delimited_framing.size, &offset);
+	fail_unless(ret == SR_ERR_NA, "Packet found without end.");
+	fail_unless(offset == delimited_framing.size,
+			"Discarded up to %zu.", offset);
+}
+END_TEST
+
+/* The length callback can ask for more data (0) or reject a start (< 0). */
+START_TEST(test_length_callback)
+{
+	static const uint8_t packet[] = {
+		DLE, STX, 0x00, 0x02, 'a', 'b', 'a' ^ 'b', DLE, ETX,
+	};
+	uint8_t buf[64];
+	size_t offset;
+	int ret;
+
+	/* Too short to tell the length: wait. */
+	ret = sr_framing_find(&length_framing, packet, 3, &offset);
+	fail_unless(ret == SR_ERR_NA, "Packet found in 3 bytes.");
+	fail_unless(offset == 0, "Discarded up to %zu.", offset);
+
+	/* DLE without STX, then a length beyond the maximum, then a packet. */
+	memset(buf, 'x', sizeof(buf));
+	buf[0] = DLE;
+	buf[5] = DLE;
+	buf[6] = STX;
+	buf[8] = 200;
+	memcpy(buf + 12, packet, sizeof(packet));
+	ret = sr_framing_find(&length_framing, buf, 12 + sizeof(packet),
+			&offset);
+	fail_unless(ret == (int)sizeof(packet), "Packet not found: %d.", ret);
+	fail_unless(offset == 12, "Packet found at %zu.", offset);
+
+	/* The length is known, but the packet isn't complete yet. */
+	ret = sr_framing_find(&length_framing, buf, 12 + sizeof(packet) - 1,
+			&offset);
+	fail_unless(ret == SR_ERR_NA, "Incomplete packet found.");
+	fail_unless(offset == 12, "Discarded up to %zu.", offset);
+}
+END_TEST
+
+/* Packets mixed with filler, and where the packets are in it. */
+static GByteArray *make_stream(const struct protocol *p, GArray *offsets,
+		GArray *sizes)
+{
+	GByteArray *stream;
+	GRand *rand;
+	uint8_t buf[64], c;
+	size_t offset, size;
+	int i, j, filler;
+
+	rand = g_rand_new_with_seed(STREAM_SEED);
+	stream = g_byte_array_new();
+	for (i = 0; i < NUM_PACKETS; i++) {
+		filler = g_rand_int_range(rand, 0, 4) ? 0 :
+			g_rand_int_range(rand, 1, 32);
+		for (j = 0; j < filler; j++) {
+			do {
+				c = g_rand_int_range(rand, 0, 256);
+			} while (!p->is_filler(c));
+			g_byte_array_append(stream, &c, 1);
+		}
+		offset = stream->len;
+		size = p->make_packet(buf, rand);
+		g_byte_array_append(stream, buf, size);
+		g_array_append_val(offsets, offset);
+		g_array_append_val(sizes, size);
+	}
+	g_rand_free(rand);
+
+	return stream;
+}
+
+/* Feed a stream in random chunks, all packets must come out intact. */
+START_TEST(test_stream)
+{
+	const struct protocol *p;
+	GByteArray *stream;
+	GArray *offsets, *sizes;
+	GRand *rand;
+	struct rx rx;
+	const uint8_t *pkt;
+	size_t pos, chunk;
+	unsigned int found;
+	int ret;
+
+	p = &protocols[_i];
+	offsets = g_array_new(FALSE, FALSE, sizeof(size_t));
+	sizes = g_array_new(FALSE, FALSE, sizeof(size_t));
+	stream = make_stream(p, offsets, sizes);
+	rand = g_rand_new_with_seed(STREAM_SEED + 1);
+	memset(&rx, 0, sizeof(rx));
+
+	found = 0;
+	for (pos = 0; pos < stream->len; pos += chunk) {
+		chunk = g_rand_int_range(rand, 1, MAX_CHUNK_SIZE + 1);
+		chunk = MIN(chunk, stream->len - pos);
+		rx_feed(&rx, stream->data + pos, chunk);
+		while ((ret = rx_frame(&rx, p->framing, &pkt)) > 0) {
+			fail_unless(found < offsets->len,
+					"%s: Extra packet.", p->name);
+			fail_unless((size_t)ret == g_array_index(sizes,
+					size_t, found) && !memcmp(pkt,
+					stream->data + g_array_index(offsets,
+					size_t, found), ret),
+					"%s: Packet %u is wrong.", p->name, found);
+			found++;
+		}
+	}
+	fail_unless(found == offsets->len, "%s: Found %u of %u packets.",
+			p->name, found, offsets->len);
+
+	g_rand_free(rand);
+	g_byte_array_free(stream, TRUE);
+	g_array_free(offsets, TRUE);
+	g_array_free(sizes, TRUE);
+}
+END_TEST
+
+/* Feed random bytes, whatever is found must be sane. */
+START_TEST(test_fuzz)
+{
+	const struct protocol *p;
+	GRand *rand;
+	struct rx rx;
+	uint8_t chunk[MAX_CHUNK_SIZE];
+	const uint8_t *pkt;
+	size_t pos, len, i;
+	int ret;
+
+	p = &protocols[_i];
+	rand = g_rand_new_with_seed(STREAM_SEED + 2);
+	memset(&rx, 0, sizeof(rx));
+
+	for (pos = 0; pos < FUZZ_SIZE; pos += len) {
+		len = g_rand_int_range(rand, 1, MAX_CHUNK_SIZE + 1);
+		for (i = 0; i < len; i++)
+			chunk[i] = g_rand_int_range(rand, 0, 256);
+		rx_feed(&rx, chunk, len);
+		while ((ret = rx_frame(&rx, p->framing, &pkt)) > 0) {
+			fail_unless((size_t)ret <= p->framing->size &&
+					(p->framing->type != SR_FRAMING_FIXED ||
+					(size_t)ret == p->framing->size) &&
+					(!p->framing->is_valid ||
+					p->framing->is_valid(pkt)),
+					"%s: Bad %d byte packet.", p->name, ret);
+		}
+		/* Nothing may pile up beyond a packet's worth. */
+		fail_unless(rx.len < p->framing->size + MAX_CHUNK_SIZE,
+				"%s: %zu bytes left over.", p->name, rx.len);
+	}
+	g_rand_free(rand);
+}
+END_TEST
+
+Suite *suite_framing(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("framing");
+
+	tc = tcase_create("find");
+	tcase_add_test(tc, test_sync_offset);
+	tcase_add_test(tc, test_delimited_too_long);
+	tcase_add_test(tc, test_length_callback);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("stream");
+	tcase_add_loop_test(tc, test_stream, 0, ARRAY_SIZE(protocols));
+	tcase_add_loop_test(tc, test_fuzz, 0, ARRAY_SIZE(protocols));
+	suite_add_tcase(s, tc);
+
+	return s;
+}
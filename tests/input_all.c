@@ -20,7 +20,10 @@
 
 #include <config.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <check.h>
+#include <glib/gstdio.h>
 #include <libsigrok/libsigrok.h>
 #include "lib.h"
 
@@ -34,6 +37,67 @@ START_TEST(test_input_available)
 }
 END_TEST
 
+/* Write a temporary file with the given contents, return its name. */
+static char *write_tmpfile(const char *tmpl, const char *data, gsize len)
+{
+	GError *error;
+	char *name;
+	int fd;
+
+	error = NULL;
+	fd = g_file_open_tmp(tmpl, &name, &error);
+	fail_unless(fd >= 0, "Failed to create temporary file.");
+	close(fd);
+	fail_unless(g_file_set_contents(name, data, len, &error),
+			"Failed to write temporary file.");
+
+	return name;
+}
+
+/* Check whether a list of files can be identified in one go. */
+START_TEST(test_input_scan_files)
+{
+	const struct sr_input_module *modules[3];
+	const char *filenames[3];
+	char wav[46];
+	char *wavname, *txtname;
+	int ret;
+
+	/* Minimal 16-bit mono PCM WAV header, followed by one sample. */
+	memset(wav, 0, sizeof(wav));
+	memcpy(wav, "RIFF", 4);
+	memcpy(wav + 8, "WAVEfmt ", 8);
+	wav[16] = 16;
+	wav[20] = 1;
+	wav[22] = 1;
+	wav[24] = 0x44;
+	wav[25] = 0xac;
+	wav[32] = 2;
+	wav[34] = 16;
+	memcpy(wav + 36, "data", 4);
+	wav[40] = 2;
+	wavname = write_tmpfile("sr-test-XXXXXX.wav", wav, sizeof(wav));
+	txtname = write_tmpfile("sr-test-XXXXXX.txt", "not a capture", 13);
+
+	filenames[0] = wavname;
+	filenames[1] = txtname;
+	filenames[2] = NULL;
+	ret = sr_input_scan_files(filenames, modules, 2);
+	fail_unless(ret == SR_OK, "sr_input_scan_files() failed: %d.", ret);
+	fail_unless(modules[0] && !strcmp(sr_input_id_get(modules[0]), "wav"),
+			"WAV file not identified.");
+	fail_unless(modules[1] == NULL, "Text file wrongly identified.");
+
+	ret = sr_input_scan_files(NULL, modules, 2);
+	fail_unless(ret == SR_ERR_ARG, "NULL file list not rejected.");
+
+	g_unlink(wavname);
+	g_unlink(txtname);
+	g_free(wavname);
+	g_free(txtname);
+}
+END_TEST
+
 Suite *suite_input_all(void)
 {
 	Suite *s;
@@ -43,6 +107,7 @@ Suite *suite_input_all(void)
 
 	tc = tcase_create("basic");
 	tcase_add_test(tc, test_input_available);
+	tcase_add_test(tc, test_input_scan_files);
 	suite_add_tcase(s, tc);
 
 	return s;
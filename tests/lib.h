@@ -54,5 +54,15 @@ Suite *suite_version(void);
 Suite *suite_device(void);
 Suite *suite_trigger(void);
 Suite *suite_analog(void);
+Suite *suite_framing(void);
+#ifndef _WIN32
+Suite *suite_scpi(void);
+#endif
+#ifdef HAVE_HW_SALEAE_LOGIC16
+Suite *suite_logic16_convert(void);
+#endif
+#ifdef HAVE_HW_RIGOL_DS
+Suite *suite_rigol_ds(void);
+#endif
 
 #endif
@@ -0,0 +1,202 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "hardware/saleae-logic16/convert.h"
+#include "lib.h"
+
+#define TEST_WORDS	(4 * 1024 + 5)
+
+struct reference {
+	int num_channels;
+	int cur_channel;
+	uint16_t channel_masks[16];
+	uint16_t channel_data[16];
+};
+
+/* The original bit by bit conversion, producing little endian samples. */
+static size_t reference_convert(struct reference *ref, uint8_t *dest,
+		const uint8_t *src, size_t srccnt)
+{
+	uint16_t sample, channel_mask;
+	size_t ret = 0;
+	int i;
+
+	for (srccnt /= 2; srccnt; srccnt--, src += 2) {
+		sample = src[0] | (src[1] << 8);
+		channel_mask = ref->channel_masks[ref->cur_channel];
+
+		for (i = 15; i >= 0; --i, sample >>= 1)
+			if (sample & 1)
+				ref->channel_data[i] |= channel_mask;
+
+		if (++ref->cur_channel == ref->num_channels) {
+			ref->cur_channel = 0;
+			for (i = 0; i < 16; i++) {
+				*dest++ = ref->channel_data[i] & 0xff;
+				*dest++ = ref->channel_data[i] >> 8;
+			}
+			memset(ref->channel_data, 0, sizeof(ref->channel_data));
+			ret += 16;
+		}
+	}
+
+	return ret;
+}
+
+static int masks_from_bits(uint16_t bits, uint16_t *masks)
+{
+	int i, n;
+
+	for (i = n = 0; i < 16; i++)
+		if (bits & (1 << i))
+			masks[n++] = 1 << i;
+
+	return n;
+}
+
+static void fill_random(uint8_t *buf, size_t len, uint32_t seed)
+{
+	uint32_t x;
+	size_t i;
+
+	x = seed;
+	for (i = 0; i < len; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		buf[i] = x >> 24;
+	}
+}
+
+/*
+ * Convert the data with both implementations, in transfers of the
+ * given sizes (cycled through), and compare the results bit for bit.
+ */
+static void compare(uint16_t bits, const uint8_t *data, size_t len,
+		const size_t *sizes, unsigned int num_sizes)
+{
+	struct logic16_converter conv;
+	struct reference ref;
+	uint8_t *out, *ref_out;
+	size_t pos, chunk, n, ref_n, total;
+	unsigned int i;
+
+	memset(&ref, 0, sizeof(ref));
+	ref.num_channels = masks_from_bits(bits, ref.channel_masks);
+	logic16_converter_init(&conv, ref.channel_masks, ref.num_channels);
+
+	out = g_malloc(len * 16 + 32);
+	ref_out = g_malloc(len * 16 + 32);
+
+	for (pos = total = 0, i = 0; pos < len; pos += chunk, i++) {
+		chunk = MIN(sizes[i % num_sizes], len - pos);
+		n = logic16_convert(&conv, out + total * 2, data + pos, chunk);
+		ref_n = reference_convert(&ref, ref_out + total * 2,
+				data + pos, chunk);
+		fail_unless(n == ref_n, "Sample count mismatch for mask "
+				"0x%04x at offset %zu: %zu != %zu.",
+				bits, pos, n, ref_n);
+		total += n;
+	}
+
+	fail_unless(total == len / 2 / ref.num_channels * 16,
+			"Wrong sample count for mask 0x%04x: %zu.", bits, total);
+	fail_unless(!memcmp(out, ref_out, total * 2),
+			"Sample data mismatch for mask 0x%04x.", bits);
+
+	g_free(out);
+	g_free(ref_out);
+}
+
+/* Check a single block against hand-computed samples. */
+START_TEST(test_convert_block)
+{
+	/* Channels 0 and 9: MSB first, the first word is channel 0. */
+	static const uint16_t masks[] = { 1 << 0, 1 << 9 };
+	static const uint8_t src[] = { 0x01, 0x80, 0xff, 0x00 };
+	struct logic16_converter conv;
+	uint8_t out[16 * 2];
+	size_t n;
+	int i;
+
+	logic16_converter_init(&conv, masks, ARRAY_SIZE(masks));
+
+	/* Half a block gives no samples yet. */
+	n = logic16_convert(&conv, out, src, 2);
+	fail_unless(n == 0, "Samples from an incomplete block: %zu.", n);
+	n = logic16_convert(&conv, out, src + 2, 2);
+	fail_unless(n == 16, "Wrong sample count: %zu.", n);
+
+	for (i = 0; i < 16; i++) {
+		fail_unless(out[i * 2] == (i == 0 || i == 15 ? 0x01 : 0x00),
+				"Wrong low byte of sample %d.", i);
+		fail_unless(out[i * 2 + 1] == (i >= 8 ? 0x02 : 0x00),
+				"Wrong high byte of sample %d.", i);
+	}
+}
+END_TEST
+
+/*
+ * Compare against the reference for every channel count, using both the
+ * lowest and the highest channels, in transfers of varying odd sizes.
+ */
+START_TEST(test_convert_reference)
+{
+	static const size_t sizes[] = { 2, 30, 512, 6, 1022, 4096, 34 };
+	uint8_t *data;
+	size_t len;
+	int n;
+
+	len = TEST_WORDS * 2;
+	data = g_malloc(len);
+	fill_random(data, len, 0x4c313621);
+
+	for (n = 1; n <= 16; n++) {
+		compare((1 << n) - 1, data, len, sizes, ARRAY_SIZE(sizes));
+		compare(((1 << n) - 1) << (16 - n), data, len,
+				sizes, ARRAY_SIZE(sizes));
+	}
+	/* A sparse selection spanning both output bytes. */
+	compare(0x8421, data, len, sizes, ARRAY_SIZE(sizes));
+
+	g_free(data);
+}
+END_TEST
+
+Suite *suite_logic16_convert(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("logic16_convert");
+
+	tc = tcase_create("convert");
+	tcase_add_test(tc, test_convert_block);
+	tcase_add_test(tc, test_convert_reference);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -46,6 +46,16 @@ int main(void)
 	srunner_add_suite(srunner, suite_device());
 	srunner_add_suite(srunner, suite_trigger());
 	srunner_add_suite(srunner, suite_analog());
+	srunner_add_suite(srunner, suite_framing());
+#ifndef _WIN32
+	srunner_add_suite(srunner, suite_scpi());
+#endif
+#ifdef HAVE_HW_SALEAE_LOGIC16
+	srunner_add_suite(srunner, suite_logic16_convert());
+#endif
+#ifdef HAVE_HW_RIGOL_DS
+	srunner_add_suite(srunner, suite_rigol_ds());
+#endif
 
 	srunner_run_all(srunner, CK_VERBOSE);
 	ret = srunner_ntests_failed(srunner);
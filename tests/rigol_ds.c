@@ -0,0 +1,122 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+#include <math.h>
+#include <glib.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "hardware/rigol-ds/protocol.h"
+#include "lib.h"
+
+/* Convert raw samples with the encoding set up for the given model. */
+static void convert(enum protocol_version protocol, float vdiv,
+		float offset, int vref, const uint8_t *samples,
+		unsigned int num_samples, float *volts)
+{
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	int ret;
+
+	sr_analog_init(&analog, &encoding, &meaning, &spec, 0);
+	rigol_ds_analog_encoding(&encoding, protocol, vdiv, offset, vref);
+	analog.num_samples = num_samples;
+	analog.data = (void *)samples;
+	ret = sr_analog_to_float(&analog, volts);
+	fail_unless(ret == SR_OK, "sr_analog_to_float() failed: %d.", ret);
+}
+
+/* DS2000 and later: (sample - vref) * vdiv / 25.6 - offset. */
+START_TEST(test_encoding_vref)
+{
+	static const uint8_t samples[] = { 0, 63, 127, 200, 255 };
+	float volts[ARRAY_SIZE(samples)], expected;
+	unsigned int i;
+	int protocol;
+
+	for (protocol = PROTOCOL_V3; protocol <= PROTOCOL_V4; protocol++) {
+		convert(protocol, 1.0, 0.5, 127, samples,
+				ARRAY_SIZE(samples), volts);
+		for (i = 0; i < ARRAY_SIZE(samples); i++) {
+			expected = (samples[i] - 127) / 25.6 - 0.5;
+			fail_unless(fabs(volts[i] - expected) < 1e-5,
+					"Protocol %d, sample %d: %f V instead "
+					"of %f V.", protocol, samples[i],
+					volts[i], expected);
+		}
+	}
+}
+END_TEST
+
+/* DS1000 and VS5000: (128 - sample) * vdiv / 25.6 - offset. */
+START_TEST(test_encoding_inverted)
+{
+	static const uint8_t samples[] = { 0, 28, 128, 228, 255 };
+	float volts[ARRAY_SIZE(samples)], expected;
+	unsigned int i;
+	int protocol;
+
+	for (protocol = PROTOCOL_V1; protocol <= PROTOCOL_V2; protocol++) {
+		convert(protocol, 2.56, -1.25, 0, samples,
+				ARRAY_SIZE(samples), volts);
+		for (i = 0; i < ARRAY_SIZE(samples); i++) {
+			expected = (128 - samples[i]) * 0.1 + 1.25;
+			fail_unless(fabs(volts[i] - expected) < 1e-5,
+					"Protocol %d, sample %d: %f V instead "
+					"of %f V.", protocol, samples[i],
+					volts[i], expected);
+		}
+	}
+}
+END_TEST
+
+/* Small ranges must not lose their resolution to rounding. */
+START_TEST(test_encoding_small)
+{
+	static const uint8_t samples[] = { 100, 101 };
+	float volts[ARRAY_SIZE(samples)];
+
+	convert(PROTOCOL_V4, 500e-6, 0, 100, samples,
+			ARRAY_SIZE(samples), volts);
+	fail_unless(fabs(volts[0]) < 1e-9, "Reference not at 0 V: %g V.",
+			volts[0]);
+	fail_unless(fabs(volts[1] - 500e-6 / 25.6) < 1e-9,
+			"Wrong step: %g V.", volts[1]);
+}
+END_TEST
+
+Suite *suite_rigol_ds(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("rigol_ds");
+
+	tc = tcase_create("encoding");
+	tcase_add_test(tc, test_encoding_vref);
+	tcase_add_test(tc, test_encoding_inverted);
+	tcase_add_test(tc, test_encoding_small);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,694 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "scpi.h"
+#include "lib.h"
+#include "scpi_emulator.h"
+
+/* Short, so that waiting for a missing response doesn't take long. */
+#define READ_TIMEOUT_MS		200
+/* Enough for separately sent responses to arrive one by one. */
+#define LATENCY_US		(10 * 1000)
+
+static const struct scpi_emulator_setting settings[] = {
+	{ "*IDN", "HAMEG,HMO2024,012345678,05.886" },
+	{ ":CHAN1:SCAL", "1.0E+00" },
+	{ ":CHAN1:COUP", "DCL" },
+	{ ":CHAN1:DATA:POINTS", "24000" },
+	{ ":CHAN2:STAT", "1" },
+	{ ":ACQ:SRAT", "1.0E+09" },
+	{ ":SYST:NAME", "\"scope;1\"" },
+	{ ":WAV:DATA", "#210ABCDEFGHIJ" },
+	{ ":WAV:INDF", "#0abcdef" },
+	{ ":WAV:HUGE", "#9999999999" },
+	{ ":WAV:DIGIT", "#3a10ABCDEFGHIJ" },
+	{ ":WAV:SHORT", "#9100000000ABC" },
+	{ NULL, NULL },
+};
+
+static struct scpi_emulator *emu;
+static struct sr_scpi_dev_inst *scpi;
+
+static void scpi_setup(void)
+{
+	char *resource;
+	int ret;
+
+	srtest_setup();
+
+	emu = scpi_emulator_start(0, settings, LATENCY_US);
+	fail_unless(emu != NULL, "Failed to start the SCPI emulator.");
+	resource = g_strdup_printf("tcp-raw/127.0.0.1/%d",
+			scpi_emulator_port(emu));
+	scpi = scpi_dev_inst_new(NULL, resource, NULL);
+	g_free(resource);
+	fail_unless(scpi != NULL, "Failed to create the SCPI device.");
+	ret = sr_scpi_open(scpi);
+	fail_unless(ret == SR_OK, "sr_scpi_open() failed: %d.", ret);
+	scpi->read_timeout_ms = READ_TIMEOUT_MS;
+}
+
+static void scpi_teardown(void)
+{
+	sr_scpi_close(scpi);
+	sr_scpi_free(scpi);
+	scpi_emulator_stop(emu);
+
+	srtest_teardown();
+}
+
+struct batch_results {
+	char *idn;
+	gboolean state;
+	float vdiv;
+	int points;
+	double samplerate;
+	char *name;
+	char *coupling;
+};
+
+static struct sr_scpi_batch *batch_new(struct batch_results *r)
+{
+	struct sr_scpi_batch *batch;
+
+	batch = sr_scpi_batch_new();
+	sr_scpi_batch_add_string(batch, &r->idn, "*IDN?");
+	sr_scpi_batch_add_float(batch, &r->vdiv, ":CHAN1:SCAL?");
+	/* Relative to the root only with the colon added by the batch. */
+	sr_scpi_batch_add_bool(batch, &r->state, "CHAN2:STAT?");
+	sr_scpi_batch_add_int(batch, &r->points, ":CHAN%d:DATA:POINTS?", 1);
+	sr_scpi_batch_add_double(batch, &r->samplerate, ":ACQ:SRAT?");
+	sr_scpi_batch_add_string(batch, &r->name, ":SYST:NAME?");
+
+	return batch;
+}
+
+static void batch_check(const struct batch_results *r, const char *what)
+{
+	fail_unless(r->idn && !strcmp(r->idn, settings[0].value),
+			"%s: wrong *IDN? result '%s'.", what, r->idn);
+	fail_unless(r->vdiv == 1.0 && r->state == TRUE && r->points == 24000
+			&& r->samplerate == 1e9,
+			"%s: wrong numeric results.", what);
+	fail_unless(r->name && !strcmp(r->name, "\"scope;1\""),
+			"%s: wrong :SYST:NAME? result '%s'.", what, r->name);
+}
+
+static void batch_results_free(struct batch_results *r)
+{
+	g_free(r->idn);
+	g_free(r->name);
+	g_free(r->coupling);
+	memset(r, 0, sizeof(struct batch_results));
+}
+
+/* Check that a batch is sent as one compound query. */
+START_TEST(test_batch_compound)
+{
+	struct sr_scpi_batch *batch;
+	struct scpi_emulator_stats stats;
+	struct batch_results r;
+	int ret;
+
+	memset(&r, 0, sizeof(r));
+	batch = batch_new(&r);
+	ret = sr_scpi_batch_run(scpi, batch);
+	fail_unless(ret == SR_OK, "sr_scpi_batch_run() failed: %d.", ret);
+	batch_check(&r, "compound");
+	fail_unless(!scpi->no_batch, "Batching disabled.");
+
+	scpi_emulator_get_stats(emu, &stats);
+	fail_unless(stats.messages == 1 && stats.unknown == 0,
+			"Batch took %d messages, %d unknown queries.",
+			(int)stats.messages, (int)stats.unknown);
+
+	batch_results_free(&r);
+	sr_scpi_batch_free(batch);
+}
+END_TEST
+
+/*
+ * Check the fallback to single queries on devices which answer only the
+ * first query of a compound query, don't answer at all, or send each
+ * response on its own. Nothing may be left behind for later queries.
+ */
+START_TEST(test_batch_fallback)
+{
+	static const enum scpi_emulator_compound modes[] = {
+		SCPI_EMULATOR_COMPOUND_FIRST,
+		SCPI_EMULATOR_COMPOUND_NONE,
+		SCPI_EMULATOR_COMPOUND_LINES,
+	};
+	static const char *const names[] = { "first", "none", "lines" };
+	struct sr_scpi_batch *batch;
+	struct batch_results r;
+	char *idn;
+	unsigned int i;
+	int ret;
+
+	memset(&r, 0, sizeof(r));
+	batch = batch_new(&r);
+
+	for (i = 0; i < ARRAY_SIZE(modes); i++) {
+		scpi_emulator_set_compound(emu, modes[i]);
+		scpi->no_batch = FALSE;
+
+		ret = sr_scpi_batch_run(scpi, batch);
+		fail_unless(ret == SR_OK, "%s: sr_scpi_batch_run() failed: %d.",
+				names[i], ret);
+		batch_check(&r, names[i]);
+		fail_unless(scpi->no_batch, "%s: batching not disabled.",
+				names[i]);
+		batch_results_free(&r);
+
+		/* Again, now one at a time from the start. */
+		ret = sr_scpi_batch_run(scpi, batch);
+		fail_unless(ret == SR_OK, "%s: sr_scpi_batch_run() failed: %d.",
+				names[i], ret);
+		batch_check(&r, names[i]);
+		batch_results_free(&r);
+
+		idn = NULL;
+		ret = sr_scpi_get_string(scpi, "*IDN?", &idn);
+		fail_unless(ret == SR_OK && !strcmp(idn, settings[0].value),
+				"%s: stale response '%s'.", names[i], idn);
+		g_free(idn);
+	}
+
+	sr_scpi_batch_free(batch);
+}
+END_TEST
+
+/* Check that a reply which fails to parse leaves no strings behind. */
+START_TEST(test_batch_invalid)
+{
+	struct sr_scpi_batch *batch;
+	struct batch_results r;
+	int ret;
+
+	memset(&r, 0, sizeof(r));
+	batch = sr_scpi_batch_new();
+	sr_scpi_batch_add_string(batch, &r.coupling, ":CHAN1:COUP?");
+	sr_scpi_batch_add_int(batch, &r.points, "*IDN?");
+	ret = sr_scpi_batch_run(scpi, batch);
+	fail_unless(ret == SR_ERR_DATA, "Invalid reply not reported: %d.", ret);
+	fail_unless(r.coupling == NULL, "String result left behind.");
+
+	batch_results_free(&r);
+	sr_scpi_batch_free(batch);
+}
+END_TEST
+
+static void block_check(const char *name, const GByteArray *block,
+		const char *expect, size_t len)
+{
+	fail_unless(block != NULL, "No %s block.", name);
+	fail_unless(block->len == len && !memcmp(block->data, expect, len),
+			"Block %s mismatch.", name);
+}
+
+/* Check definite and indefinite length blocks, and reuse of the array. */
+START_TEST(test_block)
+{
+	GByteArray *block, *reused;
+	GString *data;
+	unsigned int i;
+	int ret;
+
+	block = NULL;
+	ret = sr_scpi_get_block(scpi, ":WAV:DATA?", &block);
+	fail_unless(ret == SR_OK, "sr_scpi_get_block() failed: %d.", ret);
+	block_check("definite", block, "ABCDEFGHIJ", 10);
+
+	/* Larger than any single read, into the same array. */
+	data = g_string_new("#6100000");
+	for (i = 0; i < 100000; i++)
+		g_string_append_c(data, 'A' + i % 26);
+	sr_scpi_send(scpi, ":WAV:BIG %s", data->str);
+	reused = block;
+	ret = sr_scpi_get_block(scpi, ":WAV:BIG?", &block);
+	fail_unless(ret == SR_OK, "sr_scpi_get_block() failed: %d.", ret);
+	fail_unless(block == reused, "Block array not reused.");
+	block_check("large", block, data->str + 8, 100000);
+	g_string_free(data, TRUE);
+	g_byte_array_free(block, TRUE);
+
+	block = NULL;
+	ret = sr_scpi_get_block(scpi, ":WAV:INDF?", &block);
+	fail_unless(ret == SR_OK, "sr_scpi_get_block() failed: %d.", ret);
+	block_check("indefinite", block, "abcdef", 6);
+	g_byte_array_free(block, TRUE);
+}
+END_TEST
+
+/*
+ * Check that invalid block headers are rejected, and that a block which
+ * ends early times out. Each test leaves the rest of the response unread.
+ */
+START_TEST(test_block_invalid)
+{
+	static const struct {
+		const char *query;
+		int ret;
+	} cases[] = {
+		{ "*IDN?", SR_ERR_DATA },
+		/* Longer than any block accepted. */
+		{ ":WAV:HUGE?", SR_ERR_DATA },
+		{ ":WAV:DIGIT?", SR_ERR_DATA },
+		{ ":WAV:SHORT?", SR_ERR_TIMEOUT },
+	};
+	GByteArray *block;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(cases); i++) {
+		block = NULL;
+		ret = sr_scpi_get_block(scpi, cases[i].query, &block);
+		fail_unless(ret == cases[i].ret && block == NULL,
+				"%s: expected %d, got %d.", cases[i].query,
+				cases[i].ret, ret);
+		/* Get rid of what's left. */
+		sr_scpi_close(scpi);
+		ret = sr_scpi_open(scpi);
+		fail_unless(ret == SR_OK, "sr_scpi_open() failed: %d.", ret);
+	}
+}
+END_TEST
+
+/* Two instruments queried concurrently from one session. */
+#define ASYNC_DEVICES		2
+#define ASYNC_LATENCY_US	(100 * 1000)
+#define ASYNC_TIMEOUT_MS	250
+/* Well within the timeout of the test. */
+#define ASYNC_DEADLINE_US	(2 * 1000 * 1000)
+
+static const struct {
+	const char *request;
+	gboolean query;
+	const char *result;
+} async_requests[] = {
+	{ ":CHAN1:SCAL 2.0E+00", FALSE, "sent" },
+	{ ":CHAN1:SCAL?", TRUE, "2.0E+00" },
+	{ "*IDN?", TRUE, "HAMEG,HMO2024,012345678,05.886" },
+	/* Unknown to the emulator, which doesn't answer it. */
+	{ ":SYST:NOPE?", TRUE, "timeout" },
+	{ ":ACQ:SRAT?", TRUE, "1.0E+09" },
+};
+
+struct async_dev {
+	struct scpi_emulator *emu;
+	struct sr_scpi_dev_inst *scpi;
+	struct sr_dev_inst *sdi;
+	/* Results, in the order the callbacks were called. */
+	GPtrArray *results;
+	/* Completion number, over all devices, of the first and last result. */
+	int first;
+	int last;
+	gboolean cancelled_called;
+};
+
+static struct async_dev async_devs[ASYNC_DEVICES];
+static struct sr_session *async_session;
+static gint64 async_deadline;
+static int async_completions;
+
+static void async_done(struct sr_scpi_dev_inst *scpi, int result,
+		const char *response, void *cb_data)
+{
+	struct async_dev *dev;
+
+	(void)scpi;
+
+	dev = cb_data;
+	if (result == SR_ERR_TIMEOUT)
+		g_ptr_array_add(dev->results, g_strdup("timeout"));
+	else if (result != SR_OK)
+		g_ptr_array_add(dev->results, g_strdup(sr_strerror(result)));
+	else
+		g_ptr_array_add(dev->results, g_strdup(response ? response : "sent"));
+
+	if (dev->results->len == 1)
+		dev->first = async_completions;
+	dev->last = async_completions++;
+}
+
+static void async_cancelled(struct sr_scpi_dev_inst *scpi, int result,
+		const char *response, void *cb_data)
+{
+	struct async_dev *dev;
+
+	(void)scpi;
+	(void)result;
+	(void)response;
+
+	dev = cb_data;
+	dev->cancelled_called = TRUE;
+}
+
+static int async_dev_open(struct sr_dev_inst *sdi)
+{
+	(void)sdi;
+
+	return SR_OK;
+}
+
+static int async_acquisition_start(const struct sr_dev_inst *sdi,
+		void *cb_data)
+{
+	struct async_dev *dev;
+	unsigned int i;
+	int ret;
+
+	(void)cb_data;
+
+	dev = sdi->priv;
+	std_session_send_df_header(sdi, "scpi-async-test");
+
+	for (i = 0; i < ARRAY_SIZE(async_requests); i++) {
+		if (async_requests[i].query)
+			ret = sr_scpi_get_string_async(sdi->session, sdi->conn,
+					async_done, dev, "%s",
+					async_requests[i].request);
+		else
+			ret = sr_scpi_send_async(sdi->session, sdi->conn,
+					async_done, dev, "%s",
+					async_requests[i].request);
+		if (ret != SR_OK)
+			return ret;
+	}
+
+	return SR_OK;
+}
+
+static int async_acquisition_stop(struct sr_dev_inst *sdi, void *cb_data)
+{
+	struct sr_datafeed_packet packet;
+
+	(void)cb_data;
+
+	sr_scpi_async_cancel(sdi->conn);
+
+	packet.type = SR_DF_END;
+	sr_session_send(sdi, &packet);
+
+	return SR_OK;
+}
+
+static struct sr_dev_driver async_driver = {
+	.name = "scpi-async-test",
+	.longname = "Asynchronous SCPI test",
+	.api_version = 1,
+	.dev_open = async_dev_open,
+	.dev_acquisition_start = async_acquisition_start,
+	.dev_acquisition_stop = async_acquisition_stop,
+};
+
+/* Stop the session with a query in flight once all others completed. */
+static gboolean async_stop_check(void *data)
+{
+	unsigned int i;
+
+	(void)data;
+
+	for (i = 0; i < ASYNC_DEVICES; i++) {
+		if (async_devs[i].results->len < ARRAY_SIZE(async_requests)
+				&& g_get_monotonic_time() < async_deadline)
+			return G_SOURCE_CONTINUE;
+	}
+
+	/* Sent right away, so dev_acquisition_stop() has to discard it. */
+	for (i = 0; i < ASYNC_DEVICES; i++)
+		sr_scpi_get_string_async(async_session, async_devs[i].scpi,
+				async_cancelled, &async_devs[i], "*IDN?");
+	sr_session_stop(async_session);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void async_dev_new(struct async_dev *dev)
+{
+	char *resource;
+	int ret;
+
+	memset(dev, 0, sizeof(struct async_dev));
+	dev->results = g_ptr_array_new_with_free_func(g_free);
+
+	dev->emu = scpi_emulator_start(0, settings, ASYNC_LATENCY_US);
+	fail_unless(dev->emu != NULL, "Failed to start the SCPI emulator.");
+	resource = g_strdup_printf("tcp-raw/127.0.0.1/%d",
+			scpi_emulator_port(dev->emu));
+	dev->scpi = scpi_dev_inst_new(NULL, resource, NULL);
+	g_free(resource);
+	fail_unless(dev->scpi != NULL, "Failed to create the SCPI device.");
+	ret = sr_scpi_open(dev->scpi);
+	fail_unless(ret == SR_OK, "sr_scpi_open() failed: %d.", ret);
+	dev->scpi->read_timeout_ms = ASYNC_TIMEOUT_MS;
+
+	dev->sdi = sr_dev_inst_user_new("Hameg", "HMO2024", NULL);
+	sr_dev_inst_channel_add(dev->sdi, 0, SR_CHANNEL_ANALOG, "CH1");
+	dev->sdi->driver = &async_driver;
+	dev->sdi->status = SR_ST_ACTIVE;
+	dev->sdi->conn = dev->scpi;
+	dev->sdi->priv = dev;
+
+	ret = sr_session_dev_add(async_session, dev->sdi);
+	fail_unless(ret == SR_OK, "sr_session_dev_add() failed: %d.", ret);
+}
+
+static void async_dev_free(struct async_dev *dev)
+{
+	sr_dev_inst_free(dev->sdi);
+	sr_scpi_close(dev->scpi);
+	sr_scpi_free(dev->scpi);
+	scpi_emulator_stop(dev->emu);
+	g_ptr_array_free(dev->results, TRUE);
+}
+
+static void async_dev_check(struct async_dev *dev, int num)
+{
+	const char *result;
+	char *idn;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < ARRAY_SIZE(async_requests); i++) {
+		fail_unless(i < dev->results->len, "Device %d: '%s' not "
+				"completed.", num, async_requests[i].request);
+		result = g_ptr_array_index(dev->results, i);
+		fail_unless(!strcmp(result, async_requests[i].result),
+				"Device %d: '%s' gave '%s', not '%s'.", num,
+				async_requests[i].request, result,
+				async_requests[i].result);
+	}
+	fail_unless(dev->results->len == ARRAY_SIZE(async_requests),
+			"Device %d: too many completions.", num);
+
+	fail_unless(!dev->cancelled_called, "Device %d: callback of a "
+			"cancelled query called.", num);
+	fail_unless(sr_scpi_async_pending(dev->scpi) == 0,
+			"Device %d: requests left pending.", num);
+
+	/* The response to the cancelled query must not be left behind. */
+	idn = NULL;
+	ret = sr_scpi_get_string(dev->scpi, "*IDN?", &idn);
+	fail_unless(ret == SR_OK && !strcmp(idn, settings[0].value),
+			"Device %d: not idle after cancelling.", num);
+	g_free(idn);
+}
+
+/*
+ * Check that the asynchronous requests of each instrument complete in
+ * order, that both instruments are waited on at once, that a query
+ * without an answer times out, and that a query still in flight is
+ * cancelled by dev_acquisition_stop().
+ */
+START_TEST(test_async)
+{
+	unsigned int i;
+	int ret;
+
+	async_completions = 0;
+	ret = sr_session_new(srtest_ctx, &async_session);
+	fail_unless(ret == SR_OK, "sr_session_new() failed: %d.", ret);
+	for (i = 0; i < ASYNC_DEVICES; i++)
+		async_dev_new(&async_devs[i]);
+
+	ret = sr_session_start(async_session);
+	fail_unless(ret == SR_OK, "sr_session_start() failed: %d.", ret);
+	async_deadline = g_get_monotonic_time() + ASYNC_DEADLINE_US;
+	g_timeout_add(10, async_stop_check, NULL);
+	sr_session_run(async_session);
+
+	for (i = 0; i < ASYNC_DEVICES; i++)
+		async_dev_check(&async_devs[i], i);
+	fail_unless(async_devs[1].first <= async_devs[0].last,
+			"Devices were queried one after the other.");
+
+	sr_session_destroy(async_session);
+	for (i = 0; i < ASYNC_DEVICES; i++)
+		async_dev_free(&async_devs[i]);
+}
+END_TEST
+
+#ifdef HAVE_HW_SCPI_PPS
+/* Measurements taken of each of the six channels, one round each. */
+#define PPS_PACKETS		6
+
+static const struct scpi_emulator_setting pps_settings[] = {
+	{ "*IDN", "RIGOL TECHNOLOGIES,DP821A,DP8A000000,00.01.14" },
+	{ ":SYST:BEEP:STAT", "0" },
+	{ ":MEAS:VOLT", "12.5" },
+	{ ":MEAS:CURR", "0.25" },
+	{ ":MEAS:POWE", "3.125" },
+	{ NULL, NULL },
+};
+
+struct pps_check {
+	struct sr_session *session;
+	int packets;
+	int wrong;
+	gboolean ended;
+};
+
+static void pps_datafeed(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_analog *analog;
+	struct pps_check *check;
+	float expected;
+
+	(void)sdi;
+
+	check = cb_data;
+	if (packet->type == SR_DF_END)
+		check->ended = TRUE;
+	if (packet->type != SR_DF_ANALOG)
+		return;
+
+	analog = packet->payload;
+	if (analog->meaning->mq == SR_MQ_VOLTAGE)
+		expected = 12.5;
+	else if (analog->meaning->mq == SR_MQ_CURRENT)
+		expected = 0.25;
+	else
+		expected = 3.125;
+	if (analog->num_samples != 1
+			|| ((const float *)analog->data)[0] != expected)
+		check->wrong++;
+
+	if (++check->packets == PPS_PACKETS)
+		sr_session_stop(check->session);
+}
+
+/*
+ * Check that scpi-pps polls its measurements through asynchronous
+ * queries, and leaves the device idle once stopped.
+ */
+START_TEST(test_pps)
+{
+	struct scpi_emulator *pps;
+	struct sr_dev_driver *driver;
+	struct sr_dev_inst *sdi;
+	struct pps_check check;
+	GSList *options, *devices;
+	char *resource, *idn;
+	int ret;
+
+	pps = scpi_emulator_start(0, pps_settings, LATENCY_US);
+	fail_unless(pps != NULL, "Failed to start the SCPI emulator.");
+	resource = g_strdup_printf("tcp-raw/127.0.0.1/%d",
+			scpi_emulator_port(pps));
+
+	driver = srtest_driver_get("scpi-pps");
+	srtest_driver_init(srtest_ctx, driver);
+	options = g_slist_append(NULL, sr_config_new(SR_CONF_CONN,
+			g_variant_new_string(resource)));
+	devices = sr_driver_scan(driver, options);
+	g_slist_free_full(options, (GDestroyNotify)sr_config_free);
+	g_free(resource);
+	fail_unless(g_slist_length(devices) == 1, "DP821A not found.");
+	sdi = devices->data;
+	g_slist_free(devices);
+	ret = sr_dev_open(sdi);
+	fail_unless(ret == SR_OK, "sr_dev_open() failed: %d.", ret);
+
+	memset(&check, 0, sizeof(check));
+	sr_session_new(srtest_ctx, &check.session);
+	sr_session_dev_add(check.session, sdi);
+	sr_session_datafeed_callback_add(check.session, pps_datafeed, &check);
+	ret = sr_session_start(check.session);
+	fail_unless(ret == SR_OK, "sr_session_start() failed: %d.", ret);
+	sr_session_run(check.session);
+
+	fail_unless(check.packets >= PPS_PACKETS && check.ended,
+			"Got %d measurements.", check.packets);
+	fail_unless(check.wrong == 0, "%d wrong measurements.", check.wrong);
+	fail_unless(sr_scpi_async_pending(sdi->conn) == 0,
+			"Requests left pending.");
+
+	idn = NULL;
+	ret = sr_scpi_get_string(sdi->conn, "*IDN?", &idn);
+	fail_unless(ret == SR_OK && !strcmp(idn, pps_settings[0].value),
+			"Not idle after stopping.");
+	g_free(idn);
+
+	sr_session_destroy(check.session);
+	sr_dev_close(sdi);
+	scpi_emulator_stop(pps);
+}
+END_TEST
+#endif
+
+Suite *suite_scpi(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("scpi");
+
+	tc = tcase_create("batch");
+	tcase_add_checked_fixture(tc, scpi_setup, scpi_teardown);
+	tcase_add_test(tc, test_batch_compound);
+	tcase_add_test(tc, test_batch_fallback);
+	tcase_add_test(tc, test_batch_invalid);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("block");
+	tcase_add_checked_fixture(tc, scpi_setup, scpi_teardown);
+	tcase_add_test(tc, test_block);
+	tcase_add_test(tc, test_block_invalid);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("async");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_async);
+#ifdef HAVE_HW_SCPI_PPS
+	tcase_add_test(tc, test_pps);
+#endif
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,317 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "scpi_emulator.h"
+
+/* How often the server thread checks whether it should stop. */
+#define POLL_INTERVAL_MS 50
+
+struct scpi_emulator {
+	int listen_fd;
+	int port;
+	unsigned int latency_us;
+	enum scpi_emulator_compound compound;
+	/* Setting values by upper case header. */
+	GHashTable *settings;
+	struct scpi_emulator_stats stats;
+	GMutex mutex;
+	GThread *thread;
+	gint stop;
+};
+
+/* Split off the next command of a message, honoring quoted strings. */
+static char *next_command(char **msg)
+{
+	char *start, *p, quote;
+
+	if (!*msg)
+		return NULL;
+
+	start = *msg;
+	quote = '\0';
+	for (p = start; *p; p++) {
+		if (quote) {
+			if (*p == quote)
+				quote = '\0';
+		} else if (*p == '"' || *p == '\'') {
+			quote = *p;
+		} else if (*p == ';') {
+			*p = '\0';
+			*msg = p + 1;
+			return g_strstrip(start);
+		}
+	}
+	*msg = NULL;
+
+	return g_strstrip(start);
+}
+
+/* Handle one message, appending the responses to reply. */
+static void handle_message(struct scpi_emulator *emu, char *msg,
+		GString *reply)
+{
+	GString *header;
+	char *cmd, *args, *key, *last;
+	const char *value;
+	gboolean query;
+	int num_replies;
+
+	header = g_string_new("");
+	/* The current path, up to and including the last colon. */
+	last = g_strdup(":");
+	num_replies = 0;
+
+	g_mutex_lock(&emu->mutex);
+	emu->stats.messages++;
+
+	while ((cmd = next_command(&msg))) {
+		if (!*cmd)
+			continue;
+
+		args = cmd + strcspn(cmd, " \t");
+		if (*args)
+			*args++ = '\0';
+		args = g_strstrip(args);
+
+		query = cmd[strlen(cmd) - 1] == '?';
+		if (query)
+			cmd[strlen(cmd) - 1] = '\0';
+
+		if (cmd[0] == '*' || cmd[0] == ':') {
+			g_string_assign(header, cmd);
+		} else {
+			g_string_assign(header, last);
+			g_string_append(header, cmd);
+		}
+		if (header->str[0] != '*') {
+			g_free(last);
+			last = g_strndup(header->str,
+				strrchr(header->str, ':') - header->str + 1);
+		}
+
+		key = g_ascii_strup(header->str, -1);
+		if (query) {
+			emu->stats.queries++;
+			if ((value = g_hash_table_lookup(emu->settings, key))) {
+				if (num_replies++)
+					g_string_append_c(reply,
+						emu->compound == SCPI_EMULATOR_COMPOUND_LINES
+						? '\n' : ';');
+				g_string_append(reply, value);
+			} else {
+				emu->stats.unknown++;
+			}
+			g_free(key);
+		} else {
+			g_hash_table_insert(emu->settings, key, g_strdup(args));
+		}
+
+		/* Instruments without compound support ignore the rest. */
+		if (emu->compound == SCPI_EMULATOR_COMPOUND_FIRST)
+			break;
+		/* Or the whole message, once they notice. */
+		if (emu->compound == SCPI_EMULATOR_COMPOUND_NONE && msg) {
+			g_string_truncate(reply, 0);
+			num_replies = 0;
+			break;
+		}
+	}
+
+	g_mutex_unlock(&emu->mutex);
+
+	if (num_replies)
+		g_string_append_c(reply, '\n');
+
+	g_free(last);
+	g_string_free(header, TRUE);
+}
+
+static void serve_client(struct scpi_emulator *emu, int fd)
+{
+	struct pollfd pfd;
+	GString *input, *reply;
+	char buf[1024], *line, *end;
+	size_t pos, chunk;
+	ssize_t len, sent;
+
+	input = g_string_new("");
+	reply = g_string_new("");
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+
+	while (!g_atomic_int_get(&emu->stop)) {
+		if (poll(&pfd, 1, POLL_INTERVAL_MS) <= 0)
+			continue;
+		if ((len = recv(fd, buf, sizeof(buf), 0)) <= 0)
+			break;
+		g_string_append_len(input, buf, len);
+
+		/* Messages are terminated by a linefeed. */
+		while ((end = memchr(input->str, '\n', input->len))) {
+			line = g_strndup(input->str, end - input->str);
+			g_string_erase(input, 0, end - input->str + 1);
+			g_string_truncate(reply, 0);
+			handle_message(emu, line, reply);
+			g_free(line);
+			/*
+			 * Each line at once, for the tcp-raw read completion
+			 * check. There's only one, unless the responses are
+			 * sent separately.
+			 */
+			for (pos = 0; pos < reply->len; pos += chunk) {
+				end = memchr(reply->str + pos, '\n',
+						reply->len - pos);
+				chunk = end - (reply->str + pos) + 1;
+				if (emu->latency_us)
+					g_usleep(emu->latency_us);
+				sent = send(fd, reply->str + pos, chunk, 0);
+				if (sent != (ssize_t)chunk)
+					fprintf(stderr, "scpi_emulator: "
+						"Short send.\n");
+			}
+		}
+	}
+
+	g_string_free(input, TRUE);
+	g_string_free(reply, TRUE);
+}
+
+static gpointer server_thread(gpointer data)
+{
+	struct scpi_emulator *emu;
+	struct pollfd pfd;
+	int fd;
+
+	emu = data;
+	pfd.fd = emu->listen_fd;
+	pfd.events = POLLIN;
+
+	while (!g_atomic_int_get(&emu->stop)) {
+		if (poll(&pfd, 1, POLL_INTERVAL_MS) <= 0)
+			continue;
+		if ((fd = accept(emu->listen_fd, NULL, NULL)) < 0)
+			continue;
+		serve_client(emu, fd);
+		close(fd);
+	}
+
+	return NULL;
+}
+
+/**
+ * Start an emulated instrument, listening on localhost.
+ *
+ * @param port The TCP port to listen on, or 0 for any free port.
+ * @param settings The initial settings, terminated by an entry with
+ *        a NULL header.
+ * @param latency_us Delay before answering a message.
+ *
+ * @return The emulator, or NULL if the port couldn't be opened.
+ */
+struct scpi_emulator *scpi_emulator_start(int port,
+		const struct scpi_emulator_setting *settings,
+		unsigned int latency_us)
+{
+	struct scpi_emulator *emu;
+	struct sockaddr_in addr;
+	socklen_t addrlen;
+	int fd, on;
+
+	if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+		return NULL;
+	on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	addrlen = sizeof(addr);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+			listen(fd, 1) < 0 ||
+			getsockname(fd, (struct sockaddr *)&addr, &addrlen) < 0) {
+		fprintf(stderr, "scpi_emulator: Failed to listen on port %d: "
+			"%s\n", port, g_strerror(errno));
+		close(fd);
+		return NULL;
+	}
+
+	emu = g_malloc0(sizeof(struct scpi_emulator));
+	emu->listen_fd = fd;
+	emu->port = ntohs(addr.sin_port);
+	emu->latency_us = latency_us;
+	emu->compound = SCPI_EMULATOR_COMPOUND_ALL;
+	emu->settings = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, g_free);
+	for (; settings->header; settings++)
+		g_hash_table_insert(emu->settings,
+			g_ascii_strup(settings->header, -1),
+			g_strdup(settings->value));
+	g_mutex_init(&emu->mutex);
+	emu->thread = g_thread_new("scpi-emulator", server_thread, emu);
+
+	return emu;
+}
+
+void scpi_emulator_stop(struct scpi_emulator *emu)
+{
+	g_atomic_int_set(&emu->stop, 1);
+	g_thread_join(emu->thread);
+	close(emu->listen_fd);
+	g_hash_table_destroy(emu->settings);
+	g_mutex_clear(&emu->mutex);
+	g_free(emu);
+}
+
+int scpi_emulator_port(const struct scpi_emulator *emu)
+{
+	return emu->port;
+}
+
+void scpi_emulator_set_compound(struct scpi_emulator *emu,
+		enum scpi_emulator_compound compound)
+{
+	g_mutex_lock(&emu->mutex);
+	emu->compound = compound;
+	g_mutex_unlock(&emu->mutex);
+}
+
+void scpi_emulator_get_stats(struct scpi_emulator *emu,
+		struct scpi_emulator_stats *stats)
+{
+	g_mutex_lock(&emu->mutex);
+	*stats = emu->stats;
+	g_mutex_unlock(&emu->mutex);
+}
+
+void scpi_emulator_reset_stats(struct scpi_emulator *emu)
+{
+	g_mutex_lock(&emu->mutex);
+	memset(&emu->stats, 0, sizeof(emu->stats));
+	g_mutex_unlock(&emu->mutex);
+}
@@ -0,0 +1,81 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBSIGROK_TESTS_SCPI_EMULATOR_H
+#define LIBSIGROK_TESTS_SCPI_EMULATOR_H
+
+#include <stdint.h>
+#include <glib.h>
+
+/*
+ * A stand-in SCPI instrument on a TCP port, for use with the tcp-raw
+ * transport.
+ *
+ * The instrument is a table of settings. "<header>?" answers the value
+ * of a setting, "<header> <value>" changes it. Headers are matched
+ * exactly, after resolving them against the current path the way
+ * compound messages ("A:B?;C?;:D?") are resolved by real instruments.
+ * Unknown queries are answered with nothing, as their errors would
+ * only end up in the error queue.
+ *
+ * The responses to all queries in a message are joined with semicolons
+ * and sent at once, after the configured latency.
+ */
+
+/* How messages with more than one command are handled. */
+enum scpi_emulator_compound {
+	/* All commands are handled. */
+	SCPI_EMULATOR_COMPOUND_ALL,
+	/* Only the first command is handled, the rest is ignored. */
+	SCPI_EMULATOR_COMPOUND_FIRST,
+	/* The message is rejected, without an answer. */
+	SCPI_EMULATOR_COMPOUND_NONE,
+	/* Each response is sent on its own, after the latency. */
+	SCPI_EMULATOR_COMPOUND_LINES,
+};
+
+struct scpi_emulator_setting {
+	/* Full header, starting with a colon or asterisk. */
+	const char *header;
+	const char *value;
+};
+
+struct scpi_emulator_stats {
+	/* Messages (lines) received. */
+	uint64_t messages;
+	/* Queries answered. */
+	uint64_t queries;
+	/* Queries for unknown settings. */
+	uint64_t unknown;
+};
+
+struct scpi_emulator;
+
+struct scpi_emulator *scpi_emulator_start(int port,
+		const struct scpi_emulator_setting *settings,
+		unsigned int latency_us);
+void scpi_emulator_stop(struct scpi_emulator *emu);
+int scpi_emulator_port(const struct scpi_emulator *emu);
+void scpi_emulator_set_compound(struct scpi_emulator *emu,
+		enum scpi_emulator_compound compound);
+void scpi_emulator_get_stats(struct scpi_emulator *emu,
+		struct scpi_emulator_stats *stats);
+void scpi_emulator_reset_stats(struct scpi_emulator *emu);
+
+#endif
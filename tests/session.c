@@ -20,8 +20,11 @@
 
 #include <config.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
 #include "lib.h"
 
 /*
@@ -186,6 +189,654 @@ START_TEST(test_session_trigger_get_null)
 }
 END_TEST
 
+static void datafeed_nop(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	(void)sdi;
+	(void)packet;
+	(void)cb_data;
+}
+
+/* Without sr_session_stats_enable(), there are no statistics. */
+START_TEST(test_session_stats_disabled)
+{
+	int ret;
+	struct sr_session *sess;
+	GSList *stats;
+
+	sr_session_new(srtest_ctx, &sess);
+	ret = sr_session_stats_get(sess, &stats);
+	fail_unless(ret == SR_ERR_NA);
+	fail_unless(stats == NULL);
+	ret = sr_session_stats_get(NULL, &stats);
+	fail_unless(ret == SR_ERR_ARG);
+	sr_session_destroy(sess);
+}
+END_TEST
+
+/* Feed data through the binary input module and check the statistics. */
+START_TEST(test_session_stats)
+{
+	int ret, num_send, num_callback;
+	unsigned int i;
+	uint64_t sum;
+	struct sr_session *sess;
+	const struct sr_input *in;
+	struct sr_session_stats *st;
+	GString *buf;
+	GSList *stats, *l;
+
+	sr_session_new(srtest_ctx, &sess);
+	sr_session_datafeed_callback_add(sess, datafeed_nop, NULL);
+	sr_session_datafeed_callback_add(sess, datafeed_nop, NULL);
+	ret = sr_session_stats_enable(sess, TRUE);
+	fail_unless(ret == SR_OK);
+
+	in = sr_input_new(sr_input_find("binary"), NULL);
+	fail_unless(in != NULL);
+	sr_session_dev_add(sess, sr_input_dev_inst_get(in));
+	buf = g_string_new(NULL);
+	g_string_set_size(buf, 100000);
+	sr_input_send(in, buf);
+	sr_input_end(in);
+	g_string_free(buf, TRUE);
+
+	ret = sr_session_stats_get(sess, &stats);
+	fail_unless(ret == SR_OK);
+	num_send = num_callback = 0;
+	for (l = stats; l; l = l->next) {
+		st = l->data;
+		fail_unless(st->sdi == sr_input_dev_inst_get(in));
+		for (i = 0, sum = 0; i < SR_STATS_HISTOGRAM_BUCKETS; i++)
+			sum += st->histogram[i];
+		fail_unless(sum == st->count);
+		fail_unless(st->max_ns <= st->total_ns);
+		if (st->stage == SR_STAGE_SEND) {
+			/* Header, logic data, end. */
+			fail_unless(st->count >= 3);
+			fail_unless(st->bytes == 100000);
+			num_send++;
+		} else if (st->stage == SR_STAGE_CALLBACK) {
+			fail_unless(st->index == 0 || st->index == 1);
+			fail_unless(st->bytes == 100000);
+			num_callback++;
+		}
+	}
+	fail_unless(num_send == 1);
+	fail_unless(num_callback == 2);
+	g_slist_free_full(stats, g_free);
+
+	/* Reset, then disable. */
+	sr_session_stats_reset(sess);
+	ret = sr_session_stats_get(sess, &stats);
+	fail_unless(ret == SR_OK && stats == NULL);
+	sr_session_stats_enable(sess, FALSE);
+	ret = sr_session_stats_get(sess, &stats);
+	fail_unless(ret == SR_ERR_NA);
+
+	sr_session_destroy(sess);
+	sr_input_free(in);
+}
+END_TEST
+
+struct time_check {
+	const struct sr_dev_inst *sdi;
+	int num_packets;
+	/* Position of the next sample. */
+	uint64_t next_sample;
+	gboolean ended;
+};
+
+/* Check that the sample positions of each device follow each other. */
+static void datafeed_time_check(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	struct time_check *checks;
+	const struct sr_datafeed_logic *logic;
+
+	fail_unless(packet->time != NULL);
+	for (checks = cb_data; checks->sdi != sdi; checks++)
+		fail_unless(checks->sdi != NULL);
+	checks->num_packets++;
+
+	switch (packet->type) {
+	case SR_DF_HEADER:
+		fail_unless(packet->time->sample == 0);
+		checks->next_sample = 0;
+		break;
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		fail_unless(packet->time->sample == checks->next_sample);
+		checks->next_sample += logic->length / logic->unitsize;
+		break;
+	case SR_DF_END:
+		fail_unless(packet->time->sample == checks->next_sample);
+		checks->ended = TRUE;
+		break;
+	}
+}
+
+static void datafeed_merge(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	sr_session_merge_push(cb_data, sdi, packet);
+}
+
+/* Send the same data through the binary input modules in turns. */
+static void send_binary(const struct sr_input **in, int num_in)
+{
+	GString *buf;
+	int i, j;
+
+	buf = g_string_new(NULL);
+	g_string_set_size(buf, 10000);
+	for (i = 0; i < 5; i++)
+		for (j = 0; j < num_in; j++)
+			sr_input_send(in[j], buf);
+	for (j = 0; j < num_in; j++)
+		sr_input_end(in[j]);
+	g_string_free(buf, TRUE);
+}
+
+/* Packets are stamped with the sample position of their first sample. */
+START_TEST(test_session_time)
+{
+	int ret;
+	struct sr_session *sess;
+	const struct sr_input *in;
+	struct time_check checks[2];
+	struct sr_session_clock clock;
+
+	sr_session_new(srtest_ctx, &sess);
+	in = sr_input_new(sr_input_find("binary"), NULL);
+	fail_unless(in != NULL);
+	sr_session_dev_add(sess, sr_input_dev_inst_get(in));
+
+	ret = sr_session_clock_get(sess, sr_input_dev_inst_get(in), &clock);
+	fail_unless(ret == SR_ERR_NA);
+
+	memset(checks, 0, sizeof(checks));
+	checks[0].sdi = sr_input_dev_inst_get(in);
+	sr_session_datafeed_callback_add(sess, datafeed_time_check, checks);
+	send_binary(&in, 1);
+
+	fail_unless(checks[0].ended);
+	/* One byte per sample. */
+	fail_unless(checks[0].next_sample == 5 * 10000);
+
+	ret = sr_session_clock_get(sess, sr_input_dev_inst_get(in), &clock);
+	fail_unless(ret == SR_OK);
+	fail_unless(clock.samplerate == 0);
+	fail_unless(clock.observations > 0);
+
+	sr_session_destroy(sess);
+	sr_input_free(in);
+}
+END_TEST
+
+/* Merging keeps all packets, and the order of those of each device. */
+START_TEST(test_session_merge)
+{
+	struct sr_session *sess;
+	struct sr_session_merge *merge;
+	const struct sr_input *in[2];
+	struct time_check checks[3];
+	int i, num_packets;
+
+	sr_session_new(srtest_ctx, &sess);
+	memset(checks, 0, sizeof(checks));
+	for (i = 0; i < 2; i++) {
+		in[i] = sr_input_new(sr_input_find("binary"), NULL);
+		fail_unless(in[i] != NULL);
+		sr_session_dev_add(sess, sr_input_dev_inst_get(in[i]));
+		checks[i].sdi = sr_input_dev_inst_get(in[i]);
+	}
+
+	fail_unless(sr_session_merge_new(NULL, 0, datafeed_nop, NULL) == NULL);
+	merge = sr_session_merge_new(sess, G_MAXINT64,
+			datafeed_time_check, checks);
+	fail_unless(merge != NULL);
+	sr_session_datafeed_callback_add(sess, datafeed_merge, merge);
+	send_binary(in, 2);
+	sr_session_merge_flush(merge);
+
+	num_packets = 0;
+	for (i = 0; i < 2; i++) {
+		fail_unless(checks[i].ended);
+		fail_unless(checks[i].next_sample == 5 * 10000);
+		num_packets += checks[i].num_packets;
+	}
+	fail_unless(num_packets > 2 * 3);
+
+	sr_session_merge_free(merge);
+	sr_session_destroy(sess);
+	for (i = 0; i < 2; i++)
+		sr_input_free(in[i]);
+}
+END_TEST
+
+/* Stamp a packet as sent by a device at the given monotonic time. */
+static void clock_stamp(struct sr_dev_clock *clock, int type,
+		uint64_t num_samples, int64_t monotonic_us,
+		struct sr_datafeed_time *time)
+{
+	static uint8_t data[1000];
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+
+	fail_unless(num_samples <= sizeof(data));
+	logic.length = num_samples;
+	logic.unitsize = 1;
+	logic.data = data;
+	packet.type = type;
+	packet.payload = (type == SR_DF_LOGIC) ? &logic : NULL;
+	packet.time = NULL;
+	memset(time, 0, sizeof(*time));
+	time->monotonic_us = monotonic_us;
+	sr_dev_clock_stamp(clock, &packet, time);
+}
+
+/*
+ * A device with a nominal samplerate of 1 MHz actually taking 1.001 us
+ * per sample, which sends 1000 samples at a time with a latency of
+ * 500 us, is measured to run at 999000.999 Hz, with a drift of about
+ * -999 ppm. Its packets are mapped onto the timeline accordingly.
+ */
+START_TEST(test_dev_clock_fit)
+{
+	struct sr_dev_clock *clock;
+	struct sr_datafeed_time time;
+	struct sr_session_clock info;
+	const int64_t zero_us = 1000000;
+	int64_t sent_us;
+	int i;
+
+	clock = sr_dev_clock_new(SR_MHZ(1), zero_us);
+	clock_stamp(clock, SR_DF_HEADER, 0, zero_us, &time);
+	fail_unless(time.sample == 0);
+	fail_unless(time.samplerate == SR_MHZ(1));
+
+	for (i = 0; i < 100; i++) {
+		/* Sent once the last sample of the packet was taken. */
+		sent_us = zero_us + 500 + (i + 1) * 1001;
+		clock_stamp(clock, SR_DF_LOGIC, 1000, sent_us, &time);
+		fail_unless(time.sample == (uint64_t)i * 1000);
+
+		sr_dev_clock_info(clock, &info);
+		fail_unless(info.samplerate == SR_MHZ(1));
+		fail_unless(info.observations == (uint64_t)i + 1);
+		if (i + 1 < 8) {
+			/* Too few observations for a fit of its own. */
+			fail_unless(info.measured_samplerate == 0);
+			fail_unless(info.drift_ppm == 0);
+			continue;
+		}
+		fail_unless(fabs(info.measured_samplerate - 1e6 / 1.001) < 1e-3,
+			"Measured %f Hz.", info.measured_samplerate);
+		fail_unless(fabs(info.drift_ppm - (1e6 / 1.001 - 1e6)) < 1e-3,
+			"Drift is %f ppm.", info.drift_ppm);
+		/* The first sample of the packet, at 500 + i * 1001 us. */
+		fail_unless(llabs(time.timeline_ns - (500 + i * 1001) * 1000) <= 1,
+			"Packet %d at %" PRId64 " ns.", i, time.timeline_ns);
+		fail_unless(llabs(info.offset_ns - 500 * 1000) <= 1);
+	}
+
+	/* A new acquisition starts from the nominal samplerate again. */
+	clock_stamp(clock, SR_DF_HEADER, 0, sent_us, &time);
+	sr_dev_clock_info(clock, &info);
+	fail_unless(info.observations == 0);
+	fail_unless(info.measured_samplerate == 0);
+
+	sr_dev_clock_free(clock);
+}
+END_TEST
+
+struct merge_check {
+	const struct sr_dev_inst *sdi[8];
+	int64_t timeline_ns[8];
+	int num_packets;
+};
+
+static void datafeed_merge_check(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	struct merge_check *mc;
+
+	mc = cb_data;
+	fail_unless(mc->num_packets < 8);
+	mc->sdi[mc->num_packets] = sdi;
+	mc->timeline_ns[mc->num_packets] = packet->time->timeline_ns;
+	mc->num_packets++;
+}
+
+/* Push a packet stamped with a time on the timeline into a merger. */
+static void merge_push(struct sr_session_merge *merge,
+		const struct sr_dev_inst *sdi, int type, int64_t timeline_ns)
+{
+	uint8_t data[10];
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+	struct sr_datafeed_time time;
+
+	memset(data, 0, sizeof(data));
+	logic.length = sizeof(data);
+	logic.unitsize = 1;
+	logic.data = data;
+	packet.type = type;
+	packet.payload = (type == SR_DF_LOGIC) ? &logic : NULL;
+	memset(&time, 0, sizeof(time));
+	time.timeline_ns = timeline_ns;
+	packet.time = &time;
+	fail_unless(sr_session_merge_push(merge, sdi, &packet) == SR_OK);
+}
+
+/* Two devices for merging, in a new session. */
+static struct sr_session *merge_session_new(struct sr_dev_inst **sdi)
+{
+	struct sr_session *sess;
+	int i;
+
+	sr_session_new(srtest_ctx, &sess);
+	for (i = 0; i < 2; i++) {
+		sdi[i] = sr_dev_inst_user_new("sigrok", "Merge", NULL);
+		sr_session_dev_add(sess, sdi[i]);
+	}
+
+	return sess;
+}
+
+/* Packets of several devices are passed on in timeline order. */
+START_TEST(test_session_merge_order)
+{
+	const int64_t expected[] = { 0, 10, 20, 30, 60, 61, 70, 71 };
+	const int expected_dev[] = { 0, 1, 1, 0, 0, 0, 1, 1 };
+	struct sr_session *sess;
+	struct sr_session_merge *merge;
+	struct sr_dev_inst *sdi[2];
+	struct merge_check mc;
+	unsigned int i;
+
+	sess = merge_session_new(sdi);
+	memset(&mc, 0, sizeof(mc));
+	merge = sr_session_merge_new(sess, G_MAXINT64,
+			datafeed_merge_check, &mc);
+
+	/* Nothing is passed on while the other device may send earlier. */
+	merge_push(merge, sdi[0], SR_DF_LOGIC, 0);
+	merge_push(merge, sdi[0], SR_DF_LOGIC, 30);
+	merge_push(merge, sdi[0], SR_DF_LOGIC, 60);
+	fail_unless(mc.num_packets == 0);
+	merge_push(merge, sdi[1], SR_DF_LOGIC, 10);
+	fail_unless(mc.num_packets == 2);
+	merge_push(merge, sdi[1], SR_DF_LOGIC, 20);
+	merge_push(merge, sdi[1], SR_DF_LOGIC, 70);
+	fail_unless(mc.num_packets == 5);
+	/* A device that ended doesn't hold up the others. */
+	merge_push(merge, sdi[0], SR_DF_END, 61);
+	fail_unless(mc.num_packets == 7);
+	merge_push(merge, sdi[1], SR_DF_END, 71);
+
+	fail_unless(mc.num_packets == ARRAY_SIZE(expected));
+	for (i = 0; i < ARRAY_SIZE(expected); i++) {
+		fail_unless(mc.timeline_ns[i] == expected[i],
+			"Packet %u at %" PRId64 " ns.", i, mc.timeline_ns[i]);
+		fail_unless(mc.sdi[i] == sdi[expected_dev[i]]);
+	}
+
+	sr_session_merge_free(merge);
+	sr_session_destroy(sess);
+	for (i = 0; i < 2; i++)
+		sr_dev_inst_free(sdi[i]);
+}
+END_TEST
+
+/* A silent device holds up the others for at most the maximum delay. */
+START_TEST(test_session_merge_max_delay)
+{
+	struct sr_session *sess;
+	struct sr_session_merge *merge;
+	struct sr_dev_inst *sdi[2];
+	struct merge_check mc;
+	int i;
+
+	sess = merge_session_new(sdi);
+	memset(&mc, 0, sizeof(mc));
+	merge = sr_session_merge_new(sess, 1000, datafeed_merge_check, &mc);
+
+	merge_push(merge, sdi[0], SR_DF_LOGIC, 0);
+	merge_push(merge, sdi[0], SR_DF_LOGIC, 500);
+	merge_push(merge, sdi[0], SR_DF_LOGIC, 999);
+	fail_unless(mc.num_packets == 0);
+	/* The first packet is now 1000 ns old. */
+	merge_push(merge, sdi[0], SR_DF_LOGIC, 1000);
+	fail_unless(mc.num_packets == 1);
+	merge_push(merge, sdi[0], SR_DF_LOGIC, 2000);
+	fail_unless(mc.num_packets == 4);
+	fail_unless(mc.timeline_ns[3] == 1000);
+
+	/* Only the newest packet is held, until flushed. */
+	sr_session_merge_flush(merge);
+	fail_unless(mc.num_packets == 5);
+	for (i = 0; i < 5; i++)
+		fail_unless(mc.sdi[i] == sdi[0]);
+
+	sr_session_merge_free(merge);
+	sr_session_destroy(sess);
+	for (i = 0; i < 2; i++)
+		sr_dev_inst_free(sdi[i]);
+}
+END_TEST
+
+/* Check the threading policy setter and getter. */
+START_TEST(test_session_threading)
+{
+	int ret, threading;
+	struct sr_session *sess;
+
+	sr_session_new(srtest_ctx, &sess);
+	ret = sr_session_threading_get(sess, &threading);
+	fail_unless(ret == SR_OK);
+	fail_unless(threading == SR_SESSION_THREADING_SINGLE);
+
+	ret = sr_session_threading_set(sess, SR_SESSION_THREADING_PER_DEVICE);
+	fail_unless(ret == SR_OK);
+	sr_session_threading_get(sess, &threading);
+	fail_unless(threading == SR_SESSION_THREADING_PER_DEVICE);
+
+	ret = sr_session_threading_set(sess, -1);
+	fail_unless(ret == SR_ERR_ARG);
+	sr_session_threading_get(sess, &threading);
+	fail_unless(threading == SR_SESSION_THREADING_PER_DEVICE);
+
+	ret = sr_session_threading_set(NULL, SR_SESSION_THREADING_SINGLE);
+	fail_unless(ret == SR_ERR_ARG);
+	ret = sr_session_threading_get(sess, NULL);
+	fail_unless(ret == SR_ERR_ARG);
+
+	sr_session_destroy(sess);
+}
+END_TEST
+
+/* Number of demo device samples per logic packet, one byte each. */
+#define THREADS_PACKET_SAMPLES	1000
+
+struct threads_check {
+	/* The thread running the session. */
+	GThread *thread;
+	struct time_check devs[3];
+	struct sr_session *session;
+	/* Stop the session after this many more packets, unless 0. */
+	int stop_after;
+};
+
+/*
+ * Packets sent on the device threads are passed on on the session's
+ * thread, each device's in order, and none after a device's end.
+ */
+static void datafeed_threads_check(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	struct threads_check *tc;
+	struct time_check *dev;
+
+	tc = cb_data;
+	fail_unless(g_thread_self() == tc->thread);
+	for (dev = tc->devs; dev->sdi != sdi; dev++)
+		fail_unless(dev->sdi != NULL);
+	fail_unless(!dev->ended);
+	datafeed_time_check(sdi, packet, tc->devs);
+
+	if (tc->stop_after && !--tc->stop_after)
+		sr_session_stop(tc->session);
+}
+
+/* Set up a session with a thread per demo device, sending logic data. */
+static struct sr_session *threads_session_new(struct threads_check *tc,
+		int num_devs)
+{
+	struct sr_dev_driver *driver;
+	struct sr_session *sess;
+	struct sr_dev_inst *sdi;
+	GSList *options, *devs, *l;
+	int i;
+
+	driver = srtest_driver_get("demo");
+	srtest_driver_init(srtest_ctx, driver);
+	options = g_slist_append(NULL, sr_config_new(SR_CONF_NUM_DEVICES,
+			g_variant_new_int32(num_devs)));
+	options = g_slist_append(options, sr_config_new(
+			SR_CONF_NUM_ANALOG_CHANNELS, g_variant_new_int32(0)));
+	devs = sr_driver_scan(driver, options);
+	g_slist_free_full(options, (GDestroyNotify)sr_config_free);
+	fail_unless(g_slist_length(devs) == (unsigned int)num_devs);
+
+	sr_session_new(srtest_ctx, &sess);
+	sr_session_threading_set(sess, SR_SESSION_THREADING_PER_DEVICE);
+	memset(tc, 0, sizeof(*tc));
+	tc->thread = g_thread_self();
+	tc->session = sess;
+	for (l = devs, i = 0; l; l = l->next, i++) {
+		sdi = l->data;
+		fail_unless(sr_dev_open(sdi) == SR_OK);
+		sr_config_set(sdi, NULL, SR_CONF_UNTHROTTLED,
+				g_variant_new_boolean(TRUE));
+		sr_config_set(sdi, NULL, SR_CONF_BUFFERSIZE,
+				g_variant_new_uint64(THREADS_PACKET_SAMPLES));
+		sr_session_dev_add(sess, sdi);
+		tc->devs[i].sdi = sdi;
+	}
+	g_slist_free(devs);
+	sr_session_datafeed_callback_add(sess, datafeed_threads_check, tc);
+
+	return sess;
+}
+
+static void threads_limit_set(struct threads_check *tc, uint64_t samples)
+{
+	struct time_check *dev;
+
+	for (dev = tc->devs; dev->sdi; dev++) {
+		sr_config_set(dev->sdi, NULL, SR_CONF_LIMIT_SAMPLES,
+				g_variant_new_uint64(samples));
+		dev->num_packets = 0;
+		dev->ended = FALSE;
+	}
+}
+
+/* Devices on threads of their own run until their sample limit. */
+START_TEST(test_session_threading_run)
+{
+	struct sr_session *sess;
+	struct threads_check tc;
+	int ret, i;
+
+	sess = threads_session_new(&tc, 2);
+	threads_limit_set(&tc, 100 * THREADS_PACKET_SAMPLES);
+
+	ret = sr_session_start(sess);
+	fail_unless(ret == SR_OK);
+	sr_session_run(sess);
+	fail_unless(!sr_session_is_running(sess));
+
+	for (i = 0; i < 2; i++) {
+		fail_unless(tc.devs[i].ended);
+		fail_unless(tc.devs[i].next_sample
+				== 100 * THREADS_PACKET_SAMPLES);
+		/* Header, logic packets, end. */
+		fail_unless(tc.devs[i].num_packets == 1 + 100 + 1);
+	}
+
+	sr_session_destroy(sess);
+}
+END_TEST
+
+/*
+ * Stopping the session stops the devices on their threads, and all
+ * they sent is passed on before it ends.
+ */
+START_TEST(test_session_threading_stop)
+{
+	struct sr_session *sess;
+	struct threads_check tc;
+	int ret, i;
+
+	sess = threads_session_new(&tc, 2);
+	threads_limit_set(&tc, 0);
+	tc.stop_after = 50;
+
+	ret = sr_session_start(sess);
+	fail_unless(ret == SR_OK);
+	sr_session_run(sess);
+	fail_unless(!sr_session_is_running(sess));
+	fail_unless(tc.stop_after == 0);
+
+	for (i = 0; i < 2; i++) {
+		fail_unless(tc.devs[i].ended);
+		fail_unless(tc.devs[i].next_sample % THREADS_PACKET_SAMPLES == 0);
+	}
+
+	sr_session_destroy(sess);
+}
+END_TEST
+
+/*
+ * When a device fails to start, the others are stopped again, and the
+ * session can be started once the problem is solved.
+ */
+START_TEST(test_session_threading_start_fail)
+{
+	struct sr_session *sess;
+	struct threads_check tc;
+	int ret, i;
+
+	sess = threads_session_new(&tc, 2);
+	/* No limit, so only the rollback ends the first device. */
+	threads_limit_set(&tc, 0);
+	sr_dev_close((struct sr_dev_inst *)tc.devs[1].sdi);
+
+	ret = sr_session_start(sess);
+	fail_unless(ret == SR_ERR_DEV_CLOSED);
+	fail_unless(!sr_session_is_running(sess));
+	fail_unless(tc.devs[0].num_packets >= 2);
+	fail_unless(tc.devs[0].ended);
+	fail_unless(tc.devs[1].num_packets == 0);
+
+	fail_unless(sr_dev_open((struct sr_dev_inst *)tc.devs[1].sdi) == SR_OK);
+	threads_limit_set(&tc, 10 * THREADS_PACKET_SAMPLES);
+	ret = sr_session_start(sess);
+	fail_unless(ret == SR_OK);
+	sr_session_run(sess);
+
+	for (i = 0; i < 2; i++) {
+		fail_unless(tc.devs[i].ended);
+		fail_unless(tc.devs[i].next_sample
+				== 10 * THREADS_PACKET_SAMPLES);
+	}
+
+	sr_session_destroy(sess);
+}
+END_TEST
+
 Suite *suite_session(void)
 {
 	Suite *s;
@@ -210,5 +861,28 @@ Suite *suite_session(void)
 	tcase_add_test(tc, test_session_trigger_get_null);
 	suite_add_tcase(s, tc);
 
+	tc = tcase_create("stats");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_session_stats_disabled);
+	tcase_add_test(tc, test_session_stats);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("time");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_session_time);
+	tcase_add_test(tc, test_session_merge);
+	tcase_add_test(tc, test_dev_clock_fit);
+	tcase_add_test(tc, test_session_merge_order);
+	tcase_add_test(tc, test_session_merge_max_delay);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("threading");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_session_threading);
+	tcase_add_test(tc, test_session_threading_run);
+	tcase_add_test(tc, test_session_threading_stop);
+	tcase_add_test(tc, test_session_threading_start_fail);
+	suite_add_tcase(s, tc);
+
 	return s;
 }
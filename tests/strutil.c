@@ -19,8 +19,11 @@
  */
 
 #include <config.h>
+#include <string.h>
+#include <glib.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
 #include "lib.h"
 
 static void test_samplerate(uint64_t samplerate, const char *expected)
@@ -155,6 +158,124 @@ START_TEST(test_ghz)
 }
 END_TEST
 
+static void test_float_list(const char *str, int expected_ret,
+		const float *expected, unsigned int num_expected)
+{
+	GArray *result;
+	unsigned int i;
+	int ret;
+
+	result = g_array_new(FALSE, FALSE, sizeof(float));
+	ret = sr_atof_ascii_list(str, result);
+	fail_unless(ret == expected_ret,
+		    "Unexpected return value %d for '%s'.", ret, str);
+	fail_unless(result->len == num_expected,
+		    "Got %u values instead of %u for '%s'.",
+		    result->len, num_expected, str);
+	for (i = 0; i < num_expected; i++)
+		fail_unless(g_array_index(result, float, i) == expected[i],
+			    "Value %u of '%s' is %g instead of %g.", i, str,
+			    g_array_index(result, float, i), expected[i]);
+	g_array_free(result, TRUE);
+}
+
+/*
+ * Check that a single value is converted exactly like g_ascii_strtod()
+ * followed by a conversion to float would do.
+ */
+static void test_float_exact(const char *str)
+{
+	float expected;
+
+	expected = g_ascii_strtod(str, NULL);
+	test_float_list(str, SR_OK, &expected, 1);
+}
+
+/*
+ * Values with at most 15 significant digits and an exponent of at most
+ * 22 are converted without g_ascii_strtod(), the result must be the
+ * same nonetheless.
+ */
+START_TEST(test_atof_list_fast)
+{
+	test_float_exact("0");
+	test_float_exact("1");
+	test_float_exact("0.1");
+	test_float_exact("0.3");
+	test_float_exact("1.5");
+	test_float_exact("3.14159265358979");
+	test_float_exact("123456789012345");
+	test_float_exact("0.000123456789012345");
+	test_float_exact("1e22");
+	test_float_exact("1e-22");
+	test_float_exact("9.99999999999999e22");
+	test_float_exact("1.5e-21");
+	test_float_exact("4.2E+3");
+	test_float_exact("-2.5e-3");
+	test_float_exact("+7.25");
+	test_float_exact(".5");
+	test_float_exact("5.");
+	test_float_exact("000000000000000000001.25");
+	test_float_exact("16777217");
+}
+END_TEST
+
+/* Values just outside of the above take the g_ascii_strtod() path. */
+START_TEST(test_atof_list_fallback)
+{
+	test_float_exact("1234567890123456");
+	test_float_exact("0.1000000000000001");
+	test_float_exact("3.141592653589793238");
+	test_float_exact("1e23");
+	test_float_exact("1e-23");
+	test_float_exact("1.5e-30");
+	test_float_exact("-2e23");
+	test_float_exact("1.250000000000000000000");
+	test_float_exact("3.4028234e38");
+	test_float_exact("1e-45");
+	test_float_exact("inf");
+	test_float_exact("-INF");
+}
+END_TEST
+
+START_TEST(test_atof_list_separators)
+{
+	const float single[] = { 1.5 };
+	const float values[] = { 1, -2.5, 3e3, 0.25 };
+
+	test_float_list("", SR_OK, NULL, 0);
+	test_float_list("1.5", SR_OK, single, 1);
+	test_float_list(" 1.5", SR_OK, single, 1);
+	test_float_list("1.5 ", SR_OK, single, 1);
+	test_float_list("1.5\r\n", SR_OK, single, 1);
+	test_float_list("1,-2.5,3e3,0.25", SR_OK, values, 4);
+	test_float_list("+1, -2.5 ,3E+3,\t2.5e-1\n", SR_OK, values, 4);
+	test_float_list("1.0 ,  -2.50,  3000.0 , .25  ", SR_OK, values, 4);
+}
+END_TEST
+
+/* Values that can't be parsed are skipped, but still reported. */
+START_TEST(test_atof_list_malformed)
+{
+	const float values[] = { 1, 3 };
+	const float single[] = { 1 };
+
+	test_float_list("1,foo,3", SR_ERR, values, 2);
+	test_float_list("1,,3", SR_ERR, values, 2);
+	test_float_list("1,2.5x,3", SR_ERR, values, 2);
+	test_float_list("1,2 5,3", SR_ERR, values, 2);
+	test_float_list("1,1e400,3", SR_ERR, values, 2);
+	test_float_list("1,", SR_ERR, single, 1);
+	test_float_list(",1", SR_ERR, single, 1);
+	test_float_list("1e", SR_ERR, NULL, 0);
+	test_float_list("1e+", SR_ERR, NULL, 0);
+	test_float_list("-", SR_ERR, NULL, 0);
+	test_float_list(".", SR_ERR, NULL, 0);
+	test_float_list(" ", SR_ERR, NULL, 0);
+	test_float_list(",", SR_ERR, NULL, 0);
+}
+END_TEST
+
 Suite *suite_strutil(void)
 {
 	Suite *s;
@@ -170,5 +291,13 @@ Suite *suite_strutil(void)
 	tcase_add_test(tc, test_ghz);
 	suite_add_tcase(s, tc);
 
+	tc = tcase_create("sr_atof_ascii_list");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_atof_list_fast);
+	tcase_add_test(tc, test_atof_list_fallback);
+	tcase_add_test(tc, test_atof_list_separators);
+	tcase_add_test(tc, test_atof_list_malformed);
+	suite_add_tcase(s, tc);
+
 	return s;
 }
@@ -19,9 +19,13 @@
  */
 
 #include <config.h>
+#include <inttypes.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
 #include "lib.h"
 
 /* Check whether at least one transform module is available. */
@@ -97,6 +101,438 @@ START_TEST(test_transform_options)
 }
 END_TEST
 
+static void datafeed_logic(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_logic *logic;
+
+	(void)sdi;
+
+	if (packet->type != SR_DF_LOGIC)
+		return;
+	logic = packet->payload;
+	g_string_append_len(cb_data, logic->data, logic->length);
+}
+
+/* Feed bytes through the given transforms, return what comes out. */
+static GString *transform_bytes(const char **ids, GString *in)
+{
+	struct sr_session *sess;
+	const struct sr_input *input;
+	struct sr_dev_inst *sdi;
+	const struct sr_transform *t[4];
+	GString *out;
+	int i;
+
+	sr_session_new(srtest_ctx, &sess);
+	input = sr_input_new(sr_input_find("binary"), NULL);
+	fail_unless(input != NULL);
+	sdi = sr_input_dev_inst_get(input);
+	sr_session_dev_add(sess, sdi);
+	for (i = 0; ids[i]; i++) {
+		t[i] = sr_transform_new(sr_transform_find(ids[i]), NULL, sdi);
+		fail_unless(t[i] != NULL);
+	}
+	out = g_string_new(NULL);
+	sr_session_datafeed_callback_add(sess, datafeed_logic, out);
+
+	sr_input_send(input, in);
+	sr_input_end(input);
+
+	sr_session_destroy(sess);
+	while (i--)
+		sr_transform_free(t[i]);
+	sr_input_free(input);
+
+	return out;
+}
+
+/* Check that fused transforms do what they would do one by one. */
+START_TEST(test_transform_fused)
+{
+	const char *invert[] = { "invert", NULL };
+	const char *invert_twice[] = { "invert", "nop", "invert", NULL };
+	const char *invert_thrice[] = { "invert", "invert", "invert", NULL };
+	GString *in, *out;
+	unsigned int i;
+
+	in = g_string_sized_new(1000);
+	for (i = 0; i < 1000; i++)
+		g_string_append_c(in, i * 7);
+
+	out = transform_bytes(invert, in);
+	fail_unless(out->len == in->len);
+	for (i = 0; i < in->len; i++)
+		fail_unless((uint8_t)out->str[i] == (uint8_t)~in->str[i]);
+	g_string_free(out, TRUE);
+
+	out = transform_bytes(invert_twice, in);
+	fail_unless(out->len == in->len);
+	fail_unless(!memcmp(out->str, in->str, in->len));
+	g_string_free(out, TRUE);
+
+	out = transform_bytes(invert_thrice, in);
+	fail_unless(out->len == in->len);
+	for (i = 0; i < in->len; i++)
+		fail_unless((uint8_t)out->str[i] == (uint8_t)~in->str[i]);
+	g_string_free(out, TRUE);
+
+	g_string_free(in, TRUE);
+}
+END_TEST
+
+/* A transform, with the factor if it's "scale". */
+struct transform_spec {
+	const char *id;
+	int64_t p;
+	uint64_t q;
+};
+
+#define FLOAT_SAMPLES	500
+#define FLOAT_CHANNELS	2
+
+/* A device with two analog channels, in a new session. */
+static struct sr_dev_inst *analog_dev_new(struct sr_session **sess)
+{
+	struct sr_dev_inst *sdi;
+
+	sr_session_new(srtest_ctx, sess);
+	sdi = sr_dev_inst_user_new("sigrok", "Transform", NULL);
+	sr_dev_inst_channel_add(sdi, 0, SR_CHANNEL_ANALOG, "A0");
+	sr_dev_inst_channel_add(sdi, 1, SR_CHANNEL_ANALOG, "A1");
+	sr_session_dev_add(*sess, sdi);
+
+	return sdi;
+}
+
+static const struct sr_transform *scale_new(const struct sr_dev_inst *sdi,
+		int64_t p, uint64_t q)
+{
+	const struct sr_transform *t;
+	GHashTable *options;
+
+	options = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+			(GDestroyNotify)g_variant_unref);
+	g_hash_table_insert(options, "factor", g_variant_ref_sink(
+		g_variant_new("(xt)", p, q)));
+	t = sr_transform_new(sr_transform_find("scale"), options, sdi);
+	g_hash_table_destroy(options);
+
+	return t;
+}
+
+/*
+ * Run SR_DF_ANALOG_OLD floats of two channels through the given
+ * transforms, fused and one by one, and check both against the
+ * expected result. Returns the fused result.
+ */
+static float *transform_floats(const struct transform_spec *specs,
+		float (*expected)(float))
+{
+	struct sr_session *sess;
+	struct sr_dev_inst *sdi;
+	struct sr_transform_chain *chain;
+	const struct sr_transform *t[8];
+	struct sr_datafeed_packet packet, *out;
+	struct sr_datafeed_analog_old analog_old;
+	float in[FLOAT_SAMPLES * FLOAT_CHANNELS];
+	float *fused, *unfused;
+	unsigned int i;
+	int n, ret;
+
+	sdi = analog_dev_new(&sess);
+	for (n = 0; specs[n].id; n++) {
+		if (!strcmp(specs[n].id, "scale"))
+			t[n] = scale_new(sdi, specs[n].p, specs[n].q);
+		else
+			t[n] = sr_transform_new(sr_transform_find(specs[n].id),
+					NULL, sdi);
+		fail_unless(t[n] != NULL);
+	}
+
+	/* No zeroes, for the reciprocals. */
+	for (i = 0; i < G_N_ELEMENTS(in); i++)
+		in[i] = ((int)i - 499.5f) * 0.37f;
+	fused = g_memdup(in, sizeof(in));
+	unfused = g_memdup(in, sizeof(in));
+	analog_old.channels = sdi->channels;
+	analog_old.num_samples = FLOAT_SAMPLES;
+	analog_old.mq = SR_MQ_VOLTAGE;
+	analog_old.unit = SR_UNIT_VOLT;
+	analog_old.mqflags = 0;
+	packet.type = SR_DF_ANALOG_OLD;
+	packet.payload = &analog_old;
+	packet.time = NULL;
+
+	chain = sr_transform_chain_new(sess->transforms);
+	fail_unless(chain != NULL);
+	analog_old.data = fused;
+	ret = sr_transform_chain_run(chain, &packet);
+	fail_unless(ret == SR_OK);
+	sr_transform_chain_free(chain);
+
+	analog_old.data = unfused;
+	for (i = 0; i < (unsigned int)n; i++) {
+		ret = t[i]->module->receive(t[i], &packet, &out);
+		fail_unless(ret == SR_OK && out == &packet);
+	}
+
+	for (i = 0; i < G_N_ELEMENTS(in); i++) {
+		fail_unless(fabsf(fused[i] - unfused[i])
+				<= 1e-5f * fabsf(unfused[i]),
+			"Value %u: fused %g, one by one %g.", i,
+			fused[i], unfused[i]);
+		fail_unless(fabsf(fused[i] - expected(in[i]))
+				<= 1e-5f * fabsf(expected(in[i])),
+			"Value %u: %g instead of %g.", i,
+			fused[i], expected(in[i]));
+	}
+
+	while (n--)
+		sr_transform_free(t[n]);
+	sr_session_destroy(sess);
+	sr_dev_inst_free(sdi);
+	g_free(unfused);
+
+	return fused;
+}
+
+static float times_one_and_a_half(float x)
+{
+	return x * 1.5f;
+}
+
+static float minus_one_sixth_reciprocal(float x)
+{
+	return -1 / (6 * x);
+}
+
+static float identity(float x)
+{
+	return x;
+}
+
+/* Check that fused factors and reciprocals do what they would one by one. */
+START_TEST(test_transform_fused_analog)
+{
+	const struct transform_spec scale_twice[] = {
+		{ "scale", 3, 1 }, { "scale", 1, 2 }, { NULL, 0, 0 },
+	};
+	/* The factors on either side of the reciprocal can't be merged. */
+	const struct transform_spec around_invert[] = {
+		{ "scale", 2, 1 }, { "scale", 3, 2 }, { "invert", 0, 0 },
+		{ "scale", 5, 1 }, { "nop", 0, 0 }, { "scale", -1, 10 },
+		{ NULL, 0, 0 },
+	};
+	const struct transform_spec scale_cancel[] = {
+		{ "scale", 3, 1 }, { "scale", 1, 3 }, { NULL, 0, 0 },
+	};
+	const struct transform_spec invert_twice[] = {
+		{ "invert", 0, 0 }, { "invert", 0, 0 }, { NULL, 0, 0 },
+	};
+	float *out;
+	unsigned int i;
+
+	g_free(transform_floats(scale_twice, times_one_and_a_half));
+	g_free(transform_floats(around_invert, minus_one_sixth_reciprocal));
+	g_free(transform_floats(invert_twice, identity));
+
+	/* Merged into a factor of 1, which is left out: no rounding at all. */
+	out = transform_floats(scale_cancel, identity);
+	for (i = 0; i < FLOAT_SAMPLES * FLOAT_CHANNELS; i++)
+		fail_unless(out[i] == ((int)i - 499.5f) * 0.37f);
+	g_free(out);
+}
+END_TEST
+
+#define ANALOG_SAMPLES	8
+
+/* Half-integers, so that no value ends up exactly at zero. */
+static void analog_init(struct sr_datafeed_packet *packet,
+		struct sr_datafeed_analog *analog,
+		struct sr_analog_encoding *encoding,
+		struct sr_analog_meaning *meaning, struct sr_analog_spec *spec,
+		const struct sr_dev_inst *sdi, float *data)
+{
+	unsigned int i;
+
+	for (i = 0; i < ANALOG_SAMPLES * 2; i++)
+		data[i] = i - 7.5f;
+	sr_analog_init(analog, encoding, meaning, spec, 0);
+	meaning->channels = sdi->channels;
+	analog->num_samples = ANALOG_SAMPLES;
+	analog->data = data;
+	packet->type = SR_DF_ANALOG;
+	packet->payload = analog;
+	packet->time = NULL;
+}
+
+/* Check the values of a packet, as they would be read by a frontend. */
+static void analog_check(const struct sr_datafeed_analog *analog,
+		float mul, float add)
+{
+	float values[ANALOG_SAMPLES * 2], expected;
+	unsigned int i;
+	int ret;
+
+	ret = sr_analog_to_float(analog, values);
+	fail_unless(ret == SR_OK, "sr_analog_to_float() failed: %d.", ret);
+	for (i = 0; i < ANALOG_SAMPLES * 2; i++) {
+		expected = (i - 7.5f) * mul + add;
+		fail_unless(fabsf(values[i] - expected) <= 1e-5f,
+			"Value %u: %g instead of %g.", i, values[i], expected);
+	}
+}
+
+/* Check that scaling through the encoding scales the offset as well. */
+START_TEST(test_scale_offset)
+{
+	struct sr_session *sess;
+	struct sr_dev_inst *sdi;
+	const struct sr_transform *t;
+	struct sr_datafeed_packet packet, *out;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	float data[ANALOG_SAMPLES * 2], orig[ANALOG_SAMPLES * 2];
+	int ret;
+
+	sdi = analog_dev_new(&sess);
+	t = scale_new(sdi, 3, 2);
+	fail_unless(t != NULL);
+	analog_init(&packet, &analog, &encoding, &meaning, &spec, sdi, data);
+	sr_rational_set(&encoding.offset, 5, 4);
+	memcpy(orig, data, sizeof(data));
+
+	ret = t->module->receive(t, &packet, &out);
+	fail_unless(ret == SR_OK && out == &packet);
+	fail_unless(encoding.scale.p == 3 && encoding.scale.q == 2,
+		"Scale %" PRId64 "/%" PRIu64 " instead of 3/2.",
+		encoding.scale.p, encoding.scale.q);
+	fail_unless(encoding.offset.p == 15 && encoding.offset.q == 8,
+		"Offset %" PRId64 "/%" PRIu64 " instead of 15/8.",
+		encoding.offset.p, encoding.offset.q);
+	fail_unless(!memcmp(data, orig, sizeof(data)), "Data modified.");
+	analog_check(&analog, 1.5f, 1.875f);
+
+	sr_transform_free(t);
+	sr_session_destroy(sess);
+	sr_dev_inst_free(sdi);
+}
+END_TEST
+
+/*
+ * Check that floats are scaled in place when the encoding's rationals
+ * would overflow, and that other data are rejected then.
+ */
+START_TEST(test_scale_overflow)
+{
+	struct sr_session *sess;
+	struct sr_dev_inst *sdi;
+	const struct sr_transform *t;
+	struct sr_datafeed_packet packet, *out;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	float data[ANALOG_SAMPLES * 2];
+	int16_t raw[ANALOG_SAMPLES * 2];
+	unsigned int i;
+	int ret;
+
+	sdi = analog_dev_new(&sess);
+	t = scale_new(sdi, 1, 3);
+	fail_unless(t != NULL);
+
+	/* An offset of almost exactly 1, whose denominator can't triple. */
+	analog_init(&packet, &analog, &encoding, &meaning, &spec, sdi, data);
+	sr_rational_set(&encoding.offset, INT64_MAX, 1ULL << 63);
+	ret = t->module->receive(t, &packet, &out);
+	fail_unless(ret == SR_OK && out == &packet);
+	fail_unless(encoding.scale.p == 1 && encoding.scale.q == 1
+		&& encoding.offset.p == INT64_MAX
+		&& encoding.offset.q == 1ULL << 63, "Encoding modified.");
+	analog_check(&analog, 1 / 3.0f, 1 / 3.0f);
+
+	/* The same with integers, which can't be scaled in place. */
+	for (i = 0; i < ANALOG_SAMPLES * 2; i++)
+		raw[i] = i;
+	analog_init(&packet, &analog, &encoding, &meaning, &spec, sdi, data);
+	sr_rational_set(&encoding.offset, INT64_MAX, 1ULL << 63);
+	encoding.unitsize = sizeof(int16_t);
+	encoding.is_float = FALSE;
+	analog.data = raw;
+	ret = t->module->receive(t, &packet, &out);
+	fail_unless(ret == SR_ERR, "Integer data not rejected: %d.", ret);
+	for (i = 0; i < ANALOG_SAMPLES * 2; i++)
+		fail_unless(raw[i] == (int16_t)i, "Data modified.");
+
+	sr_transform_free(t);
+	sr_session_destroy(sess);
+	sr_dev_inst_free(sdi);
+}
+END_TEST
+
+/* Check that a factor with a zero denominator is rejected. */
+START_TEST(test_scale_zero_denominator)
+{
+	struct sr_session *sess;
+	struct sr_dev_inst *sdi;
+	const struct sr_transform *t;
+
+	sdi = analog_dev_new(&sess);
+	t = scale_new(sdi, 1, 0);
+	fail_unless(t == NULL, "Factor 1/0 accepted.");
+
+	sr_session_destroy(sess);
+	sr_dev_inst_free(sdi);
+}
+END_TEST
+
+/* Check that only whole samples of logic data are inverted. */
+START_TEST(test_invert_partial)
+{
+	struct sr_session *sess;
+	struct sr_dev_inst *sdi;
+	const struct sr_transform *t;
+	struct sr_datafeed_packet packet, *out;
+	struct sr_datafeed_logic logic;
+	uint8_t data[3];
+	int ret;
+
+	sdi = analog_dev_new(&sess);
+	t = sr_transform_new(sr_transform_find("invert"), NULL, sdi);
+	fail_unless(t != NULL);
+	logic.unitsize = 2;
+	logic.data = data;
+	packet.type = SR_DF_LOGIC;
+	packet.payload = &logic;
+	packet.time = NULL;
+
+	/* Shorter than one sample: nothing to do. */
+	data[0] = 0x5a;
+	logic.length = 1;
+	ret = t->module->receive(t, &packet, &out);
+	fail_unless(ret == SR_OK && out == &packet);
+	fail_unless(data[0] == 0x5a, "Partial sample inverted.");
+
+	/* One sample and a bit. */
+	data[0] = 0x5a;
+	data[1] = 0x00;
+	data[2] = 0xc3;
+	logic.length = 3;
+	ret = t->module->receive(t, &packet, &out);
+	fail_unless(ret == SR_OK && out == &packet);
+	fail_unless(data[0] == 0xa5 && data[1] == 0xff && data[2] == 0xc3,
+		"Wrong result %02x %02x %02x.", data[0], data[1], data[2]);
+
+	sr_transform_free(t);
+	sr_session_destroy(sess);
+	sr_dev_inst_free(sdi);
+}
+END_TEST
+
 Suite *suite_transform_all(void)
 {
 	Suite *s;
@@ -113,5 +549,19 @@ Suite *suite_transform_all(void)
 	tcase_add_test(tc, test_transform_options);
 	suite_add_tcase(s, tc);
 
+	tc = tcase_create("fused");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_transform_fused);
+	tcase_add_test(tc, test_transform_fused_analog);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("encoding");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_scale_offset);
+	tcase_add_test(tc, test_scale_overflow);
+	tcase_add_test(tc, test_scale_zero_denominator);
+	tcase_add_test(tc, test_invert_partial);
+	suite_add_tcase(s, tc);
+
 	return s;
 }